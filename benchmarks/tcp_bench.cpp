@@ -0,0 +1,265 @@
+#include <benchmark/benchmark.h>
+#include "client_pool.h"
+#include "frame.h"
+#include "logger.h"
+#include "tcp_client.h"
+#include "tcp_server.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 回环网络上的基准测试：连接延迟、单连接发送吞吐、多连接下服务器的消息处理速率、
+// 帧解析吞吐和断线重连的恢复时间。客户端和服务器在同一进程内，结果受本机负载影响，
+// 比较不同版本时应在同一台空闲机器上运行
+
+namespace {
+
+// 轮询等待条件成立，超时返回false
+template <typename F>
+bool waitUntil(F&& condition, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+// 启动监听随机端口的服务器；respond为false时只接收不回复
+std::unique_ptr<TcpServer> startServer(bool respond, int port = 0) {
+    ServerConfig config;
+    config.port = port;
+    config.reactor_count = 2;
+    auto server = std::make_unique<TcpServer>(config);
+    if (!respond) {
+        server->setMessageHandler([](const FrameHeader&, std::string_view, ByteBuffer&) { return false; });
+    }
+    return server->start() ? std::move(server) : nullptr;
+}
+
+// 当前进程可用的文件描述符数
+rlim_t fileLimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) < 0) return 0;
+    return limit.rlim_cur;
+}
+
+// 服务器消息速率测试的连接集合，连接数不变时在多次调用之间复用，避免每轮重建上万条连接
+struct Cluster {
+    std::unique_ptr<TcpServer> server;
+    std::unique_ptr<ClientPool> pool;
+    std::vector<std::unique_ptr<TcpClient>> clients;
+
+    ~Cluster() {
+        for (auto& client : clients) client->stop();
+        clients.clear();
+        pool.reset();
+        if (server) server->stop();
+    }
+};
+
+std::unique_ptr<Cluster> gCluster;
+
+Cluster* clusterWith(size_t connections) {
+    if (gCluster && gCluster->clients.size() == connections) return gCluster.get();
+    gCluster.reset();
+    auto cluster = std::make_unique<Cluster>();
+    cluster->server = startServer(true);
+    if (!cluster->server) return nullptr;
+    cluster->pool = std::make_unique<ClientPool>(2);
+    for (size_t i = 0; i < connections; ++i) {
+        auto client = std::make_unique<TcpClient>(*cluster->pool, "127.0.0.1", cluster->server->port());
+        client->startAsync();
+        cluster->clients.push_back(std::move(client));
+    }
+    bool connected = waitUntil([&] {
+        for (auto& client : cluster->clients) {
+            if (!client->isConnected()) return false;
+        }
+        return true;
+    }, std::chrono::seconds(30));
+    if (!connected) return nullptr;
+    gCluster = std::move(cluster);
+    return gCluster.get();
+}
+
+}  // namespace
+
+// 建立一条连接（含非阻塞connect和事件循环往返）再关闭的耗时
+static void BM_Connect(benchmark::State& state) {
+    auto server = startServer(true);
+    if (!server) {
+        state.SkipWithError("服务器启动失败");
+        return;
+    }
+    ClientPool pool(1);
+    for (auto _ : state) {
+        TcpClient client(pool, "127.0.0.1", server->port());
+        client.start();
+        if (!client.isConnected()) {
+            state.SkipWithError("连接失败");
+            break;
+        }
+        client.stop();
+    }
+    server->stop();
+}
+BENCHMARK(BM_Connect)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// 单连接异步发送吞吐，负载从64B到1MB：每轮发出约1MB并等待全部写入socket，
+// 积压超过高水位时让出CPU等待
+static void BM_SendThroughput(benchmark::State& state) {
+    auto server = startServer(false);
+    if (!server) {
+        state.SkipWithError("服务器启动失败");
+        return;
+    }
+    ClientPool pool(1);
+    TcpClient client(pool, "127.0.0.1", server->port());
+    client.start();
+    if (!client.isConnected()) {
+        state.SkipWithError("连接失败");
+        return;
+    }
+    size_t size = static_cast<size_t>(state.range(0));
+    std::string payload(size, 'x');
+    uint64_t batch = std::max<uint64_t>(1, (1 << 20) / size);
+    std::atomic<uint64_t> completed(0);
+    uint64_t sent = 0;
+    for (auto _ : state) {
+        for (uint64_t i = 0; i < batch; ++i) {
+            while (!client.sendAsync(payload, [&completed](bool) { completed.fetch_add(1, std::memory_order_relaxed); })) {
+                std::this_thread::yield();
+            }
+            ++sent;
+        }
+        if (!waitUntil([&] { return completed.load() == sent; }, std::chrono::seconds(30))) {
+            state.SkipWithError("发送未完成");
+            break;
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(sent * size));
+    state.SetItemsProcessed(static_cast<int64_t>(sent));
+    client.stop();
+    server->stop();
+}
+BENCHMARK(BM_SendThroughput)->RangeMultiplier(8)->Range(64, 1 << 20)->UseRealTime();
+
+// 服务器在不同连接数下的请求/响应速率：每轮在所有连接上轮流发出1000个调用并等待全部完成
+static void BM_ServerMessages(benchmark::State& state) {
+    size_t connections = static_cast<size_t>(state.range(0));
+    // 客户端和服务器各占一个fd，另留出余量
+    if (fileLimit() < connections * 2 + 256) {
+        state.SkipWithError("文件描述符上限不足");
+        return;
+    }
+    Cluster* cluster = clusterWith(connections);
+    if (cluster == nullptr) {
+        state.SkipWithError("建立连接失败");
+        return;
+    }
+    constexpr int kCallsPerRound = 1000;
+    std::atomic<int> completed(0);
+    size_t next = 0;
+    for (auto _ : state) {
+        completed.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < kCallsPerRound; ++i) {
+            TcpClient& client = *cluster->clients[next++ % connections];
+            if (!client.call("ping", [&completed](CallStatus, std::string_view) {
+                    completed.fetch_add(1, std::memory_order_relaxed);
+                })) {
+                completed.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        waitUntil([&] { return completed.load() == kCallsPerRound; }, std::chrono::seconds(30));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * kCallsPerRound);
+}
+BENCHMARK(BM_ServerMessages)->Arg(1)->Arg(100)->Arg(10000)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// 帧解析吞吐：接收缓冲区中排满同样大小的帧，按64KB一次的粒度喂给解析器
+static void BM_FrameParse(benchmark::State& state) {
+    std::string payload(static_cast<size_t>(state.range(0)), 'x');
+    std::string stream;
+    while (stream.size() < (1 << 20)) {
+        appendFrame(stream, FrameType::Message, static_cast<uint32_t>(stream.size()), payload);
+    }
+    constexpr size_t kChunk = 64 * 1024;
+    FrameDecoder decoder;
+    uint64_t frames = 0;
+    for (auto _ : state) {
+        for (size_t offset = 0; offset < stream.size(); offset += kChunk) {
+            size_t len = std::min(kChunk, stream.size() - offset);
+            decoder.feed(stream.data() + offset, len, [&frames](const FrameHeader&, std::string_view payload) {
+                benchmark::DoNotOptimize(payload.data());
+                ++frames;
+            });
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * stream.size()));
+    state.SetItemsProcessed(static_cast<int64_t>(frames));
+}
+BENCHMARK(BM_FrameParse)->RangeMultiplier(8)->Range(16, 64 * 1024);
+
+// 服务器重启后客户端恢复连接的耗时：从新服务器开始监听计时到客户端重新可用
+static void BM_ReconnectRecovery(benchmark::State& state) {
+    auto server = startServer(true);
+    if (!server) {
+        state.SkipWithError("服务器启动失败");
+        return;
+    }
+    int port = server->port();
+    ClientPool pool(1);
+    TcpClient client(pool, "127.0.0.1", port);
+    ReconnectConfig reconnect;
+    reconnect.initial_backoff_ms = 10;
+    reconnect.max_backoff_ms = 50;
+    client.setReconnectConfig(reconnect);
+    client.start();
+
+    for (auto _ : state) {
+        server->stop();
+        server.reset();
+        if (!waitUntil([&] { return !client.isConnected(); }, std::chrono::seconds(5))) {
+            state.SkipWithError("未检测到断开");
+            break;
+        }
+        auto begin = std::chrono::steady_clock::now();
+        server = startServer(true, port);
+        if (!server || !waitUntil([&] { return client.isConnected(); }, std::chrono::seconds(5))) {
+            state.SkipWithError("未能重新连接");
+            break;
+        }
+        state.SetIterationTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+    }
+    client.stop();
+    if (server) server->stop();
+}
+BENCHMARK(BM_ReconnectRecovery)->UseManualTime()->Unit(benchmark::kMillisecond)->Iterations(20);
+
+int main(int argc, char** argv) {
+    // 把打开文件数的软限制提升到硬限制
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    // 连接和断开日志会淹没基准结果，只输出错误
+    Logger::instance().setSink([](LogLevel level, std::string_view line) {
+        if (level >= LogLevel::Error) fwrite(line.data(), 1, line.size(), stderr);
+    });
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    gCluster.reset();
+    Logger::instance().flush();
+    return 0;
+}
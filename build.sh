@@ -48,6 +48,7 @@ echo "可执行文件位置："
 echo "- 服务器: build/tcp_server"
 echo "- 客户端: build/tcp_client"
 echo "- 测试程序: build/tcp_client_test"
+echo "- 基准测试: build/tcp_bench（需要Google Benchmark）"
 
 # 提示如何运行
 echo -e "\n运行说明："
@@ -57,6 +58,8 @@ echo "2. 运行客户端："
 echo "   ./build/tcp_client"
 echo "3. 运行测试："
 echo "   ./build/tcp_client_test"
+echo "4. 运行基准测试："
+echo "   ./build/tcp_bench"
 
 # 重置终端设置
 echo -e "\033[0m"  # 重置所有属性 
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// 连接准入与accept路径的过载保护配置
+struct AdmissionConfig {
+    int backlog = 128;                 // listen队列长度
+    size_t max_connections = 0;        // 同时存在的最大连接数，0表示不限制
+    int accept_batch = 64;             // 每次监听socket就绪时最多accept的连接数
+    double accept_rate = 0;            // 全局每秒接受的新连接数，0表示不限制
+    double accept_burst = 0;           // 全局令牌桶容量，0表示等于accept_rate
+    double source_accept_rate = 0;     // 每个源IP每秒接受的新连接数，0表示不限制
+    double source_accept_burst = 0;    // 每个源IP的令牌桶容量，0表示等于source_accept_rate
+};
+
+// 拒绝原因
+enum class AdmissionResult {
+    Accepted,
+    TooManyConnections,   // 达到最大连接数
+    GlobalRateLimited,    // 超出全局accept速率
+    SourceRateLimited,    // 超出单个源IP的accept速率
+    FdExhausted           // 进程文件描述符耗尽
+};
+
+// 准入统计，各计数自服务器启动起累计
+struct AdmissionStats {
+    uint64_t accepted = 0;
+    uint64_t rejected_max_connections = 0;
+    uint64_t rejected_global_rate = 0;
+    uint64_t rejected_source_rate = 0;
+    uint64_t rejected_fd_exhausted = 0;
+    size_t active_connections = 0;
+};
+
+// 令牌桶：按rate每秒补充令牌，最多积累burst个，每次通过消耗一个
+class TokenBucket {
+public:
+    TokenBucket(double rate, double burst, uint64_t now_ns);
+
+    // 取一个令牌，没有令牌返回false
+    bool tryTake(uint64_t now_ns);
+
+    // 归还一个取出后未使用的令牌
+    void refund();
+
+    // 到now_ns时令牌桶是否已补满（补满的桶与新建的桶等价，可以回收）
+    bool full(uint64_t now_ns) const;
+
+private:
+    double rate_;
+    double burst_;
+    double tokens_;
+    uint64_t last_ns_;
+};
+
+// 连接准入控制：所有反应器线程共享，线程安全。
+// 检查顺序为最大连接数、全局速率、源IP速率，先检查开销小的；被源IP拒绝时归还全局令牌
+class AdmissionController {
+public:
+    explicit AdmissionController(const AdmissionConfig& config);
+
+    // 禁止拷贝和赋值
+    AdmissionController(const AdmissionController&) = delete;
+    AdmissionController& operator=(const AdmissionController&) = delete;
+
+    // 新连接到达：返回Accepted时占用一个连接名额，连接关闭时须调用release()。
+    // source_ip为网络字节序的IPv4地址
+    AdmissionResult admit(uint32_t source_ip);
+    AdmissionResult admit(uint32_t source_ip, uint64_t now_ns);
+
+    // 连接关闭，归还名额
+    void release();
+
+    // accept因文件描述符耗尽失败时记录
+    void recordFdExhausted();
+
+    AdmissionStats stats() const;
+
+    const AdmissionConfig& config() const { return config_; }
+
+private:
+    // 源IP令牌桶按地址的散列分片，减少多个反应器之间的锁竞争。每个分片按最近使用排成链表，
+    // 满时复用最久未使用的节点，淘汰的开销固定，不随跟踪的源IP数增长
+    struct SourceEntry {
+        uint32_t source_ip;
+        TokenBucket bucket;
+    };
+    struct alignas(64) SourceShard {
+        std::mutex mutex;
+        std::list<SourceEntry> lru;  // 表头为最近使用
+        std::unordered_map<uint32_t, std::list<SourceEntry>::iterator> index;
+    };
+
+    SourceShard& sourceShard(uint32_t source_ip);
+
+    bool takeGlobal(uint64_t now_ns);
+    void refundGlobal();
+    bool takeSource(uint32_t source_ip, uint64_t now_ns);
+
+    AdmissionConfig config_;
+    std::atomic<size_t> active_;
+
+    std::mutex global_mutex_;
+    std::unique_ptr<TokenBucket> global_bucket_;   // 为空表示不限制全局速率
+    std::unique_ptr<SourceShard[]> source_shards_;  // 为空表示不限制源IP速率
+
+    std::atomic<uint64_t> accepted_;
+    std::atomic<uint64_t> rejected_max_connections_;
+    std::atomic<uint64_t> rejected_global_rate_;
+    std::atomic<uint64_t> rejected_source_rate_;
+    std::atomic<uint64_t> rejected_fd_exhausted_;
+};
+
+const char* admissionResultName(AdmissionResult result);
+
+// 快速拒绝已accept的连接：SO_LINGER为0后关闭，发送RST而不进入TIME_WAIT
+void rejectConnection(int fd);
+
+// 文件描述符耗尽时的应急处理：accept失败于EMFILE/ENFILE时，连接留在listen队列中，
+// 边缘触发下不会再次通知。预留一个fd，耗尽时释放它来accept并立即拒绝队首连接
+class ReserveFd {
+public:
+    ReserveFd();
+    ~ReserveFd();
+
+    // 禁止拷贝和赋值
+    ReserveFd(const ReserveFd&) = delete;
+    ReserveFd& operator=(const ReserveFd&) = delete;
+
+    // 用预留的fd接受并拒绝listen_fd队首的一个连接，成功返回true
+    bool shedOne(int listen_fd);
+
+private:
+    int fd_;
+};
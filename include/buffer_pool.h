@@ -0,0 +1,203 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// 缓冲区池：按2的幂划分大小级别（256B ~ 1MB）。每个线程持有本地空闲链表，
+// 本地缓存为空或超过上限时才批量访问全局空闲链表；内存以slab为单位向系统申请，
+// 进程生命周期内不归还，稳态下申请和释放都不会触发堆分配
+class BufferPool {
+public:
+    static constexpr size_t kMinBlockSize = 256;
+    static constexpr size_t kMaxBlockSize = 1024 * 1024;
+    static constexpr size_t kClassCount = 13;
+
+    struct Stats {
+        size_t slab_bytes = 0;         // 已向系统申请的slab总字节数
+        size_t large_allocations = 0;  // 超出最大级别、直接走堆的分配次数
+    };
+
+    static BufferPool& instance();
+
+    // 申请至少size字节，实际容量写入capacity
+    void* allocate(size_t size, size_t& capacity);
+
+    // 归还内存，size为申请时的大小或实际容量
+    void deallocate(void* ptr, size_t size);
+
+    // size对应的大小级别，超出最大级别返回kClassCount
+    static size_t sizeClass(size_t size);
+    static size_t classSize(size_t index) { return kMinBlockSize << index; }
+
+    Stats stats() const;
+
+    // 将当前线程的本地缓存全部归还到全局空闲链表
+    void flushThreadCache();
+
+private:
+    BufferPool() = default;
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+};
+
+// 池化内存块的RAII句柄，只能移动
+class PooledBuffer {
+public:
+    PooledBuffer() = default;
+    explicit PooledBuffer(size_t min_capacity);
+    ~PooledBuffer() { reset(); }
+
+    PooledBuffer(PooledBuffer&& other) noexcept
+        : data_(other.data_), capacity_(other.capacity_) {
+        other.data_ = nullptr;
+        other.capacity_ = 0;
+    }
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept {
+        if (this != &other) {
+            reset();
+            swap(other);
+        }
+        return *this;
+    }
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    char* data() { return data_; }
+    const char* data() const { return data_; }
+    size_t capacity() const { return capacity_; }
+
+    // 归还内存块
+    void reset();
+
+    void swap(PooledBuffer& other) noexcept {
+        char* data = data_;
+        size_t capacity = capacity_;
+        data_ = other.data_;
+        capacity_ = other.capacity_;
+        other.data_ = data;
+        other.capacity_ = capacity;
+    }
+
+private:
+    char* data_ = nullptr;
+    size_t capacity_ = 0;
+};
+
+// 可增长的字节缓冲区：读写游标在一块连续的池化内存上推进，空间不足时
+// 先把未读数据挪到头部，仍不够再换更大的块，保证未读数据始终连续可直接解析。
+// 用作连接的接收缓冲区和发送缓冲区
+class ByteBuffer {
+public:
+    // initial_capacity为0时首次写入才申请内存
+    explicit ByteBuffer(size_t initial_capacity = 0);
+
+    ByteBuffer(ByteBuffer&& other) noexcept { swap(other); }
+    ByteBuffer& operator=(ByteBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            swap(other);
+        }
+        return *this;
+    }
+
+    const char* readPtr() const { return buffer_.data() + read_index_; }
+    size_t readableBytes() const { return write_index_ - read_index_; }
+    bool empty() const { return read_index_ == write_index_; }
+    void consume(size_t len);
+    void clear() { read_index_ = write_index_ = 0; }
+
+    char* writePtr() { return buffer_.data() + write_index_; }
+    size_t writableBytes() const { return buffer_.capacity() - write_index_; }
+    void commit(size_t len) { write_index_ += len; }
+
+    // 保证至少有len字节可写空间
+    void ensureWritable(size_t len);
+
+    void append(const char* data, size_t len);
+    void append(std::string_view data) { append(data.data(), data.size()); }
+
+    size_t capacity() const { return buffer_.capacity(); }
+
+    // 交换两个缓冲区的内容（不拷贝数据）
+    void swap(ByteBuffer& other) noexcept;
+
+    // 归还内存块到池中
+    void release();
+
+private:
+    PooledBuffer buffer_;
+    size_t read_index_ = 0;
+    size_t write_index_ = 0;
+};
+
+// 继承此类的对象通过缓冲区池分配，释放后内存回到池中复用
+struct PoolAllocated {
+    static void* operator new(size_t size) {
+        size_t capacity;
+        return BufferPool::instance().allocate(size, capacity);
+    }
+    static void operator delete(void* ptr, size_t size) {
+        BufferPool::instance().deallocate(ptr, size);
+    }
+};
+
+// 引用计数的不可变缓冲区：创建后内容不再修改，拷贝只增加引用计数，可以同时排入多个
+// 连接的发送队列（如广播）而不拷贝数据。引用计数是原子的，可以跨线程传递；
+// 内存来自缓冲区池，最后一个引用释放时归还
+class SharedBuffer {
+public:
+    SharedBuffer() = default;
+
+    // 拷贝data
+    explicit SharedBuffer(std::string_view data);
+
+    // 接管data的内存，不拷贝
+    explicit SharedBuffer(ByteBuffer&& data);
+
+    ~SharedBuffer() { reset(); }
+
+    SharedBuffer(const SharedBuffer& other) noexcept : block_(other.block_) { retain(); }
+    SharedBuffer& operator=(const SharedBuffer& other) noexcept {
+        if (block_ != other.block_) {
+            reset();
+            block_ = other.block_;
+            retain();
+        }
+        return *this;
+    }
+    SharedBuffer(SharedBuffer&& other) noexcept : block_(other.block_) { other.block_ = nullptr; }
+    SharedBuffer& operator=(SharedBuffer&& other) noexcept {
+        if (this != &other) {
+            reset();
+            block_ = other.block_;
+            other.block_ = nullptr;
+        }
+        return *this;
+    }
+
+    const char* data() const { return block_ != nullptr ? block_->data.readPtr() : nullptr; }
+    size_t size() const { return block_ != nullptr ? block_->data.readableBytes() : 0; }
+    bool empty() const { return size() == 0; }
+    std::string_view view() const { return std::string_view(data(), size()); }
+
+    // 当前引用数，空缓冲区为0
+    int useCount() const { return block_ != nullptr ? block_->refs.load(std::memory_order_relaxed) : 0; }
+
+    // 释放本引用
+    void reset();
+
+private:
+    struct Block : public PoolAllocated {
+        std::atomic<int> refs{1};
+        ByteBuffer data;
+    };
+
+    void retain() {
+        if (block_ != nullptr) block_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Block* block_ = nullptr;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "event_loop.h"
+#include "loop_uring.h"
+
+// 客户端连接池：少量事件循环线程驱动大量TcpClient连接。连接、收发、
+// 重连定时都在所属循环线程上非阻塞地完成，TcpClient本身不再创建线程，
+// 因此连接数不受线程数限制。另有一个回调线程按顺序执行所有连接的状态回调，
+// 回调中的阻塞操作不会拖住I/O线程
+class ClientPool {
+public:
+    // loop_count为事件循环线程数，0表示每个CPU核心一个
+    explicit ClientPool(size_t loop_count = 1);
+
+    // 停止并等待所有事件循环线程。使用该池的TcpClient须先于池销毁
+    ~ClientPool();
+
+    // 禁止拷贝和赋值
+    ClientPool(const ClientPool&) = delete;
+    ClientPool& operator=(const ClientPool&) = delete;
+
+    // 进程内共享的默认池（一个事件循环线程），未指定池的TcpClient使用它。
+    // 首次使用时创建，有意不析构，避免进程退出时与静态TcpClient的析构顺序问题
+    static ClientPool& defaultPool();
+
+    // 按轮询选择一个事件循环，新连接均匀分布到各线程
+    EventLoop& nextLoop();
+
+    size_t loopCount() const { return loops_.size(); }
+
+    // 执行连接状态回调的事件循环，所有连接共用，同一连接的回调按状态变化的顺序执行
+    EventLoop& callbackLoop() { return *callback_loop_; }
+
+    // loop上所有连接共用的io_uring，首次使用时创建，创建失败返回nullptr。
+    // 只能在loop的线程上调用，loop须属于本池
+    LoopUring* uring(EventLoop& loop);
+
+private:
+    // 在新线程上运行loop
+    void runLoop(EventLoop* loop);
+
+private:
+    std::vector<std::unique_ptr<EventLoop>> loops_;
+    // 与loops_一一对应，各自只在对应循环线程上创建和使用，须在loops_之前析构
+    std::vector<std::unique_ptr<LoopUring>> rings_;
+    std::unique_ptr<EventLoop> callback_loop_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_loop_;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include "timing_wheel.h"
+#include "mpsc_queue.h"
+
+// 事件处理接口，fd就绪时由EventLoop回调
+class EventHandler {
+public:
+    virtual ~EventHandler() = default;
+    virtual void handleEvent(uint32_t events) = 0;
+};
+
+// 侵入式通知：从任意线程无锁地投递到事件循环，在循环线程上回调onNotify()。
+// 对象的生命周期由调用方管理，同一对象在回调之前不能重复投递
+class LoopNotification {
+public:
+    virtual ~LoopNotification() = default;
+    virtual void onNotify() = 0;
+
+    LoopNotification* next = nullptr;
+};
+
+// 基于epoll的事件循环，每个I/O线程拥有一个实例。
+// 内置时间轮，epoll_wait的超时取自最近的定时器
+class EventLoop {
+public:
+    using Task = std::function<void()>;
+
+    // timer_tick_ms为定时器精度
+    explicit EventLoop(uint64_t timer_tick_ms = 10);
+    ~EventLoop();
+
+    // 禁止拷贝和赋值
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // epoll和唤醒fd是否创建成功
+    bool valid() const;
+
+    // 注册/修改/注销fd，handler的生命周期由调用方管理
+    bool add(int fd, uint32_t events, EventHandler* handler);
+    bool modify(int fd, uint32_t events, EventHandler* handler);
+    void remove(int fd);
+
+    // 运行事件循环，直到stop()被调用
+    void run();
+
+    // 停止事件循环（线程安全）
+    void stop();
+
+    // 投递任务到事件循环线程执行（线程安全）
+    void post(Task task);
+
+    // 投递通知（线程安全）：与post()不同，不加锁也不分配内存，适合发送等热路径
+    void notify(LoopNotification* notification);
+
+    // 注册每轮进入epoll_wait之前执行的回调（如批量提交本轮积累的io_uring请求）。
+    // 只能在事件循环线程上调用，回调须在循环停止之前一直有效
+    void addBeforeWait(Task task);
+
+    bool isRunning() const;
+
+    // 当前线程是否为事件循环线程
+    bool isInLoopThread() const;
+
+    // 本循环的定时器，只能在事件循环线程上使用。
+    // 每次epoll_wait返回后先更新时间，timers().now()可作为处理事件时的当前时间
+    TimingWheel& timers() { return timers_; }
+
+private:
+    // 唤醒阻塞在epoll_wait中的循环
+    void wakeup();
+
+    // 执行投递的任务
+    void runPendingTasks();
+
+    // 回调投递的通知
+    void runNotifications();
+
+private:
+    int epoll_fd_;
+    int wakeup_fd_;
+    std::atomic<bool> running_;
+    std::atomic<bool> quit_;
+    std::vector<Task> pending_tasks_;
+    std::vector<Task> before_wait_;  // 只在循环线程上访问
+    std::mutex tasks_mutex_;
+    MpscQueue<LoopNotification> notifications_;
+    std::atomic<std::thread::id> loop_thread_;
+    TimingWheel timers_;
+};
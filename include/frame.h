@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <arpa/inet.h>
+#include "buffer_pool.h"
+
+// 帧格式（网络字节序）：
+//   | length(4) | type(2) | reserved(2) | sequence(4) | payload(length) |
+constexpr size_t kFrameHeaderSize = 12;
+
+// 单帧负载的默认上限，超过视为协议错误
+constexpr uint32_t kMaxFrameLength = 16 * 1024 * 1024;
+
+// 为不完整帧预留空间的下限。帧头声明的长度只是对端的说法，预留量不超过已收到的字节数
+// 与该值中的较大者，随数据到达成倍增长，只发一个帧头无法让连接占用大块内存
+constexpr size_t kPartialReserveMin = 64 * 1024;
+
+// 接收缓冲区超过该容量、剩余数据又不多时换回小缓冲区，大帧处理完后不长期占用内存
+constexpr size_t kDecoderShrinkCapacity = 256 * 1024;
+
+enum class FrameType : uint16_t {
+    Message = 1,   // 客户端发送的消息
+    Response = 2   // 服务器的响应
+};
+
+struct FrameHeader {
+    uint32_t length = 0;     // 负载长度，不含帧头
+    uint16_t type = 0;
+    uint32_t sequence = 0;
+};
+
+// 将帧头编码到out（至少kFrameHeaderSize字节）
+inline void encodeFrameHeader(char* out, const FrameHeader& header) {
+    uint32_t length = htonl(header.length);
+    uint16_t type = htons(header.type);
+    uint16_t reserved = 0;
+    uint32_t sequence = htonl(header.sequence);
+    memcpy(out, &length, 4);
+    memcpy(out + 4, &type, 2);
+    memcpy(out + 6, &reserved, 2);
+    memcpy(out + 8, &sequence, 4);
+}
+
+inline FrameHeader decodeFrameHeader(const char* data) {
+    uint32_t length;
+    uint16_t type;
+    uint32_t sequence;
+    memcpy(&length, data, 4);
+    memcpy(&type, data + 4, 2);
+    memcpy(&sequence, data + 8, 4);
+    FrameHeader header;
+    header.length = ntohl(length);
+    header.type = ntohs(type);
+    header.sequence = ntohl(sequence);
+    return header;
+}
+
+// 追加一个完整帧到out
+void appendFrame(std::string& out, FrameType type, uint32_t sequence, std::string_view payload);
+void appendFrame(ByteBuffer& out, FrameType type, uint32_t sequence, std::string_view payload);
+
+// 帧解析器：在接收缓冲区上原地切出完整帧，回调拿到的payload视图
+// 指向缓冲区内部，只在回调期间有效
+class FrameDecoder {
+public:
+    explicit FrameDecoder(size_t initial_capacity = 4096, uint32_t max_frame_length = kMaxFrameLength);
+
+    // 直接接收模式：recv到prepare()返回的区域后调用commit()，再调用drain()
+    char* prepare(size_t min_size) {
+        buffer_.ensureWritable(min_size);
+        return buffer_.writePtr();
+    }
+    size_t writableBytes() const { return buffer_.writableBytes(); }
+    void commit(size_t len) { buffer_.commit(len); }
+
+    // 解析缓冲区中所有完整帧，协议错误时返回false
+    template <typename F>
+    bool drain(F&& on_frame) {
+        size_t consumed = 0;
+        bool ok = parse(buffer_.readPtr(), buffer_.readableBytes(), on_frame, consumed);
+        buffer_.consume(consumed);
+        if (ok) {
+            shrinkIfOversized();
+            reserveForPartial(buffer_.readPtr(), buffer_.readableBytes());
+        }
+        return ok;
+    }
+
+    // 外部数据（如io_uring提供的缓冲区）：没有残留数据时直接在data上解析，
+    // 只把末尾不完整的帧拷贝进接收缓冲区
+    template <typename F>
+    bool feed(const char* data, size_t len, F&& on_frame) {
+        if (buffer_.readableBytes() > 0) {
+            buffer_.append(data, len);
+            return drain(on_frame);
+        }
+        size_t consumed = 0;
+        if (!parse(data, len, on_frame, consumed)) return false;
+        if (consumed < len) {
+            buffer_.append(data + consumed, len - consumed);
+            reserveForPartial(buffer_.readPtr(), buffer_.readableBytes());
+        }
+        return true;
+    }
+
+    // 缓冲区中尚未构成完整帧的字节数
+    size_t buffered() const { return buffer_.readableBytes(); }
+
+    // 接收缓冲区当前占用的内存
+    size_t capacity() const { return buffer_.capacity(); }
+
+private:
+    template <typename F>
+    bool parse(const char* data, size_t len, F& on_frame, size_t& consumed) {
+        while (len - consumed >= kFrameHeaderSize) {
+            FrameHeader header = decodeFrameHeader(data + consumed);
+            if (header.length > max_frame_length_) return false;
+            size_t frame_size = kFrameHeaderSize + header.length;
+            if (len - consumed < frame_size) break;
+            on_frame(header, std::string_view(data + consumed + kFrameHeaderSize, header.length));
+            consumed += frame_size;
+        }
+        return true;
+    }
+
+    // 已知不完整帧的总长度时按已收到的数据量预留空间：大帧的扩容次数仍是对数级，
+    // 但预留的内存不会远超对端实际发来的字节数
+    void reserveForPartial(const char* data, size_t len) {
+        if (len < kFrameHeaderSize) return;
+        size_t frame_size = kFrameHeaderSize + decodeFrameHeader(data).length;
+        if (frame_size > len) {
+            buffer_.ensureWritable(std::min(frame_size - len, std::max(len, kPartialReserveMin)));
+        }
+    }
+
+    // 大帧处理完后缩回：没有剩余数据时归还缓冲区，下次接收时再申请；剩余的不完整帧
+    // 本身不大时拷贝到小缓冲区。剩余的是另一个大帧时保留，避免反复缩小又扩大
+    void shrinkIfOversized() {
+        if (buffer_.capacity() <= kDecoderShrinkCapacity) return;
+        size_t readable = buffer_.readableBytes();
+        if (readable == 0) {
+            buffer_.release();
+            return;
+        }
+        size_t needed = readable < kFrameHeaderSize
+            ? readable : kFrameHeaderSize + decodeFrameHeader(buffer_.readPtr()).length;
+        if (needed > kDecoderShrinkCapacity / 4) return;
+        ByteBuffer smaller(readable);
+        smaller.append(buffer_.readPtr(), readable);
+        buffer_.swap(smaller);
+    }
+
+    ByteBuffer buffer_;
+    uint32_t max_frame_length_;
+};
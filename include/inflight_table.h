@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 在途请求表：以请求id（帧序号）为键的开放寻址哈希表，线性探测，删除时把后续元素前移，
+// 不留墓碑。序号在连接上单调递增，直接取低位作为槽位，同时在途的请求落在连续的槽上，
+// 几乎没有冲突，查找通常只访问一个槽。负载因子超过1/2时容量翻倍。只在单个线程上使用
+template <typename T>
+class InflightTable {
+public:
+    // initial_capacity会向上取整为2的幂
+    explicit InflightTable(size_t initial_capacity = 64)
+        : size_(0) {
+        size_t capacity = 8;
+        while (capacity < initial_capacity) capacity *= 2;
+        slots_.resize(capacity);
+        mask_ = capacity - 1;
+    }
+
+    // 禁止拷贝和赋值
+    InflightTable(const InflightTable&) = delete;
+    InflightTable& operator=(const InflightTable&) = delete;
+
+    // 插入id，value不能为空；id已存在时返回false
+    bool insert(uint32_t id, T* value) {
+        if ((size_ + 1) * 2 > slots_.size()) grow();
+        size_t i = indexOf(id);
+        while (slots_[i].value != nullptr) {
+            if (slots_[i].id == id) return false;
+            i = (i + 1) & mask_;
+        }
+        slots_[i].id = id;
+        slots_[i].value = value;
+        ++size_;
+        return true;
+    }
+
+    // 查找id，不存在返回nullptr
+    T* find(uint32_t id) const {
+        size_t i = indexOf(id);
+        while (slots_[i].value != nullptr) {
+            if (slots_[i].id == id) return slots_[i].value;
+            i = (i + 1) & mask_;
+        }
+        return nullptr;
+    }
+
+    // 删除id并返回对应的值，不存在返回nullptr
+    T* take(uint32_t id) {
+        size_t i = indexOf(id);
+        while (slots_[i].id != id || slots_[i].value == nullptr) {
+            if (slots_[i].value == nullptr) return nullptr;
+            i = (i + 1) & mask_;
+        }
+        T* value = slots_[i].value;
+
+        // 后移删除：空出的槽之后探测链上的元素，若其起始槽不在(i, j]之间就前移填补
+        size_t j = i;
+        while (true) {
+            j = (j + 1) & mask_;
+            if (slots_[j].value == nullptr) break;
+            size_t home = indexOf(slots_[j].id);
+            if (((j - home) & mask_) >= ((j - i) & mask_)) {
+                slots_[i] = slots_[j];
+                i = j;
+            }
+        }
+        slots_[i].value = nullptr;
+        --size_;
+        return value;
+    }
+
+    // 对所有值调用f后清空，f中不能修改本表
+    template <typename F>
+    void drain(F&& f) {
+        if (size_ == 0) return;
+        for (Slot& slot : slots_) {
+            if (slot.value != nullptr) {
+                T* value = slot.value;
+                slot.value = nullptr;
+                f(value);
+            }
+        }
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return slots_.size(); }
+
+private:
+    struct Slot {
+        uint32_t id = 0;
+        T* value = nullptr;  // 为空表示空槽
+    };
+
+    size_t indexOf(uint32_t id) const { return id & mask_; }
+
+    void grow() {
+        std::vector<Slot> old;
+        old.swap(slots_);
+        slots_.resize(old.size() * 2);
+        mask_ = slots_.size() - 1;
+        size_ = 0;
+        for (const Slot& slot : old) {
+            if (slot.value != nullptr) insert(slot.id, slot.value);
+        }
+    }
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    size_t size_;
+};
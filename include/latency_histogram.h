@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// HDR风格的延迟直方图：值域按2的幂分段，每段再线性细分为sub_bucket_count个桶，
+// 任意值的记录误差不超过10^-significant_digits，内存与记录的样本数无关。
+// 桶计数为原子变量，record()无锁，可以在多个事件循环线程上并发调用
+class LatencyHistogram {
+public:
+    // 可记录[1, highest_value]内的值，超出上限的按上限计数（max()仍是真实值）；
+    // significant_digits取1到5
+    explicit LatencyHistogram(uint64_t highest_value = 60000000, int significant_digits = 3);
+
+    // 禁止拷贝和赋值
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    // 记录一个值
+    void record(uint64_t value);
+
+    // 记录一个值，并为闭环测量中被延迟挡住的请求补记样本：值超过expected_interval时，
+    // 依次补记value - interval、value - 2*interval……直到不超过interval。
+    // 开环发送按计划时间计算延迟时不需要补记
+    void recordCorrected(uint64_t value, uint64_t expected_interval);
+
+    // 把other的计数累加进来，两者的配置须相同
+    void merge(const LatencyHistogram& other);
+
+    void reset();
+
+    uint64_t count() const { return total_.load(std::memory_order_relaxed); }
+    uint64_t min() const;
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    double mean() const;
+
+    // 至少percentile%的样本不超过的值（取所在桶的上界，不超过max()），percentile取0到100
+    uint64_t valueAtPercentile(double percentile) const;
+
+private:
+    size_t indexOf(uint64_t value) const;
+    uint64_t valueOf(size_t index) const;            // 桶的下界
+    uint64_t highestEquivalent(uint64_t value) const; // 与value同桶的最大值
+
+private:
+    uint64_t highest_value_;
+    int sub_bucket_half_count_magnitude_;
+    uint64_t sub_bucket_half_count_;
+    uint64_t sub_bucket_mask_;
+    size_t counts_length_;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+    std::atomic<uint64_t> total_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> min_;
+    std::atomic<uint64_t> max_{0};
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "output_queue.h"
+#include "tcp_client.h"
+
+class ClientPool;
+
+// 负载大小分布：若干个区间按权重随机选取，区间内均匀取值
+struct PayloadSizes {
+    struct Range {
+        size_t min;
+        size_t max;
+        uint32_t weight;
+    };
+
+    std::vector<Range> ranges{{64, 64, 1}};
+
+    // 按分布取一个大小
+    size_t next(std::mt19937_64& rng) const;
+
+    // 分布中的最大值
+    size_t maxSize() const;
+};
+
+// 解析负载大小分布，逗号分隔的若干项"最小[-最大][:权重]"，例如"256"、"64-1024"、
+// "64:90,4096:10"。格式错误返回false
+bool parsePayloadSizes(std::string_view spec, PayloadSizes& sizes);
+
+// 开环压测配置
+struct LoadConfig {
+    std::string host = "127.0.0.1";
+    int port = 8888;
+    size_t connections = 10;
+    double rate = 1000;                // 目标总速率（条/秒），按计划时间发送，不受响应快慢影响
+    uint64_t duration_ms = 10000;      // 测量时长
+    uint64_t ramp_up_ms = 0;           // 在这段时间内均匀地建立连接，0表示同时建立
+    size_t sender_threads = 1;         // 发送线程数，各自负责一部分连接和速率
+    uint64_t timeout_ms = kDefaultCallTimeoutMs;  // 单个请求的超时
+    PayloadSizes payload;
+    OutputConfig output;
+};
+
+// 一组延迟的分位数（微秒）。超时和断开的请求按失败时的耗时计入分位数，
+// 未能发出的请求没有耗时，只在旁边列出数量
+struct LatencySummary {
+    uint64_t count = 0;
+    uint64_t failed = 0;       // count中超时或断开的请求数
+    uint64_t rejected = 0;     // 未能发出、不在分位数中的请求数
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+    double mean = 0;
+};
+
+// 压测结果
+struct LoadReport {
+    size_t connected = 0;      // 测量开始时可用的连接数
+    uint64_t sent = 0;         // 已发出的请求数
+    uint64_t completed = 0;    // 收到响应的请求数
+    uint64_t failed = 0;       // 超时、断开或测量结束时仍未完成的请求数
+    uint64_t timed_out = 0;    // 其中超时的请求数
+    uint64_t rejected = 0;     // 没有可用连接或积压超过高水位而未能发出的请求数
+    uint64_t bytes = 0;        // 已发出请求的负载字节数
+    double elapsed_s = 0;      // 实际测量时长
+    double throughput = 0;     // 每秒完成的请求数
+    double max_lag_ms = 0;     // 发送线程落后于计划的最大时间，过大说明压测端本身是瓶颈
+    LatencySummary latency;    // 从计划发送时间算起，已校正协调遗漏，含失败的请求
+    LatencySummary service;    // 从实际发出时间算起，未校正，与上者对比可看出排队的影响
+};
+
+// 按配置建立连接并开环压测：第i个请求计划在start + i/rate发出，发送线程落后时立即补发，
+// 延迟从计划时间而不是实际发出时间算起，服务器变慢时排队的时间也计入延迟
+// （避免协调遗漏）。没有可用连接时返回false
+bool runLoad(ClientPool& pool, const LoadConfig& config, LoadReport& report);
+
+// 压测配置和结果的JSON表示，用于比较不同版本
+std::string loadReportJson(const LoadConfig& config, const LoadReport& report);
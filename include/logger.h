@@ -0,0 +1,252 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// 编译期日志级别：低于该级别的日志语句连同参数求值一起被编译器移除。
+// 由CMake的LOG_MIN_LEVEL选项设置，0=DEBUG 1=INFO 2=WARN 3=ERROR
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 1
+#endif
+
+enum class LogLevel : uint8_t {
+    Debug = 0,
+    Info = 1,
+    Warn = 2,
+    Error = 3
+};
+
+constexpr LogLevel kCompiledLogLevel = static_cast<LogLevel>(LOG_MIN_LEVEL);
+
+const char* logLevelName(LogLevel level);
+
+// 单生产者单消费者的字节环：每个写日志的线程独占一个，由后台线程消费。
+// 记录在环中连续存放，尾部放不下时写入填充标记后回绕到头部
+class LogRing {
+public:
+    explicit LogRing(size_t capacity);
+
+    // 生产者：预留size字节的连续空间，空间不足返回nullptr
+    char* reserve(size_t size);
+    void publish() { tail_.store(pending_tail_, std::memory_order_release); }
+
+    // 消费者：取出下一条记录，没有记录返回nullptr
+    const char* peek(size_t& size);
+    void pop() { head_.store(head_.load(std::memory_order_relaxed) + peek_entry_, std::memory_order_release); }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    // 线程退出后标记，后台线程消费完剩余记录再释放
+    std::atomic<bool> retired{false};
+    // 因环满被丢弃的记录数
+    std::atomic<uint64_t> dropped{0};
+    // 所属线程的编号，输出时用于区分线程
+    uint32_t thread_index = 0;
+
+private:
+    std::unique_ptr<char[]> data_;
+    size_t capacity_;
+    size_t mask_;
+    // 生产者和消费者各自写的游标放在不同缓存行上
+    alignas(64) std::atomic<size_t> head_{0};   // 消费者读位置
+    size_t peek_entry_ = 0;                      // peek到的记录占用的字节数
+    alignas(64) size_t pending_tail_ = 0;        // reserve后待publish的位置
+    std::atomic<size_t> tail_{0};               // 生产者写位置
+};
+
+// 参数的二进制编码：生产者只拷贝参数的原始字节，格式化在后台线程完成
+namespace logdetail {
+
+enum class ArgType : uint8_t {
+    Bool,
+    Char,
+    Int,
+    UInt,
+    Double,
+    String,
+    Pointer
+};
+
+// 记录头：长度不含记录头本身
+struct RecordHeader {
+    const char* format;
+    uint64_t timestamp_ns;
+    uint32_t payload_size;
+    LogLevel level;
+    uint8_t arg_count;
+};
+
+template <typename T>
+constexpr ArgType argType() {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, bool>) return ArgType::Bool;
+    else if constexpr (std::is_same_v<D, char>) return ArgType::Char;
+    else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>) return ArgType::Int;
+    else if constexpr (std::is_integral_v<D>) return ArgType::UInt;
+    else if constexpr (std::is_floating_point_v<D>) return ArgType::Double;
+    else if constexpr (std::is_same_v<D, const char*> || std::is_same_v<D, char*> ||
+                       std::is_convertible_v<const D&, std::string_view>) return ArgType::String;
+    else if constexpr (std::is_pointer_v<D>) return ArgType::Pointer;
+    else static_assert(sizeof(D) == 0, "不支持的日志参数类型");
+}
+
+template <typename T>
+std::string_view asString(const T& value) {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_array_v<T>) {
+        // 字符数组（如字符串字面量）不可能为空指针，不做检查
+        return std::string_view(value);
+    } else if constexpr (std::is_same_v<D, const char*> || std::is_same_v<D, char*>) {
+        return value ? std::string_view(value) : std::string_view("(null)");
+    } else {
+        return std::string_view(value);
+    }
+}
+
+template <typename T>
+size_t encodedSize(const T& value) {
+    constexpr ArgType type = argType<T>();
+    if constexpr (type == ArgType::String) {
+        return 1 + sizeof(uint32_t) + asString(value).size();
+    } else if constexpr (type == ArgType::Bool || type == ArgType::Char) {
+        return 2;
+    } else {
+        return 1 + 8;
+    }
+}
+
+template <typename T>
+char* encode(char* out, const T& value) {
+    constexpr ArgType type = argType<T>();
+    *out++ = static_cast<char>(type);
+    if constexpr (type == ArgType::String) {
+        std::string_view str = asString(value);
+        uint32_t len = static_cast<uint32_t>(str.size());
+        memcpy(out, &len, sizeof(len));
+        memcpy(out + sizeof(len), str.data(), len);
+        return out + sizeof(len) + len;
+    } else if constexpr (type == ArgType::Bool || type == ArgType::Char) {
+        *out = static_cast<char>(value);
+        return out + 1;
+    } else {
+        uint64_t bits;
+        if constexpr (type == ArgType::Int) {
+            int64_t v = static_cast<int64_t>(value);
+            memcpy(&bits, &v, 8);
+        } else if constexpr (type == ArgType::UInt) {
+            bits = static_cast<uint64_t>(value);
+        } else if constexpr (type == ArgType::Double) {
+            double v = static_cast<double>(value);
+            memcpy(&bits, &v, 8);
+        } else {
+            bits = reinterpret_cast<uint64_t>(value);
+        }
+        memcpy(out, &bits, 8);
+        return out + 8;
+    }
+}
+
+// 把一条记录解码并按格式串中的{}占位符格式化，追加到out
+void formatRecord(const RecordHeader& header, const char* payload, std::string& out);
+
+uint64_t nowNanoseconds();
+
+}  // namespace logdetail
+
+// 异步日志：每个线程写自己的无锁环，后台线程统一格式化并输出。
+// 写日志只做一次时间戳读取和参数拷贝，不加锁、不做系统调用
+class Logger {
+public:
+    // 输出回调：收到一行完整日志（含换行符）
+    using Sink = std::function<void(LogLevel level, std::string_view line)>;
+
+    static Logger& instance();
+
+    // format必须是字符串字面量，后台线程格式化时仍会访问它
+    template <size_t N, typename... Args>
+    void log(LogLevel level, const char (&format)[N], const Args&... args) {
+        static_assert(sizeof...(Args) < 256, "日志参数过多");
+        LogRing* ring = threadRing();
+        size_t payload_size = (size_t(0) + ... + logdetail::encodedSize(args));
+        size_t record_size = sizeof(logdetail::RecordHeader) + payload_size;
+        char* out = ring->reserve(record_size);
+        if (out == nullptr) {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        logdetail::RecordHeader header;
+        header.format = format;
+        header.timestamp_ns = logdetail::nowNanoseconds();
+        header.payload_size = static_cast<uint32_t>(payload_size);
+        header.level = level;
+        header.arg_count = static_cast<uint8_t>(sizeof...(Args));
+        memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+        ((out = logdetail::encode(out, args)), ...);
+        ring->publish();
+    }
+
+    // 替换输出目标，传入空回调恢复默认输出（INFO及以下到stdout，其余到stderr）
+    void setSink(Sink sink);
+
+    // 之后新注册线程的环大小（字节，向上取整为2的幂）
+    void setRingCapacity(size_t capacity);
+
+    // 阻塞直到调用前写入的日志全部输出
+    void flush();
+
+    // 至今因环满丢弃的日志条数
+    uint64_t droppedCount() const;
+
+private:
+    Logger();
+    ~Logger() = delete;
+
+    LogRing* threadRing();
+    LogRing* registerThread();
+    void drainLoop();
+    bool drainOnce();
+    void shutdown();
+
+    mutable std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<LogRing>> rings_;
+    std::atomic<size_t> ring_capacity_;
+    std::atomic<uint32_t> next_thread_index_;
+    uint64_t retired_dropped_;
+
+    std::mutex drain_mutex_;    // 消费端串行化：后台线程与flush()
+    Sink sink_;
+    std::string line_;
+    uint64_t reported_dropped_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    bool quit_;
+    std::thread drain_thread_;
+};
+
+#define LOG_AT(level, ...)                                                  \
+    do {                                                                    \
+        if constexpr ((level) >= kCompiledLogLevel) {                       \
+            ::Logger::instance().log((level), __VA_ARGS__);                 \
+        }                                                                   \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::Error, __VA_ARGS__)
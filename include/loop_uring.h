@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include "event_loop.h"
+#include "uring.h"
+
+// 提交到LoopUring的请求完成时的回调，result为CQE的res（负值为-errno）
+class UringCompletion {
+public:
+    virtual ~UringCompletion() = default;
+    virtual void onUringComplete(int result) = 0;
+};
+
+// 事件循环上所有连接共用的io_uring：请求先排入提交队列，每轮事件处理结束、进入epoll_wait
+// 之前以一次io_uring_enter批量提交，不等待完成。ring的fd注册在循环的epoll中，有完成事件时
+// 在循环线程上按user_data回调发起请求的对象。只能在所属循环线程上使用
+class LoopUring : public EventHandler {
+public:
+    // 须在loop的线程上创建，构造时向loop注册ring的fd和提交回调
+    explicit LoopUring(EventLoop& loop, unsigned entries = 1024);
+    ~LoopUring() override;
+
+    // 禁止拷贝和赋值
+    LoopUring(const LoopUring&) = delete;
+    LoopUring& operator=(const LoopUring&) = delete;
+
+    bool valid() const { return valid_; }
+
+    // 取得一个SQE，完成时回调completion。提交队列已满时先提交已有的请求，仍失败返回nullptr。
+    // 请求引用的内存和completion在回调之前都须保持有效
+    struct io_uring_sqe* prepare(UringCompletion* completion);
+
+    // 立即提交已积累的请求。请求引用的fd在提交后才能关闭，否则提交时该fd可能已被复用
+    void submit();
+
+    // 累计调用io_uring_enter的次数
+    uint64_t submitCalls() const { return submit_calls_; }
+
+    void handleEvent(uint32_t events) override;
+
+private:
+
+    EventLoop& loop_;
+    IoUring ring_;
+    bool valid_;
+    unsigned pending_;
+    uint64_t submit_calls_;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string_view>
+#include "buffer_pool.h"
+#include "frame.h"
+#include "mpsc_queue.h"
+#include "output_queue.h"
+#include "work_stealing_pool.h"
+
+// 消息处理函数：在处理线程池上执行，payload只在调用期间有效。
+// 响应负载写入response，返回false表示不回复该消息
+using MessageHandler = std::function<bool(const FrameHeader& header, std::string_view payload,
+                                          ByteBuffer& response)>;
+
+// 调用处理函数：处理函数抛出的异常记录日志后按不回复处理，不会终止所在线程
+bool invokeHandler(const MessageHandler& handler, const FrameHeader& header, std::string_view payload,
+                   ByteBuffer& response);
+
+// 一次异步处理：请求负载拷贝进来，处理后替换为响应负载，经完成队列回到I/O线程
+struct HandlerCall : public PoolAllocated {
+    HandlerCall* next = nullptr;   // 完成队列的链表指针
+    int fd = -1;
+    uint64_t connection_id = 0;    // 区分fd被复用后的新连接
+    uint64_t index = 0;            // 在连接内的请求序号，用于按顺序回复
+    FrameHeader header;
+    ByteBuffer payload;
+    bool reply = false;
+};
+
+// 工作线程向I/O线程回传结果的队列：无锁链表加eventfd唤醒，
+// 只有队列由空变为非空时才写eventfd
+class CompletionQueue {
+public:
+    CompletionQueue();
+    ~CompletionQueue();
+
+    // 禁止拷贝和赋值
+    CompletionQueue(const CompletionQueue&) = delete;
+    CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+    bool valid() const { return event_fd_ != -1; }
+
+    // 可读时表示有结果到达，由I/O线程注册到自己的事件循环
+    int fd() const { return event_fd_; }
+
+    // 工作线程：投递结果并在需要时唤醒I/O线程
+    void push(HandlerCall* call);
+
+    // I/O线程：取出所有结果，按投递顺序组成链表，调用方负责释放
+    HandlerCall* popAll();
+
+private:
+    int event_fd_;
+    MpscQueue<HandlerCall> queue_;
+};
+
+// 消息分发器：由TcpServer创建，所有反应器共享同一个处理线程池
+class MessageDispatcher {
+public:
+    MessageDispatcher(MessageHandler handler, size_t thread_count);
+
+    // 拷贝请求负载后提交到线程池，处理结果投递到queue。任务持有请求，
+    // 线程池停止时丢弃的任务随之释放请求
+    void dispatch(CompletionQueue& queue, int fd, uint64_t connection_id, uint64_t index,
+                  const FrameHeader& header, std::string_view payload);
+
+    // 在调用线程上同步处理，返回是否回复
+    bool handle(const FrameHeader& header, std::string_view payload, ByteBuffer& response) const;
+
+    // 停止线程池，未执行的请求被丢弃
+    void stop() { pool_.stop(); }
+
+    const WorkStealingPool& pool() const { return pool_; }
+
+private:
+    MessageHandler handler_;
+    WorkStealingPool pool_;
+};
+
+// 每个连接的响应排序：线程池上的请求可能乱序完成，按请求顺序追加到发送队列
+class ResponseSequencer {
+public:
+    // 为新请求分配序号
+    uint64_t nextIndex() { return next_index_++; }
+
+    // 接管处理结果，把所有已按序就绪的响应追加到output
+    void complete(HandlerCall* call, OutputQueue& output);
+
+    // 已分发但尚未回复的请求数
+    size_t outstanding() const { return static_cast<size_t>(next_index_ - next_deliver_); }
+
+private:
+    uint64_t next_index_ = 0;
+    uint64_t next_deliver_ = 0;
+    std::map<uint64_t, std::unique_ptr<HandlerCall>> reorder_;  // 提前完成的结果
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 进程内指标：计数器、仪表和按2的幂分桶的延迟直方图。
+// 每个线程首次更新指标时分配一块按缓存行对齐的槽位数组，之后只写自己的槽：
+// 写入是对本线程槽的普通读改写（relaxed的load+store），不使用带锁前缀的原子指令，
+// 也不与其他线程共享缓存行。读取时加锁汇总所有线程的槽以及已退出线程留下的值
+
+// 每个线程的槽位数，所有已注册指标共用；直方图占kHistogramBuckets + 1个槽
+constexpr size_t kMetricSlots = 1024;
+
+// 直方图桶数：上界依次为1、2、4……2^26微秒（约67秒），最后一个桶为+Inf
+constexpr size_t kHistogramBuckets = 28;
+
+namespace metricsdetail {
+
+constexpr uint32_t kInvalidSlot = UINT32_MAX;
+
+struct alignas(64) Shard {
+    std::atomic<uint64_t> slots[kMetricSlots];
+};
+
+// 当前线程的槽位数组，首次使用时登记到注册表
+extern thread_local Shard* tls_shard;
+Shard* registerThread();
+
+// 线程退出时把槽值并入注册表
+void retireThread(Shard* shard);
+
+inline std::atomic<uint64_t>* threadSlots() {
+    Shard* shard = tls_shard;
+    if (shard == nullptr) shard = registerThread();
+    return shard->slots;
+}
+
+// 只有本线程写这个槽，读改写不需要原子指令；读取方可能看到旧值，但不会看到撕裂的值
+inline void add(uint32_t slot, uint64_t n) {
+    std::atomic<uint64_t>& cell = threadSlots()[slot];
+    cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// 值（微秒）所在的桶：桶i收录(2^(i-1), 2^i]
+inline uint32_t histogramBucket(uint64_t value) {
+    if (value <= 1) return 0;
+    uint32_t bucket = static_cast<uint32_t>(64 - __builtin_clzll(value - 1));
+    return bucket < kHistogramBuckets - 1 ? bucket : static_cast<uint32_t>(kHistogramBuckets - 1);
+}
+
+}  // namespace metricsdetail
+
+// 单调递增的计数器。默认构造的对象未注册，操作没有效果
+class Counter {
+public:
+    Counter() = default;
+
+    void inc(uint64_t n = 1) const {
+        if (slot_ != metricsdetail::kInvalidSlot) metricsdetail::add(slot_, n);
+    }
+
+    bool valid() const { return slot_ != metricsdetail::kInvalidSlot; }
+
+private:
+    friend class MetricsRegistry;
+    explicit Counter(uint32_t slot) : slot_(slot) {}
+    uint32_t slot_ = metricsdetail::kInvalidSlot;
+};
+
+// 可增可减的仪表：每个线程记录自己的增量，读取时求和，
+// 所以增加和减少可以发生在不同线程上（如生产者入队、事件循环出队）
+class Gauge {
+public:
+    Gauge() = default;
+
+    void add(int64_t n) const {
+        if (slot_ != metricsdetail::kInvalidSlot) metricsdetail::add(slot_, static_cast<uint64_t>(n));
+    }
+    void sub(int64_t n) const { add(-n); }
+    void inc() const { add(1); }
+    void dec() const { add(-1); }
+
+    bool valid() const { return slot_ != metricsdetail::kInvalidSlot; }
+
+private:
+    friend class MetricsRegistry;
+    explicit Gauge(uint32_t slot) : slot_(slot) {}
+    uint32_t slot_ = metricsdetail::kInvalidSlot;
+};
+
+// 延迟直方图（微秒），桶边界固定为2的幂，记录只是两次槽更新
+class Histogram {
+public:
+    Histogram() = default;
+
+    void record(uint64_t value_us) const {
+        if (slot_ == metricsdetail::kInvalidSlot) return;
+        std::atomic<uint64_t>* slots = metricsdetail::threadSlots() + slot_;
+        std::atomic<uint64_t>& bucket = slots[metricsdetail::histogramBucket(value_us)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic<uint64_t>& sum = slots[kHistogramBuckets];
+        sum.store(sum.load(std::memory_order_relaxed) + value_us, std::memory_order_relaxed);
+    }
+
+    bool valid() const { return slot_ != metricsdetail::kInvalidSlot; }
+
+private:
+    friend class MetricsRegistry;
+    explicit Histogram(uint32_t slot) : slot_(slot) {}
+    uint32_t slot_ = metricsdetail::kInvalidSlot;
+};
+
+// 直方图的汇总值
+struct HistogramSnapshot {
+    uint64_t buckets[kHistogramBuckets] = {};  // 各桶的计数（非累计）
+    uint64_t count = 0;
+    uint64_t sum = 0;
+};
+
+// 指标注册表：进程内唯一，注册加锁，更新无锁，读取时汇总
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance();
+
+    // 注册指标并返回句柄。name须符合Prometheus命名，labels为不带花括号的标签列表，
+    // 如"reason=\"rate\""。同名同标签的指标重复注册时返回同一个句柄；
+    // 类型冲突或槽位用尽时记录错误并返回未注册的句柄
+    Counter counter(std::string_view name, std::string_view help, std::string_view labels = {});
+    Gauge gauge(std::string_view name, std::string_view help, std::string_view labels = {});
+    Histogram histogram(std::string_view name, std::string_view help, std::string_view labels = {});
+
+    // 读取汇总值
+    uint64_t value(const Counter& counter) const;
+    int64_t value(const Gauge& gauge) const;
+    HistogramSnapshot snapshot(const Histogram& histogram) const;
+
+    // 所有指标的Prometheus文本格式
+    std::string prometheusText() const;
+
+private:
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Metric {
+        std::string name;
+        std::string help;
+        std::string labels;
+        Type type;
+        uint32_t slot;
+    };
+
+    MetricsRegistry();
+    ~MetricsRegistry() = delete;
+
+    uint32_t registerMetric(std::string_view name, std::string_view help, std::string_view labels, Type type);
+
+    // 汇总一个槽，调用方持有mutex_
+    uint64_t sumLocked(uint32_t slot) const;
+
+    friend metricsdetail::Shard* metricsdetail::registerThread();
+    friend void metricsdetail::retireThread(metricsdetail::Shard* shard);
+    void addShard(metricsdetail::Shard* shard);
+    void retireShard(metricsdetail::Shard* shard);
+
+    mutable std::mutex mutex_;
+    std::vector<Metric> metrics_;
+    std::unordered_map<std::string, size_t> index_;  // name{labels} -> metrics_下标
+    uint32_t next_slot_;
+    std::vector<metricsdetail::Shard*> shards_;
+    std::unique_ptr<uint64_t[]> retired_;  // 已退出线程的槽值之和
+};
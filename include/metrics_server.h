@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+// 指标管理端点：在本机TCP端口或Unix域socket上以HTTP返回MetricsRegistry的
+// Prometheus文本格式（GET /metrics），GET /trace返回跟踪点的trace-event JSON。
+// 单个后台线程逐个处理请求，只用于本机采集，不在数据路径上
+class MetricsServer {
+public:
+    MetricsServer();
+
+    // 停止服务
+    ~MetricsServer();
+
+    // 禁止拷贝和赋值
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // 在127.0.0.1:port上监听，port为0时由系统分配，失败返回false
+    bool listenTcp(int port);
+
+    // 在Unix域socket上监听，path已存在时先删除，失败返回false
+    bool listenUnix(const std::string& path);
+
+    // 停止后台线程并关闭监听socket
+    void stop();
+
+    // 实际监听的TCP端口，未监听TCP时为0
+    int port() const { return port_; }
+
+private:
+    bool startThread(int fd);
+    void serveLoop();
+    void serveClient(int fd);
+
+private:
+    int listen_fd_;
+    int port_;
+    std::string unix_path_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+
+// 无锁多生产者单消费者队列（侵入式）：T需要有成员 T* next。
+// 生产者用一次CAS把节点压入链表头，消费者一次取走整条链表并反转为提交顺序，
+// 两端都不加锁
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head_(nullptr) {}
+
+    // 禁止拷贝和赋值
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // 压入节点，返回压入前队列是否为空（用于合并唤醒通知）
+    bool push(T* node) {
+        T* head = head_.load(std::memory_order_relaxed);
+        do {
+            node->next = head;
+        } while (!head_.compare_exchange_weak(head, node, std::memory_order_release,
+                                              std::memory_order_relaxed));
+        return head == nullptr;
+    }
+
+    // 取出全部节点，按压入顺序返回链表头；队列为空返回nullptr
+    T* popAll() {
+        T* node = head_.exchange(nullptr, std::memory_order_acquire);
+        T* reversed = nullptr;
+        while (node != nullptr) {
+            T* next = node->next;
+            node->next = reversed;
+            reversed = node;
+            node = next;
+        }
+        return reversed;
+    }
+
+    bool empty() const { return head_.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    std::atomic<T*> head_;
+};
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "tcp_client.h"
+
+// 按时间衰减的延迟均值（peak EWMA）：新样本高于当前值时直接取样本，慢下来的服务器
+// 立即被察觉；低于当前值时按距上次样本的时间加权平滑，权重exp(-dt/decay)。
+// 读取时也按空闲时间衰减，长时间没有样本的服务器逐渐恢复被选中的机会，借此重新探测。
+// 无锁近似更新，多条连接的回调并发写入时可能丢失个别样本，可以在任意线程读取
+class LatencyEwma {
+public:
+    explicit LatencyEwma(uint64_t decay_ms = 5000);
+
+    // 记录一次往返时间
+    void record(uint64_t rtt_us, uint64_t now_ms);
+
+    // now_ms时刻的估计值（微秒）
+    uint64_t valueUs(uint64_t now_ms) const;
+
+private:
+    double decay_ms_;
+    std::atomic<uint64_t> ewma_us_;
+    std::atomic<uint64_t> last_ms_;
+};
+
+// 负载均衡配置
+struct BalancerConfig {
+    uint64_t decay_ms = 5000;            // 延迟均值的衰减时间常数
+    size_t connections_per_server = 1;   // 每个服务器的连接数，单条TCP流跑不满带宽时调大
+};
+
+// 单个服务器的统计
+struct ServerStats {
+    std::string server;        // 配置的"host:port"
+    bool connected = false;    // 至少一条连接可用
+    size_t connections = 0;    // 可用的连接数
+    uint64_t latency_us = 0;   // 当前的延迟估计
+    uint32_t outstanding = 0;  // 在途调用数
+    uint64_t requests = 0;     // 发往该服务器的请求数
+};
+
+// 多服务器客户端：对每个服务器保持connections_per_server条连接（域名异步解析，多地址时
+// happy eyeballs并行连接），连接均匀分布在连接池的各个事件循环上。
+// 不指定键的请求先用power of two choices选择服务器：随机取两个可用的服务器，选延迟估计乘以
+// (在途调用数+1)较小的一个；再选该服务器上积压最少的连接。指定键的请求按键的哈希固定到
+// 一条连接，同一个键的请求保持发送顺序。
+// 断开的连接移出轮转，由TcpClient在后台按退避重新建立，连上后自动回到轮转中
+class MultiServerClient {
+public:
+    // hosts与ports一一对应，数量不一致时多出的部分被忽略
+    MultiServerClient(const std::vector<std::string>& hosts, const std::vector<int>& ports,
+                      const BalancerConfig& config = BalancerConfig());
+    MultiServerClient(ClientPool& pool, const std::vector<std::string>& hosts, const std::vector<int>& ports,
+                      const BalancerConfig& config = BalancerConfig());
+
+    // 停止所有连接
+    ~MultiServerClient();
+
+    // 禁止拷贝和赋值
+    MultiServerClient(const MultiServerClient&) = delete;
+    MultiServerClient& operator=(const MultiServerClient&) = delete;
+
+    // 连接所有服务器，等到任意一个连接成功或连接超时
+    void start();
+
+    // 连接所有服务器，不等待
+    void startAsync();
+
+    // 停止所有连接，返回时不再有回调
+    void stop();
+
+    // 请求/响应调用，发往按延迟选出的服务器；往返时间计入该服务器的延迟估计，
+    // 超时和断开以实际等待的时间计入
+    std::future<CallResult> call(std::string_view request, uint64_t timeout_ms = kDefaultCallTimeoutMs);
+    bool call(std::string_view request, CallCallback callback, uint64_t timeout_ms = kDefaultCallTimeoutMs);
+
+    // 单向发送，同样按延迟选择服务器
+    bool sendAsync(std::string_view data, SendCallback callback);
+    bool send(std::string_view data);
+
+    // 按key的哈希选择连接：连接保持可用时同一个key总是发往同一条连接，请求按发送顺序到达。
+    // 该连接断开期间顺延到下一条可用连接
+    bool sendByKey(std::string_view key, std::string_view data, SendCallback callback);
+    std::future<CallResult> callByKey(std::string_view key, std::string_view request,
+                                      uint64_t timeout_ms = kDefaultCallTimeoutMs);
+    bool callByKey(std::string_view key, std::string_view request, CallCallback callback,
+                   uint64_t timeout_ms = kDefaultCallTimeoutMs);
+
+    // 设置连接状态回调，参数为配置的"host:port"和是否连接
+    void setConnectionCallback(std::function<void(const std::string& server, bool connected)> callback);
+
+    // 设置所有连接的消息回调
+    void setMessageCallback(MessageCallback callback);
+
+    // 设置所有连接的连接超时与重连退避，下次连接时生效
+    void setReconnectConfig(const ReconnectConfig& config);
+
+    size_t serverCount() const { return servers_.size(); }
+
+    // 至少有一条可用连接的服务器数
+    size_t connectedCount() const;
+
+    // 所有服务器上可用的连接总数
+    size_t connectionCount() const;
+
+    bool isConnected() const { return connectedCount() > 0; }
+
+    // 各服务器的当前统计
+    std::vector<ServerStats> stats() const;
+
+private:
+    struct Member;
+
+    struct Server {
+        Server(const std::string& host, int port, uint64_t decay_ms)
+            : name(host + ":" + std::to_string(port))
+            , host(host)
+            , port(port)
+            , latency(decay_ms) {
+        }
+
+        bool connected() const;
+
+        std::string name;
+        std::string host;
+        int port;
+        std::vector<std::unique_ptr<Member>> members;
+        LatencyEwma latency;
+        std::atomic<uint32_t> outstanding{0};
+        std::atomic<uint64_t> requests{0};
+        size_t members_up = 0;  // mutex_保护
+    };
+
+    // 到某个服务器的一条连接
+    struct Member {
+        Member(ClientPool& pool, Server* server)
+            : server(server)
+            , client(pool, server->host, server->port) {
+        }
+
+        Server* server;
+        TcpClient client;
+        std::atomic<uint32_t> outstanding{0};  // 在途调用数
+        bool up = false;                        // mutex_保护，最近一次回调的连接状态
+    };
+
+    // power of two choices选择服务器，再选其上积压最少的连接；没有可用连接时返回nullptr
+    Member* pick();
+
+    // 按key的哈希选择连接
+    Member* pickByKey(std::string_view key);
+
+    // 经member发出调用，往返时间计入所属服务器的延迟估计
+    bool callOn(Member* member, std::string_view request, CallCallback callback, uint64_t timeout_ms);
+
+    // 经member发出单向消息
+    bool sendOn(Member* member, std::string_view data, SendCallback callback);
+
+    // 连接状态变化，在连接池的回调线程上调用
+    void onMemberConnection(Member* member, bool up);
+
+private:
+    std::vector<std::unique_ptr<Server>> servers_;
+    std::vector<Member*> members_;  // 所有服务器的连接，按服务器顺序排列，按键分片时使用
+    std::function<void(const std::string&, bool)> connection_callback_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t members_up_;  // mutex_保护，start()据此等待
+    uint64_t start_timeout_ms_;
+};
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "buffer_pool.h"
+#include "frame.h"
+
+struct iovec;
+
+// 写出策略：在单条消息的延迟与批量写出的吞吐之间取舍。所有策略都开启TCP_NODELAY，
+// 是否合并由发送队列决定，不依赖Nagle算法（它与对端的延迟ACK叠加会使小消息多等几十毫秒）
+enum class WritePolicy {
+    LowLatency,  // 每轮事件处理产生的数据立即写出
+    Throughput,  // 合并写出：积累到coalesce_bytes或首条数据等待coalesce_delay_ms后才写出，
+                 // 写出期间开启TCP_CORK只发满MSS的报文，队列排空时解除cork推出尾部
+    Adaptive     // 按写出时观察到的积压切换：积压达到adaptive_threshold_bytes时转为合并写出，
+                 // 合并期间积压降到阈值的四分之一以下时回到低延迟
+};
+
+// 批量发送、零拷贝与写出策略配置
+struct OutputConfig {
+    size_t max_batch_bytes = 1024 * 1024;  // 单次sendmsg最多发送的字节数
+    int max_batch_iovecs = 64;             // 单次sendmsg最多携带的iovec数
+    size_t zerocopy_threshold = 0;         // 不小于该值的数据块使用MSG_ZEROCOPY，0表示关闭
+    WritePolicy write_policy = WritePolicy::LowLatency;
+    size_t coalesce_bytes = 64 * 1024;     // 合并写出时积累到该字节数立即写出
+    uint32_t coalesce_delay_ms = 2;        // 合并写出时首条数据最多等待的时间，另受定时器精度影响
+    size_t adaptive_threshold_bytes = 16 * 1024;  // 自适应策略转为合并写出的积压字节数
+};
+
+// 开启socket的TCP_NODELAY，失败返回false
+bool enableNoDelay(int fd);
+
+// 解析命令行中的策略名：latency | throughput | adaptive，无法识别时返回false
+bool parseWritePolicy(std::string_view name, WritePolicy& policy);
+
+// 开启socket的SO_ZEROCOPY，内核不支持时返回false
+bool enableZerocopy(int fd);
+
+// 零拷贝完成通知的跟踪：每次带MSG_ZEROCOPY且成功的sendmsg占用一个递增的序号，
+// 内核通过socket错误队列按序号区间通知哪些发送的内存已不再被引用
+class ZerocopyTracker {
+public:
+    // 记录一次成功的零拷贝发送，返回其序号
+    uint32_t onSend() { return next_id_++; }
+
+    // 非阻塞地读取错误队列中的所有通知，返回读到的通知数，出错返回-1
+    int reap(int fd);
+
+    // 序号为id的发送已完成
+    bool completed(uint32_t id) const { return static_cast<int32_t>(id - completed_) < 0; }
+
+    // 所有零拷贝发送都已完成
+    bool idle() const { return completed_ == next_id_; }
+
+    uint64_t sendCount() const { return next_id_; }
+
+    // 内核无法零拷贝、改为拷贝发送的次数（如回环设备）
+    uint64_t copiedCount() const { return copied_; }
+
+private:
+    uint32_t next_id_ = 0;
+    uint32_t completed_ = 0;  // 小于该值的序号都已完成（TCP的通知按序到达）
+    uint64_t copied_ = 0;
+};
+
+// 连接的发送队列：小块数据拷贝合并到尾部缓冲区，大块数据按所有权接管、共享缓冲区按引用
+// 排入，都不拷贝；发送时把多个数据块聚合成一次sendmsg，受字节数和iovec数上限约束。
+// 达到零拷贝阈值的数据块单独以MSG_ZEROCOPY发送，完成通知到达前保留其内存。
+// 文件区间以sendfile直接从页缓存发送，数据不进入用户态。
+// 何时写出由写出策略决定：调用方先问writeDue()，返回false时启动合并定时器，到期后直接flush()
+class ZerocopyLinger;
+
+class OutputQueue {
+public:
+    enum class FlushResult {
+        Done,        // 全部发送完成
+        WouldBlock,  // socket发送缓冲区已满，等待可写
+        Error        // 发送出错，连接应关闭
+    };
+
+    explicit OutputQueue(const OutputConfig& config = OutputConfig());
+    // 销毁时释放仍在等待完成通知的零拷贝数据块，此时socket须已由closeSocket()关闭
+    ~OutputQueue();
+
+    // 禁止拷贝和赋值
+    OutputQueue(const OutputQueue&) = delete;
+    OutputQueue& operator=(const OutputQueue&) = delete;
+
+    // 拷贝追加
+    void append(std::string_view data);
+    void appendFrame(FrameType type, uint32_t sequence, std::string_view payload);
+
+    // 接管payload的内存，不做拷贝
+    void append(ByteBuffer&& data);
+    void appendFrame(FrameType type, uint32_t sequence, ByteBuffer&& payload);
+
+    // 引用共享缓冲区，不拷贝；发送完成前保持一个引用
+    void append(const SharedBuffer& data);
+    void appendFrame(FrameType type, uint32_t sequence, const SharedBuffer& payload);
+
+    // 多段数据作为一个帧的负载，拷贝进尾部缓冲区
+    void appendFrame(FrameType type, uint32_t sequence, const struct iovec* iov, int iovcnt);
+
+    // 文件file_fd从offset开始的len字节，以sendfile发送。接管file_fd的所有权，发送完成或
+    // 队列销毁时关闭；调用方须保证文件在该区间内有数据，否则发送出错
+    void appendFile(int file_fd, uint64_t offset, size_t len);
+    void appendFrameFile(FrameType type, uint32_t sequence, int file_fd, uint64_t offset, size_t len);
+
+    bool empty() const { return pending_bytes_ == 0; }
+    size_t pendingBytes() const { return pending_bytes_; }
+
+    // 同步发送：循环sendmsg直到发完、socket缓冲区满或出错
+    FlushResult flush(int fd);
+
+    // 异步发送（如io_uring）：把队首数据填入iov，返回iovec数；
+    // 填入的数据块在advance()之前不会被修改。队首是文件区间时返回0，需要改用flush()
+    int gather(struct iovec* iov, int max_iov, size_t max_bytes);
+
+    // 确认已发送n字节
+    void advance(size_t n);
+
+    // 按写出策略判断现在是否写出：低延迟模式下有数据即写出；合并模式下积累到coalesce_bytes
+    // 或上次写出因socket缓冲区满而未完成时才写出，否则调用方须在coalesceDelayMs()后调用flush()
+    bool writeDue() const;
+
+    uint32_t coalesceDelayMs() const { return config_.coalesce_delay_ms; }
+
+    // 当前是否处于合并写出模式
+    bool coalescing() const { return coalescing_; }
+
+    // 一次写出的开始与结束：开始时按积压切换自适应模式并同步TCP_CORK，结束时队列已排空则
+    // 解除cork推出尾部。flush()内部自动调用，gather()/advance()的异步路径由调用方在提交
+    // 发送前和发送完成后调用
+    void beginWrite(int fd);
+    void endWrite(int fd);
+
+    // 读取零拷贝完成通知，释放不再被内核引用的数据块；出错返回false
+    bool reapZerocopy(int fd);
+
+    // 是否有已发送但尚未收到完成通知的零拷贝数据，包括只发出一部分、仍在队首的数据块
+    bool zerocopyPending() const;
+
+    // 关闭连接的socket。仍有零拷贝数据未完成时，socket和这些数据块交给后台线程，
+    // 等完成通知到达后再关闭socket、释放内存；超时仍未完成则复位连接，丢弃内核中的待发数据
+    void closeSocket(int fd);
+
+    const ZerocopyTracker& zerocopyTracker() const { return tracker_; }
+
+private:
+    // 数据块：自有缓冲区、共享缓冲区或文件区间三者之一
+    struct Segment {
+        ByteBuffer data;
+        SharedBuffer shared;        // 非空时数据来自共享缓冲区
+        size_t shared_offset = 0;   // 共享缓冲区中已发送的字节数
+        int file_fd = -1;           // 非负时为文件区间，由队列关闭
+        uint64_t file_offset = 0;
+        size_t file_remaining = 0;
+        bool sealed = false;  // 已交给内核或已被gather引用，不能再追加
+        bool zerocopy_sent = false;  // 有部分以零拷贝发出，释放前须等待完成通知
+        uint32_t zerocopy_id = 0;    // 最后一次零拷贝发送的序号
+
+        bool isFile() const { return file_fd >= 0; }
+        const char* readPtr() const {
+            return shared.data() != nullptr ? shared.data() + shared_offset : data.readPtr();
+        }
+        size_t readableBytes() const {
+            if (isFile()) return file_remaining;
+            return shared.data() != nullptr ? shared.size() - shared_offset : data.readableBytes();
+        }
+        void consume(size_t len) {
+            if (shared.data() != nullptr) {
+                shared_offset += len;
+            } else {
+                data.consume(len);
+            }
+        }
+    };
+
+    struct InflightSegment {
+        ByteBuffer data;
+        SharedBuffer shared;
+        uint32_t last_id;     // 该数据块最后一次零拷贝发送的序号
+    };
+
+    // 返回可追加的尾部缓冲区，至少有len字节空间
+    ByteBuffer& tailBuffer(size_t len);
+    void pushSegment(ByteBuffer&& data);
+    void appendHeader(FrameType type, uint32_t sequence, size_t length);
+    void popFront();
+    FlushResult flushSegments(int fd);
+    bool useZerocopy(const Segment& segment) const;
+    void releaseCompleted();
+    template <typename T>
+    static void compact(std::vector<T>& items, size_t& head);
+    void setCork(int fd, bool on);
+
+    friend class ZerocopyLinger;
+
+    OutputConfig config_;
+    std::vector<Segment> segments_;
+    size_t head_;
+    size_t pending_bytes_;
+
+    ZerocopyTracker tracker_;
+    bool zerocopy_enabled_;
+    std::vector<InflightSegment> zerocopy_inflight_;
+    size_t zerocopy_head_;
+
+    bool coalescing_;  // 合并写出模式，Throughput策略下始终为true
+    bool corked_;      // socket当前开启了TCP_CORK
+    bool draining_;    // 上次写出因socket缓冲区满而未完成
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <sys/socket.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// IPv4或IPv6的socket地址
+struct SocketAddress {
+    struct sockaddr_storage storage {};
+    socklen_t length = 0;
+
+    int family() const { return storage.ss_family; }
+    const struct sockaddr* get() const { return reinterpret_cast<const struct sockaddr*>(&storage); }
+    int port() const;
+    void setPort(int port);
+
+    // "127.0.0.1:80"或"[::1]:80"
+    std::string toString() const;
+
+    // 解析数字形式的IPv4/IPv6地址，不访问DNS
+    static bool parse(const std::string& ip, int port, SocketAddress& address);
+};
+
+// 解析缓存配置。getaddrinfo不返回记录的TTL，这里的ttl_ms作为缓存时间的上限，
+// 应不大于域名记录的TTL
+struct ResolverConfig {
+    uint64_t ttl_ms = 30000;           // 解析成功的缓存时间
+    uint64_t negative_ttl_ms = 1000;   // 解析失败的缓存时间，避免失败的域名反复查询
+    size_t max_entries = 1024;         // 缓存条目上限，超过时先清理过期条目
+    size_t max_threads = 4;            // 并发执行getaddrinfo的解析线程数上限，按需创建
+};
+
+// 解析完成的回调，addresses为空表示解析失败。地址按RFC 8305交替排列地址族
+// （如IPv6、IPv4、IPv6……），端口已填好
+using ResolveCallback = std::function<void(const std::vector<SocketAddress>& addresses)>;
+
+// 异步域名解析：getaddrinfo是阻塞的，放到后台解析线程上执行，结果按TTL缓存。
+// 数字地址和未过期的缓存不经过解析线程，直接在调用线程上回调；
+// 同一主机名的并发查询合并为一次getaddrinfo，不同主机名由最多max_threads个线程并发解析，
+// 一个响应缓慢的域名不会拖住其他域名的解析
+class Resolver {
+public:
+    explicit Resolver(const ResolverConfig& config = ResolverConfig());
+
+    // 停止所有解析线程，尚未完成的查询以失败回调
+    ~Resolver();
+
+    // 禁止拷贝和赋值
+    Resolver(const Resolver&) = delete;
+    Resolver& operator=(const Resolver&) = delete;
+
+    // 进程内共享的解析器，有意不析构
+    static Resolver& defaultResolver();
+
+    // 解析host，回调可能在调用线程上同步执行，也可能在解析线程上执行
+    void resolve(const std::string& host, int port, ResolveCallback callback);
+
+    // 清空缓存
+    void clear();
+
+    // 实际调用getaddrinfo的次数
+    uint64_t lookupCount() const;
+
+private:
+    struct Waiter {
+        int port;
+        ResolveCallback callback;
+    };
+
+    struct Entry {
+        std::vector<SocketAddress> addresses;  // 端口为0
+        uint64_t expires_ms = 0;
+        bool resolving = false;
+        std::vector<Waiter> waiters;
+    };
+
+    // 解析线程：逐个取出待解析的主机名调用getaddrinfo
+    void workerLoop();
+
+    // 按地址族交替排列并去重
+    static std::vector<SocketAddress> lookup(const std::string& host);
+
+    // 复制地址列表并填入端口
+    static std::vector<SocketAddress> withPort(const std::vector<SocketAddress>& addresses, int port);
+
+    // 缓存过大时清理过期条目，调用方持有锁
+    void evictLocked(uint64_t now);
+
+private:
+    ResolverConfig config_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<std::string, Entry> cache_;
+    std::deque<std::string> pending_;   // 待解析的主机名，各不相同
+    std::vector<std::thread> workers_;
+    size_t idle_workers_;               // 正在等待新主机名的解析线程数
+    bool stopping_;
+    uint64_t lookups_;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include "metrics.h"
+#include "output_queue.h"
+#include "timing_wheel.h"
+
+class MessageDispatcher;
+class AdmissionController;
+
+// 所有反应器共享的配置与组件，由TcpServer创建，生命周期长于所有反应器
+struct ReactorContext {
+    OutputConfig output;                       // 响应的批量发送与零拷贝配置
+    MessageDispatcher* dispatcher = nullptr;   // 非空时消息交给处理线程池，为空时在反应器线程上调用processMessage
+    AdmissionController* admission = nullptr;  // 连接准入控制，不能为空
+    TimeoutConfig timeouts;                    // 连接的空闲与读写超时
+};
+
+// 服务器数据路径的指标，所有反应器和线程模式共用
+struct ServerMetrics {
+    Counter bytes_received;   // 从客户端读取的字节数
+    Counter bytes_sent;       // 写入socket的字节数
+    Counter frames_received;  // 收到的完整帧数
+    Counter send_stalls;      // socket发送缓冲区满而暂停写出的次数
+};
+
+// 首次调用时注册到MetricsRegistry
+const ServerMetrics& serverMetrics();
+
+// 服务器反应器接口：每个实例运行在独立线程上，拥有自己的监听socket
+class ServerReactor {
+public:
+    virtual ~ServerReactor() = default;
+
+    // 初始化事件源并开始监听，失败返回false
+    virtual bool init() = 0;
+
+    // 运行事件循环，直到stop()被调用
+    virtual void run() = 0;
+
+    // 停止事件循环（线程安全）
+    virtual void stop() = 0;
+};
+
+// 创建基于epoll边缘触发的反应器，接管listen_fd的所有权
+std::unique_ptr<ServerReactor> createEpollReactor(int listen_fd, const ReactorContext& context);
+
+// 创建基于io_uring的反应器，接管listen_fd的所有权
+std::unique_ptr<ServerReactor> createUringReactor(int listen_fd, const ReactorContext& context);
+
+// 未设置消息处理函数时所有I/O引擎共享的默认处理：每收到一个完整帧，将响应帧追加到output
+void processMessage(const FrameHeader& header, std::string_view payload, OutputQueue& output);
@@ -1,56 +1,192 @@
 #pragma once
 
 #include <string>
-#include <thread>
+#include <string_view>
+#include <vector>
 #include <functional>
-#include <mutex>
-#include <atomic>
+#include <future>
+#include <cstdint>
+#include "uring.h"
+#include "output_queue.h"
+#include "frame.h"
+#include "resolver.h"
 
+// 异步发送的完成回调，参数表示数据是否已全部写入socket。在连接所属的事件循环线程上调用
+using SendCallback = std::function<void(bool)>;
+
+// 收到服务器消息的回调，在连接所属的事件循环线程上调用。payload指向接收缓冲区内部，
+// 只在回调期间有效，需要保留时由调用方拷贝
+using MessageCallback = std::function<void(const FrameHeader& header, std::string_view payload)>;
+
+// 请求/响应调用的结果状态
+enum class CallStatus {
+    Ok,            // 收到响应
+    Rejected,      // 未连接或发送队列超过高水位，请求没有发出
+    Disconnected,  // 收到响应之前连接断开或客户端停止
+    Timeout        // 截止时间内没有收到响应
+};
+
+struct CallResult {
+    CallStatus status = CallStatus::Rejected;
+    std::string payload;  // 响应负载，status为Ok时有效
+
+    bool ok() const { return status == CallStatus::Ok; }
+};
+
+// 调用完成的回调，在事件循环线程上执行。payload指向接收缓冲区内部，只在回调期间有效
+using CallCallback = std::function<void(CallStatus status, std::string_view payload)>;
+
+// 调用的默认超时
+constexpr uint64_t kDefaultCallTimeoutMs = 5000;
+
+// 发送队列积压字节数的默认高水位
+constexpr size_t kDefaultSendHighWatermark = 8 * 1024 * 1024;
+
+// 连接与重连配置。连接断开或失败后按带上限的指数退避重连，每次的等待时间在
+// [0, min(max_backoff_ms, initial_backoff_ms * 2^连续失败次数)]内均匀随机（full jitter），
+// 大量客户端同时断开时重连被打散，不会同时涌向刚恢复的服务器
+struct ReconnectConfig {
+    uint64_t connect_timeout_ms = 5000;   // 一轮连接（含域名解析和所有地址的尝试）的超时
+    uint64_t attempt_delay_ms = 250;      // 服务器有多个地址时，发起下一个地址前等待上一个的时间
+    uint64_t initial_backoff_ms = 100;    // 退避基数，断开后首次重连的等待上限
+    uint64_t max_backoff_ms = 30000;      // 退避上限
+};
+
+// 第failures次连续失败后的重连等待时间（毫秒），按上述规则随机取值
+uint64_t reconnectBackoffMs(const ReconnectConfig& config, uint32_t failures);
+
+// 连接状态。状态只由连接所属的事件循环线程改变，任意线程都可以无锁读取
+enum class ConnectionState {
+    Stopped,     // 未启动或已停止
+    Connecting,  // 正在解析地址或建立连接
+    Connected,   // 已连接，可以发送
+    Draining,    // 连接断开或正在停止：关闭socket，未完成的请求以失败结束
+    Backoff      // 连接失败或断开后等待退避时间，到期后重新连接
+};
+
+// 状态名，用于日志
+const char* connectionStateName(ConnectionState state);
+
+// 状态变化回调，参数为变化前后的状态
+using StateCallback = std::function<void(ConnectionState previous, ConnectionState state)>;
+
+class ClientPool;
+
+// 客户端句柄：连接由ClientPool中的一个事件循环驱动，非阻塞地连接、发送和定时重连，
+// 句柄本身不持有线程。发送完成回调和消息回调在该事件循环线程上执行；状态变化按发生顺序
+// 投递到连接池的回调线程，在不持有任何锁的情况下回调。
+// 服务器有多个地址时按happy eyeballs（RFC 8305）错开并行连接，保留最先成功的一个
 class TcpClient {
 public:
-    TcpClient(const std::string& ip, int port);
+    // 使用进程内默认的连接池。host可以是IP地址或域名，域名在每次连接前经
+    // Resolver::defaultResolver()异步解析（结果有缓存）
+    TcpClient(const std::string& host, int port);
+
+    // 使用指定的连接池，pool须比客户端存活更久
+    TcpClient(ClientPool& pool, const std::string& host, int port);
+
+    // 直接给出服务器的候选地址，按顺序错开连接，不做域名解析
+    TcpClient(ClientPool& pool, const std::vector<SocketAddress>& addresses);
     ~TcpClient();
 
     // 禁止拷贝和赋值
     TcpClient(const TcpClient&) = delete;
     TcpClient& operator=(const TcpClient&) = delete;
 
-    // 启动客户端
+    // 启动客户端并等待首次连接的结果，失败时在后台定时重连
     void start();
 
-    // 停止客户端
+    // 启动客户端但不等待首次连接，用于一次启动大量连接
+    void startAsync();
+
+    // 停止客户端：关闭连接，未发出的请求以失败完成，返回时不再有回调。
+    // 在状态回调中调用时，停止产生的状态回调在当前回调返回后送达；在事件循环线程上
+    // （如发送完成回调中）调用时不等待回调线程
     void stop();
 
-    // 发送数据
-    bool send(const std::string& data);
+    // 异步发送：数据拷贝进无锁发送队列后立即返回，由事件循环批量写入socket，
+    // 调用方从不阻塞在socket上。未连接或积压超过高水位时返回的future立即为false
+    std::future<bool> sendAsync(std::string_view data);
 
-    // 设置连接状态回调
+    // 同上，完成时在事件循环线程上调用callback；被拒绝时返回false且不调用callback
+    bool sendAsync(std::string_view data, SendCallback callback);
+
+    // 同步发送：经同一发送队列，等待数据写入socket后返回，不受高水位限制
+    bool send(std::string_view data);
+
+    // 多段数据（如帧头加正文）作为一条消息发送：入队时一次性拼接进池化缓冲区，
+    // 不经过中间的std::string。返回后iov指向的内存即可复用
+    bool sendAsync(const struct iovec* iov, int iovcnt, SendCallback callback);
+    bool send(const struct iovec* iov, int iovcnt);
+
+    // 发送共享缓冲区：只增加引用计数，数据不拷贝，写入socket后释放引用。
+    // 同一缓冲区可以同时发给多个客户端
+    bool sendAsync(const SharedBuffer& data, SendCallback callback);
+    bool send(const SharedBuffer& data);
+
+    // 把文件fd从offset开始的len字节作为一条消息发送，数据由sendfile从页缓存直接写入socket，
+    // 不经过用户态。fd须为普通文件，区间须在文件范围内且不超过单帧上限；fd被复制，
+    // 返回后调用方即可关闭。发送期间文件内容不能被截短
+    bool sendFile(int fd, uint64_t offset, size_t len, SendCallback callback);
+    bool sendFile(int fd, uint64_t offset, size_t len);
+
+    // 批量发送多条消息：全部入队后等待发送完成，事件循环把所有帧聚合为尽量少的sendmsg调用
+    bool sendBatch(const std::vector<std::string>& messages);
+
+    // 请求/响应调用：请求帧的序号作为请求id，服务器以相同序号回复，响应由接收路径
+    // 在在途表中匹配后完成。同一连接上可以流水线地发出任意多个调用，不为在途调用占用线程。
+    // timeout_ms为0表示不设截止时间。匹配上的响应不再交给消息回调
+    std::future<CallResult> call(std::string_view request, uint64_t timeout_ms = kDefaultCallTimeoutMs);
+
+    // 同上，完成时在事件循环线程上回调；被拒绝时返回false且不调用callback
+    bool call(std::string_view request, CallCallback callback, uint64_t timeout_ms = kDefaultCallTimeoutMs);
+
+    // 设置发送队列的高水位（字节，含帧头），积压超过后异步发送被拒绝
+    void setSendHighWatermark(size_t bytes);
+
+    // 已入队但尚未写入socket的字节数
+    size_t queuedBytes() const;
+
+    // 设置批量发送、零拷贝与写出策略配置，下次连接时生效。延迟敏感的控制流量用
+    // WritePolicy::LowLatency（默认），大批量数据流用Throughput或Adaptive
+    void setOutputConfig(const OutputConfig& config);
+
+    // 设置连接超时与重连退避，下次连接时生效
+    void setReconnectConfig(const ReconnectConfig& config);
+
+    // 设置连接状态回调：连上时为true，连接断开或停止时为false。在回调线程上执行
     void setConnectionCallback(std::function<void(bool)> callback);
 
-    // 检查客户端状态
+    // 设置状态变化回调，每次状态变化回调一次。在回调线程上执行，同一连接按变化顺序回调
+    void setStateCallback(StateCallback callback);
+
+    // 设置消息回调，未设置时收到的消息被丢弃。回调中可以调用sendAsync()，
+    // 但不能调用会等待事件循环的send()/sendBatch()
+    void setMessageCallback(MessageCallback callback);
+
+    // 选择发送使用的I/O后端，io_uring不可用时回退到epoll，返回实际使用的后端。
+    // io_uring后端下同一事件循环上的连接共用一个ring，发送异步提交、在循环中完成。
+    // 在下次建立连接时生效
+    IoBackend setIoBackend(IoBackend backend);
+
+    // 检查客户端状态，都不加锁，可以在发送热路径上频繁调用
     bool isRunning() const;
     bool isConnected() const;
+    ConnectionState state() const;
 
-private:
-    // 连接到服务器
-    bool connect();
+    // 当前连接的服务器地址，未连接时为空
+    std::string remoteAddress() const;
 
-    // 重连线程函数
-    void reconnectThread();
+private:
+    struct SendRequest;
+    class Connection;
 
-    // 关闭socket
-    void closeSocket();
+    // 同步发送：等待请求完成，超时返回false
+    bool waitRequest(SendRequest* request);
 
-    // 通知连接状态变化
-    void notifyConnectionChange(bool connected);
+    // 检查文件区间并创建持有fd副本的请求，失败返回nullptr
+    static SendRequest* newFileRequest(int fd, uint64_t offset, size_t len);
 
 private:
-    std::string server_ip_;
-    int server_port_;
-    int sock_fd_;
-    std::atomic<bool> running_;
-    bool connected_;
-    std::thread reconnect_thread_;
-    std::function<void(bool)> connection_callback_;
-    mutable std::mutex mutex_;
-}; 
\ No newline at end of file
+    Connection* conn_;  // 池中的连接，句柄与事件循环各持有引用，最后释放的一方回收
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_set>
+#include <condition_variable>
+#include "output_queue.h"
+#include "message_dispatcher.h"
+#include "admission_control.h"
+#include "timing_wheel.h"
+
+class ServerReactor;
+
+// 服务器I/O引擎
+enum class ServerEngine {
+    Epoll,                // 非阻塞epoll边缘触发事件循环（默认）
+    IoUring,              // io_uring多重accept/recv，内核不支持时自动回退到epoll
+    ThreadPerConnection   // 旧模式：每个连接一个阻塞线程，用于对比测试
+};
+
+struct ServerConfig {
+    int port = 8888;                           // 监听端口，0表示由系统分配
+    ServerEngine engine = ServerEngine::Epoll;
+    int reactor_count = 0;                     // 反应器线程数，0表示每个CPU核心一个
+    OutputConfig output;                       // 响应的批量发送与零拷贝配置
+    int handler_threads = 0;                   // 消息处理线程数，0表示每个CPU核心一个
+    AdmissionConfig admission;                 // 连接准入与过载保护
+    TimeoutConfig timeouts;                    // 连接的空闲与读写超时
+};
+
+class TcpServer {
+public:
+    explicit TcpServer(int port);
+    explicit TcpServer(const ServerConfig& config);
+    ~TcpServer();
+
+    // 禁止拷贝和赋值
+    TcpServer(const TcpServer&) = delete;
+    TcpServer& operator=(const TcpServer&) = delete;
+
+    // 设置消息处理函数，须在start()之前调用。epoll/io_uring引擎下处理函数在
+    // 独立的工作窃取线程池上执行，不阻塞I/O线程；同一连接的响应按请求顺序发送。
+    // 每连接线程模式下在连接线程上直接执行。未设置时回复固定的确认消息
+    void setMessageHandler(MessageHandler handler);
+
+    // 启动服务器（非阻塞），监听成功返回true
+    bool start();
+
+    // 停止服务器，关闭所有连接
+    void stop();
+
+    // 阻塞等待服务器停止
+    void wait();
+
+    // 检查服务器状态
+    bool isRunning() const;
+
+    // 实际监听的端口（配置为0时由系统分配）
+    int port() const;
+
+    // 实际使用的I/O引擎（io_uring不可用时为Epoll）
+    ServerEngine engine() const;
+
+    // 反应器线程数
+    int reactorCount() const;
+
+    // 连接准入统计：接受数、按原因分类的拒绝数和当前连接数
+    AdmissionStats admissionStats() const;
+
+private:
+    // 创建并监听服务器socket，失败返回-1
+    int createListenSocket(int port, bool reuse_port);
+
+    // 创建所有反应器及其监听socket并启动线程
+    bool startReactors();
+
+    // 旧模式：阻塞accept循环
+    void acceptLoop();
+
+    // 旧模式：处理单个客户端
+    void handleClient(int client_socket);
+
+    // 旧模式：清理已结束的客户端线程
+    void cleanupFinishedThreads();
+
+private:
+    ServerConfig config_;
+    int server_fd_;
+    int bound_port_;
+    ServerEngine engine_;
+    std::atomic<bool> running_;
+    MessageHandler handler_;
+    std::unique_ptr<AdmissionController> admission_;
+
+    // epoll/io_uring模式下设置了处理函数时的处理线程池，所有反应器共享
+    std::unique_ptr<MessageDispatcher> dispatcher_;
+
+    // epoll/io_uring模式：每个反应器一个线程
+    std::vector<std::unique_ptr<ServerReactor>> reactors_;
+    std::vector<std::thread> reactor_threads_;
+
+    // 每连接线程模式
+    struct ClientThread {
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+    std::thread accept_thread_;
+    std::vector<std::unique_ptr<ClientThread>> client_threads_;
+    std::unordered_set<int> client_sockets_;
+    std::mutex clients_mutex_;
+
+    std::mutex state_mutex_;
+    std::condition_variable state_cv_;
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class Timer;
+class TimingWheel;
+
+// 定时器到期回调接口，由持有定时器的对象实现
+class TimerHandler {
+public:
+    virtual ~TimerHandler() = default;
+    virtual void onTimer(Timer& timer) = 0;
+};
+
+// 时间轮槽位的双向循环链表节点，每个槽位有一个哨兵节点
+struct TimerNode {
+    TimerNode* prev = nullptr;
+    TimerNode* next = nullptr;
+};
+
+// 侵入式定时器：嵌入在连接等对象中，由TimingWheel链接到槽位，自身不分配内存。
+// 定时器析构时自动从时间轮中取消
+class Timer : private TimerNode {
+public:
+    explicit Timer(TimerHandler* handler = nullptr) : handler_(handler) {}
+    ~Timer() { cancel(); }
+
+    // 禁止拷贝和赋值：时间轮持有其地址
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    void setHandler(TimerHandler* handler) { handler_ = handler; }
+
+    bool armed() const { return next != nullptr; }
+
+    // 到期的绝对时间（毫秒，单调时钟），仅在armed()时有意义
+    uint64_t deadline() const { return deadline_ms_; }
+
+    // 从时间轮中移除，O(1)；未启动时无操作
+    void cancel();
+
+private:
+    friend class TimingWheel;
+
+    TimerHandler* handler_;
+    TimingWheel* wheel_ = nullptr;
+    uint64_t expires_ = 0;        // 到期的tick
+    uint64_t deadline_ms_ = 0;
+    int16_t level_ = -1;          // 所在层级，-1表示在到期处理的临时链表中
+    uint16_t slot_ = 0;
+};
+
+// 分层哈希时间轮：4层、每层64个槽，最低层每槽一个tick，每升一层槽跨度乘64。
+// 启动/取消都是O(1)的链表操作；推进时只处理非空槽，高层槽在低层转完一圈时
+// 向下迁移。到期时间超出最高层范围时先放在最高层，迁移时重新计算。
+// 不是线程安全的：只在所属事件循环线程上使用
+class TimingWheel {
+public:
+    static constexpr int kLevels = 4;
+    static constexpr int kSlotBits = 6;
+    static constexpr int kSlots = 1 << kSlotBits;
+
+    // tick_ms为时间精度，定时器最多晚一个tick到期，不会提前
+    explicit TimingWheel(uint64_t tick_ms = 10, uint64_t now_ms = monotonicMilliseconds());
+    ~TimingWheel();
+
+    // 禁止拷贝和赋值
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    // 启动或重新启动定时器，delay_ms后到期，以最近一次advance()的时间为起点
+    void schedule(Timer& timer, uint64_t delay_ms);
+
+    // 推进到now_ms并执行所有到期定时器的回调，返回执行的个数。
+    // 回调中可以启动或取消任意定时器，包括自己
+    size_t advance(uint64_t now_ms);
+
+    // 只更新当前时间，不执行到期回调。事件循环在处理I/O前调用，
+    // 使处理过程中启动的定时器以实际时间为起点
+    void setNow(uint64_t now_ms) { now_ms_ = now_ms > now_ms_ ? now_ms : now_ms_; }
+
+    // 距离下一次需要调用advance()的毫秒数，没有定时器时返回-1。
+    // 只有高层定时器时返回下一次向下迁移的时间
+    int nextTimeoutMs(uint64_t now_ms) const;
+
+    // 最近一次advance()或setNow()的时间，事件循环中可用作当前时间，省去一次时钟读取
+    uint64_t now() const { return now_ms_; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    static uint64_t monotonicMilliseconds();
+
+private:
+    friend class Timer;
+
+    void insert(Timer& timer);
+    void remove(Timer& timer);
+    void cascade(int level, size_t index);
+    size_t expireSlot(size_t index);
+    TimerNode& slot(int level, size_t index) { return slots_[level * kSlots + index]; }
+
+    uint64_t tick_ms_;
+    uint64_t now_ms_;
+    uint64_t current_;                       // 下一个待处理的tick
+    size_t size_;
+    uint64_t occupied_[kLevels];             // 各层非空槽的位图
+    TimerNode slots_[kLevels * kSlots];      // 各槽位的哨兵节点
+};
+
+// 服务器连接的超时配置，0表示不限制
+struct TimeoutConfig {
+    int idle_timeout_ms = 0;    // 连接上没有任何收发超过该时间后关闭
+    int read_timeout_ms = 0;    // 收到帧的首个字节后须在该时间内收齐整帧，防御慢速发送（slow-loris）
+    int write_timeout_ms = 0;   // 有待发送数据时超过该时间没有任何发送进展则关闭，防御不读取响应的客户端
+    int tick_ms = 10;           // 定时器精度
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// 跟踪点：以TSC时间戳把定长二进制记录写入每个线程的环形缓冲区，
+// 按需导出为Chrome/Perfetto的trace-event JSON，在chrome://tracing或ui.perfetto.dev中
+// 按线程和按连接查看时间线。
+// 由CMake的ENABLE_TRACE选项定义TCP_TRACE，未定义时TRACE_*宏展开为空，参数不求值
+
+// 每个线程的环形缓冲区记录数，写满后覆盖最旧的记录
+constexpr size_t kTraceRingSize = 16384;
+
+// 保留的已退出线程的缓冲区数，超出时释放最早退出的
+constexpr size_t kTraceRetainedRings = 64;
+
+enum class TracePhase : uint8_t {
+    Begin,       // 线程上的区间开始（B）
+    End,         // 线程上的区间结束（E）
+    Instant,     // 瞬时事件（i）
+    AsyncBegin,  // 按id关联的跨回调区间开始（b），每个id在查看器中单独一行
+    AsyncEnd     // 按id关联的跨回调区间结束（e）
+};
+
+// 定长记录。name必须指向静态存储期的字符串（通常是字面量），只保存指针
+struct TraceRecord {
+    uint64_t ticks;    // TSC计数，不支持时为单调时钟纳秒
+    uint64_t id;       // 连接等对象的编号，0表示无
+    const char* name;
+    TracePhase phase;
+};
+
+namespace tracedetail {
+
+struct alignas(64) TraceRing {
+    std::atomic<uint64_t> next{0};   // 已写入的记录总数，只有所属线程写
+    std::atomic<uint64_t> start{0};  // clearTrace()时的next，导出时跳过之前的记录
+    uint32_t tid = 0;
+    TraceRecord records[kTraceRingSize];
+};
+
+extern thread_local TraceRing* tls_ring;
+TraceRing* registerThread();
+
+inline uint64_t readTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline void record(TracePhase phase, const char* name, uint64_t id) {
+    TraceRing* ring = tls_ring;
+    if (ring == nullptr) ring = registerThread();
+    uint64_t index = ring->next.load(std::memory_order_relaxed);
+    TraceRecord& slot = ring->records[index & (kTraceRingSize - 1)];
+    slot.ticks = readTicks();
+    slot.id = id;
+    slot.name = name;
+    slot.phase = phase;
+    ring->next.store(index + 1, std::memory_order_release);
+}
+
+// 线程上的区间，析构时结束
+class TraceScope {
+public:
+    TraceScope(const char* name, uint64_t id) : name_(name), id_(id) {
+        record(TracePhase::Begin, name_, id_);
+    }
+    ~TraceScope() { record(TracePhase::End, name_, id_); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t id_;
+};
+
+}  // namespace tracedetail
+
+// 为连接等对象分配跟踪编号，从1开始
+uint64_t traceNextId();
+
+// 把所有线程（含已退出且仍保留的线程）缓冲区中的记录转换为trace-event JSON。
+// 导出时写线程可能正在覆盖最旧的记录，需要精确结果时应在静止时导出
+std::string traceEventsJson();
+
+// 写入文件，失败返回false
+bool dumpTrace(const std::string& path);
+
+// 清空所有缓冲区中的记录
+void clearTrace();
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef TCP_TRACE
+#define TRACE_SCOPE(name, id) tracedetail::TraceScope TRACE_CONCAT(trace_scope_, __LINE__)((name), (id))
+#define TRACE_INSTANT(name, id) tracedetail::record(TracePhase::Instant, (name), (id))
+#define TRACE_ASYNC_BEGIN(name, id) tracedetail::record(TracePhase::AsyncBegin, (name), (id))
+#define TRACE_ASYNC_END(name, id) tracedetail::record(TracePhase::AsyncEnd, (name), (id))
+#else
+#define TRACE_SCOPE(name, id) ((void)0)
+#define TRACE_INSTANT(name, id) ((void)0)
+#define TRACE_ASYNC_BEGIN(name, id) ((void)0)
+#define TRACE_ASYNC_END(name, id) ((void)0)
+#endif
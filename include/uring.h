@@ -0,0 +1,114 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// I/O后端选择：io_uring不可用时自动回退到epoll
+enum class IoBackend {
+    Epoll,
+    IoUring
+};
+
+// 基于原始系统调用的io_uring封装（不依赖liburing），仅供单线程使用
+class IoUring {
+public:
+    explicit IoUring(unsigned entries = 256);
+    ~IoUring();
+
+    // 禁止拷贝和赋值
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // 当前内核是否支持本项目用到的全部特性
+    // （多重accept、多重recv、提供缓冲区环），结果会被缓存
+    static bool supported();
+
+    bool valid() const;
+
+    int fd() const { return ring_fd_; }
+
+    // 通过IORING_REGISTER_PROBE检查操作码是否可用
+    bool supportsOp(int opcode) const;
+
+    // 获取一个空闲SQE，提交队列已满时返回nullptr
+    struct io_uring_sqe* getSqe();
+
+    // 提交所有已准备的SQE，不等待完成
+    int submit();
+
+    // 提交所有已准备的SQE，并等待至少wait_nr个完成事件
+    int submitAndWait(unsigned wait_nr);
+
+    // 遍历所有已完成的CQE并推进完成队列头，返回处理数量
+    template <typename F>
+    unsigned forEachCqe(F&& f) {
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        unsigned count = 0;
+        while (head != tail) {
+            f(&cqes_[head & cq_mask_]);
+            ++head;
+            ++count;
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    // 注册提供缓冲区环（IORING_REGISTER_PBUF_RING），entries必须是2的幂；
+    // 缓冲区环不可用时回退到IORING_OP_PROVIDE_BUFFERS
+    bool setupBufferRing(uint16_t group_id, unsigned entries, unsigned buffer_size);
+
+    // 多重recv能否在当前提供的缓冲区上工作（自检）
+    bool recvSelfTest();
+
+    // 按缓冲区ID取得缓冲区地址
+    char* buffer(uint16_t buffer_id) const;
+
+    // 将用完的缓冲区归还给内核
+    void recycleBuffer(uint16_t buffer_id);
+
+private:
+    // 将本地SQ尾指针发布给内核，返回待提交数量
+    unsigned flushSq();
+
+    int enter(unsigned to_submit, unsigned wait_nr, unsigned flags);
+
+    // 注册缓冲区环并交出全部缓冲区
+    bool registerBufferRing();
+
+    // 当前内核的缓冲区环是否真正可用，结果会被缓存
+    static bool bufferRingUsable();
+
+private:
+    int ring_fd_;
+
+    // 提交队列
+    void* sq_ptr_;
+    size_t sq_ring_size_;
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned sq_mask_;
+    unsigned sq_entries_;
+    struct io_uring_sqe* sqes_;
+    size_t sqes_size_;
+    unsigned sqe_tail_;     // 本地已分配的SQE尾
+    unsigned sqe_flushed_;  // 已发布给内核的SQE尾
+
+    // 完成队列
+    void* cq_ptr_;
+    size_t cq_ring_size_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned cq_mask_;
+    struct io_uring_cqe* cqes_;
+
+    // 提供缓冲区（buf_ring_为空表示使用PROVIDE_BUFFERS回退模式）
+    struct io_uring_buf_ring* buf_ring_;
+    size_t buf_ring_size_;
+    char* buf_base_;
+    uint16_t buf_group_;
+    unsigned buf_entries_;
+    unsigned buf_size_;
+};
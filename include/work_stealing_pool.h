@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 固定线程数的工作窃取线程池：每个工作线程有自己的任务双端队列，
+// 外部线程提交的任务轮流分配到各队列，工作线程自己的队列空了就从其他队列窃取。
+// 任务之间没有顺序保证
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    // thread_count为0时每个CPU核心一个线程
+    explicit WorkStealingPool(size_t thread_count = 0);
+    ~WorkStealingPool();
+
+    // 禁止拷贝和赋值
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // 提交任务（线程安全）。在工作线程内提交的任务进入该线程自己的队列
+    void submit(Task task);
+
+    // 停止所有工作线程，尚未执行的任务被丢弃
+    void stop();
+
+    size_t threadCount() const { return workers_.size(); }
+
+    // 被其他线程窃取执行的任务数
+    uint64_t stolenCount() const { return stolen_.load(std::memory_order_relaxed); }
+
+private:
+    // 每个工作线程的队列放在独立的缓存行上
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void workerLoop(size_t index);
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t thief, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> next_worker_;   // 外部提交的轮转位置
+    std::atomic<size_t> pending_;       // 已提交未取走的任务数
+    std::atomic<size_t> idle_;          // 正在休眠的工作线程数
+    std::atomic<uint64_t> stolen_;
+    std::atomic<bool> quit_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+};
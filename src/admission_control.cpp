@@ -0,0 +1,249 @@
+#include "admission_control.h"
+#include "metrics.h"
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// 源IP令牌桶的分片数
+constexpr size_t kSourceShardCount = 16;
+
+// 每个分片最多跟踪的源IP数，超出时淘汰最久未使用的令牌桶
+constexpr size_t kMaxSourcesPerShard = 4096;
+
+// 准入指标，所有控制器共用
+struct AdmissionMetrics {
+    AdmissionMetrics() {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        const char* rejected_help = "按原因统计的被拒绝连接数";
+        accepted = registry.counter("tcp_server_connections_accepted_total", "通过准入控制的连接数");
+        rejected_max_connections = registry.counter("tcp_server_connections_rejected_total", rejected_help,
+                                                    "reason=\"max_connections\"");
+        rejected_global_rate = registry.counter("tcp_server_connections_rejected_total", rejected_help,
+                                                "reason=\"global_rate\"");
+        rejected_source_rate = registry.counter("tcp_server_connections_rejected_total", rejected_help,
+                                                "reason=\"source_rate\"");
+        rejected_fd_exhausted = registry.counter("tcp_server_connections_rejected_total", rejected_help,
+                                                 "reason=\"fd_exhausted\"");
+        active = registry.gauge("tcp_server_active_connections", "当前活跃的连接数");
+    }
+
+    Counter accepted;
+    Counter rejected_max_connections;
+    Counter rejected_global_rate;
+    Counter rejected_source_rate;
+    Counter rejected_fd_exhausted;
+    Gauge active;
+};
+
+const AdmissionMetrics& admissionMetrics() {
+    static const AdmissionMetrics metrics;
+    return metrics;
+}
+
+uint64_t steadyNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+TokenBucket::TokenBucket(double rate, double burst, uint64_t now_ns)
+    : rate_(rate)
+    , burst_(std::max(burst, 1.0))
+    , tokens_(burst_)
+    , last_ns_(now_ns) {
+}
+
+bool TokenBucket::tryTake(uint64_t now_ns) {
+    if (now_ns > last_ns_) {
+        tokens_ = std::min(burst_, tokens_ + rate_ * (now_ns - last_ns_) / 1e9);
+        last_ns_ = now_ns;
+    }
+    if (tokens_ < 1.0) return false;
+    tokens_ -= 1.0;
+    return true;
+}
+
+void TokenBucket::refund() {
+    tokens_ = std::min(burst_, tokens_ + 1.0);
+}
+
+bool TokenBucket::full(uint64_t now_ns) const {
+    double elapsed = now_ns > last_ns_ ? (now_ns - last_ns_) / 1e9 : 0;
+    return tokens_ + rate_ * elapsed >= burst_;
+}
+
+AdmissionController::AdmissionController(const AdmissionConfig& config)
+    : config_(config)
+    , active_(0)
+    , accepted_(0)
+    , rejected_max_connections_(0)
+    , rejected_global_rate_(0)
+    , rejected_source_rate_(0)
+    , rejected_fd_exhausted_(0) {
+    if (config_.accept_rate > 0) {
+        // 令牌桶初始即为满的，起始时间取0不影响限速
+        double burst = config_.accept_burst > 0 ? config_.accept_burst : config_.accept_rate;
+        global_bucket_ = std::make_unique<TokenBucket>(config_.accept_rate, burst, 0);
+    }
+    if (config_.source_accept_rate > 0) {
+        source_shards_ = std::make_unique<SourceShard[]>(kSourceShardCount);
+    }
+    admissionMetrics();
+}
+
+AdmissionResult AdmissionController::admit(uint32_t source_ip) {
+    return admit(source_ip, steadyNanoseconds());
+}
+
+AdmissionResult AdmissionController::admit(uint32_t source_ip, uint64_t now_ns) {
+    if (config_.max_connections > 0 &&
+        active_.fetch_add(1, std::memory_order_relaxed) >= config_.max_connections) {
+        active_.fetch_sub(1, std::memory_order_relaxed);
+        rejected_max_connections_.fetch_add(1, std::memory_order_relaxed);
+        admissionMetrics().rejected_max_connections.inc();
+        return AdmissionResult::TooManyConnections;
+    }
+
+    AdmissionResult result = AdmissionResult::Accepted;
+    if (!takeGlobal(now_ns)) {
+        result = AdmissionResult::GlobalRateLimited;
+        rejected_global_rate_.fetch_add(1, std::memory_order_relaxed);
+        admissionMetrics().rejected_global_rate.inc();
+    } else if (!takeSource(source_ip, now_ns)) {
+        // 被源IP拒绝的连接不占全局速率，否则单个源IP的洪泛会挤占其他源的全局配额
+        refundGlobal();
+        result = AdmissionResult::SourceRateLimited;
+        rejected_source_rate_.fetch_add(1, std::memory_order_relaxed);
+        admissionMetrics().rejected_source_rate.inc();
+    }
+
+    if (result != AdmissionResult::Accepted) {
+        if (config_.max_connections > 0) {
+            active_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return result;
+    }
+    if (config_.max_connections == 0) {
+        active_.fetch_add(1, std::memory_order_relaxed);
+    }
+    accepted_.fetch_add(1, std::memory_order_relaxed);
+    admissionMetrics().accepted.inc();
+    admissionMetrics().active.inc();
+    return AdmissionResult::Accepted;
+}
+
+void AdmissionController::release() {
+    active_.fetch_sub(1, std::memory_order_relaxed);
+    admissionMetrics().active.dec();
+}
+
+void AdmissionController::recordFdExhausted() {
+    rejected_fd_exhausted_.fetch_add(1, std::memory_order_relaxed);
+    admissionMetrics().rejected_fd_exhausted.inc();
+}
+
+bool AdmissionController::takeGlobal(uint64_t now_ns) {
+    if (!global_bucket_) return true;
+    std::lock_guard<std::mutex> lock(global_mutex_);
+    return global_bucket_->tryTake(now_ns);
+}
+
+void AdmissionController::refundGlobal() {
+    if (!global_bucket_) return;
+    std::lock_guard<std::mutex> lock(global_mutex_);
+    global_bucket_->refund();
+}
+
+AdmissionController::SourceShard& AdmissionController::sourceShard(uint32_t source_ip) {
+    // 地址是网络字节序，直接取模只看第一个字节的低位，同一网段会全部落到一个分片；
+    // 转为主机字节序后混合所有位再选分片
+    uint32_t hash = ntohl(source_ip);
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3bu;
+    hash ^= hash >> 16;
+    return source_shards_[hash % kSourceShardCount];
+}
+
+bool AdmissionController::takeSource(uint32_t source_ip, uint64_t now_ns) {
+    if (!source_shards_) return true;
+    SourceShard& shard = sourceShard(source_ip);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(source_ip);
+    if (it != shard.index.end()) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return it->second->bucket.tryTake(now_ns);
+    }
+
+    double burst = config_.source_accept_burst > 0 ? config_.source_accept_burst
+                                                   : config_.source_accept_rate;
+    TokenBucket bucket(config_.source_accept_rate, burst, now_ns);
+    if (shard.index.size() >= kMaxSourcesPerShard) {
+        // 复用最久未使用的节点，不分配内存：正在被限速的活跃源总在表头附近，不会被淘汰
+        auto victim = std::prev(shard.lru.end());
+        auto node = shard.index.extract(victim->source_ip);
+        node.key() = source_ip;
+        shard.index.insert(std::move(node));
+        *victim = SourceEntry{source_ip, bucket};
+        shard.lru.splice(shard.lru.begin(), shard.lru, victim);
+    } else {
+        shard.lru.push_front(SourceEntry{source_ip, bucket});
+        shard.index.emplace(source_ip, shard.lru.begin());
+    }
+    return shard.lru.front().bucket.tryTake(now_ns);
+}
+
+AdmissionStats AdmissionController::stats() const {
+    AdmissionStats stats;
+    stats.accepted = accepted_.load(std::memory_order_relaxed);
+    stats.rejected_max_connections = rejected_max_connections_.load(std::memory_order_relaxed);
+    stats.rejected_global_rate = rejected_global_rate_.load(std::memory_order_relaxed);
+    stats.rejected_source_rate = rejected_source_rate_.load(std::memory_order_relaxed);
+    stats.rejected_fd_exhausted = rejected_fd_exhausted_.load(std::memory_order_relaxed);
+    stats.active_connections = active_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+const char* admissionResultName(AdmissionResult result) {
+    switch (result) {
+    case AdmissionResult::Accepted: return "已接受";
+    case AdmissionResult::TooManyConnections: return "连接数已达上限";
+    case AdmissionResult::GlobalRateLimited: return "超出全局连接速率";
+    case AdmissionResult::SourceRateLimited: return "超出源IP连接速率";
+    case AdmissionResult::FdExhausted: return "文件描述符耗尽";
+    }
+    return "未知";
+}
+
+void rejectConnection(int fd) {
+    struct linger lg;
+    lg.l_onoff = 1;
+    lg.l_linger = 0;
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    close(fd);
+}
+
+ReserveFd::ReserveFd()
+    : fd_(open("/dev/null", O_RDONLY | O_CLOEXEC)) {
+}
+
+ReserveFd::~ReserveFd() {
+    if (fd_ != -1) close(fd_);
+}
+
+bool ReserveFd::shedOne(int listen_fd) {
+    if (fd_ == -1) return false;
+    close(fd_);
+    int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd >= 0) {
+        rejectConnection(fd);
+    }
+    fd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    return fd >= 0;
+}
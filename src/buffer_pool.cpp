@@ -0,0 +1,232 @@
+#include "buffer_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+
+namespace {
+
+// 每次向系统申请的slab大小，超过该大小的级别每个slab只含一个块
+constexpr size_t kSlabSize = 256 * 1024;
+// 每个级别的线程本地缓存上限（字节）
+constexpr size_t kThreadCacheBytes = 1024 * 1024;
+// 本地缓存与全局链表之间单次搬运的最大块数
+constexpr size_t kMaxBatch = 64;
+
+// 空闲块的前8字节存放下一个空闲块的指针
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct FreeList {
+    FreeBlock* head = nullptr;
+    size_t count = 0;
+
+    void push(FreeBlock* block) {
+        block->next = head;
+        head = block;
+        ++count;
+    }
+
+    FreeBlock* pop() {
+        FreeBlock* block = head;
+        head = block->next;
+        --count;
+        return block;
+    }
+};
+
+// 全局空闲链表，每个级别一把锁
+struct CentralList {
+    std::mutex mutex;
+    FreeList list;
+};
+
+CentralList gCentral[BufferPool::kClassCount];
+std::atomic<size_t> gSlabBytes(0);
+std::atomic<size_t> gLargeAllocations(0);
+
+size_t cacheLimit(size_t index) {
+    return std::max<size_t>(2, kThreadCacheBytes / BufferPool::classSize(index));
+}
+
+size_t batchSize(size_t index) {
+    return std::min(kMaxBatch, cacheLimit(index) / 2);
+}
+
+// 从全局链表取最多count个块放入out，全局链表为空时切分一个新slab
+void fetchBlocks(size_t index, size_t count, FreeList& out) {
+    CentralList& central = gCentral[index];
+    std::lock_guard<std::mutex> lock(central.mutex);
+    if (central.list.count == 0) {
+        size_t block_size = BufferPool::classSize(index);
+        size_t slab_size = std::max(kSlabSize, block_size);
+        char* slab = static_cast<char*>(::operator new(slab_size));
+        gSlabBytes += slab_size;
+        for (size_t offset = 0; offset + block_size <= slab_size; offset += block_size) {
+            central.list.push(reinterpret_cast<FreeBlock*>(slab + offset));
+        }
+    }
+    while (count-- > 0 && central.list.count > 0) {
+        out.push(central.list.pop());
+    }
+}
+
+// 从in中归还count个块到全局链表
+void releaseBlocks(size_t index, size_t count, FreeList& in) {
+    CentralList& central = gCentral[index];
+    std::lock_guard<std::mutex> lock(central.mutex);
+    while (count-- > 0 && in.count > 0) {
+        central.list.push(in.pop());
+    }
+}
+
+// 线程本地缓存，线程退出时把所有块还给全局链表
+struct ThreadCache {
+    FreeList lists[BufferPool::kClassCount];
+
+    ~ThreadCache() { flush(); }
+
+    void flush() {
+        for (size_t i = 0; i < BufferPool::kClassCount; ++i) {
+            releaseBlocks(i, lists[i].count, lists[i]);
+        }
+    }
+};
+
+thread_local ThreadCache tCache;
+
+}  // namespace
+
+BufferPool& BufferPool::instance() {
+    static BufferPool pool;
+    return pool;
+}
+
+size_t BufferPool::sizeClass(size_t size) {
+    size_t index = 0;
+    size_t block_size = kMinBlockSize;
+    while (block_size < size) {
+        if (++index == kClassCount) return kClassCount;
+        block_size <<= 1;
+    }
+    return index;
+}
+
+void* BufferPool::allocate(size_t size, size_t& capacity) {
+    size_t index = sizeClass(size);
+    if (index == kClassCount) {
+        ++gLargeAllocations;
+        capacity = size;
+        return ::operator new(size);
+    }
+
+    FreeList& list = tCache.lists[index];
+    if (list.count == 0) {
+        fetchBlocks(index, std::max<size_t>(1, batchSize(index)), list);
+    }
+    capacity = classSize(index);
+    return list.pop();
+}
+
+void BufferPool::deallocate(void* ptr, size_t size) {
+    if (ptr == nullptr) return;
+    size_t index = sizeClass(size);
+    if (index == kClassCount) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    FreeList& list = tCache.lists[index];
+    list.push(static_cast<FreeBlock*>(ptr));
+    if (list.count > cacheLimit(index)) {
+        // 本地缓存过多时归还一半，避免内存滞留在空闲线程上
+        releaseBlocks(index, std::max<size_t>(1, batchSize(index)), list);
+    }
+}
+
+BufferPool::Stats BufferPool::stats() const {
+    Stats stats;
+    stats.slab_bytes = gSlabBytes;
+    stats.large_allocations = gLargeAllocations;
+    return stats;
+}
+
+void BufferPool::flushThreadCache() {
+    tCache.flush();
+}
+
+PooledBuffer::PooledBuffer(size_t min_capacity) {
+    data_ = static_cast<char*>(BufferPool::instance().allocate(min_capacity, capacity_));
+}
+
+void PooledBuffer::reset() {
+    if (data_ == nullptr) return;
+    BufferPool::instance().deallocate(data_, capacity_);
+    data_ = nullptr;
+    capacity_ = 0;
+}
+
+ByteBuffer::ByteBuffer(size_t initial_capacity) {
+    if (initial_capacity > 0) {
+        buffer_ = PooledBuffer(initial_capacity);
+    }
+}
+
+void ByteBuffer::consume(size_t len) {
+    read_index_ += len;
+    if (read_index_ == write_index_) {
+        // 数据读完后回到头部，下一次写入可以使用全部空间
+        read_index_ = write_index_ = 0;
+    }
+}
+
+void ByteBuffer::ensureWritable(size_t len) {
+    if (writableBytes() >= len) return;
+
+    size_t readable = readableBytes();
+    if (capacity() - readable >= len) {
+        // 把未读数据挪到头部即可满足
+        memmove(buffer_.data(), readPtr(), readable);
+    } else {
+        PooledBuffer new_buffer(std::max(capacity() * 2, readable + len));
+        if (readable > 0) memcpy(new_buffer.data(), readPtr(), readable);
+        buffer_ = std::move(new_buffer);
+    }
+    read_index_ = 0;
+    write_index_ = readable;
+}
+
+void ByteBuffer::append(const char* data, size_t len) {
+    ensureWritable(len);
+    memcpy(writePtr(), data, len);
+    commit(len);
+}
+
+void ByteBuffer::swap(ByteBuffer& other) noexcept {
+    buffer_.swap(other.buffer_);
+    std::swap(read_index_, other.read_index_);
+    std::swap(write_index_, other.write_index_);
+}
+
+void ByteBuffer::release() {
+    buffer_.reset();
+    read_index_ = write_index_ = 0;
+}
+
+SharedBuffer::SharedBuffer(std::string_view data)
+    : block_(new Block()) {
+    block_->data.append(data);
+}
+
+SharedBuffer::SharedBuffer(ByteBuffer&& data)
+    : block_(new Block()) {
+    block_->data = std::move(data);
+}
+
+void SharedBuffer::reset() {
+    if (block_ != nullptr && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete block_;
+    }
+    block_ = nullptr;
+}
@@ -0,0 +1,83 @@
+#include "client_pool.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <signal.h>
+
+ClientPool::ClientPool(size_t loop_count)
+    : callback_loop_(std::make_unique<EventLoop>())
+    , next_loop_(0) {
+    if (loop_count == 0) {
+        loop_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // 创建失败的循环也保留：其上的连接在注册fd时失败并按连接失败处理
+    for (size_t i = 0; i < loop_count; ++i) {
+        loops_.push_back(std::make_unique<EventLoop>());
+        if (!loops_.back()->valid()) {
+            LOG_ERROR("创建客户端事件循环失败");
+        }
+    }
+    rings_.resize(loops_.size());
+    if (!callback_loop_->valid()) {
+        LOG_ERROR("创建客户端回调循环失败");
+    }
+    for (auto& loop : loops_) {
+        runLoop(loop.get());
+    }
+    runLoop(callback_loop_.get());
+    // 等待所有循环进入运行状态，之后投递的任务和通知都能被及时处理
+    for (auto& loop : loops_) {
+        while (loop->valid() && !loop->isRunning()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    while (callback_loop_->valid() && !callback_loop_->isRunning()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+ClientPool::~ClientPool() {
+    for (auto& loop : loops_) {
+        loop->stop();
+    }
+    callback_loop_->stop();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void ClientPool::runLoop(EventLoop* loop) {
+    if (!loop->valid()) return;
+    threads_.emplace_back([loop] {
+        // sendfile没有MSG_NOSIGNAL，在循环线程上屏蔽SIGPIPE，对端关闭时只返回EPIPE
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &set, nullptr);
+        loop->run();
+    });
+}
+
+ClientPool& ClientPool::defaultPool() {
+    static ClientPool* pool = new ClientPool(1);
+    return *pool;
+}
+
+LoopUring* ClientPool::uring(EventLoop& loop) {
+    for (size_t i = 0; i < loops_.size(); ++i) {
+        if (loops_[i].get() != &loop) continue;
+        // 创建失败的ring也保留，之后不再重试
+        if (!rings_[i]) {
+            rings_[i] = std::make_unique<LoopUring>(loop);
+        }
+        return rings_[i]->valid() ? rings_[i].get() : nullptr;
+    }
+    return nullptr;
+}
+
+EventLoop& ClientPool::nextLoop() {
+    size_t index = next_loop_.fetch_add(1, std::memory_order_relaxed);
+    return *loops_[index % loops_.size()];
+}
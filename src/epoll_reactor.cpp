@@ -0,0 +1,361 @@
+#include "server_reactor.h"
+#include "event_loop.h"
+#include "message_dispatcher.h"
+#include "admission_control.h"
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "logger.h"
+#include "trace.h"
+#include <cstring>
+#include <errno.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// 每次recv至少预留的缓冲区空间
+constexpr size_t kRecvBufferSize = 1024;
+
+// epoll边缘触发反应器：每个反应器线程拥有独立的监听socket（SO_REUSEPORT）
+// 和事件循环，连接状态不在线程间共享。监听socket使用水平触发，
+// 每次就绪最多accept一批连接，避免连接风暴时饿死已有连接的读写。
+// 连接的空闲与读写超时由事件循环的时间轮驱动
+class EpollReactor : public ServerReactor, public EventHandler {
+public:
+    EpollReactor(int listen_fd, const ReactorContext& context)
+        : loop_(context.timeouts.tick_ms)
+        , listen_fd_(listen_fd)
+        , output_config_(context.output)
+        , dispatcher_(context.dispatcher)
+        , admission_(*context.admission)
+        , timeouts_(context.timeouts)
+        , completion_handler_(*this)
+        , next_connection_id_(0) {}
+
+    ~EpollReactor() override {
+        for (auto& item : connections_) {
+            item.second->output.closeSocket(item.first);
+            admission_.release();
+        }
+        close(listen_fd_);
+    }
+
+    bool init() override {
+        if (!loop_.valid()) return false;
+        if (dispatcher_ != nullptr &&
+            (!completions_.valid() || !loop_.add(completions_.fd(), EPOLLIN, &completion_handler_))) {
+            return false;
+        }
+        return loop_.add(listen_fd_, EPOLLIN, this);
+    }
+
+    void run() override { loop_.run(); }
+    void stop() override { loop_.stop(); }
+
+    // 监听socket可读：最多accept一批连接，剩余的等下一轮事件循环
+    void handleEvent(uint32_t) override {
+        TRACE_SCOPE("accept", 0);
+        int batch = std::max(admission_.config().accept_batch, 1);
+        for (int i = 0; i < batch; ++i) {
+            struct sockaddr_in client_addr;
+            socklen_t client_len = sizeof(client_addr);
+            int client_socket = accept4(listen_fd_, (struct sockaddr*)&client_addr, &client_len,
+                                        SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (client_socket < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EMFILE || errno == ENFILE) {
+                    // 不取走队首连接的话监听socket会一直可读
+                    admission_.recordFdExhausted();
+                    LOG_WARN("文件描述符耗尽，拒绝新连接");
+                    if (reserve_fd_.shedOne(listen_fd_)) continue;
+                } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    LOG_ERROR("接受连接失败: {}", strerror(errno));
+                }
+                return;
+            }
+
+            AdmissionResult result = admission_.admit(client_addr.sin_addr.s_addr);
+            if (result != AdmissionResult::Accepted) {
+                LOG_DEBUG("拒绝新连接: {}", admissionResultName(result));
+                rejectConnection(client_socket);
+                continue;
+            }
+
+            char client_ip[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &(client_addr.sin_addr), client_ip, INET_ADDRSTRLEN);
+            LOG_INFO("新客户端连接，IP: {}, 端口: {}", client_ip, ntohs(client_addr.sin_port));
+
+            OutputConfig output_config = output_config_;
+            if (output_config.zerocopy_threshold > 0 && !enableZerocopy(client_socket)) {
+                output_config.zerocopy_threshold = 0;
+            }
+            if (!enableNoDelay(client_socket)) {
+                LOG_WARN("设置TCP_NODELAY失败: {}", strerror(errno));
+            }
+            auto conn = std::make_unique<Connection>(*this, client_socket, output_config);
+            conn->id = next_connection_id_++;
+            conn->trace_id = traceNextId();
+            TRACE_INSTANT("accepted", conn->trace_id);
+            if (!loop_.add(client_socket, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, conn.get())) {
+                close(client_socket);
+                admission_.release();
+                continue;
+            }
+            conn->last_activity_ms = loop_.timers().now();
+            if (timeouts_.idle_timeout_ms > 0) {
+                loop_.timers().schedule(conn->idle_timer, timeouts_.idle_timeout_ms);
+            }
+            connections_.emplace(client_socket, std::move(conn));
+        }
+    }
+
+private:
+    // 每个连接的状态
+    // 连接对象和它的缓冲区都来自缓冲区池，关闭后回到池中供新连接复用
+    struct Connection : public EventHandler, public TimerHandler, public PoolAllocated {
+        Connection(EpollReactor& reactor, int fd, const OutputConfig& output_config)
+            : reactor(reactor), fd(fd), output(output_config)
+            , idle_timer(this), read_timer(this), write_timer(this), coalesce_timer(this) {}
+
+        void handleEvent(uint32_t events) override {
+            reactor.onConnectionEvent(this, events);
+        }
+
+        void onTimer(Timer& timer) override {
+            reactor.onConnectionTimer(this, timer);
+        }
+
+        EpollReactor& reactor;
+        int fd;
+        uint64_t id = 0;
+        uint64_t trace_id = 0;        // 跟踪记录中的连接编号，所有反应器间唯一
+        FrameDecoder decoder;         // 接收缓冲区与帧解析
+        OutputQueue output;           // 待发送数据
+        ResponseSequencer sequencer;  // 处理线程池返回结果的排序
+        bool flush_pending = false;   // 已加入本轮完成处理的待发送列表
+        uint64_t last_activity_ms = 0;  // 最近一次收到数据或发送有进展的时间
+        Timer idle_timer;             // 空闲超时，到期时按last_activity_ms惰性续期
+        Timer read_timer;             // 未收齐的帧的截止时间
+        Timer write_timer;            // 积压数据的发送进展截止时间
+        Timer coalesce_timer;         // 合并写出时首条数据的最长等待
+    };
+
+    // 完成队列的eventfd可读：处理线程池返回了结果
+    struct CompletionHandler : public EventHandler {
+        explicit CompletionHandler(EpollReactor& reactor) : reactor(reactor) {}
+        void handleEvent(uint32_t) override { reactor.onCompletions(); }
+        EpollReactor& reactor;
+    };
+
+    void onConnectionEvent(Connection* conn, uint32_t events) {
+        if (events & EPOLLERR) {
+            // 零拷贝完成通知也以EPOLLERR提示：读完通知后socket本身没有错误则继续处理
+            if (!conn->output.zerocopyPending() || !conn->output.reapZerocopy(conn->fd) ||
+                socketError(conn->fd) != 0) {
+                closeConnection(conn);
+                return;
+            }
+        }
+
+        if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) {
+            if (!readAll(conn)) {
+                closeConnection(conn);
+                return;
+            }
+        }
+
+        // 读事件中已经尝试过发送，这里只处理单纯的可写通知；合并写出期间不提前写出
+        if ((events & EPOLLOUT) && conn->output.writeDue() && !flush(conn)) {
+            closeConnection(conn);
+        }
+    }
+
+    void onConnectionTimer(Connection* conn, Timer& timer) {
+        if (&timer == &conn->coalesce_timer) {
+            if (!flush(conn)) closeConnection(conn);
+            return;
+        }
+        uint64_t now = loop_.timers().now();
+        if (&timer == &conn->idle_timer) {
+            // 收发时只更新时间戳，到期时再判断是否真的空闲，避免每次读写都重新启动定时器；
+            // 还有请求在处理线程池中时不算空闲
+            uint64_t idle_ms = now - conn->last_activity_ms;
+            if (idle_ms < static_cast<uint64_t>(timeouts_.idle_timeout_ms) ||
+                conn->sequencer.outstanding() > 0) {
+                uint64_t remaining = conn->sequencer.outstanding() > 0
+                    ? timeouts_.idle_timeout_ms : timeouts_.idle_timeout_ms - idle_ms;
+                loop_.timers().schedule(conn->idle_timer, remaining);
+                return;
+            }
+            LOG_INFO("连接空闲超时，关闭连接");
+        } else if (&timer == &conn->read_timer) {
+            LOG_WARN("未在{}ms内收齐完整帧，关闭连接", timeouts_.read_timeout_ms);
+        } else {
+            LOG_WARN("发送积压数据超时，关闭连接");
+        }
+        closeConnection(conn);
+    }
+
+    // 直接recv到连接的接收缓冲区，读取直到EAGAIN，每次读取后解析出所有完整帧；
+    // 连接需要关闭时返回false
+    bool readAll(Connection* conn) {
+        TRACE_SCOPE("read", conn->trace_id);
+        bool frame_completed = false;
+        auto on_frame = [this, conn, &frame_completed](const FrameHeader& header,
+                                                       std::string_view payload) {
+            frame_completed = true;
+            serverMetrics().frames_received.inc();
+            if (dispatcher_ != nullptr) {
+                dispatcher_->dispatch(completions_, conn->fd, conn->id, conn->sequencer.nextIndex(),
+                                      header, payload);
+            } else {
+                processMessage(header, payload, conn->output);
+            }
+        };
+        while (true) {
+            char* buffer = conn->decoder.prepare(kRecvBufferSize);
+            ssize_t bytes_read = recv(conn->fd, buffer, conn->decoder.writableBytes(), 0);
+            if (bytes_read > 0) {
+                conn->last_activity_ms = loop_.timers().now();
+                conn->decoder.commit(bytes_read);
+                serverMetrics().bytes_received.inc(bytes_read);
+                if (!conn->decoder.drain(on_frame)) {
+                    LOG_WARN("收到非法帧，关闭连接");
+                    return false;
+                }
+                continue;
+            }
+            if (bytes_read == 0) {
+                LOG_INFO("客户端主动断开连接");
+                return false;
+            }
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            LOG_ERROR("接收数据失败: {}", strerror(errno));
+            return false;
+        }
+        updateReadDeadline(conn, frame_completed);
+        return scheduleFlush(conn);
+    }
+
+    // 缓冲区中有未收齐的帧时启动读超时，每收齐一帧重新计时，
+    // 这样持续发送多帧的正常客户端不会因为帧跨越recv边界而被关闭
+    void updateReadDeadline(Connection* conn, bool frame_completed) {
+        if (timeouts_.read_timeout_ms <= 0) return;
+        if (conn->decoder.buffered() == 0) {
+            conn->read_timer.cancel();
+        } else if (frame_completed || !conn->read_timer.armed()) {
+            loop_.timers().schedule(conn->read_timer, timeouts_.read_timeout_ms);
+        }
+    }
+
+    // 按请求顺序把处理结果追加到各连接的发送队列，每个连接只发送一次
+    void onCompletions() {
+        HandlerCall* call = completions_.popAll();
+        while (call != nullptr) {
+            HandlerCall* next = call->next;
+            auto it = connections_.find(call->fd);
+            if (it == connections_.end() || it->second->id != call->connection_id) {
+                // 连接在处理期间已关闭
+                delete call;
+            } else {
+                Connection* conn = it->second.get();
+                conn->sequencer.complete(call, conn->output);
+                if (!conn->flush_pending) {
+                    conn->flush_pending = true;
+                    flush_list_.push_back(conn);
+                }
+            }
+            call = next;
+        }
+
+        for (Connection* conn : flush_list_) {
+            conn->flush_pending = false;
+            if (!scheduleFlush(conn)) {
+                closeConnection(conn);
+            }
+        }
+        flush_list_.clear();
+    }
+
+    // 有新数据排入：写出策略要求立即写出时写出，否则启动合并定时器等待更多数据
+    bool scheduleFlush(Connection* conn) {
+        if (conn->output.writeDue()) return flush(conn);
+        if (!conn->output.empty() && !conn->coalesce_timer.armed()) {
+            loop_.timers().schedule(conn->coalesce_timer, conn->output.coalesceDelayMs());
+        }
+        return true;
+    }
+
+    // 尽可能发送积压数据，socket缓冲区满时等待EPOLLOUT，发送出错时返回false。
+    // 有积压时启动写超时，每次发送有进展重新计时
+    bool flush(Connection* conn) {
+        TRACE_SCOPE("flush", conn->trace_id);
+        conn->coalesce_timer.cancel();
+        size_t pending = conn->output.pendingBytes();
+        OutputQueue::FlushResult result = conn->output.flush(conn->fd);
+        if (result == OutputQueue::FlushResult::Error) {
+            LOG_ERROR("发送响应失败: {}", strerror(errno));
+            return false;
+        }
+        const ServerMetrics& metrics = serverMetrics();
+        metrics.bytes_sent.inc(pending - conn->output.pendingBytes());
+        if (result == OutputQueue::FlushResult::WouldBlock) {
+            metrics.send_stalls.inc();
+            TRACE_INSTANT("send_stall", conn->trace_id);
+        }
+        bool progressed = conn->output.pendingBytes() < pending;
+        if (progressed) {
+            conn->last_activity_ms = loop_.timers().now();
+        }
+        if (timeouts_.write_timeout_ms > 0) {
+            if (conn->output.empty()) {
+                conn->write_timer.cancel();
+            } else if (progressed || !conn->write_timer.armed()) {
+                loop_.timers().schedule(conn->write_timer, timeouts_.write_timeout_ms);
+            }
+        }
+        return true;
+    }
+
+    static int socketError(int fd) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0) return errno;
+        return error;
+    }
+
+    void closeConnection(Connection* conn) {
+        TRACE_INSTANT("close", conn->trace_id);
+        int fd = conn->fd;
+        loop_.remove(fd);
+        // 零拷贝数据未完成时由发送队列延后关闭
+        conn->output.closeSocket(fd);
+        connections_.erase(fd);
+        admission_.release();
+        LOG_INFO("客户端连接已关闭");
+    }
+
+    EventLoop loop_;
+    int listen_fd_;
+    OutputConfig output_config_;
+    MessageDispatcher* dispatcher_;
+    AdmissionController& admission_;
+    TimeoutConfig timeouts_;
+    ReserveFd reserve_fd_;
+    CompletionQueue completions_;
+    CompletionHandler completion_handler_;
+    uint64_t next_connection_id_;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+    std::vector<Connection*> flush_list_;
+};
+
+}  // namespace
+
+std::unique_ptr<ServerReactor> createEpollReactor(int listen_fd, const ReactorContext& context) {
+    return std::make_unique<EpollReactor>(listen_fd, context);
+}
@@ -0,0 +1,165 @@
+#include "event_loop.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "logger.h"
+#include <cstring>
+#include <errno.h>
+
+namespace {
+// 单次epoll_wait最多处理的事件数
+constexpr int kMaxEvents = 256;
+}
+
+EventLoop::EventLoop(uint64_t timer_tick_ms)
+    : epoll_fd_(epoll_create1(EPOLL_CLOEXEC))
+    , wakeup_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    , running_(false)
+    , quit_(false)
+    , timers_(timer_tick_ms) {
+    if (epoll_fd_ == -1 || wakeup_fd_ == -1) {
+        LOG_ERROR("创建事件循环失败: {}", strerror(errno));
+        return;
+    }
+
+    // 唤醒fd的data.ptr为空，用于和普通handler区分
+    struct epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &ev);
+}
+
+EventLoop::~EventLoop() {
+    if (wakeup_fd_ != -1) close(wakeup_fd_);
+    if (epoll_fd_ != -1) close(epoll_fd_);
+}
+
+bool EventLoop::valid() const {
+    return epoll_fd_ != -1 && wakeup_fd_ != -1;
+}
+
+bool EventLoop::add(int fd, uint32_t events, EventHandler* handler) {
+    struct epoll_event ev {};
+    ev.events = events;
+    ev.data.ptr = handler;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        LOG_ERROR("注册fd失败: {}", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool EventLoop::modify(int fd, uint32_t events, EventHandler* handler) {
+    struct epoll_event ev {};
+    ev.events = events;
+    ev.data.ptr = handler;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EventLoop::remove(int fd) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void EventLoop::run() {
+    loop_thread_ = std::this_thread::get_id();
+    running_ = true;
+    struct epoll_event events[kMaxEvents];
+
+    while (!quit_) {
+        for (auto& hook : before_wait_) {
+            hook();
+        }
+        int timeout = timers_.nextTimeoutMs(TimingWheel::monotonicMilliseconds());
+        int n = epoll_wait(epoll_fd_, events, kMaxEvents, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("epoll_wait失败: {}", strerror(errno));
+            break;
+        }
+
+        // 先更新时间基准，处理事件时启动的定时器从当前时间算起；到期回调在事件处理之后
+        // 执行，避免回调关闭的连接仍出现在本批事件中
+        uint64_t now = TimingWheel::monotonicMilliseconds();
+        timers_.setNow(now);
+
+        for (int i = 0; i < n; ++i) {
+            auto* handler = static_cast<EventHandler*>(events[i].data.ptr);
+            if (handler == nullptr) {
+                uint64_t value;
+                while (read(wakeup_fd_, &value, sizeof(value)) > 0) {}
+                continue;
+            }
+            handler->handleEvent(events[i].events);
+        }
+
+        timers_.advance(now);
+
+        runNotifications();
+        runPendingTasks();
+    }
+
+    // 退出前执行剩余任务，保证投递的清理工作不丢失
+    runNotifications();
+    runPendingTasks();
+    running_ = false;
+    loop_thread_ = std::thread::id();
+}
+
+void EventLoop::stop() {
+    quit_ = true;
+    wakeup();
+}
+
+void EventLoop::post(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        pending_tasks_.push_back(std::move(task));
+    }
+    wakeup();
+}
+
+void EventLoop::notify(LoopNotification* notification) {
+    // 队列由空变为非空时才需要唤醒，循环每次取走全部通知
+    if (notifications_.push(notification)) {
+        wakeup();
+    }
+}
+
+void EventLoop::addBeforeWait(Task task) {
+    before_wait_.push_back(std::move(task));
+}
+
+bool EventLoop::isRunning() const {
+    return running_;
+}
+
+bool EventLoop::isInLoopThread() const {
+    return loop_thread_.load() == std::this_thread::get_id();
+}
+
+void EventLoop::wakeup() {
+    uint64_t one = 1;
+    ssize_t ret = write(wakeup_fd_, &one, sizeof(one));
+    (void)ret;
+}
+
+void EventLoop::runPendingTasks() {
+    std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        tasks.swap(pending_tasks_);
+    }
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+void EventLoop::runNotifications() {
+    LoopNotification* notification = notifications_.popAll();
+    while (notification != nullptr) {
+        // 先取next：回调中对象可能再次投递自己
+        LoopNotification* next = notification->next;
+        notification->onNotify();
+        notification = next;
+    }
+}
@@ -0,0 +1,30 @@
+#include "frame.h"
+
+void appendFrame(std::string& out, FrameType type, uint32_t sequence, std::string_view payload) {
+    FrameHeader header;
+    header.length = static_cast<uint32_t>(payload.size());
+    header.type = static_cast<uint16_t>(type);
+    header.sequence = sequence;
+
+    size_t offset = out.size();
+    out.resize(offset + kFrameHeaderSize);
+    encodeFrameHeader(&out[offset], header);
+    out.append(payload.data(), payload.size());
+}
+
+void appendFrame(ByteBuffer& out, FrameType type, uint32_t sequence, std::string_view payload) {
+    FrameHeader header;
+    header.length = static_cast<uint32_t>(payload.size());
+    header.type = static_cast<uint16_t>(type);
+    header.sequence = sequence;
+
+    out.ensureWritable(kFrameHeaderSize + payload.size());
+    encodeFrameHeader(out.writePtr(), header);
+    memcpy(out.writePtr() + kFrameHeaderSize, payload.data(), payload.size());
+    out.commit(kFrameHeaderSize + payload.size());
+}
+
+FrameDecoder::FrameDecoder(size_t initial_capacity, uint32_t max_frame_length)
+    : buffer_(initial_capacity)
+    , max_frame_length_(max_frame_length) {
+}
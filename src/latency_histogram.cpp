@@ -0,0 +1,143 @@
+#include "latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// 原子地把target更新为较小/较大的值
+void updateMin(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void updateMax(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
+LatencyHistogram::LatencyHistogram(uint64_t highest_value, int significant_digits)
+    : highest_value_(std::max<uint64_t>(highest_value, 2))
+    , min_(std::numeric_limits<uint64_t>::max()) {
+    significant_digits = std::min(std::max(significant_digits, 1), 5);
+
+    // 每段至少需要2*10^digits个桶才能保证相对误差
+    uint64_t largest_single_unit = 2;
+    for (int i = 0; i < significant_digits; ++i) largest_single_unit *= 10;
+    int sub_bucket_count_magnitude = static_cast<int>(std::ceil(std::log2(static_cast<double>(largest_single_unit))));
+    sub_bucket_half_count_magnitude_ = std::max(sub_bucket_count_magnitude, 1) - 1;
+    uint64_t sub_bucket_count = uint64_t(1) << (sub_bucket_half_count_magnitude_ + 1);
+    sub_bucket_half_count_ = sub_bucket_count / 2;
+    sub_bucket_mask_ = sub_bucket_count - 1;
+
+    // 覆盖highest_value所需的分段数
+    uint64_t smallest_untrackable = sub_bucket_count;
+    size_t bucket_count = 1;
+    while (smallest_untrackable <= highest_value_) {
+        if (smallest_untrackable > std::numeric_limits<uint64_t>::max() / 2) {
+            ++bucket_count;
+            break;
+        }
+        smallest_untrackable <<= 1;
+        ++bucket_count;
+    }
+    counts_length_ = (bucket_count + 1) * sub_bucket_half_count_;
+    counts_.reset(new std::atomic<uint64_t>[counts_length_]);
+    for (size_t i = 0; i < counts_length_; ++i) {
+        counts_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t LatencyHistogram::indexOf(uint64_t value) const {
+    value = std::min(value, highest_value_);
+    int pow2_ceiling = 64 - __builtin_clzll(value | sub_bucket_mask_);
+    int bucket = pow2_ceiling - (sub_bucket_half_count_magnitude_ + 1);
+    uint64_t sub_bucket = value >> bucket;
+    return (static_cast<size_t>(bucket + 1) << sub_bucket_half_count_magnitude_) + (sub_bucket - sub_bucket_half_count_);
+}
+
+uint64_t LatencyHistogram::valueOf(size_t index) const {
+    int bucket = static_cast<int>(index >> sub_bucket_half_count_magnitude_) - 1;
+    uint64_t sub_bucket = (index & (sub_bucket_half_count_ - 1)) + sub_bucket_half_count_;
+    if (bucket < 0) {
+        sub_bucket -= sub_bucket_half_count_;
+        bucket = 0;
+    }
+    return sub_bucket << bucket;
+}
+
+uint64_t LatencyHistogram::highestEquivalent(uint64_t value) const {
+    int pow2_ceiling = 64 - __builtin_clzll(value | sub_bucket_mask_);
+    int bucket = pow2_ceiling - (sub_bucket_half_count_magnitude_ + 1);
+    uint64_t lowest = (value >> bucket) << bucket;
+    return lowest + (uint64_t(1) << bucket) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    counts_[indexOf(value)].fetch_add(1, std::memory_order_relaxed);
+    total_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    updateMin(min_, value);
+    updateMax(max_, value);
+}
+
+void LatencyHistogram::recordCorrected(uint64_t value, uint64_t expected_interval) {
+    record(value);
+    if (expected_interval == 0) return;
+    for (uint64_t missing = value; missing > expected_interval;) {
+        missing -= expected_interval;
+        record(missing);
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    size_t length = std::min(counts_length_, other.counts_length_);
+    for (size_t i = 0; i < length; ++i) {
+        uint64_t count = other.counts_[i].load(std::memory_order_relaxed);
+        if (count != 0) counts_[i].fetch_add(count, std::memory_order_relaxed);
+    }
+    total_.fetch_add(other.total_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    sum_.fetch_add(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    updateMin(min_, other.min_.load(std::memory_order_relaxed));
+    updateMax(max_, other.max_.load(std::memory_order_relaxed));
+}
+
+void LatencyHistogram::reset() {
+    for (size_t i = 0; i < counts_length_; ++i) {
+        counts_[i].store(0, std::memory_order_relaxed);
+    }
+    total_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::min() const {
+    return count() == 0 ? 0 : min_.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t total = count();
+    return total == 0 ? 0.0 : static_cast<double>(sum_.load(std::memory_order_relaxed)) / total;
+}
+
+uint64_t LatencyHistogram::valueAtPercentile(double percentile) const {
+    uint64_t total = count();
+    if (total == 0) return 0;
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    uint64_t target = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(total)));
+    target = std::max<uint64_t>(target, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_length_; ++i) {
+        seen += counts_[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return std::min(highestEquivalent(valueOf(i)), max());
+        }
+    }
+    return max();
+}
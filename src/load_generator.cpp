@@ -0,0 +1,342 @@
+#include "load_generator.h"
+#include "client_pool.h"
+#include "latency_histogram.h"
+#include "logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+namespace {
+
+// 等待连接建立和在途请求完成时的额外余量
+constexpr auto kConnectWait = std::chrono::milliseconds(5000);
+constexpr auto kDrainMargin = std::chrono::milliseconds(1000);
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 完成回调在各事件循环线程上并发更新
+struct LoadState {
+    LatencyHistogram latency;
+    LatencyHistogram service;
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> timed_out{0};
+};
+
+// 单个发送线程的计数，线程结束后汇总
+struct SenderStats {
+    uint64_t sent = 0;
+    uint64_t rejected = 0;
+    uint64_t bytes = 0;
+    int64_t max_lag_ns = 0;
+};
+
+// 发送线程：负责下标与index同余的连接，以及全局请求序列中与index同余的请求
+void sendLoop(const LoadConfig& config, const std::vector<TcpClient*>& clients, LoadState& state,
+              size_t index, size_t threads, int64_t start_ns, int64_t end_ns, SenderStats& stats) {
+    std::vector<TcpClient*> slice;
+    for (size_t i = index; i < clients.size(); i += threads) {
+        slice.push_back(clients[i]);
+    }
+    std::mt19937_64 rng(std::random_device{}());
+    // 负载内容不影响测量，所有请求共用一块缓冲区的前缀
+    std::string buffer(config.payload.maxSize(), 'x');
+    double request_ns = 1e9 / config.rate;
+    size_t cursor = 0;
+
+    for (uint64_t k = 0;; ++k) {
+        int64_t intended = start_ns + static_cast<int64_t>(static_cast<double>(index + k * threads) * request_ns);
+        if (intended >= end_ns) break;
+        int64_t now = nowNs();
+        while (now < intended) {
+            // 远离计划时间时睡眠，临近时让出CPU，兼顾精度和压测端开销
+            if (intended - now > 200000) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(intended - now - 100000));
+            } else {
+                std::this_thread::yield();
+            }
+            now = nowNs();
+        }
+        stats.max_lag_ns = std::max(stats.max_lag_ns, now - intended);
+
+        // 跳过断开的连接，轮转到下一条可用连接
+        TcpClient* client = nullptr;
+        for (size_t tries = 0; tries < slice.size(); ++tries) {
+            TcpClient* candidate = slice[cursor++ % slice.size()];
+            if (candidate->isConnected()) {
+                client = candidate;
+                break;
+            }
+        }
+        size_t size = config.payload.next(rng);
+        bool queued = client != nullptr &&
+                      client->call(std::string_view(buffer.data(), size),
+                                   [&state, intended, now](CallStatus status, std::string_view) {
+                                       // 超时和断开也按此刻的耗时记录，否则慢到失败的请求
+                                       // 会从分位数中消失，尾延迟反而显得更好
+                                       int64_t done = nowNs();
+                                       state.latency.record(static_cast<uint64_t>(done - intended) / 1000);
+                                       state.service.record(static_cast<uint64_t>(done - now) / 1000);
+                                       if (status == CallStatus::Ok) {
+                                           state.completed.fetch_add(1, std::memory_order_relaxed);
+                                           return;
+                                       }
+                                       if (status == CallStatus::Timeout) {
+                                           state.timed_out.fetch_add(1, std::memory_order_relaxed);
+                                       }
+                                       state.failed.fetch_add(1, std::memory_order_relaxed);
+                                   },
+                                   config.timeout_ms);
+        if (!queued) {
+            ++stats.rejected;
+            continue;
+        }
+        ++stats.sent;
+        stats.bytes += size;
+    }
+}
+
+LatencySummary summarize(const LatencyHistogram& histogram) {
+    LatencySummary summary;
+    summary.count = histogram.count();
+    summary.p50 = histogram.valueAtPercentile(50);
+    summary.p90 = histogram.valueAtPercentile(90);
+    summary.p99 = histogram.valueAtPercentile(99);
+    summary.p999 = histogram.valueAtPercentile(99.9);
+    summary.max = histogram.max();
+    summary.mean = histogram.mean();
+    return summary;
+}
+
+void appendNumber(std::string& out, double value) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.3f", value);
+    out += buffer;
+}
+
+void appendString(std::string& out, std::string_view value) {
+    out += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    out += '"';
+}
+
+void appendSummary(std::string& out, const LatencySummary& summary) {
+    out += "{\"count\": " + std::to_string(summary.count);
+    out += ", \"failed\": " + std::to_string(summary.failed);
+    out += ", \"rejected\": " + std::to_string(summary.rejected);
+    out += ", \"p50\": " + std::to_string(summary.p50);
+    out += ", \"p90\": " + std::to_string(summary.p90);
+    out += ", \"p99\": " + std::to_string(summary.p99);
+    out += ", \"p99_9\": " + std::to_string(summary.p999);
+    out += ", \"max\": " + std::to_string(summary.max);
+    out += ", \"mean\": ";
+    appendNumber(out, summary.mean);
+    out += "}";
+}
+
+const char* writePolicyName(WritePolicy policy) {
+    switch (policy) {
+    case WritePolicy::LowLatency:
+        return "latency";
+    case WritePolicy::Throughput:
+        return "throughput";
+    case WritePolicy::Adaptive:
+        return "adaptive";
+    }
+    return "unknown";
+}
+
+}  // namespace
+
+size_t PayloadSizes::next(std::mt19937_64& rng) const {
+    if (ranges.empty()) return 0;
+    const Range* range = &ranges[0];
+    if (ranges.size() > 1) {
+        uint64_t total = 0;
+        for (const Range& r : ranges) total += r.weight;
+        uint64_t pick = std::uniform_int_distribution<uint64_t>(0, total - 1)(rng);
+        for (const Range& r : ranges) {
+            if (pick < r.weight) {
+                range = &r;
+                break;
+            }
+            pick -= r.weight;
+        }
+    }
+    if (range->min == range->max) return range->min;
+    return std::uniform_int_distribution<size_t>(range->min, range->max)(rng);
+}
+
+size_t PayloadSizes::maxSize() const {
+    size_t result = 0;
+    for (const Range& range : ranges) result = std::max(result, range.max);
+    return result;
+}
+
+bool parsePayloadSizes(std::string_view spec, PayloadSizes& sizes) {
+    // 解析非负整数，整个字符串都须是数字
+    auto parseNumber = [](std::string_view text, uint64_t& value) {
+        if (text.empty() || text.size() > 12) return false;
+        value = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9') return false;
+            value = value * 10 + static_cast<uint64_t>(c - '0');
+        }
+        return true;
+    };
+
+    std::vector<PayloadSizes::Range> ranges;
+    while (!spec.empty()) {
+        size_t comma = spec.find(',');
+        std::string_view item = spec.substr(0, comma);
+        spec = comma == std::string_view::npos ? std::string_view() : spec.substr(comma + 1);
+
+        uint64_t weight = 1;
+        size_t colon = item.find(':');
+        if (colon != std::string_view::npos) {
+            if (!parseNumber(item.substr(colon + 1), weight) || weight == 0 || weight > UINT32_MAX) return false;
+            item = item.substr(0, colon);
+        }
+        uint64_t min = 0;
+        uint64_t max = 0;
+        size_t dash = item.find('-');
+        if (!parseNumber(item.substr(0, dash), min)) return false;
+        max = min;
+        if (dash != std::string_view::npos && !parseNumber(item.substr(dash + 1), max)) return false;
+        if (max < min || max > kMaxFrameLength) return false;
+        ranges.push_back({static_cast<size_t>(min), static_cast<size_t>(max), static_cast<uint32_t>(weight)});
+    }
+    if (ranges.empty()) return false;
+    sizes.ranges = std::move(ranges);
+    return true;
+}
+
+bool runLoad(ClientPool& pool, const LoadConfig& config, LoadReport& report) {
+    report = LoadReport();
+    if (config.connections == 0 || config.rate <= 0) return false;
+
+    // 按计划逐个启动连接
+    std::vector<std::unique_ptr<TcpClient>> owned;
+    std::vector<TcpClient*> clients;
+    auto ramp_start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < config.connections; ++i) {
+        if (config.ramp_up_ms > 0) {
+            std::this_thread::sleep_until(ramp_start + std::chrono::milliseconds(config.ramp_up_ms * i / config.connections));
+        }
+        auto client = std::make_unique<TcpClient>(pool, config.host, config.port);
+        client->setOutputConfig(config.output);
+        client->startAsync();
+        clients.push_back(client.get());
+        owned.push_back(std::move(client));
+    }
+    auto connect_deadline = std::chrono::steady_clock::now() + kConnectWait;
+    auto countConnected = [&clients] {
+        return static_cast<size_t>(std::count_if(clients.begin(), clients.end(),
+                                                  [](TcpClient* client) { return client->isConnected(); }));
+    };
+    while (countConnected() < clients.size() && std::chrono::steady_clock::now() < connect_deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    report.connected = countConnected();
+    if (report.connected == 0) {
+        LOG_ERROR("没有可用的连接，无法压测{}:{}", config.host, config.port);
+        for (TcpClient* client : clients) client->stop();
+        return false;
+    }
+    if (report.connected < clients.size()) {
+        LOG_WARN("只有{}/{}条连接可用", report.connected, clients.size());
+    }
+
+    LoadState state;
+    size_t threads = std::max<size_t>(1, std::min(config.sender_threads, clients.size()));
+    std::vector<SenderStats> stats(threads);
+    int64_t start_ns = nowNs();
+    int64_t end_ns = start_ns + static_cast<int64_t>(config.duration_ms) * 1000000;
+    std::vector<std::thread> senders;
+    for (size_t i = 0; i < threads; ++i) {
+        senders.emplace_back(sendLoop, std::cref(config), std::cref(clients), std::ref(state), i, threads,
+                             start_ns, end_ns, std::ref(stats[i]));
+    }
+    for (std::thread& sender : senders) {
+        sender.join();
+    }
+    report.elapsed_s = static_cast<double>(nowNs() - start_ns) / 1e9;
+
+    for (const SenderStats& s : stats) {
+        report.sent += s.sent;
+        report.rejected += s.rejected;
+        report.bytes += s.bytes;
+        report.max_lag_ms = std::max(report.max_lag_ms, static_cast<double>(s.max_lag_ns) / 1e6);
+    }
+
+    // 等待在途请求完成或超时，再停止连接；stop()返回后不再有回调
+    auto drain_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.timeout_ms) + kDrainMargin;
+    while (state.completed.load() + state.failed.load() < report.sent &&
+           std::chrono::steady_clock::now() < drain_deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (TcpClient* client : clients) {
+        client->stop();
+    }
+
+    report.completed = state.completed.load();
+    report.failed = report.sent - report.completed;
+    report.timed_out = state.timed_out.load();
+    report.throughput = report.elapsed_s > 0 ? static_cast<double>(report.completed) / report.elapsed_s : 0;
+    report.latency = summarize(state.latency);
+    report.service = summarize(state.service);
+    report.latency.failed = report.service.failed = state.failed.load();
+    report.latency.rejected = report.service.rejected = report.rejected;
+    return true;
+}
+
+std::string loadReportJson(const LoadConfig& config, const LoadReport& report) {
+    std::string out = "{\n  \"config\": {\"host\": ";
+    appendString(out, config.host);
+    out += ", \"port\": " + std::to_string(config.port);
+    out += ", \"connections\": " + std::to_string(config.connections);
+    out += ", \"rate\": ";
+    appendNumber(out, config.rate);
+    out += ", \"duration_ms\": " + std::to_string(config.duration_ms);
+    out += ", \"ramp_up_ms\": " + std::to_string(config.ramp_up_ms);
+    out += ", \"sender_threads\": " + std::to_string(config.sender_threads);
+    out += ", \"timeout_ms\": " + std::to_string(config.timeout_ms);
+    out += ", \"write_policy\": ";
+    appendString(out, writePolicyName(config.output.write_policy));
+    out += ", \"payload\": [";
+    for (size_t i = 0; i < config.payload.ranges.size(); ++i) {
+        const PayloadSizes::Range& range = config.payload.ranges[i];
+        if (i > 0) out += ", ";
+        out += "{\"min\": " + std::to_string(range.min) + ", \"max\": " + std::to_string(range.max) +
+               ", \"weight\": " + std::to_string(range.weight) + "}";
+    }
+    out += "]},\n";
+    out += "  \"connected\": " + std::to_string(report.connected) + ",\n";
+    out += "  \"sent\": " + std::to_string(report.sent) + ",\n";
+    out += "  \"completed\": " + std::to_string(report.completed) + ",\n";
+    out += "  \"failed\": " + std::to_string(report.failed) + ",\n";
+    out += "  \"timed_out\": " + std::to_string(report.timed_out) + ",\n";
+    out += "  \"rejected\": " + std::to_string(report.rejected) + ",\n";
+    out += "  \"bytes\": " + std::to_string(report.bytes) + ",\n";
+    out += "  \"elapsed_s\": ";
+    appendNumber(out, report.elapsed_s);
+    out += ",\n  \"throughput\": ";
+    appendNumber(out, report.throughput);
+    out += ",\n  \"max_lag_ms\": ";
+    appendNumber(out, report.max_lag_ms);
+    out += ",\n  \"latency_us\": ";
+    appendSummary(out, report.latency);
+    out += ",\n  \"service_time_us\": ";
+    appendSummary(out, report.service);
+    out += "\n}\n";
+    return out;
+}
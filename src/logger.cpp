@@ -0,0 +1,358 @@
+#include "logger.h"
+#include <cstdio>
+#include <cstdlib>
+#include <charconv>
+#include <ctime>
+
+namespace {
+
+// 每个线程日志环的默认大小
+constexpr size_t kDefaultRingCapacity = 256 * 1024;
+// 环中记录按8字节对齐，前8字节存放记录长度
+constexpr size_t kEntryHeaderSize = 8;
+// 填充标记：环尾部剩余空间放不下记录时写入，消费者遇到后回绕到头部
+constexpr uint64_t kPaddingMarker = ~uint64_t(0);
+// 没有日志时后台线程的轮询间隔
+constexpr auto kIdleWait = std::chrono::milliseconds(5);
+// 格式化缓冲区的预留空间，常见长度的日志行格式化时不会触发扩容
+constexpr size_t kLineReserve = 4096;
+
+size_t alignUp(size_t size) {
+    return (size + 7) & ~size_t(7);
+}
+
+size_t roundUpPowerOfTwo(size_t size) {
+    size_t result = 1024;
+    while (result < size) result <<= 1;
+    return result;
+}
+
+// 线程退出时把自己的环标记为退休，由后台线程消费完后释放
+struct RingHolder {
+    std::shared_ptr<LogRing> ring;
+    ~RingHolder() {
+        if (ring) ring->retired = true;
+    }
+};
+
+thread_local LogRing* tRing = nullptr;
+thread_local RingHolder tRingHolder;
+
+void appendTimestamp(uint64_t timestamp_ns, std::string& out) {
+    // 同一秒内的日志复用已格式化的日期时间
+    static time_t cached_second = -1;
+    static char cached[32];
+    time_t second = static_cast<time_t>(timestamp_ns / 1000000000);
+    if (second != cached_second) {
+        struct tm tm;
+        localtime_r(&second, &tm);
+        strftime(cached, sizeof(cached), "%Y-%m-%d %H:%M:%S", &tm);
+        cached_second = second;
+    }
+    char micros[8];
+    snprintf(micros, sizeof(micros), ".%06u",
+             static_cast<unsigned>((timestamp_ns % 1000000000) / 1000));
+    out.append(cached);
+    out.append(micros);
+}
+
+template <typename T>
+void appendNumber(std::string& out, T value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr - buffer);
+}
+
+// 解码一个参数并追加到out，返回下一个参数的位置
+const char* appendArg(const char* in, std::string& out) {
+    auto type = static_cast<logdetail::ArgType>(*in++);
+    switch (type) {
+    case logdetail::ArgType::Bool:
+        out.append(*in ? "true" : "false");
+        return in + 1;
+    case logdetail::ArgType::Char:
+        out.push_back(*in);
+        return in + 1;
+    case logdetail::ArgType::String: {
+        uint32_t len;
+        memcpy(&len, in, sizeof(len));
+        out.append(in + sizeof(len), len);
+        return in + sizeof(len) + len;
+    }
+    default:
+        break;
+    }
+
+    uint64_t bits;
+    memcpy(&bits, in, 8);
+    switch (type) {
+    case logdetail::ArgType::Int: {
+        int64_t value;
+        memcpy(&value, &bits, 8);
+        appendNumber(out, value);
+        break;
+    }
+    case logdetail::ArgType::UInt:
+        appendNumber(out, bits);
+        break;
+    case logdetail::ArgType::Double: {
+        double value;
+        memcpy(&value, &bits, 8);
+        char buffer[32];
+        int len = snprintf(buffer, sizeof(buffer), "%g", value);
+        out.append(buffer, len);
+        break;
+    }
+    default: {
+        char buffer[24];
+        int len = snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(bits));
+        out.append(buffer, len);
+        break;
+    }
+    }
+    return in + 8;
+}
+
+void defaultSink(LogLevel level, std::string_view line) {
+    FILE* stream = level >= LogLevel::Warn ? stderr : stdout;
+    fwrite(line.data(), 1, line.size(), stream);
+}
+
+}  // namespace
+
+const char* logLevelName(LogLevel level) {
+    switch (level) {
+    case LogLevel::Debug: return "DEBUG";
+    case LogLevel::Info: return "INFO";
+    case LogLevel::Warn: return "WARN";
+    case LogLevel::Error: return "ERROR";
+    }
+    return "UNKNOWN";
+}
+
+LogRing::LogRing(size_t capacity)
+    : data_(new char[roundUpPowerOfTwo(capacity)])
+    , capacity_(roundUpPowerOfTwo(capacity))
+    , mask_(capacity_ - 1) {
+}
+
+char* LogRing::reserve(size_t size) {
+    size_t entry = kEntryHeaderSize + alignUp(size);
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t pos = tail & mask_;
+    size_t contiguous = capacity_ - pos;
+
+    // 尾部放不下时整段填充，记录从头部开始写
+    size_t padding = entry > contiguous ? contiguous : 0;
+    if (tail + padding + entry - head > capacity_) return nullptr;
+    if (padding > 0) {
+        memcpy(data_.get() + pos, &kPaddingMarker, sizeof(kPaddingMarker));
+        tail += padding;
+        pos = 0;
+    }
+
+    uint64_t length = size;
+    memcpy(data_.get() + pos, &length, sizeof(length));
+    pending_tail_ = tail + entry;
+    return data_.get() + pos + kEntryHeaderSize;
+}
+
+const char* LogRing::peek(size_t& size) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    while (head != tail_.load(std::memory_order_acquire)) {
+        size_t pos = head & mask_;
+        uint64_t length;
+        memcpy(&length, data_.get() + pos, sizeof(length));
+        if (length == kPaddingMarker) {
+            head += capacity_ - pos;
+            head_.store(head, std::memory_order_release);
+            continue;
+        }
+        size = length;
+        peek_entry_ = kEntryHeaderSize + alignUp(length);
+        return data_.get() + pos + kEntryHeaderSize;
+    }
+    return nullptr;
+}
+
+namespace logdetail {
+
+void formatRecord(const RecordHeader& header, const char* payload, std::string& out) {
+    const char* format = header.format;
+    const char* arg = payload;
+    unsigned remaining = header.arg_count;
+    while (*format) {
+        if (format[0] == '{' && format[1] == '}') {
+            if (remaining > 0) {
+                arg = appendArg(arg, out);
+                --remaining;
+            } else {
+                out.append("{}");
+            }
+            format += 2;
+        } else {
+            out.push_back(*format++);
+        }
+    }
+    // 参数多于占位符时依次追加在末尾
+    while (remaining-- > 0) {
+        out.push_back(' ');
+        arg = appendArg(arg, out);
+    }
+}
+
+uint64_t nowNanoseconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+}  // namespace logdetail
+
+Logger& Logger::instance() {
+    // 有意不析构：其他静态对象析构时仍可能写日志
+    static Logger* logger = new Logger();
+    return *logger;
+}
+
+Logger::Logger()
+    : ring_capacity_(kDefaultRingCapacity)
+    , next_thread_index_(0)
+    , retired_dropped_(0)
+    , reported_dropped_(0)
+    , quit_(false) {
+    line_.reserve(kLineReserve);
+    drain_thread_ = std::thread(&Logger::drainLoop, this);
+    // 进程正常退出时输出剩余日志
+    std::atexit([] { Logger::instance().shutdown(); });
+}
+
+LogRing* Logger::threadRing() {
+    if (tRing == nullptr) {
+        tRing = registerThread();
+    }
+    return tRing;
+}
+
+LogRing* Logger::registerThread() {
+    auto ring = std::make_shared<LogRing>(ring_capacity_.load());
+    ring->thread_index = next_thread_index_++;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(ring);
+    }
+    tRingHolder.ring = ring;
+    return ring.get();
+}
+
+void Logger::setSink(Sink sink) {
+    flush();
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    sink_ = std::move(sink);
+}
+
+void Logger::setRingCapacity(size_t capacity) {
+    ring_capacity_ = capacity;
+}
+
+void Logger::flush() {
+    drainOnce();
+}
+
+uint64_t Logger::droppedCount() const {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    uint64_t total = retired_dropped_;
+    for (const auto& ring : rings_) {
+        total += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void Logger::drainLoop() {
+    while (true) {
+        if (drainOnce()) continue;
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        if (quit_) break;
+        wake_cv_.wait_for(lock, kIdleWait);
+        if (quit_) break;
+    }
+}
+
+bool Logger::drainOnce() {
+    std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+    bool worked = false;
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (auto it = rings_.begin(); it != rings_.end();) {
+            LogRing& ring = **it;
+            // 先读退休标记：标记之后线程不会再写入，消费完即可释放
+            bool retired = ring.retired.load(std::memory_order_acquire);
+            size_t size;
+            while (const char* record = ring.peek(size)) {
+                logdetail::RecordHeader header;
+                memcpy(&header, record, sizeof(header));
+
+                line_.clear();
+                appendTimestamp(header.timestamp_ns, line_);
+                line_.append(" [");
+                line_.append(logLevelName(header.level));
+                line_.append("] [T");
+                appendNumber(line_, ring.thread_index);
+                line_.append("] ");
+                logdetail::formatRecord(header, record + sizeof(header), line_);
+                line_.push_back('\n');
+                ring.pop();
+
+                if (sink_) {
+                    sink_(header.level, line_);
+                } else {
+                    defaultSink(header.level, line_);
+                }
+                worked = true;
+            }
+
+            if (retired) {
+                retired_dropped_ += ring.dropped.load(std::memory_order_relaxed);
+                it = rings_.erase(it);
+            } else {
+                dropped += ring.dropped.load(std::memory_order_relaxed);
+                ++it;
+            }
+        }
+        dropped += retired_dropped_;
+    }
+
+    if (dropped > reported_dropped_) {
+        line_.clear();
+        line_.append("[WARN] 日志缓冲区已满，丢弃了");
+        appendNumber(line_, dropped - reported_dropped_);
+        line_.append("条日志\n");
+        reported_dropped_ = dropped;
+        if (sink_) {
+            sink_(LogLevel::Warn, line_);
+        } else {
+            defaultSink(LogLevel::Warn, line_);
+        }
+        worked = true;
+    }
+
+    if (worked && !sink_) {
+        fflush(stdout);
+        fflush(stderr);
+    }
+    return worked;
+}
+
+void Logger::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        quit_ = true;
+    }
+    wake_cv_.notify_one();
+    if (drain_thread_.joinable()) {
+        drain_thread_.join();
+    }
+    drainOnce();
+}
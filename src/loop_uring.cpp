@@ -0,0 +1,59 @@
+#include "loop_uring.h"
+#include "logger.h"
+#include <sys/epoll.h>
+#include <errno.h>
+#include <cstring>
+
+LoopUring::LoopUring(EventLoop& loop, unsigned entries)
+    : loop_(loop)
+    , ring_(entries)
+    , valid_(false)
+    , pending_(0)
+    , submit_calls_(0) {
+    if (!ring_.valid()) {
+        LOG_ERROR("创建io_uring失败: {}", strerror(errno));
+        return;
+    }
+    // 完成队列非空时ring的fd可读
+    if (!loop_.add(ring_.fd(), EPOLLIN, this)) {
+        LOG_ERROR("注册io_uring到事件循环失败: {}", strerror(errno));
+        return;
+    }
+    loop_.addBeforeWait([this] { submit(); });
+    valid_ = true;
+}
+
+LoopUring::~LoopUring() {
+    if (valid_) loop_.remove(ring_.fd());
+}
+
+struct io_uring_sqe* LoopUring::prepare(UringCompletion* completion) {
+    struct io_uring_sqe* sqe = ring_.getSqe();
+    if (sqe == nullptr) {
+        submit();
+        sqe = ring_.getSqe();
+        if (sqe == nullptr) return nullptr;
+    }
+    sqe->user_data = reinterpret_cast<uint64_t>(completion);
+    ++pending_;
+    return sqe;
+}
+
+void LoopUring::submit() {
+    if (pending_ == 0) return;
+    int ret = ring_.submit();
+    ++submit_calls_;
+    if (ret < 0) {
+        // 提交失败时请求仍留在队列中，下一轮再试
+        LOG_ERROR("提交io_uring请求失败: {}", strerror(errno));
+        return;
+    }
+    pending_ = 0;
+}
+
+void LoopUring::handleEvent(uint32_t) {
+    // 回调中可能再排入新的请求，它们在本轮结束时统一提交
+    ring_.forEachCqe([](struct io_uring_cqe* cqe) {
+        reinterpret_cast<UringCompletion*>(cqe->user_data)->onUringComplete(cqe->res);
+    });
+}
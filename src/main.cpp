@@ -1,4 +1,11 @@
 #include "tcp_client.h"
+#include "client_pool.h"
+#include "load_generator.h"
+#include "logger.h"
+#include "metrics_server.h"
+#include "trace.h"
+#include <sys/resource.h>
+#include <fstream>
 #include <iostream>
 #include <thread>
 #include <vector>
@@ -6,6 +13,8 @@
 #include <atomic>
 #include <cstdlib>
 #include <string>
+#include <cstring>
+#include <cerrno>
 
 void printUsage(const char* programName) {
     std::cout << "用法: " << programName << " [选项]\n"
@@ -15,6 +24,18 @@ void printUsage(const char* programName) {
               << "  -p, --port <端口>         服务器端口 (默认: 8888)\n"
               << "  -c, --clients <数量>      客户端数量 (默认: 10)\n"
               << "  -i, --interval <毫秒>     发送消息间隔 (默认: 2000)\n"
+              << "  -t, --threads <数量>      事件循环线程数 (默认: 1)\n"
+              << "  -w, --write-policy <策略> 写出策略: latency | throughput | adaptive (默认: latency)\n"
+              << "      --metrics-port <端口>   在127.0.0.1的该端口上提供Prometheus指标 (默认: 0，关闭)\n"
+              << "      --metrics-socket <路径> 在该Unix域socket上提供Prometheus指标\n"
+              << "      --trace <文件>          退出时把跟踪记录写成trace-event JSON（需ENABLE_TRACE编译）\n"
+              << "压测选项（指定-r时进入开环压测模式，-c为连接数）:\n"
+              << "  -r, --rate <条/秒>        目标总速率\n"
+              << "  -d, --duration <秒>       测量时长 (默认: 10)\n"
+              << "      --ramp-up <毫秒>      在这段时间内均匀建立连接 (默认: 0)\n"
+              << "      --payload <分布>      负载大小，如 256、64-1024、64:90,4096:10 (默认: 64)\n"
+              << "      --senders <数量>      发送线程数 (默认: 1)\n"
+              << "      --json <文件>         把结果写成JSON\n"
               << std::endl;
 }
 
@@ -23,6 +44,17 @@ struct ClientConfig {
     int serverPort = 8888;
     int clientCount = 10;
     int messageInterval = 2000;
+    int loopThreads = 1;
+    WritePolicy writePolicy = WritePolicy::LowLatency;
+    double rate = 0;          // 大于0时进入开环压测模式
+    int durationSeconds = 10;
+    int rampUpMs = 0;
+    int senderThreads = 1;
+    PayloadSizes payload;
+    std::string jsonPath;
+    int metricsPort = 0;      // 大于0时在该端口上提供指标
+    std::string metricsSocket;
+    std::string tracePath;    // 非空时退出前导出跟踪记录
 };
 
 ClientConfig parseArguments(int argc, char* argv[]) {
@@ -62,90 +94,258 @@ ClientConfig parseArguments(int argc, char* argv[]) {
                     exit(1);
                 }
             }
+        } else if (arg == "-w" || arg == "--write-policy") {
+            if (i + 1 < argc) {
+                std::string policy = argv[++i];
+                if (!parseWritePolicy(policy, config.writePolicy)) {
+                    std::cerr << "错误：未知的写出策略 " << policy << std::endl;
+                    exit(1);
+                }
+            }
+        } else if (arg == "-r" || arg == "--rate") {
+            if (i + 1 < argc) {
+                config.rate = std::atof(argv[++i]);
+                if (config.rate <= 0) {
+                    std::cerr << "错误：目标速率必须大于0" << std::endl;
+                    exit(1);
+                }
+            }
+        } else if (arg == "-d" || arg == "--duration") {
+            if (i + 1 < argc) {
+                config.durationSeconds = std::atoi(argv[++i]);
+                if (config.durationSeconds <= 0) {
+                    std::cerr << "错误：测量时长必须大于0秒" << std::endl;
+                    exit(1);
+                }
+            }
+        } else if (arg == "--ramp-up") {
+            if (i + 1 < argc) {
+                config.rampUpMs = std::atoi(argv[++i]);
+                if (config.rampUpMs < 0) {
+                    std::cerr << "错误：连接建立时间不能为负" << std::endl;
+                    exit(1);
+                }
+            }
+        } else if (arg == "--payload") {
+            if (i + 1 < argc) {
+                std::string spec = argv[++i];
+                if (!parsePayloadSizes(spec, config.payload)) {
+                    std::cerr << "错误：无效的负载大小分布 " << spec << std::endl;
+                    exit(1);
+                }
+            }
+        } else if (arg == "--senders") {
+            if (i + 1 < argc) {
+                config.senderThreads = std::atoi(argv[++i]);
+                if (config.senderThreads <= 0) {
+                    std::cerr << "错误：发送线程数必须大于0" << std::endl;
+                    exit(1);
+                }
+            }
+        } else if (arg == "--metrics-port") {
+            if (i + 1 < argc) {
+                config.metricsPort = std::atoi(argv[++i]);
+                if (config.metricsPort <= 0 || config.metricsPort > 65535) {
+                    std::cerr << "错误：指标端口必须在1-65535之间" << std::endl;
+                    exit(1);
+                }
+            }
+        } else if (arg == "--metrics-socket") {
+            if (i + 1 < argc) {
+                config.metricsSocket = argv[++i];
+            }
+        } else if (arg == "--trace") {
+            if (i + 1 < argc) {
+                config.tracePath = argv[++i];
+            }
+        } else if (arg == "--json") {
+            if (i + 1 < argc) {
+                config.jsonPath = argv[++i];
+            }
+        } else if (arg == "-t" || arg == "--threads") {
+            if (i + 1 < argc) {
+                config.loopThreads = std::atoi(argv[++i]);
+                if (config.loopThreads <= 0) {
+                    std::cerr << "错误：事件循环线程数必须大于0" << std::endl;
+                    exit(1);
+                }
+            }
         }
     }
     
     return config;
 }
 
-// 全局变量用于控制所有客户端
+// 全局变量用于控制发送线程
 std::atomic<bool> gRunning(true);
 
-// 客户端线程函数
-void clientThread(const int clientId, 
-                 const std::string& serverIp, 
-                 const int serverPort,
-                 const int messageInterval) {
-    try {
-        // 创建TCP客户端实例
-        auto client = std::make_unique<TcpClient>(serverIp, serverPort);
-        
-        // 设置连接状态回调
-        client->setConnectionCallback([clientId](bool connected) {
-            std::cout << "客户端 " << clientId << " 连接状态: " 
-                      << (connected ? "已连接" : "已断开") << std::endl;
-        });
-        
-        // 启动客户端
-        client->start();
-        
-        // 主循环
-        while (gRunning) {
-            if (client->isConnected()) {
-                std::string message = "客户端 " + std::to_string(clientId) + " 发送的消息";
-                if (client->send(message)) {
-                    std::cout << "客户端 " << clientId << " 消息发送成功" << std::endl;
-                } else {
-                    std::cout << "客户端 " << clientId << " 消息发送失败" << std::endl;
-                }
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(messageInterval));
+// 发送完成回调在事件循环线程上计数，客户端停止时仍可能回调，所以放在全局
+std::atomic<size_t> gSucceeded(0);
+std::atomic<size_t> gFailed(0);
+std::atomic<size_t> gResponses(0);
+
+// 把打开文件数的软限制提升到硬限制，每个连接占用一个fd
+void raiseFileLimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &limit) < 0) {
+            LOG_WARN("提升文件描述符上限失败: {}", strerror(errno));
         }
-        
-        // 停止客户端
-        client->stop();
-    } catch (const std::exception& e) {
-        std::cerr << "客户端 " << clientId << " 发生异常: " << e.what() << std::endl;
     }
 }
 
+// 发送线程：每个间隔向所有已连接的客户端各异步发送一条消息，只汇总上一轮的结果，
+// 不为每个客户端单独创建线程
+void senderThread(std::vector<std::unique_ptr<TcpClient>>& clients, const int messageInterval) {
+    // 消息内容不变，在循环外构造一次，发送路径不再逐条分配内存
+    std::vector<std::string> messages;
+    messages.reserve(clients.size());
+    for (size_t i = 0; i < clients.size(); ++i) {
+        messages.push_back("客户端 " + std::to_string(i) + " 发送的消息");
+    }
+
+    while (gRunning) {
+        size_t rejected = 0;
+        for (size_t i = 0; i < clients.size(); ++i) {
+            if (!clients[i]->isConnected()) continue;
+            bool queued = clients[i]->sendAsync(messages[i], [](bool ok) {
+                (ok ? gSucceeded : gFailed).fetch_add(1, std::memory_order_relaxed);
+            });
+            if (!queued) ++rejected;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(messageInterval));
+        LOG_INFO("上一轮消息发送成功 {} 条，失败 {} 条，未能入队 {} 条，收到响应 {} 条",
+                 gSucceeded.exchange(0), gFailed.exchange(0), rejected, gResponses.exchange(0));
+    }
+}
+
+// 打印一组延迟分位数
+void printLatency(const char* title, const LatencySummary& summary) {
+    std::cout << title << ": p50=" << summary.p50 << " p90=" << summary.p90 << " p99=" << summary.p99
+              << " p99.9=" << summary.p999 << " max=" << summary.max << " 平均=" << summary.mean
+              << " （含失败 " << summary.failed << " 条，未能发出 " << summary.rejected << " 条）\n";
+}
+
+// 开环压测模式：按目标速率发送固定时长后打印结果并退出
+int runBenchmark(const ClientConfig& config) {
+    LoadConfig load;
+    load.host = config.serverIp;
+    load.port = config.serverPort;
+    load.connections = config.clientCount;
+    load.rate = config.rate;
+    load.duration_ms = static_cast<uint64_t>(config.durationSeconds) * 1000;
+    load.ramp_up_ms = config.rampUpMs;
+    load.sender_threads = config.senderThreads;
+    load.payload = config.payload;
+    load.output.write_policy = config.writePolicy;
+
+    std::cout << "开环压测: " << load.connections << " 条连接，目标 " << load.rate << " 条/秒，持续 "
+              << config.durationSeconds << " 秒" << std::endl;
+
+    ClientPool pool(config.loopThreads);
+    LoadReport report;
+    if (!runLoad(pool, load, report)) {
+        std::cerr << "压测失败：没有可用的连接" << std::endl;
+        return 1;
+    }
+
+    std::cout << "可用连接: " << report.connected << "\n"
+              << "发送 " << report.sent << " 条，完成 " << report.completed << " 条，失败 " << report.failed
+              << " 条（超时 " << report.timed_out << " 条），未能发出 " << report.rejected << " 条\n"
+              << "吞吐量: " << report.throughput << " 条/秒，用时 " << report.elapsed_s << " 秒\n";
+    printLatency("延迟(微秒，按计划发送时间)", report.latency);
+    printLatency("服务时间(微秒，按实际发送时间)", report.service);
+    if (report.max_lag_ms > 10) {
+        std::cout << "警告：发送线程最多落后计划 " << report.max_lag_ms << " 毫秒，压测端可能是瓶颈" << "\n";
+    }
+    std::cout << std::flush;
+
+    if (!config.jsonPath.empty()) {
+        std::ofstream out(config.jsonPath);
+        out << loadReportJson(load, report);
+        if (!out) {
+            std::cerr << "写入" << config.jsonPath << "失败" << std::endl;
+            return 1;
+        }
+    }
+    Logger::instance().flush();
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     try {
         // 解析命令行参数
         ClientConfig config = parseArguments(argc, argv);
+
+        // 每个MetricsServer只监听一个端点
+        MetricsServer metricsTcp;
+        MetricsServer metricsUnix;
+        if (config.metricsPort > 0 && !metricsTcp.listenTcp(config.metricsPort)) {
+            return 1;
+        }
+        if (!config.metricsSocket.empty() && !metricsUnix.listenUnix(config.metricsSocket)) {
+            return 1;
+        }
+        if (config.rate > 0) {
+            raiseFileLimit();
+            int status = runBenchmark(config);
+            if (!config.tracePath.empty() && !dumpTrace(config.tracePath)) status = 1;
+            return status;
+        }
         
         std::cout << "启动配置:\n"
                   << "服务器IP: " << config.serverIp << "\n"
                   << "服务器端口: " << config.serverPort << "\n"
                   << "客户端数量: " << config.clientCount << "\n"
                   << "消息发送间隔: " << config.messageInterval << "ms\n"
+                  << "事件循环线程数: " << config.loopThreads << "\n"
                   << std::endl;
         
-        std::vector<std::thread> clientThreads;
-        clientThreads.reserve(config.clientCount);  // 预分配空间
-        
-        // 创建并启动所有客户端线程
+        raiseFileLimit();
+
+        // 所有客户端由少量事件循环线程驱动，客户端本身不创建线程
+        ClientPool pool(config.loopThreads);
+        std::vector<std::unique_ptr<TcpClient>> clients;
+        clients.reserve(config.clientCount);  // 预分配空间
+
+        OutputConfig output;
+        output.write_policy = config.writePolicy;
+
+        // 创建并启动所有客户端，不等待逐个连接完成
         for (int i = 0; i < config.clientCount; ++i) {
-            clientThreads.emplace_back(clientThread, i, 
-                                      config.serverIp, 
-                                      config.serverPort,
-                                      config.messageInterval);
+            auto client = std::make_unique<TcpClient>(pool, config.serverIp, config.serverPort);
+            client->setOutputConfig(output);
+            client->setConnectionCallback([i](bool connected) {
+                LOG_DEBUG("客户端 {} 连接状态: {}", i, connected ? "已连接" : "已断开");
+            });
+            client->setMessageCallback([](const FrameHeader&, std::string_view) {
+                gResponses.fetch_add(1, std::memory_order_relaxed);
+            });
+            client->startAsync();
+            clients.push_back(std::move(client));
         }
-        
+
+        std::thread sender(senderThread, std::ref(clients), config.messageInterval);
+
         // 等待用户输入来停止所有客户端
         std::cout << "按回车键停止所有客户端..." << std::endl;
         std::cin.get();
         
         // 设置停止标志
         gRunning = false;
-        
-        // 等待所有客户端线程结束
-        for (auto& thread : clientThreads) {
-            if (thread.joinable()) {
-                thread.join();
-            }
+        sender.join();
+
+        // 客户端须先于连接池销毁
+        for (auto& client : clients) {
+            client->stop();
         }
-        
+        clients.clear();
+
+        if (!config.tracePath.empty()) {
+            dumpTrace(config.tracePath);
+        }
+        Logger::instance().flush();
         std::cout << "所有客户端已停止" << std::endl;
         return 0;
     } catch (const std::exception& e) {
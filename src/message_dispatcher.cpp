@@ -0,0 +1,129 @@
+#include "message_dispatcher.h"
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "logger.h"
+#include "metrics.h"
+#include <cstring>
+#include <errno.h>
+#include <exception>
+
+namespace {
+// 小于该大小的响应拷贝合并到发送队列的尾部缓冲区，不单独占用一个iovec
+constexpr size_t kCopyResponseSize = 1024;
+
+// 已交给处理线程池、尚未处理完的消息数
+const Gauge& handlerQueueDepth() {
+    static const Gauge gauge = MetricsRegistry::instance().gauge(
+        "tcp_server_handler_queue_depth", "等待或正在处理线程池中处理的消息数");
+    return gauge;
+}
+}
+
+CompletionQueue::CompletionQueue()
+    : event_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    if (event_fd_ == -1) {
+        LOG_ERROR("创建完成队列失败: {}", strerror(errno));
+    }
+}
+
+CompletionQueue::~CompletionQueue() {
+    HandlerCall* call = queue_.popAll();
+    while (call != nullptr) {
+        HandlerCall* next = call->next;
+        delete call;
+        call = next;
+    }
+    if (event_fd_ != -1) close(event_fd_);
+}
+
+void CompletionQueue::push(HandlerCall* call) {
+    if (queue_.push(call)) {
+        uint64_t one = 1;
+        ssize_t ret = write(event_fd_, &one, sizeof(one));
+        (void)ret;
+    }
+}
+
+HandlerCall* CompletionQueue::popAll() {
+    // 先清除计数再取链表：之后压入空队列的结果会重新写eventfd，不会丢失唤醒
+    uint64_t value;
+    ssize_t ret = read(event_fd_, &value, sizeof(value));
+    (void)ret;
+    return queue_.popAll();
+}
+
+bool invokeHandler(const MessageHandler& handler, const FrameHeader& header, std::string_view payload,
+                   ByteBuffer& response) {
+    try {
+        return handler(header, payload, response);
+    } catch (const std::exception& e) {
+        LOG_ERROR("消息处理异常，不回复序号{}: {}", header.sequence, e.what());
+    } catch (...) {
+        LOG_ERROR("消息处理异常，不回复序号{}", header.sequence);
+    }
+    return false;
+}
+
+MessageDispatcher::MessageDispatcher(MessageHandler handler, size_t thread_count)
+    : handler_(std::move(handler))
+    , pool_(thread_count) {
+    handlerQueueDepth();
+}
+
+void MessageDispatcher::dispatch(CompletionQueue& queue, int fd, uint64_t connection_id,
+                                 uint64_t index, const FrameHeader& header,
+                                 std::string_view payload) {
+    // 线程池的任务须可拷贝，所有权放在共享的unique_ptr中：执行时交给完成队列，
+    // 任务未执行就被丢弃时随任务一起释放
+    auto owned = std::make_shared<std::unique_ptr<HandlerCall>>(new HandlerCall);
+    HandlerCall* call = owned->get();
+    call->fd = fd;
+    call->connection_id = connection_id;
+    call->index = index;
+    call->header = header;
+    call->payload.append(payload);
+
+    handlerQueueDepth().inc();
+    pool_.submit([this, &queue, owned] {
+        HandlerCall* call = owned->get();
+        ByteBuffer response;
+        call->reply = handle(call->header,
+                             std::string_view(call->payload.readPtr(), call->payload.readableBytes()),
+                             response);
+        call->payload = std::move(response);
+        handlerQueueDepth().dec();
+        queue.push(owned->release());
+    });
+}
+
+bool MessageDispatcher::handle(const FrameHeader& header, std::string_view payload,
+                               ByteBuffer& response) const {
+    LOG_DEBUG("收到消息: {}", payload);
+    return invokeHandler(handler_, header, payload, response);
+}
+
+void ResponseSequencer::complete(HandlerCall* call, OutputQueue& output) {
+    std::unique_ptr<HandlerCall> owned(call);
+    if (call->index != next_deliver_) {
+        reorder_.emplace(call->index, std::move(owned));
+        return;
+    }
+
+    while (owned) {
+        if (owned->reply) {
+            ByteBuffer& payload = owned->payload;
+            if (payload.readableBytes() < kCopyResponseSize) {
+                output.appendFrame(FrameType::Response, owned->header.sequence,
+                                   std::string_view(payload.readPtr(), payload.readableBytes()));
+            } else {
+                output.appendFrame(FrameType::Response, owned->header.sequence, std::move(payload));
+            }
+        }
+        ++next_deliver_;
+
+        auto it = reorder_.find(next_deliver_);
+        if (it == reorder_.end()) break;
+        owned = std::move(it->second);
+        reorder_.erase(it);
+    }
+}
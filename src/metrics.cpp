@@ -0,0 +1,205 @@
+#include "metrics.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace metricsdetail {
+
+thread_local Shard* tls_shard = nullptr;
+
+namespace {
+
+// 线程退出时归还槽位数组；tls_shard本身是平凡类型，析构工作放在这里
+struct ShardOwner {
+    Shard* shard = nullptr;
+    ~ShardOwner() {
+        if (shard != nullptr) {
+            tls_shard = nullptr;
+            retireThread(shard);
+        }
+    }
+};
+
+thread_local ShardOwner tls_owner;
+
+}  // namespace
+
+Shard* registerThread() {
+    Shard* shard = new Shard();
+    for (size_t i = 0; i < kMetricSlots; ++i) {
+        shard->slots[i].store(0, std::memory_order_relaxed);
+    }
+    MetricsRegistry::instance().addShard(shard);
+    tls_owner.shard = shard;
+    tls_shard = shard;
+    return shard;
+}
+
+void retireThread(Shard* shard) {
+    MetricsRegistry::instance().retireShard(shard);
+}
+
+}  // namespace metricsdetail
+
+namespace {
+
+std::string metricKey(std::string_view name, std::string_view labels) {
+    std::string key(name);
+    key += '{';
+    key += labels;
+    key += '}';
+    return key;
+}
+
+// 样本行的标签部分：基础标签加上额外的标签，都为空时不输出花括号
+std::string labelSet(const std::string& labels, const std::string& extra) {
+    if (labels.empty() && extra.empty()) return std::string();
+    std::string out = "{" + labels;
+    if (!labels.empty() && !extra.empty()) out += ',';
+    out += extra + "}";
+    return out;
+}
+
+}  // namespace
+
+MetricsRegistry& MetricsRegistry::instance() {
+    // 不析构：其他静态对象析构和线程退出时仍可能更新指标
+    static MetricsRegistry* registry = new MetricsRegistry();
+    return *registry;
+}
+
+MetricsRegistry::MetricsRegistry()
+    : next_slot_(0)
+    , retired_(new uint64_t[kMetricSlots]()) {
+}
+
+uint32_t MetricsRegistry::registerMetric(std::string_view name, std::string_view help, std::string_view labels,
+                                         Type type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string key = metricKey(name, labels);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        const Metric& metric = metrics_[it->second];
+        if (metric.type != type) {
+            LOG_ERROR("指标{}重复注册为不同的类型", key);
+            return metricsdetail::kInvalidSlot;
+        }
+        return metric.slot;
+    }
+    uint32_t width = type == Type::Histogram ? static_cast<uint32_t>(kHistogramBuckets + 1) : 1;
+    if (next_slot_ + width > kMetricSlots) {
+        LOG_ERROR("指标槽位用尽，无法注册{}", key);
+        return metricsdetail::kInvalidSlot;
+    }
+    Metric metric{std::string(name), std::string(help), std::string(labels), type, next_slot_};
+    next_slot_ += width;
+    index_.emplace(std::move(key), metrics_.size());
+    metrics_.push_back(std::move(metric));
+    return metrics_.back().slot;
+}
+
+Counter MetricsRegistry::counter(std::string_view name, std::string_view help, std::string_view labels) {
+    return Counter(registerMetric(name, help, labels, Type::Counter));
+}
+
+Gauge MetricsRegistry::gauge(std::string_view name, std::string_view help, std::string_view labels) {
+    return Gauge(registerMetric(name, help, labels, Type::Gauge));
+}
+
+Histogram MetricsRegistry::histogram(std::string_view name, std::string_view help, std::string_view labels) {
+    return Histogram(registerMetric(name, help, labels, Type::Histogram));
+}
+
+void MetricsRegistry::addShard(metricsdetail::Shard* shard) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shards_.push_back(shard);
+}
+
+void MetricsRegistry::retireShard(metricsdetail::Shard* shard) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < kMetricSlots; ++i) {
+        retired_[i] += shard->slots[i].load(std::memory_order_relaxed);
+    }
+    shards_.erase(std::remove(shards_.begin(), shards_.end(), shard), shards_.end());
+    delete shard;
+}
+
+uint64_t MetricsRegistry::sumLocked(uint32_t slot) const {
+    uint64_t total = retired_[slot];
+    for (const metricsdetail::Shard* shard : shards_) {
+        total += shard->slots[slot].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t MetricsRegistry::value(const Counter& counter) const {
+    if (!counter.valid()) return 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sumLocked(counter.slot_);
+}
+
+int64_t MetricsRegistry::value(const Gauge& gauge) const {
+    if (!gauge.valid()) return 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 各线程的增量按补码相加，和即为当前值
+    return static_cast<int64_t>(sumLocked(gauge.slot_));
+}
+
+HistogramSnapshot MetricsRegistry::snapshot(const Histogram& histogram) const {
+    HistogramSnapshot snapshot;
+    if (!histogram.valid()) return snapshot;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < kHistogramBuckets; ++i) {
+        snapshot.buckets[i] = sumLocked(histogram.slot_ + static_cast<uint32_t>(i));
+        snapshot.count += snapshot.buckets[i];
+    }
+    snapshot.sum = sumLocked(histogram.slot_ + static_cast<uint32_t>(kHistogramBuckets));
+    return snapshot;
+}
+
+std::string MetricsRegistry::prometheusText() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 同名不同标签的指标归为一族，按首次注册的顺序输出，每族只输出一次HELP和TYPE
+    std::vector<std::string> families;
+    std::unordered_map<std::string, std::vector<const Metric*>> members;
+    for (const Metric& metric : metrics_) {
+        auto& list = members[metric.name];
+        if (list.empty()) families.push_back(metric.name);
+        list.push_back(&metric);
+    }
+
+    std::string out;
+    char number[32];
+    for (const std::string& family : families) {
+        const auto& list = members[family];
+        Type type = list.front()->type;
+        const char* type_name = type == Type::Counter ? "counter" : type == Type::Gauge ? "gauge" : "histogram";
+        out += "# HELP " + family + " " + list.front()->help + "\n";
+        out += "# TYPE " + family + " " + type_name + "\n";
+        for (const Metric* metric : list) {
+            if (metric->type == Type::Counter) {
+                out += family + labelSet(metric->labels, "") + " " + std::to_string(sumLocked(metric->slot)) + "\n";
+            } else if (metric->type == Type::Gauge) {
+                out += family + labelSet(metric->labels, "") + " " +
+                       std::to_string(static_cast<int64_t>(sumLocked(metric->slot))) + "\n";
+            } else {
+                uint64_t cumulative = 0;
+                for (size_t i = 0; i < kHistogramBuckets; ++i) {
+                    cumulative += sumLocked(metric->slot + static_cast<uint32_t>(i));
+                    if (i + 1 < kHistogramBuckets) {
+                        snprintf(number, sizeof(number), "le=\"%llu\"", 1ULL << i);
+                    } else {
+                        snprintf(number, sizeof(number), "le=\"+Inf\"");
+                    }
+                    out += family + "_bucket" + labelSet(metric->labels, number) + " " +
+                           std::to_string(cumulative) + "\n";
+                }
+                out += family + "_sum" + labelSet(metric->labels, "") + " " +
+                       std::to_string(sumLocked(metric->slot + static_cast<uint32_t>(kHistogramBuckets))) + "\n";
+                out += family + "_count" + labelSet(metric->labels, "") + " " + std::to_string(cumulative) + "\n";
+            }
+        }
+    }
+    return out;
+}
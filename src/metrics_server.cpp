@@ -0,0 +1,179 @@
+#include "metrics_server.h"
+#include "metrics.h"
+#include "trace.h"
+#include "logger.h"
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+// 等待连接时的轮询间隔，决定stop()的最长等待时间
+constexpr int kPollIntervalMs = 100;
+
+// 读取请求和写出响应的超时
+constexpr int kClientTimeoutMs = 1000;
+
+// 请求头的最大长度
+constexpr size_t kMaxRequestSize = 8192;
+
+bool writeAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+std::string httpResponse(const char* status, const char* content_type, const std::string& body) {
+    std::string response = "HTTP/1.1 ";
+    response += status;
+    response += "\r\nContent-Type: ";
+    response += content_type;
+    response += "\r\nContent-Length: " + std::to_string(body.size());
+    response += "\r\nConnection: close\r\n\r\n";
+    response += body;
+    return response;
+}
+
+}  // namespace
+
+MetricsServer::MetricsServer()
+    : listen_fd_(-1)
+    , port_(0)
+    , running_(false) {
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::listenTcp(int port) {
+    if (running_) return false;
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        LOG_ERROR("创建指标socket失败: {}", strerror(errno));
+        return false;
+    }
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        LOG_ERROR("指标端口{}监听失败: {}", port, strerror(errno));
+        close(fd);
+        return false;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (struct sockaddr*)&addr, &len);
+    port_ = ntohs(addr.sin_port);
+    LOG_INFO("指标端点监听于127.0.0.1:{}", port_);
+    return startThread(fd);
+}
+
+bool MetricsServer::listenUnix(const std::string& path) {
+    if (running_) return false;
+    struct sockaddr_un addr {};
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        LOG_ERROR("Unix socket路径无效: {}", path);
+        return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        LOG_ERROR("创建指标socket失败: {}", strerror(errno));
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.data(), path.size());
+    unlink(path.c_str());
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        LOG_ERROR("指标socket {}监听失败: {}", path, strerror(errno));
+        close(fd);
+        return false;
+    }
+    unix_path_ = path;
+    LOG_INFO("指标端点监听于{}", path);
+    return startThread(fd);
+}
+
+bool MetricsServer::startThread(int fd) {
+    listen_fd_ = fd;
+    running_ = true;
+    thread_ = std::thread(&MetricsServer::serveLoop, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+    close(listen_fd_);
+    listen_fd_ = -1;
+    port_ = 0;
+    if (!unix_path_.empty()) {
+        unlink(unix_path_.c_str());
+        unix_path_.clear();
+    }
+}
+
+void MetricsServer::serveLoop() {
+    while (running_) {
+        struct pollfd pfd {};
+        pfd.fd = listen_fd_;
+        pfd.events = POLLIN;
+        int ready = poll(&pfd, 1, kPollIntervalMs);
+        if (ready <= 0) continue;
+        int client = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno != EINTR && errno != EAGAIN) {
+                LOG_WARN("接受指标请求失败: {}", strerror(errno));
+            }
+            continue;
+        }
+        serveClient(client);
+        close(client);
+    }
+}
+
+void MetricsServer::serveClient(int fd) {
+    struct timeval timeout;
+    timeout.tv_sec = kClientTimeoutMs / 1000;
+    timeout.tv_usec = (kClientTimeoutMs % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // 只需要请求行，读到请求头结束即可
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < kMaxRequestSize) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        request.append(buffer, n);
+    }
+
+    size_t line_end = request.find("\r\n");
+    std::string line = request.substr(0, line_end);
+    if (line.rfind("GET /metrics ", 0) == 0 || line.rfind("GET / ", 0) == 0) {
+        writeAll(fd, httpResponse("200 OK", "text/plain; version=0.0.4",
+                                  MetricsRegistry::instance().prometheusText()));
+    } else if (line.rfind("GET /trace ", 0) == 0) {
+        // 未开启跟踪点时返回空的事件列表
+        writeAll(fd, httpResponse("200 OK", "application/json", traceEventsJson()));
+    } else {
+        writeAll(fd, httpResponse("404 Not Found", "text/plain", "not found\n"));
+    }
+}
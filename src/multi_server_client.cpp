@@ -0,0 +1,333 @@
+#include "multi_server_client.h"
+#include <chrono>
+#include <cmath>
+#include <random>
+#include "client_pool.h"
+#include "logger.h"
+#include "timing_wheel.h"
+
+namespace {
+
+// start()在连接超时之外额外等待的时间
+constexpr uint64_t kStartWaitMarginMs = 1000;
+
+uint64_t monotonicMicroseconds() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+LatencyEwma::LatencyEwma(uint64_t decay_ms)
+    : decay_ms_(static_cast<double>(std::max<uint64_t>(decay_ms, 1)))
+    , ewma_us_(0)
+    , last_ms_(0) {
+}
+
+void LatencyEwma::record(uint64_t rtt_us, uint64_t now_ms) {
+    uint64_t last = last_ms_.load(std::memory_order_relaxed);
+    uint64_t current = ewma_us_.load(std::memory_order_relaxed);
+    if (rtt_us > current) {
+        ewma_us_.store(rtt_us, std::memory_order_relaxed);
+    } else {
+        double elapsed = now_ms > last ? static_cast<double>(now_ms - last) : 0.0;
+        double weight = std::exp(-elapsed / decay_ms_);
+        ewma_us_.store(static_cast<uint64_t>(current * weight + rtt_us * (1.0 - weight)),
+                       std::memory_order_relaxed);
+    }
+    last_ms_.store(now_ms, std::memory_order_relaxed);
+}
+
+uint64_t LatencyEwma::valueUs(uint64_t now_ms) const {
+    uint64_t last = last_ms_.load(std::memory_order_relaxed);
+    double value = static_cast<double>(ewma_us_.load(std::memory_order_relaxed));
+    if (now_ms > last) {
+        value *= std::exp(-static_cast<double>(now_ms - last) / decay_ms_);
+    }
+    return static_cast<uint64_t>(value);
+}
+
+MultiServerClient::MultiServerClient(const std::vector<std::string>& hosts, const std::vector<int>& ports,
+                                     const BalancerConfig& config)
+    : MultiServerClient(ClientPool::defaultPool(), hosts, ports, config) {
+}
+
+MultiServerClient::MultiServerClient(ClientPool& pool, const std::vector<std::string>& hosts,
+                                     const std::vector<int>& ports, const BalancerConfig& config)
+    : members_up_(0)
+    , start_timeout_ms_(ReconnectConfig().connect_timeout_ms + kStartWaitMarginMs) {
+    if (hosts.size() != ports.size()) {
+        LOG_ERROR("服务器地址和端口数量不匹配: {}个地址, {}个端口", hosts.size(), ports.size());
+    }
+    size_t count = std::min(hosts.size(), ports.size());
+    size_t connections = std::max<size_t>(config.connections_per_server, 1);
+    for (size_t i = 0; i < count; ++i) {
+        servers_.push_back(std::make_unique<Server>(hosts[i], ports[i], config.decay_ms));
+        Server* server = servers_.back().get();
+        // 连接池按轮询分配事件循环，同一服务器的多条连接落在不同的循环线程上
+        for (size_t j = 0; j < connections; ++j) {
+            server->members.push_back(std::make_unique<Member>(pool, server));
+            Member* member = server->members.back().get();
+            member->client.setConnectionCallback([this, member](bool up) { onMemberConnection(member, up); });
+            members_.push_back(member);
+        }
+    }
+}
+
+MultiServerClient::~MultiServerClient() {
+    stop();
+}
+
+bool MultiServerClient::Server::connected() const {
+    for (const auto& member : members) {
+        if (member->client.isConnected()) return true;
+    }
+    return false;
+}
+
+void MultiServerClient::onMemberConnection(Member* member, bool up) {
+    Server* server = member->server;
+    std::function<void(const std::string&, bool)> callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 停止未连上的客户端时也会回调false，只统计真实的状态变化
+        if (member->up == up) return;
+        member->up = up;
+        up ? ++members_up_ : --members_up_;
+        up ? ++server->members_up : --server->members_up;
+        // 服务器的第一条连接建立或最后一条连接断开时才通知
+        if (server->members_up == (up ? 1u : 0u)) callback = connection_callback_;
+    }
+    cv_.notify_all();
+    if (callback) callback(server->name, up);
+}
+
+void MultiServerClient::start() {
+    startAsync();
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(start_timeout_ms_);
+    while (members_up_ == 0 && std::chrono::steady_clock::now() < deadline) {
+        cv_.wait_for(lock, deadline - std::chrono::steady_clock::now());
+    }
+}
+
+void MultiServerClient::startAsync() {
+    for (Member* member : members_) {
+        member->client.startAsync();
+    }
+}
+
+void MultiServerClient::stop() {
+    for (Member* member : members_) {
+        member->client.stop();
+    }
+}
+
+MultiServerClient::Member* MultiServerClient::pick() {
+    // 服务器数量很少，直接遍历统计可用的服务器，避免在热路径上分配内存
+    size_t connected = 0;
+    for (const auto& server : servers_) {
+        if (server->connected()) ++connected;
+    }
+    if (connected == 0) return nullptr;
+
+    auto nth = [this](size_t n) -> Server* {
+        for (const auto& server : servers_) {
+            if (server->connected() && n-- == 0) return server.get();
+        }
+        return nullptr;
+    };
+    thread_local std::mt19937 rng(std::random_device{}());
+    Server* chosen;
+    size_t first = rng() % connected;
+    Server* a = nth(first);
+    if (connected == 1) {
+        chosen = a;
+    } else {
+        size_t second = rng() % (connected - 1);
+        if (second >= first) ++second;
+        Server* b = nth(second);
+        if (a == nullptr || b == nullptr) {
+            // 连接状态可能在两次遍历之间变化
+            chosen = a != nullptr ? a : b;
+        } else {
+            uint64_t now = TimingWheel::monotonicMilliseconds();
+            uint64_t cost_a = (a->latency.valueUs(now) + 1) * (a->outstanding.load(std::memory_order_relaxed) + 1);
+            uint64_t cost_b = (b->latency.valueUs(now) + 1) * (b->outstanding.load(std::memory_order_relaxed) + 1);
+            chosen = cost_b < cost_a ? b : a;
+        }
+    }
+    if (chosen == nullptr) return nullptr;
+
+    // 选积压字节最少的连接，相同时比较在途调用数；从随机位置开始遍历，空闲时轮流使用各条连接
+    Member* best = nullptr;
+    size_t best_bytes = 0;
+    uint32_t best_calls = 0;
+    size_t count = chosen->members.size();
+    size_t offset = rng() % count;
+    for (size_t i = 0; i < count; ++i) {
+        Member* member = chosen->members[(offset + i) % count].get();
+        if (!member->client.isConnected()) continue;
+        size_t bytes = member->client.queuedBytes();
+        uint32_t calls = member->outstanding.load(std::memory_order_relaxed);
+        if (best == nullptr || bytes < best_bytes || (bytes == best_bytes && calls < best_calls)) {
+            best = member;
+            best_bytes = bytes;
+            best_calls = calls;
+        }
+    }
+    return best;
+}
+
+MultiServerClient::Member* MultiServerClient::pickByKey(std::string_view key) {
+    if (members_.empty()) return nullptr;
+    size_t start = std::hash<std::string_view>()(key) % members_.size();
+    for (size_t i = 0; i < members_.size(); ++i) {
+        Member* member = members_[(start + i) % members_.size()];
+        if (member->client.isConnected()) return member;
+    }
+    return nullptr;
+}
+
+bool MultiServerClient::callOn(Member* member, std::string_view request, CallCallback callback,
+                               uint64_t timeout_ms) {
+    if (member == nullptr) {
+        LOG_WARN("没有可用的服务器");
+        return false;
+    }
+    Server* server = member->server;
+    server->outstanding.fetch_add(1, std::memory_order_relaxed);
+    member->outstanding.fetch_add(1, std::memory_order_relaxed);
+    server->requests.fetch_add(1, std::memory_order_relaxed);
+    uint64_t start_us = monotonicMicroseconds();
+    // 同一服务器的各条连接可能在不同的循环线程上完成，延迟估计的并发写入只会丢失个别样本
+    bool ok = member->client.call(request, [member, start_us, callback = std::move(callback)](
+                                               CallStatus status, std::string_view payload) {
+        Server* server = member->server;
+        server->latency.record(monotonicMicroseconds() - start_us, TimingWheel::monotonicMilliseconds());
+        server->outstanding.fetch_sub(1, std::memory_order_relaxed);
+        member->outstanding.fetch_sub(1, std::memory_order_relaxed);
+        if (callback) callback(status, payload);
+    }, timeout_ms);
+    if (!ok) {
+        server->outstanding.fetch_sub(1, std::memory_order_relaxed);
+        member->outstanding.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return ok;
+}
+
+bool MultiServerClient::sendOn(Member* member, std::string_view data, SendCallback callback) {
+    if (member == nullptr) {
+        LOG_WARN("没有可用的服务器");
+        return false;
+    }
+    member->server->requests.fetch_add(1, std::memory_order_relaxed);
+    return member->client.sendAsync(data, std::move(callback));
+}
+
+bool MultiServerClient::call(std::string_view request, CallCallback callback, uint64_t timeout_ms) {
+    return callOn(pick(), request, std::move(callback), timeout_ms);
+}
+
+std::future<CallResult> MultiServerClient::call(std::string_view request, uint64_t timeout_ms) {
+    auto promise = std::make_shared<std::promise<CallResult>>();
+    std::future<CallResult> future = promise->get_future();
+    bool ok = callOn(pick(), request, [promise](CallStatus status, std::string_view payload) {
+        promise->set_value(CallResult{status, std::string(payload)});
+    }, timeout_ms);
+    if (!ok) {
+        promise->set_value(CallResult{CallStatus::Rejected, std::string()});
+    }
+    return future;
+}
+
+bool MultiServerClient::callByKey(std::string_view key, std::string_view request, CallCallback callback,
+                                  uint64_t timeout_ms) {
+    return callOn(pickByKey(key), request, std::move(callback), timeout_ms);
+}
+
+std::future<CallResult> MultiServerClient::callByKey(std::string_view key, std::string_view request,
+                                                     uint64_t timeout_ms) {
+    auto promise = std::make_shared<std::promise<CallResult>>();
+    std::future<CallResult> future = promise->get_future();
+    bool ok = callOn(pickByKey(key), request, [promise](CallStatus status, std::string_view payload) {
+        promise->set_value(CallResult{status, std::string(payload)});
+    }, timeout_ms);
+    if (!ok) {
+        promise->set_value(CallResult{CallStatus::Rejected, std::string()});
+    }
+    return future;
+}
+
+bool MultiServerClient::sendAsync(std::string_view data, SendCallback callback) {
+    return sendOn(pick(), data, std::move(callback));
+}
+
+bool MultiServerClient::sendByKey(std::string_view key, std::string_view data, SendCallback callback) {
+    return sendOn(pickByKey(key), data, std::move(callback));
+}
+
+bool MultiServerClient::send(std::string_view data) {
+    Member* member = pick();
+    if (member == nullptr) {
+        LOG_WARN("没有可用的服务器");
+        return false;
+    }
+    member->server->requests.fetch_add(1, std::memory_order_relaxed);
+    return member->client.send(data);
+}
+
+void MultiServerClient::setConnectionCallback(std::function<void(const std::string&, bool)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connection_callback_ = std::move(callback);
+}
+
+void MultiServerClient::setMessageCallback(MessageCallback callback) {
+    for (Member* member : members_) {
+        member->client.setMessageCallback(callback);
+    }
+}
+
+void MultiServerClient::setReconnectConfig(const ReconnectConfig& config) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        start_timeout_ms_ = config.connect_timeout_ms + kStartWaitMarginMs;
+    }
+    for (Member* member : members_) {
+        member->client.setReconnectConfig(config);
+    }
+}
+
+size_t MultiServerClient::connectedCount() const {
+    size_t count = 0;
+    for (const auto& server : servers_) {
+        if (server->connected()) ++count;
+    }
+    return count;
+}
+
+size_t MultiServerClient::connectionCount() const {
+    size_t count = 0;
+    for (Member* member : members_) {
+        if (member->client.isConnected()) ++count;
+    }
+    return count;
+}
+
+std::vector<ServerStats> MultiServerClient::stats() const {
+    uint64_t now = TimingWheel::monotonicMilliseconds();
+    std::vector<ServerStats> result;
+    for (const auto& server : servers_) {
+        ServerStats stats;
+        stats.server = server->name;
+        for (const auto& member : server->members) {
+            if (member->client.isConnected()) ++stats.connections;
+        }
+        stats.connected = stats.connections > 0;
+        stats.latency_us = server->latency.valueUs(now);
+        stats.outstanding = server->outstanding.load(std::memory_order_relaxed);
+        stats.requests = server->requests.load(std::memory_order_relaxed);
+        result.push_back(stats);
+    }
+    return result;
+}
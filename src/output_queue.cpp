@@ -0,0 +1,519 @@
+#include "output_queue.h"
+#include "logger.h"
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/errqueue.h>
+#include <errno.h>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+namespace {
+
+// 单次sendmsg在栈上准备的iovec数上限
+constexpr int kMaxIovecs = 256;
+
+// 没有可追加的尾部缓冲区时新建缓冲区的最小容量
+constexpr size_t kMinSegmentSize = 4096;
+
+// 已处理的队首条目达到该数量且超过一半时整体前移，持续积压的队列不会无限增长
+constexpr size_t kCompactMinHead = 64;
+
+// 关闭后等待零拷贝完成通知的轮询间隔与最长时间
+constexpr int kLingerPollMs = 100;
+constexpr auto kLingerTimeout = std::chrono::seconds(30);
+
+}  // namespace
+
+// 关闭时仍有零拷贝数据未完成的socket：内核仍引用这些内存，不能立即归还缓冲区池。
+// 后台线程读取它们的错误队列，全部完成（或超时后复位连接）再关闭socket并释放内存。
+// 只有用到零拷贝的连接带着未完成的数据关闭时才启动线程
+class ZerocopyLinger {
+public:
+    static ZerocopyLinger& instance() {
+        // 不析构：进程退出时后台线程可能仍在运行
+        static ZerocopyLinger* linger = new ZerocopyLinger();
+        return *linger;
+    }
+
+    void add(int fd, OutputQueue& queue) {
+        auto entry = std::make_unique<Entry>();
+        entry->fd = fd;
+        entry->tracker = queue.tracker_;
+        entry->deadline = std::chrono::steady_clock::now() + kLingerTimeout;
+        for (size_t i = queue.zerocopy_head_; i < queue.zerocopy_inflight_.size(); ++i) {
+            entry->segments.push_back(std::move(queue.zerocopy_inflight_[i]));
+        }
+        queue.zerocopy_inflight_.clear();
+        queue.zerocopy_head_ = 0;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 完成通知以EPOLLERR提示，事件掩码为空也会上报
+        struct epoll_event event {};
+        event.events = EPOLLET;
+        if (epoll_fd_ == -1 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+            LOG_WARN("等待零拷贝完成通知失败: {}", strerror(errno));
+        }
+        entries_.push_back(std::move(entry));
+    }
+
+private:
+    struct Entry {
+        int fd = -1;
+        ZerocopyTracker tracker;
+        std::vector<OutputQueue::InflightSegment> segments;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    ZerocopyLinger() : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)) {
+        if (epoll_fd_ == -1) {
+            LOG_ERROR("创建零拷贝等待epoll失败: {}", strerror(errno));
+        }
+        std::thread(&ZerocopyLinger::run, this).detach();
+    }
+
+    void run() {
+        while (true) {
+            struct epoll_event events[16];
+            if (epoll_fd_ == -1) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(kLingerPollMs));
+            } else {
+                epoll_wait(epoll_fd_, events, 16, kLingerPollMs);
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto now = std::chrono::steady_clock::now();
+            for (auto it = entries_.begin(); it != entries_.end();) {
+                Entry& entry = **it;
+                bool failed = entry.tracker.reap(entry.fd) < 0;
+                if (!failed && !entry.tracker.idle() && now < entry.deadline) {
+                    ++it;
+                    continue;
+                }
+                if (!entry.tracker.idle()) {
+                    // 复位连接：内核丢弃发送队列，不再引用这些内存
+                    struct linger abort_close {1, 0};
+                    setsockopt(entry.fd, SOL_SOCKET, SO_LINGER, &abort_close, sizeof(abort_close));
+                    LOG_WARN("零拷贝数据未在{}秒内完成，复位连接",
+                             std::chrono::duration_cast<std::chrono::seconds>(kLingerTimeout).count());
+                }
+                // 关闭后epoll自动移除该fd
+                close(entry.fd);
+                it = entries_.erase(it);
+            }
+        }
+    }
+
+    int epoll_fd_;
+    std::mutex mutex_;
+    std::list<std::unique_ptr<Entry>> entries_;
+};
+
+bool enableZerocopy(int fd) {
+    int one = 1;
+    return setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+}
+
+bool enableNoDelay(int fd) {
+    int one = 1;
+    return setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) == 0;
+}
+
+bool parseWritePolicy(std::string_view name, WritePolicy& policy) {
+    if (name == "latency") {
+        policy = WritePolicy::LowLatency;
+    } else if (name == "throughput") {
+        policy = WritePolicy::Throughput;
+    } else if (name == "adaptive") {
+        policy = WritePolicy::Adaptive;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int ZerocopyTracker::reap(int fd) {
+    int count = 0;
+    while (true) {
+        char control[128];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return count;
+            return -1;
+        }
+
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            bool is_recverr = (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                              (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR);
+            if (!is_recverr) continue;
+
+            struct sock_extended_err err;
+            memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+            if (err.ee_origin != SO_EE_ORIGIN_ZEROCOPY || err.ee_errno != 0) continue;
+
+            // ee_info到ee_data为本次通知覆盖的序号区间（含两端）
+            uint32_t next = err.ee_data + 1;
+            if (static_cast<int32_t>(next - completed_) > 0) {
+                completed_ = next;
+            }
+            if (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                ++copied_;
+            }
+            ++count;
+        }
+    }
+}
+
+OutputQueue::OutputQueue(const OutputConfig& config)
+    : config_(config)
+    , head_(0)
+    , pending_bytes_(0)
+    , zerocopy_enabled_(config.zerocopy_threshold > 0)
+    , zerocopy_head_(0)
+    , coalescing_(config.write_policy == WritePolicy::Throughput)
+    , corked_(false)
+    , draining_(false) {
+    config_.max_batch_iovecs = std::clamp(config_.max_batch_iovecs, 1, kMaxIovecs);
+    config_.max_batch_bytes = std::max<size_t>(config_.max_batch_bytes, 1);
+}
+
+OutputQueue::~OutputQueue() {
+    for (size_t i = head_; i < segments_.size(); ++i) {
+        if (segments_[i].isFile()) close(segments_[i].file_fd);
+    }
+}
+
+ByteBuffer& OutputQueue::tailBuffer(size_t len) {
+    if (head_ == segments_.size() || segments_.back().sealed) {
+        pushSegment(ByteBuffer(std::max(len, kMinSegmentSize)));
+    }
+    ByteBuffer& tail = segments_.back().data;
+    tail.ensureWritable(len);
+    return tail;
+}
+
+void OutputQueue::pushSegment(ByteBuffer&& data) {
+    segments_.emplace_back();
+    segments_.back().data = std::move(data);
+}
+
+void OutputQueue::append(std::string_view data) {
+    if (data.empty()) return;
+    tailBuffer(data.size()).append(data);
+    pending_bytes_ += data.size();
+}
+
+void OutputQueue::appendFrame(FrameType type, uint32_t sequence, std::string_view payload) {
+    ::appendFrame(tailBuffer(kFrameHeaderSize + payload.size()), type, sequence, payload);
+    pending_bytes_ += kFrameHeaderSize + payload.size();
+}
+
+void OutputQueue::append(ByteBuffer&& data) {
+    if (data.empty()) return;
+    pending_bytes_ += data.readableBytes();
+    pushSegment(std::move(data));
+    // 接管的数据块不再追加，后续数据进入新的尾部缓冲区
+    segments_.back().sealed = true;
+}
+
+void OutputQueue::appendFrame(FrameType type, uint32_t sequence, ByteBuffer&& payload) {
+    appendHeader(type, sequence, payload.readableBytes());
+    append(std::move(payload));
+}
+
+void OutputQueue::append(const SharedBuffer& data) {
+    if (data.empty()) return;
+    pending_bytes_ += data.size();
+    segments_.emplace_back();
+    segments_.back().shared = data;
+    segments_.back().sealed = true;
+}
+
+void OutputQueue::appendFrame(FrameType type, uint32_t sequence, const SharedBuffer& payload) {
+    appendHeader(type, sequence, payload.size());
+    append(payload);
+}
+
+void OutputQueue::appendFrame(FrameType type, uint32_t sequence, const struct iovec* iov, int iovcnt) {
+    size_t length = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        length += iov[i].iov_len;
+    }
+    appendHeader(type, sequence, length);
+    ByteBuffer& tail = tailBuffer(length);
+    for (int i = 0; i < iovcnt; ++i) {
+        tail.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+    pending_bytes_ += length;
+}
+
+void OutputQueue::appendFile(int file_fd, uint64_t offset, size_t len) {
+    if (len == 0) {
+        close(file_fd);
+        return;
+    }
+    pending_bytes_ += len;
+    segments_.emplace_back();
+    Segment& segment = segments_.back();
+    segment.file_fd = file_fd;
+    segment.file_offset = offset;
+    segment.file_remaining = len;
+    segment.sealed = true;
+}
+
+void OutputQueue::appendFrameFile(FrameType type, uint32_t sequence, int file_fd, uint64_t offset, size_t len) {
+    appendHeader(type, sequence, len);
+    appendFile(file_fd, offset, len);
+}
+
+void OutputQueue::appendHeader(FrameType type, uint32_t sequence, size_t length) {
+    FrameHeader header;
+    header.length = static_cast<uint32_t>(length);
+    header.type = static_cast<uint16_t>(type);
+    header.sequence = sequence;
+
+    ByteBuffer& tail = tailBuffer(kFrameHeaderSize);
+    encodeFrameHeader(tail.writePtr(), header);
+    tail.commit(kFrameHeaderSize);
+    pending_bytes_ += kFrameHeaderSize;
+}
+
+void OutputQueue::popFront() {
+    Segment& front = segments_[head_];
+    if (front.zerocopy_sent) {
+        // 剩余部分可能以普通方式发出，但之前零拷贝发出的部分仍被内核引用，等完成通知后再释放
+        zerocopy_inflight_.push_back({std::move(front.data), std::move(front.shared), front.zerocopy_id});
+    } else {
+        front.data.release();
+        front.shared.reset();
+    }
+    if (front.isFile()) {
+        close(front.file_fd);
+        front.file_fd = -1;
+    }
+    ++head_;
+    compact(segments_, head_);
+}
+
+template <typename T>
+void OutputQueue::compact(std::vector<T>& items, size_t& head) {
+    if (head == items.size()) {
+        items.clear();
+        head = 0;
+    } else if (head >= kCompactMinHead && head * 2 >= items.size()) {
+        items.erase(items.begin(), items.begin() + head);
+        head = 0;
+    }
+}
+
+bool OutputQueue::useZerocopy(const Segment& segment) const {
+    return zerocopy_enabled_ && !segment.isFile() && segment.readableBytes() >= config_.zerocopy_threshold;
+}
+
+OutputQueue::FlushResult OutputQueue::flush(int fd) {
+    FlushResult result = flushSegments(fd);
+    endWrite(fd);
+    return result;
+}
+
+OutputQueue::FlushResult OutputQueue::flushSegments(int fd) {
+    beginWrite(fd);
+    struct iovec iov[kMaxIovecs];
+    while (head_ < segments_.size()) {
+        Segment& front = segments_[head_];
+        if (front.isFile()) {
+            // 文件区间由内核从页缓存直接写入socket
+            off_t offset = static_cast<off_t>(front.file_offset);
+            ssize_t sent = sendfile(fd, front.file_fd, &offset,
+                                    std::min(front.file_remaining, config_.max_batch_bytes));
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return FlushResult::WouldBlock;
+                return FlushResult::Error;
+            }
+            if (sent == 0) {
+                // 文件比声明的区间短，帧已无法补全
+                errno = EIO;
+                return FlushResult::Error;
+            }
+            front.file_offset = static_cast<uint64_t>(offset);
+            front.file_remaining -= sent;
+            pending_bytes_ -= sent;
+            if (front.file_remaining == 0) popFront();
+            continue;
+        }
+        bool zerocopy = useZerocopy(front);
+
+        int count;
+        if (zerocopy) {
+            // 零拷贝数据块单独发送，发出后内核直接引用这段内存
+            front.sealed = true;
+            iov[0].iov_base = const_cast<char*>(front.readPtr());
+            iov[0].iov_len = std::min(front.readableBytes(), config_.max_batch_bytes);
+            count = 1;
+        } else {
+            // 普通数据块聚合发送，遇到零拷贝数据块为止
+            count = 0;
+            size_t bytes = 0;
+            for (size_t i = head_; i < segments_.size() && count < config_.max_batch_iovecs &&
+                                   bytes < config_.max_batch_bytes; ++i) {
+                const Segment& segment = segments_[i];
+                if (segment.isFile() || (i != head_ && useZerocopy(segment))) break;
+                size_t len = std::min(segment.readableBytes(), config_.max_batch_bytes - bytes);
+                iov[count].iov_base = const_cast<char*>(segment.readPtr());
+                iov[count].iov_len = len;
+                bytes += len;
+                ++count;
+            }
+        }
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        int flags = MSG_NOSIGNAL | (zerocopy ? MSG_ZEROCOPY : 0);
+        ssize_t sent = sendmsg(fd, &msg, flags);
+        if (sent < 0 && zerocopy && errno == ENOBUFS) {
+            // 未完成的零拷贝通知过多，本次改为普通发送
+            flags &= ~MSG_ZEROCOPY;
+            zerocopy = false;
+            sent = sendmsg(fd, &msg, flags);
+        }
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return FlushResult::WouldBlock;
+            return FlushResult::Error;
+        }
+
+        if (zerocopy) {
+            // 内核仍引用这段内存：数据块出队时转入等待完成通知的列表
+            front.zerocopy_sent = true;
+            front.zerocopy_id = tracker_.onSend();
+        }
+        advance(sent);
+    }
+    return FlushResult::Done;
+}
+
+int OutputQueue::gather(struct iovec* iov, int max_iov, size_t max_bytes) {
+    int count = 0;
+    size_t bytes = 0;
+    for (size_t i = head_; i < segments_.size() && count < max_iov && bytes < max_bytes; ++i) {
+        Segment& segment = segments_[i];
+        if (segment.isFile()) break;
+        segment.sealed = true;
+        size_t len = std::min(segment.readableBytes(), max_bytes - bytes);
+        iov[count].iov_base = const_cast<char*>(segment.readPtr());
+        iov[count].iov_len = len;
+        bytes += len;
+        ++count;
+    }
+    return count;
+}
+
+void OutputQueue::advance(size_t n) {
+    pending_bytes_ -= n;
+    while (n > 0) {
+        Segment& front = segments_[head_];
+        size_t len = std::min(n, front.readableBytes());
+        front.consume(len);
+        n -= len;
+        if (front.readableBytes() == 0) popFront();
+    }
+}
+
+bool OutputQueue::writeDue() const {
+    if (empty()) return false;
+    return !coalescing_ || draining_ || pending_bytes_ >= config_.coalesce_bytes;
+}
+
+void OutputQueue::beginWrite(int fd) {
+    if (config_.write_policy == WritePolicy::Adaptive) {
+        if (!coalescing_ && pending_bytes_ >= config_.adaptive_threshold_bytes) {
+            coalescing_ = true;
+        } else if (coalescing_ && pending_bytes_ < config_.adaptive_threshold_bytes / 4) {
+            coalescing_ = false;
+        }
+    }
+    if (coalescing_ != corked_) setCork(fd, coalescing_);
+}
+
+void OutputQueue::endWrite(int fd) {
+    draining_ = !empty();
+    // 解除cork时内核立即发出不满一个MSS的尾部，下次写出前再开启
+    if (!draining_ && corked_) setCork(fd, false);
+}
+
+void OutputQueue::setCork(int fd, bool on) {
+    int value = on ? 1 : 0;
+    // 失败时（如非TCP的socket）保持原状，只影响报文的合并方式
+    if (setsockopt(fd, IPPROTO_TCP, TCP_CORK, &value, sizeof(value)) == 0) {
+        corked_ = on;
+    }
+}
+
+bool OutputQueue::reapZerocopy(int fd) {
+    if (tracker_.reap(fd) < 0) return false;
+    if (tracker_.copiedCount() > 0) {
+        // 内核回退为拷贝（如回环设备），零拷贝只会增加开销
+        zerocopy_enabled_ = false;
+    }
+    releaseCompleted();
+    return true;
+}
+
+void OutputQueue::releaseCompleted() {
+    while (zerocopy_head_ < zerocopy_inflight_.size() &&
+           tracker_.completed(zerocopy_inflight_[zerocopy_head_].last_id)) {
+        zerocopy_inflight_[zerocopy_head_].data.release();
+        zerocopy_inflight_[zerocopy_head_].shared.reset();
+        ++zerocopy_head_;
+    }
+    compact(zerocopy_inflight_, zerocopy_head_);
+}
+
+bool OutputQueue::zerocopyPending() const {
+    if (zerocopy_head_ < zerocopy_inflight_.size()) return true;
+    for (size_t i = head_; i < segments_.size(); ++i) {
+        if (segments_[i].zerocopy_sent) return true;
+    }
+    return false;
+}
+
+void OutputQueue::closeSocket(int fd) {
+    // 部分以零拷贝发出后因缓冲区满停下的数据块还在队列中，内核同样引用着它，
+    // 与已出队的数据块一起等待完成通知
+    for (size_t i = head_; i < segments_.size(); ++i) {
+        Segment& segment = segments_[i];
+        if (!segment.zerocopy_sent) continue;
+        pending_bytes_ -= segment.readableBytes();
+        zerocopy_inflight_.push_back({std::move(segment.data), std::move(segment.shared), segment.zerocopy_id});
+        segment.zerocopy_sent = false;
+    }
+    if (zerocopyPending()) reapZerocopy(fd);
+    if (!zerocopyPending()) {
+        close(fd);
+        return;
+    }
+    ZerocopyLinger::instance().add(fd, *this);
+}
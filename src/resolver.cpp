@@ -0,0 +1,260 @@
+#include "resolver.h"
+#include <netdb.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
+#include "logger.h"
+#include "timing_wheel.h"
+
+namespace {
+
+// 解析线程空闲时检查退出标志的间隔
+constexpr auto kWorkerPollInterval = std::chrono::milliseconds(100);
+
+bool sameAddress(const SocketAddress& a, const SocketAddress& b) {
+    return a.length == b.length && memcmp(&a.storage, &b.storage, a.length) == 0;
+}
+
+}  // namespace
+
+int SocketAddress::port() const {
+    if (family() == AF_INET) {
+        return ntohs(reinterpret_cast<const struct sockaddr_in*>(&storage)->sin_port);
+    }
+    if (family() == AF_INET6) {
+        return ntohs(reinterpret_cast<const struct sockaddr_in6*>(&storage)->sin6_port);
+    }
+    return 0;
+}
+
+void SocketAddress::setPort(int port) {
+    if (family() == AF_INET) {
+        reinterpret_cast<struct sockaddr_in*>(&storage)->sin_port = htons(port);
+    } else if (family() == AF_INET6) {
+        reinterpret_cast<struct sockaddr_in6*>(&storage)->sin6_port = htons(port);
+    }
+}
+
+std::string SocketAddress::toString() const {
+    char ip[INET6_ADDRSTRLEN] = {0};
+    if (family() == AF_INET) {
+        inet_ntop(AF_INET, &reinterpret_cast<const struct sockaddr_in*>(&storage)->sin_addr, ip, sizeof(ip));
+        return std::string(ip) + ":" + std::to_string(port());
+    }
+    if (family() == AF_INET6) {
+        inet_ntop(AF_INET6, &reinterpret_cast<const struct sockaddr_in6*>(&storage)->sin6_addr, ip, sizeof(ip));
+        return "[" + std::string(ip) + "]:" + std::to_string(port());
+    }
+    return std::string();
+}
+
+bool SocketAddress::parse(const std::string& ip, int port, SocketAddress& address) {
+    address = SocketAddress();
+    auto* v4 = reinterpret_cast<struct sockaddr_in*>(&address.storage);
+    if (inet_pton(AF_INET, ip.c_str(), &v4->sin_addr) == 1) {
+        v4->sin_family = AF_INET;
+        v4->sin_port = htons(port);
+        address.length = sizeof(struct sockaddr_in);
+        return true;
+    }
+    auto* v6 = reinterpret_cast<struct sockaddr_in6*>(&address.storage);
+    if (inet_pton(AF_INET6, ip.c_str(), &v6->sin6_addr) == 1) {
+        v6->sin6_family = AF_INET6;
+        v6->sin6_port = htons(port);
+        address.length = sizeof(struct sockaddr_in6);
+        return true;
+    }
+    return false;
+}
+
+Resolver::Resolver(const ResolverConfig& config)
+    : config_(config)
+    , idle_workers_(0)
+    , stopping_(false)
+    , lookups_(0) {
+}
+
+Resolver::~Resolver() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+
+    // 未完成的查询以失败回调
+    std::vector<Waiter> waiters;
+    for (auto& item : cache_) {
+        for (Waiter& waiter : item.second.waiters) {
+            waiters.push_back(std::move(waiter));
+        }
+    }
+    cache_.clear();
+    for (Waiter& waiter : waiters) {
+        waiter.callback(std::vector<SocketAddress>());
+    }
+}
+
+Resolver& Resolver::defaultResolver() {
+    static Resolver* resolver = new Resolver();
+    return *resolver;
+}
+
+void Resolver::resolve(const std::string& host, int port, ResolveCallback callback) {
+    SocketAddress numeric;
+    if (SocketAddress::parse(host, port, numeric)) {
+        callback(std::vector<SocketAddress>{numeric});
+        return;
+    }
+
+    std::vector<SocketAddress> cached;
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t now = TimingWheel::monotonicMilliseconds();
+        Entry& entry = cache_[host];
+        if (!entry.resolving && now < entry.expires_ms) {
+            cached = withPort(entry.addresses, port);
+        } else if (!stopping_) {
+            entry.waiters.push_back(Waiter{port, std::move(callback)});
+            queued = true;
+            if (!entry.resolving) {
+                entry.resolving = true;
+                pending_.push_back(host);
+                // 空闲线程不够取走所有待解析的主机名时再创建一个，直到达到上限
+                if (pending_.size() > idle_workers_ &&
+                    workers_.size() < std::max<size_t>(1, config_.max_threads)) {
+                    workers_.emplace_back(&Resolver::workerLoop, this);
+                }
+            }
+            evictLocked(now);
+        }
+    }
+    if (queued) {
+        cv_.notify_one();
+    } else {
+        callback(cached);
+    }
+}
+
+void Resolver::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = cache_.begin(); it != cache_.end();) {
+        if (it->second.resolving) {
+            ++it;
+        } else {
+            it = cache_.erase(it);
+        }
+    }
+}
+
+uint64_t Resolver::lookupCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lookups_;
+}
+
+void Resolver::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (pending_.empty()) {
+            ++idle_workers_;
+            cv_.wait_for(lock, kWorkerPollInterval);
+            --idle_workers_;
+            continue;
+        }
+        std::string host = std::move(pending_.front());
+        pending_.pop_front();
+        ++lookups_;
+
+        lock.unlock();
+        std::vector<SocketAddress> addresses = lookup(host);
+        lock.lock();
+
+        Entry& entry = cache_[host];
+        entry.addresses = addresses;
+        entry.resolving = false;
+        entry.expires_ms = TimingWheel::monotonicMilliseconds() +
+                           (addresses.empty() ? config_.negative_ttl_ms : config_.ttl_ms);
+        std::vector<Waiter> waiters;
+        waiters.swap(entry.waiters);
+
+        // 回调不持有锁，回调中可以再次解析
+        lock.unlock();
+        if (addresses.empty()) {
+            LOG_WARN("解析域名{}失败", host);
+        }
+        for (Waiter& waiter : waiters) {
+            waiter.callback(withPort(addresses, waiter.port));
+        }
+        lock.lock();
+    }
+}
+
+std::vector<SocketAddress> Resolver::lookup(const std::string& host) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_ADDRCONFIG;
+
+    struct addrinfo* result = nullptr;
+    int error = getaddrinfo(host.c_str(), nullptr, &hints, &result);
+    if (error != 0) {
+        LOG_DEBUG("getaddrinfo({})失败: {}", host, gai_strerror(error));
+        return {};
+    }
+
+    // getaddrinfo已按RFC 6724排好优先级，这里按族分开后交替合并，
+    // 某个地址族整体不通时，并行连接很快就会轮到另一族
+    std::vector<SocketAddress> families[2];
+    for (struct addrinfo* ai = result; ai != nullptr; ai = ai->ai_next) {
+        if ((ai->ai_family != AF_INET && ai->ai_family != AF_INET6) ||
+            ai->ai_addrlen > sizeof(struct sockaddr_storage)) {
+            continue;
+        }
+        SocketAddress address;
+        memcpy(&address.storage, ai->ai_addr, ai->ai_addrlen);
+        address.length = ai->ai_addrlen;
+        address.setPort(0);
+        std::vector<SocketAddress>& list = families[ai->ai_family == AF_INET6 ? 1 : 0];
+        bool duplicate = false;
+        for (const SocketAddress& existing : list) {
+            if (sameAddress(existing, address)) duplicate = true;
+        }
+        if (!duplicate) list.push_back(address);
+    }
+    int first_family = result->ai_family == AF_INET6 ? 1 : 0;
+    freeaddrinfo(result);
+
+    std::vector<SocketAddress> addresses;
+    std::vector<SocketAddress>& first = families[first_family];
+    std::vector<SocketAddress>& second = families[1 - first_family];
+    for (size_t i = 0; i < first.size() || i < second.size(); ++i) {
+        if (i < first.size()) addresses.push_back(first[i]);
+        if (i < second.size()) addresses.push_back(second[i]);
+    }
+    return addresses;
+}
+
+std::vector<SocketAddress> Resolver::withPort(const std::vector<SocketAddress>& addresses, int port) {
+    std::vector<SocketAddress> result(addresses);
+    for (SocketAddress& address : result) {
+        address.setPort(port);
+    }
+    return result;
+}
+
+void Resolver::evictLocked(uint64_t now) {
+    if (cache_.size() <= config_.max_entries) return;
+    for (auto it = cache_.begin(); it != cache_.end();) {
+        if (!it->second.resolving && now >= it->second.expires_ms) {
+            it = cache_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
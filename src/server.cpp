@@ -1,171 +1,211 @@
+#include "tcp_server.h"
+#include "logger.h"
+#include "metrics_server.h"
+#include "trace.h"
 #include <iostream>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <unistd.h>
-#include <thread>
-#include <vector>
-#include <atomic>
 #include <string>
-#include <cstring>
-#include <errno.h>
-#include <algorithm>
+#include <cstdlib>
+#include <csignal>
 
-class TcpServer {
-public:
-    explicit TcpServer(int port) : port_(port), running_(false), server_fd_(-1) {}
-    
-    ~TcpServer() {
-        stop();
-    }
-    
-    void start() {
-        if (running_) return;
-        
-        server_fd_ = socket(AF_INET, SOCK_STREAM, 0);
-        if (server_fd_ == -1) {
-            std::cerr << "创建socket失败: " << strerror(errno) << std::endl;
-            return;
-        }
-
-        // 设置socket选项，允许地址重用
-        int opt = 1;
-        if (setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-            std::cerr << "设置socket选项失败: " << strerror(errno) << std::endl;
-            close(server_fd_);
-            server_fd_ = -1;
-            return;
-        }
-
-        struct sockaddr_in address;
-        address.sin_family = AF_INET;
-        address.sin_addr.s_addr = INADDR_ANY;
-        address.sin_port = htons(port_);
+void printUsage(const char* programName) {
+    std::cout << "用法: " << programName << " [选项]\n"
+              << "选项:\n"
+              << "  -h, --help                显示帮助信息\n"
+              << "  -p, --port <端口>         监听端口 (默认: 8888)\n"
+              << "  -m, --mode <模式>         I/O模式: epoll | uring | thread (默认: epoll)\n"
+              << "  -r, --reactors <数量>     epoll反应器线程数 (默认: CPU核心数)\n"
+              << "  -c, --max-connections <数量>  最大连接数 (默认: 0，不限制)\n"
+              << "  -b, --backlog <长度>      listen队列长度 (默认: 128)\n"
+              << "      --accept-rate <每秒>  全局每秒接受的新连接数 (默认: 0，不限制)\n"
+              << "      --source-rate <每秒>  每个源IP每秒接受的新连接数 (默认: 0，不限制)\n"
+              << "  -z, --zerocopy <字节>     不小于该大小的响应使用MSG_ZEROCOPY发送 (默认: 0，关闭)\n"
+              << "  -w, --write-policy <策略> 响应的写出策略: latency | throughput | adaptive (默认: latency)\n"
+              << "      --idle-timeout <毫秒>   关闭空闲超过该时间的连接 (默认: 0，不限制)\n"
+              << "      --read-timeout <毫秒>   未在该时间内收齐整帧的连接被关闭 (默认: 0，不限制)\n"
+              << "      --write-timeout <毫秒>  积压响应在该时间内没有发送进展时关闭连接 (默认: 0，不限制)\n"
+              << "      --metrics-port <端口>   在127.0.0.1的该端口上提供Prometheus指标 (默认: 0，关闭)\n"
+              << "      --metrics-socket <路径> 在该Unix域socket上提供Prometheus指标\n"
+              << "      --trace <文件>          收到SIGUSR1和退出时把跟踪记录写成trace-event JSON（需ENABLE_TRACE编译）\n"
+              << std::endl;
+}
 
-        if (bind(server_fd_, (struct sockaddr*)&address, sizeof(address)) < 0) {
-            std::cerr << "绑定端口失败: " << strerror(errno) << std::endl;
-            close(server_fd_);
-            server_fd_ = -1;
-            return;
-        }
+// 指标端点，不属于服务器本身的配置
+struct MetricsOptions {
+    int port = 0;             // 大于0时在该端口上提供指标
+    std::string socket_path;  // 非空时在该Unix域socket上提供指标
+    std::string trace_path;   // 非空时导出跟踪记录
+};
 
-        if (listen(server_fd_, 10) < 0) {
-            std::cerr << "监听失败: " << strerror(errno) << std::endl;
-            close(server_fd_);
-            server_fd_ = -1;
-            return;
-        }
+ServerConfig parseArguments(int argc, char* argv[], MetricsOptions& metrics) {
+    ServerConfig config;
 
-        running_ = true;
-        std::cout << "服务器启动成功，监听端口: " << port_ << std::endl;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
 
-        while (running_) {
-            struct sockaddr_in client_addr;
-            socklen_t client_len = sizeof(client_addr);
-            std::cout << "等待客户端连接..." << std::endl;
-            int client_socket = accept(server_fd_, (struct sockaddr*)&client_addr, &client_len);
-            
-            if (client_socket < 0) {
-                if (errno == EINTR) {  // 被信号中断
-                    continue;
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            exit(0);
+        } else if (arg == "-p" || arg == "--port") {
+            if (i + 1 < argc) {
+                config.port = std::atoi(argv[++i]);
+                if (config.port <= 0 || config.port > 65535) {
+                    std::cerr << "错误：端口号必须在1-65535之间" << std::endl;
+                    exit(1);
                 }
-                std::cerr << "接受连接失败: " << strerror(errno) << std::endl;
-                continue;
             }
-
-            char client_ip[INET_ADDRSTRLEN];
-            inet_ntop(AF_INET, &(client_addr.sin_addr), client_ip, INET_ADDRSTRLEN);
-            std::cout << "新客户端连接，IP: " << client_ip 
-                      << ", 端口: " << ntohs(client_addr.sin_port) << std::endl;
-
-            // 使用智能指针管理客户端线程
-            auto client_thread = std::make_unique<std::thread>(&TcpServer::handleClient, this, client_socket);
-            client_threads_.push_back(std::move(client_thread));
-            
-            // 清理已完成的线程
-            cleanupFinishedThreads();
-        }
-    }
-
-    void stop() {
-        if (!running_) return;
-        
-        running_ = false;
-        
-        // 关闭服务器socket
-        if (server_fd_ != -1) {
-            close(server_fd_);
-            server_fd_ = -1;
-        }
-        
-        // 等待所有客户端线程结束
-        for (auto& thread : client_threads_) {
-            if (thread && thread->joinable()) {
-                thread->join();
+        } else if (arg == "-r" || arg == "--reactors") {
+            if (i + 1 < argc) {
+                config.reactor_count = std::atoi(argv[++i]);
+                if (config.reactor_count <= 0) {
+                    std::cerr << "错误：反应器线程数必须大于0" << std::endl;
+                    exit(1);
+                }
             }
-        }
-        client_threads_.clear();
-        
-        std::cout << "服务器已停止" << std::endl;
-    }
-
-private:
-    void handleClient(int client_socket) {
-        // 使用RAII方式管理客户端socket
-        struct SocketGuard {
-            int fd;
-            SocketGuard(int fd) : fd(fd) {}
-            ~SocketGuard() { if (fd != -1) close(fd); }
-        } guard(client_socket);
-        
-        char buffer[1024];
-        while (running_) {
-            int bytes_read = recv(client_socket, buffer, sizeof(buffer), 0);
-            if (bytes_read <= 0) {
-                if (bytes_read == 0) {
-                    std::cout << "客户端主动断开连接" << std::endl;
-                } else if (errno != EINTR) {  // 忽略被信号中断的情况
-                    std::cerr << "接收数据失败: " << strerror(errno) << std::endl;
+        } else if (arg == "-c" || arg == "--max-connections") {
+            if (i + 1 < argc) {
+                long long count = std::atoll(argv[++i]);
+                if (count < 0) {
+                    std::cerr << "错误：最大连接数不能为负数" << std::endl;
+                    exit(1);
                 }
-                break;
+                config.admission.max_connections = static_cast<size_t>(count);
             }
-            buffer[bytes_read] = '\0';
-            std::cout << "收到消息: " << buffer << std::endl;
-            
-            // 发送响应
-            std::string response = "服务器已收到消息";
-            if (send(client_socket, response.c_str(), response.length(), 0) < 0) {
-                if (errno != EINTR) {  // 忽略被信号中断的情况
-                    std::cerr << "发送响应失败: " << strerror(errno) << std::endl;
+        } else if (arg == "-b" || arg == "--backlog") {
+            if (i + 1 < argc) {
+                config.admission.backlog = std::atoi(argv[++i]);
+                if (config.admission.backlog <= 0) {
+                    std::cerr << "错误：listen队列长度必须大于0" << std::endl;
+                    exit(1);
+                }
+            }
+        } else if (arg == "--accept-rate" || arg == "--source-rate") {
+            if (i + 1 < argc) {
+                double rate = std::atof(argv[++i]);
+                if (rate < 0) {
+                    std::cerr << "错误：连接速率不能为负数" << std::endl;
+                    exit(1);
+                }
+                if (arg == "--accept-rate") {
+                    config.admission.accept_rate = rate;
+                } else {
+                    config.admission.source_accept_rate = rate;
+                }
+            }
+        } else if (arg == "--idle-timeout" || arg == "--read-timeout" || arg == "--write-timeout") {
+            if (i + 1 < argc) {
+                int timeout = std::atoi(argv[++i]);
+                if (timeout < 0) {
+                    std::cerr << "错误：超时时间不能为负数" << std::endl;
+                    exit(1);
+                }
+                if (arg == "--idle-timeout") {
+                    config.timeouts.idle_timeout_ms = timeout;
+                } else if (arg == "--read-timeout") {
+                    config.timeouts.read_timeout_ms = timeout;
+                } else {
+                    config.timeouts.write_timeout_ms = timeout;
+                }
+            }
+        } else if (arg == "--metrics-port") {
+            if (i + 1 < argc) {
+                metrics.port = std::atoi(argv[++i]);
+                if (metrics.port <= 0 || metrics.port > 65535) {
+                    std::cerr << "错误：指标端口必须在1-65535之间" << std::endl;
+                    exit(1);
+                }
+            }
+        } else if (arg == "--metrics-socket") {
+            if (i + 1 < argc) {
+                metrics.socket_path = argv[++i];
+            }
+        } else if (arg == "--trace") {
+            if (i + 1 < argc) {
+                metrics.trace_path = argv[++i];
+            }
+        } else if (arg == "-z" || arg == "--zerocopy") {
+            if (i + 1 < argc) {
+                long long threshold = std::atoll(argv[++i]);
+                if (threshold < 0) {
+                    std::cerr << "错误：零拷贝阈值不能为负数" << std::endl;
+                    exit(1);
+                }
+                config.output.zerocopy_threshold = static_cast<size_t>(threshold);
+            }
+        } else if (arg == "-w" || arg == "--write-policy") {
+            if (i + 1 < argc) {
+                std::string policy = argv[++i];
+                if (!parseWritePolicy(policy, config.output.write_policy)) {
+                    std::cerr << "错误：未知的写出策略 " << policy << std::endl;
+                    exit(1);
+                }
+            }
+        } else if (arg == "-m" || arg == "--mode") {
+            if (i + 1 < argc) {
+                std::string mode = argv[++i];
+                if (mode == "epoll") {
+                    config.engine = ServerEngine::Epoll;
+                } else if (mode == "uring") {
+                    config.engine = ServerEngine::IoUring;
+                } else if (mode == "thread") {
+                    config.engine = ServerEngine::ThreadPerConnection;
+                } else {
+                    std::cerr << "错误：未知的I/O模式 " << mode << std::endl;
+                    exit(1);
                 }
-                break;
             }
         }
-        std::cout << "客户端连接已关闭" << std::endl;
     }
-    
-    void cleanupFinishedThreads() {
-        client_threads_.erase(
-            std::remove_if(
-                client_threads_.begin(),
-                client_threads_.end(),
-                [](const auto& thread) {
-                    return thread && !thread->joinable();
-                }
-            ),
-            client_threads_.end()
-        );
+
+    return config;
+}
+
+int main(int argc, char* argv[]) {
+    MetricsOptions metrics_options;
+    ServerConfig config = parseArguments(argc, argv, metrics_options);
+
+    // 屏蔽退出信号，由主线程同步等待，其他线程继承该屏蔽字
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    TcpServer server(config);
+    LOG_INFO("正在启动服务器...");
+    if (!server.start()) {
+        return 1;
     }
 
-    int server_fd_;
-    int port_;
-    std::atomic<bool> running_;
-    std::vector<std::unique_ptr<std::thread>> client_threads_;
-};
+    // 每个MetricsServer只监听一个端点
+    MetricsServer metrics_tcp;
+    MetricsServer metrics_unix;
+    if (metrics_options.port > 0 && !metrics_tcp.listenTcp(metrics_options.port)) {
+        server.stop();
+        return 1;
+    }
+    if (!metrics_options.socket_path.empty() && !metrics_unix.listenUnix(metrics_options.socket_path)) {
+        server.stop();
+        return 1;
+    }
 
-int main() {
-    TcpServer server(8888);
-    std::cout << "正在启动服务器..." << std::endl;
-    server.start();
+#ifndef TCP_TRACE
+    if (!metrics_options.trace_path.empty()) {
+        LOG_WARN("未开启ENABLE_TRACE编译，跟踪文件中没有记录");
+    }
+#endif
+
+    // SIGUSR1导出当前的跟踪记录后继续运行
+    int sig = 0;
+    while (sigwait(&signals, &sig) == 0 && sig == SIGUSR1) {
+        if (!metrics_options.trace_path.empty() && dumpTrace(metrics_options.trace_path)) {
+            LOG_INFO("跟踪记录已写入{}", metrics_options.trace_path);
+        }
+    }
+    server.stop();
+    if (!metrics_options.trace_path.empty()) {
+        dumpTrace(metrics_options.trace_path);
+    }
     return 0;
-} 
\ No newline at end of file
+}
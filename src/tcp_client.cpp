@@ -1,227 +1,1380 @@
 #include "tcp_client.h"
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
-#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "logger.h"
 #include <cstring>
 #include <errno.h>
 #include <algorithm>
-#include <fcntl.h>
-#include <poll.h>
+#include <sys/uio.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <condition_variable>
+#include "client_pool.h"
+#include "event_loop.h"
+#include "mpsc_queue.h"
+#include "inflight_table.h"
+#include "frame.h"
+#include "metrics.h"
+#include "resolver.h"
+#include "trace.h"
 
-class SocketGuard {
-public:
-    explicit SocketGuard(int& sock) : sock_(sock) {}
-    ~SocketGuard() {
-        if (sock_ >= 0) {
-            close(sock_);
-            sock_ = -1;
-        }
+namespace {
+
+// 同步发送等待完成的最长时间
+constexpr auto kSyncSendTimeout = std::chrono::seconds(5);
+
+// start()在连接超时之外额外等待的时间，stop()等待事件循环完成清理的最长时间
+constexpr auto kStartWaitMargin = std::chrono::seconds(1);
+constexpr auto kStopWaitTimeout = std::chrono::seconds(5);
+
+// 小于该大小的负载拷贝合并到发送缓冲区，否则接管负载缓冲区
+constexpr size_t kCopyPayloadSize = 1024;
+
+// io_uring单次SENDMSG携带的iovec数上限
+constexpr int kMaxSendIovecs = 64;
+
+// 每次recv使用的栈上接收块大小
+constexpr size_t kReadChunkSize = 64 * 1024;
+
+// 客户端指标，所有连接共用，按线程分槽累计
+struct ClientMetrics {
+    ClientMetrics() {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        bytes_sent = registry.counter("tcp_client_bytes_sent_total", "写入socket的字节数（含帧头）");
+        bytes_received = registry.counter("tcp_client_bytes_received_total", "从socket读取的字节数");
+        messages_sent = registry.counter("tcp_client_messages_sent_total", "成功写出的消息数");
+        frames_received = registry.counter("tcp_client_frames_received_total", "收到的完整帧数");
+        send_failures = registry.counter("tcp_client_send_failures_total", "因断开或停止而未写出的消息数");
+        send_rejected = registry.counter("tcp_client_send_rejected_total", "未连接或积压超过高水位而拒绝入队的消息数");
+        send_stalls = registry.counter("tcp_client_send_stalls_total", "socket发送缓冲区满（EAGAIN）而暂停写出的次数");
+        connects = registry.counter("tcp_client_connects_total", "成功建立的连接数");
+        connect_failures = registry.counter("tcp_client_connect_failures_total", "失败的连接轮次数");
+        disconnects = registry.counter("tcp_client_disconnects_total", "已建立的连接断开的次数");
+        queued_bytes = registry.gauge("tcp_client_send_queue_bytes", "所有连接发送队列中积压的字节数");
+        send_latency = registry.histogram("tcp_client_send_latency_us", "消息从入队到写入socket的时间（微秒）");
+        call_latency = registry.histogram("tcp_client_call_latency_us", "调用从入队到收到响应的时间（微秒）");
+        connect_time = registry.histogram("tcp_client_connect_time_us", "一轮连接从开始解析到连接建立的时间（微秒）");
     }
-private:
-    int& sock_;
+
+    Counter bytes_sent;
+    Counter bytes_received;
+    Counter messages_sent;
+    Counter frames_received;
+    Counter send_failures;
+    Counter send_rejected;
+    Counter send_stalls;
+    Counter connects;
+    Counter connect_failures;
+    Counter disconnects;
+    Gauge queued_bytes;
+    Histogram send_latency;
+    Histogram call_latency;
+    Histogram connect_time;
 };
 
-TcpClient::TcpClient(const std::string& ip, int port)
-    : server_ip_(ip)
-    , server_port_(port)
-    , sock_fd_(-1)
-    , running_(false)
-    , connected_(false) {
+const ClientMetrics& clientMetrics() {
+    static const ClientMetrics metrics;
+    return metrics;
 }
 
-TcpClient::~TcpClient() {
-    stop();
+uint64_t monotonicMicroseconds() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-void TcpClient::start() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (running_) return;
-    
-    running_ = true;
-    connected_ = false;
-    
-    // 创建重连线程
-    reconnect_thread_ = std::thread(&TcpClient::reconnectThread, this);
-    
-    // 尝试首次连接
-    if (connect()) {
-        connected_ = true;
-        notifyConnectionChange(true);
+int socketError(int fd) {
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0) return errno;
+    return error;
+}
+
+// 把多段数据依次拷贝进buffer，只分配一次
+void appendIovecs(ByteBuffer& buffer, const struct iovec* iov, int iovcnt) {
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        total += iov[i].iov_len;
+    }
+    buffer.ensureWritable(total);
+    for (int i = 0; i < iovcnt; ++i) {
+        buffer.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
     }
 }
 
-void TcpClient::stop() {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (!running_) return;
-        running_ = false;
-    }
-    
-    // 关闭socket
-    closeSocket();
-    
-    // 等待重连线程结束
-    if (reconnect_thread_.joinable()) {
-        reconnect_thread_.join();
-    }
-    
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        connected_ = false;
-        notifyConnectionChange(false);
+}  // namespace
+
+uint64_t reconnectBackoffMs(const ReconnectConfig& config, uint32_t failures) {
+    // 每个线程一个随机数发生器，不同进程、不同线程的种子不同
+    thread_local std::mt19937_64 rng(std::random_device{}());
+    uint64_t ceiling = config.initial_backoff_ms;
+    for (uint32_t i = 0; i < failures && ceiling < config.max_backoff_ms; ++i) {
+        ceiling *= 2;
     }
+    ceiling = std::min(ceiling, config.max_backoff_ms);
+    return std::uniform_int_distribution<uint64_t>(0, ceiling)(rng);
 }
 
-void TcpClient::closeSocket() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (sock_fd_ != -1) {
-        close(sock_fd_);
-        sock_fd_ = -1;
+const char* connectionStateName(ConnectionState state) {
+    switch (state) {
+    case ConnectionState::Stopped:
+        return "stopped";
+    case ConnectionState::Connecting:
+        return "connecting";
+    case ConnectionState::Connected:
+        return "connected";
+    case ConnectionState::Draining:
+        return "draining";
+    case ConnectionState::Backoff:
+        return "backoff";
     }
+    return "unknown";
 }
 
-bool TcpClient::connect() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    closeSocket();
-    
-    sock_fd_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock_fd_ == -1) {
-        std::cerr << "创建socket失败: " << strerror(errno) << std::endl;
-        return false;
+// 发送请求：负载在入队时拷贝进池化缓冲区，对象本身也来自缓冲区池，
+// 稳态下入队和完成都不触发堆分配。负载也可以是共享缓冲区的引用或文件区间，
+// 三者只用其一
+struct TcpClient::SendRequest : public PoolAllocated, public TimerHandler {
+    ~SendRequest() {
+        if (file_fd >= 0) close(file_fd);
     }
-    
-    SocketGuard guard(sock_fd_);  // RAII: 自动管理socket资源
 
-    // 设置非阻塞模式
-    int flags = fcntl(sock_fd_, F_GETFL, 0);
-    fcntl(sock_fd_, F_SETFL, flags | O_NONBLOCK);
+    SendRequest* next = nullptr;
+    ByteBuffer payload;
+    SharedBuffer shared;
+    int file_fd = -1;                 // 请求持有的文件描述符副本，交给发送队列后置为-1
+    uint64_t file_offset = 0;
+    size_t file_len = 0;
+    size_t bytes = 0;                 // 含帧头的字节数，计入积压
+    uint64_t enqueued_us = 0;         // 入队时间，用于发送和调用延迟
+    uint64_t end_offset = 0;          // 该帧末尾在连接字节流中的位置
+    std::optional<std::promise<bool>> promise;
+    SendCallback callback;
 
-    // 设置socket选项
-    int opt = 1;
-    if (setsockopt(sock_fd_, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof(opt)) < 0) {
-        std::cerr << "设置socket选项失败: " << strerror(errno) << std::endl;
-        return false;
+    // 同步发送：调用方和事件循环各持有一个引用，后释放的一方回收对象，
+    // 这样调用方等待超时返回后事件循环仍可安全地完成请求
+    bool sync = false;
+    std::atomic<int> refs{1};
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    bool ok = false;
+
+    void release() {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+
+    size_t payloadSize() const {
+        if (file_fd >= 0) return file_len;
+        return shared.empty() ? payload.readableBytes() : shared.size();
+    }
+
+    // 调用：写出后登记在连接的在途表中，由响应、截止时间或连接断开三者之一完成。
+    // 以下字段除deadline_ms外只在事件循环线程上访问
+    bool call = false;
+    std::optional<std::promise<CallResult>> call_promise;
+    CallCallback call_callback;
+    uint64_t deadline_ms = 0;         // 单调时钟的截止时间，0表示没有
+    uint32_t sequence = 0;            // 请求帧的序号，即请求id
+    bool in_output = false;           // 仍在连接的发送队列中，未写出
+    bool in_table = false;            // 登记在在途表中
+    bool finished = false;            // 已通知调用方
+    Connection* owner = nullptr;
+    Timer timer{this};
+
+    void onTimer(Timer&) override;
+};
+
+// 池中的一条客户端连接：连接、收发和重连都在所属事件循环上完成。
+// 句柄、投递到循环的任务和待处理的通知各持有一个引用，最后释放的一方回收
+class TcpClient::Connection : public EventHandler, public TimerHandler, public LoopNotification {
+public:
+    using State = ConnectionState;
+
+    // addresses非空时直接按顺序连接这些地址，否则每次连接前解析host。
+    // 状态变化投递到callbacks上回调
+    Connection(ClientPool& pool, const std::string& host, int port,
+               const std::vector<SocketAddress>& addresses)
+        : pool_(pool)
+        , loop_(pool.nextLoop())
+        , callbacks_(pool.callbackLoop())
+        , server_host_(host)
+        , server_port_(port)
+        , addresses_(addresses)
+        , timer_(this)
+        , attempt_timer_(this)
+        , coalesce_timer_(this) {
+        state_notifier_.owner = this;
+        uring_send_.owner = this;
+        trace_id_ = traceNextId();
+        // 提前注册指标，采集端在第一次收发之前就能看到它们
+        clientMetrics();
+    }
+
+    void retain() { refs_.fetch_add(1, std::memory_order_relaxed); }
+    void release() {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+
+    // 启动连接，wait为true时等待首次连接的结果
+    void start(bool wait) {
+        uint64_t attempts;
+        std::chrono::milliseconds timeout;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (running_.load(std::memory_order_relaxed)) return;
+            running_.store(true, std::memory_order_release);
+            attempts = attempts_;
+            timeout = std::chrono::milliseconds(reconnect_config_.connect_timeout_ms);
+        }
+        runOnLoop([this] { startOnLoop(); });
+        if (!wait) return;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto deadline = std::chrono::steady_clock::now() + timeout + kStartWaitMargin;
+        while (attempts_ == attempts && std::chrono::steady_clock::now() < deadline) {
+            cv_.wait_for(lock, deadline - std::chrono::steady_clock::now());
+        }
     }
 
-    struct sockaddr_in server_addr;
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(server_port_);
-    server_addr.sin_addr.s_addr = inet_addr(server_ip_.c_str());
+    // 停止连接并等待事件循环完成清理，再等回调线程送达停止前的所有状态变化；
+    // 在循环线程上（如发送完成回调中）调用时直接清理，不等待回调线程
+    void stop() {
+        uint64_t stops;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_.load(std::memory_order_relaxed)) return;
+            running_.store(false, std::memory_order_release);
+            stops = stops_;
+        }
+        if (loop_.isInLoopThread()) {
+            stopOnLoop();
+            return;
+        }
+        runOnLoop([this] { stopOnLoop(); });
 
-    // 非阻塞连接
-    int ret = ::connect(sock_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr));
-    if (ret == -1) {
-        if (errno != EINPROGRESS) {
-            std::cerr << "连接服务器失败: " << strerror(errno) << std::endl;
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto deadline = std::chrono::steady_clock::now() + kStopWaitTimeout;
+        while (stops_ == stops && std::chrono::steady_clock::now() < deadline) {
+            cv_.wait_for(lock, deadline - std::chrono::steady_clock::now());
+        }
+        if (stops_ == stops) {
+            LOG_ERROR("等待客户端连接关闭超时");
+            return;
+        }
+        // 在状态回调中停止时，剩余的回调要等当前回调返回后才能送达
+        if (callbacks_.isInLoopThread()) return;
+        uint64_t published = published_.load(std::memory_order_acquire);
+        while (delivered_ < published && std::chrono::steady_clock::now() < deadline) {
+            cv_.wait_for(lock, deadline - std::chrono::steady_clock::now());
+        }
+    }
+
+    // 把请求放入发送队列并通知事件循环；check_watermark为false时不受高水位限制
+    bool enqueue(SendRequest* request, bool check_watermark) {
+        const ClientMetrics& metrics = clientMetrics();
+        if (!connected()) {
+            LOG_WARN("未连接到服务器，无法发送数据");
+            metrics.send_rejected.inc();
+            return false;
+        }
+        request->bytes = kFrameHeaderSize + request->payloadSize();
+        size_t queued = queued_bytes_.fetch_add(request->bytes, std::memory_order_relaxed);
+        if (check_watermark && queued + request->bytes > send_high_watermark_.load(std::memory_order_relaxed)) {
+            queued_bytes_.fetch_sub(request->bytes, std::memory_order_relaxed);
+            LOG_DEBUG("发送队列积压{}字节，超过高水位", queued);
+            metrics.send_rejected.inc();
             return false;
         }
+        metrics.queued_bytes.add(static_cast<int64_t>(request->bytes));
+        request->enqueued_us = monotonicMicroseconds();
+        TRACE_INSTANT("enqueue", trace_id_);
+        // 队列由空变为非空时才通知，onNotify()每次取走全部请求，
+        // 所以同一时刻最多只有一个待处理的通知
+        if (send_queue_.push(request)) {
+            retain();
+            loop_.notify(this);
+        }
+        return true;
+    }
+
+    // 回调只在循环线程上使用，从其他线程设置时投递到循环上替换
+    void setMessageCallback(MessageCallback callback) {
+        if (loop_.isInLoopThread()) {
+            message_callback_ = std::move(callback);
+            return;
+        }
+        runOnLoop([this, callback = std::move(callback)]() mutable {
+            message_callback_ = std::move(callback);
+        });
+    }
+
+    bool running() const { return running_.load(std::memory_order_acquire); }
+
+    bool connected() const { return state_.load(std::memory_order_acquire) == State::Connected; }
+
+    State state() const { return state_.load(std::memory_order_acquire); }
+
+    std::string remoteAddress() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return remote_address_;
+    }
+
+    void handleEvent(uint32_t events) override {
+        if (state_ != State::Connected) return;
+
+        if (events & EPOLLERR) {
+            // 零拷贝完成通知也以EPOLLERR提示：读完通知后socket本身没有错误则继续处理
+            if (!output_->zerocopyPending() || !output_->reapZerocopy(fd_) || socketError(fd_) != 0) {
+                disconnect("连接出错");
+                return;
+            }
+        }
+        if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) {
+            if (!readAll()) {
+                // 回调中停止了客户端时连接已经关闭
+                if (state_ == State::Connected) disconnect("接收中断");
+                return;
+            }
+        }
+        // io_uring发送在途时记下可写通知，完成时若因缓冲区满而未发完则立即重新提交
+        if (events & EPOLLOUT) uring_send_.writable = true;
+        // 合并写出期间的可写通知不提前写出，由合并定时器或积累的数据量触发
+        if ((events & EPOLLOUT) && output_->writeDue()) {
+            flushOutput();
+        }
+    }
+
+    void onTimer(Timer& timer) override {
+        if (&timer == &coalesce_timer_) {
+            if (state_ == State::Connected) flushOutput();
+            return;
+        }
+        if (&timer == &attempt_timer_) {
+            // 已发起的尝试在错开时间内没有结果，并行发起下一个地址
+            if (state_ == State::Connecting) startNextAttempt();
+            return;
+        }
+        if (state_ == State::Connecting) {
+            LOG_ERROR("连接超时");
+            connectFailed();
+        } else if (state_ == State::Backoff) {
+            LOG_INFO("尝试重新连接服务器...");
+            beginConnect();
+        }
+    }
+
+    // 取出发送队列中的全部请求追加到连接的发送队列，按写出策略聚合后非阻塞地写出
+    void onNotify() override {
+        TRACE_SCOPE("drain_send_queue", trace_id_);
+        SendRequest* request = send_queue_.popAll();
+        while (request != nullptr) {
+            SendRequest* next = request->next;
+            if (state_ == State::Connected) {
+                appendRequest(request);
+            } else {
+                completeRequest(request, false);
+            }
+            request = next;
+        }
+        if (state_ == State::Connected) {
+            scheduleFlush();
+        }
+        release();
+    }
 
-        // 等待连接完成
-        struct pollfd pfd;
-        pfd.fd = sock_fd_;
-        pfd.events = POLLOUT;
-        
-        ret = poll(&pfd, 1, 5000);  // 5秒超时
-        if (ret <= 0) {
-            std::cerr << "连接超时或错误" << std::endl;
+private:
+    ~Connection() override = default;
+
+    // 投递到事件循环执行，任务持有一个引用
+    template <typename F>
+    void runOnLoop(F&& f) {
+        retain();
+        loop_.post([this, f = std::forward<F>(f)]() mutable {
+            f();
+            release();
+        });
+    }
+
+    void startOnLoop() {
+        if (state_ != State::Stopped || !running()) return;
+        failures_ = 0;
+        beginConnect();
+    }
+
+    void stopOnLoop() {
+        timer_.cancel();
+        if (state_ != State::Stopped) setState(State::Draining);
+        closeSocket();
+        // 先投递状态变化再唤醒stop()的调用方，stop()据此等待回调送达
+        setState(State::Stopped);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stops_;
+        }
+        cv_.notify_all();
+    }
+
+    // 一次连接尝试：每个候选地址一个非阻塞socket，连接完成或失败时回调所属连接
+    struct ConnectAttempt : public EventHandler {
+        Connection* owner = nullptr;
+        int fd = -1;  // 关闭后为-1，之后同一批事件中残留的回调被忽略
+        SocketAddress address;
+
+        void handleEvent(uint32_t events) override {
+            if (fd != -1) owner->onAttemptEvent(*this, events);
+        }
+    };
+
+    // 开始一轮连接：先解析地址（数字地址和缓存命中时同步完成），再按happy eyeballs
+    // 错开发起连接。连接超时覆盖解析和所有尝试
+    void beginConnect() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            connect_config_ = reconnect_config_;
+        }
+        // 上一轮的尝试对象在这里才释放：关闭时它们可能仍在同一批epoll事件中
+        connect_attempts_.clear();
+        candidates_.clear();
+        next_candidate_ = 0;
+        connect_started_us_ = monotonicMicroseconds();
+        setState(State::Connecting);
+        loop_.timers().schedule(timer_, connect_config_.connect_timeout_ms);
+
+        uint64_t round = ++connect_round_;
+        if (!addresses_.empty()) {
+            onResolved(round, addresses_);
+            return;
+        }
+        retain();
+        Resolver::defaultResolver().resolve(server_host_, server_port_,
+                                            [this, round](const std::vector<SocketAddress>& addresses) {
+            // 同步回调时就在本循环线程上，否则从解析线程投递回来
+            if (loop_.isInLoopThread()) {
+                onResolved(round, addresses);
+                release();
+                return;
+            }
+            loop_.post([this, round, addresses] {
+                onResolved(round, addresses);
+                release();
+            });
+        });
+    }
+
+    void onResolved(uint64_t round, const std::vector<SocketAddress>& addresses) {
+        // 解析期间连接已超时、停止或开始了新一轮
+        if (round != connect_round_ || state_ != State::Connecting) return;
+        if (addresses.empty()) {
+            LOG_ERROR("解析服务器地址{}失败", server_host_);
+            connectFailed();
+            return;
+        }
+        candidates_ = addresses;
+        startNextAttempt();
+    }
+
+    // 按顺序对下一个候选地址发起连接，之后若还有地址，等待attempt_delay_ms仍没有结果
+    // 就并行发起下一个（RFC 8305）。没有剩余地址且所有尝试都已失败时本轮连接失败
+    void startNextAttempt() {
+        attempt_timer_.cancel();
+        while (next_candidate_ < candidates_.size()) {
+            if (openAttempt(candidates_[next_candidate_++])) {
+                if (next_candidate_ < candidates_.size()) {
+                    loop_.timers().schedule(attempt_timer_, connect_config_.attempt_delay_ms);
+                }
+                return;
+            }
+        }
+        for (const auto& attempt : connect_attempts_) {
+            if (attempt->fd != -1) return;
+        }
+        connectFailed();
+    }
+
+    bool openAttempt(const SocketAddress& address) {
+        int fd = socket(address.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd == -1) {
+            LOG_ERROR("创建socket失败: {}", strerror(errno));
             return false;
         }
 
-        // 检查连接是否成功
-        int error = 0;
-        socklen_t len = sizeof(error);
-        if (getsockopt(sock_fd_, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
-            std::cerr << "连接失败: " << strerror(error) << std::endl;
+        int opt = 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof(opt)) < 0) {
+            LOG_ERROR("设置socket选项失败: {}", strerror(errno));
+            close(fd);
+            return false;
+        }
+
+        // 非阻塞连接：完成或失败时socket变为可写，由onAttemptEvent()检查结果
+        if (::connect(fd, address.get(), address.length) == -1 && errno != EINPROGRESS) {
+            LOG_WARN("连接{}失败: {}", address.toString(), strerror(errno));
+            close(fd);
+            return false;
+        }
+        auto attempt = std::make_unique<ConnectAttempt>();
+        attempt->owner = this;
+        attempt->fd = fd;
+        attempt->address = address;
+        if (!loop_.add(fd, EPOLLOUT | EPOLLET, attempt.get())) {
+            close(fd);
             return false;
         }
+        connect_attempts_.push_back(std::move(attempt));
+        return true;
     }
 
-    // 恢复阻塞模式
-    fcntl(sock_fd_, F_SETFL, flags);
+    // 第一个成功的尝试胜出，接管为连接的socket，其余尝试全部关闭
+    void onAttemptEvent(ConnectAttempt& attempt, uint32_t events) {
+        int error = socketError(attempt.fd);
+        if (error == 0 && (events & EPOLLHUP)) error = ECONNRESET;
+        if (error == 0 && !(events & EPOLLOUT)) return;
+        if (error != 0) {
+            LOG_WARN("连接{}失败: {}", attempt.address.toString(), strerror(error));
+            loop_.remove(attempt.fd);
+            close(attempt.fd);
+            attempt.fd = -1;
+            // 失败时立即尝试下一个地址，不必等到错开时间
+            startNextAttempt();
+            return;
+        }
 
-    std::cout << "成功连接到服务器" << std::endl;
-    return true;
-}
+        fd_ = attempt.fd;
+        loop_.remove(fd_);
+        attempt.fd = -1;
+        closeAttempts();
+        if (!loop_.add(fd_, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, this)) {
+            connectFailed();
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            remote_address_ = attempt.address.toString();
+        }
+        onConnected();
+    }
 
-void TcpClient::reconnectThread() {
-    while (isRunning()) {
-        if (!isConnected()) {
-            std::cout << "尝试重新连接服务器..." << std::endl;
-            if (connect()) {
-                {
-                    std::lock_guard<std::mutex> lock(mutex_);
-                    connected_ = true;
-                }
-                notifyConnectionChange(true);
-                std::cout << "重连成功" << std::endl;
+    void closeAttempts() {
+        attempt_timer_.cancel();
+        for (const auto& attempt : connect_attempts_) {
+            if (attempt->fd != -1) {
+                loop_.remove(attempt->fd);
+                close(attempt->fd);
+                attempt->fd = -1;
+            }
+        }
+    }
+
+    void onConnected() {
+        timer_.cancel();
+        bool use_uring;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_config_ = output_config_;
+            use_uring = use_uring_;
+        }
+        uring_ = use_uring ? pool_.uring(loop_) : nullptr;
+        if (use_uring && uring_ == nullptr) {
+            LOG_WARN("io_uring不可用，回退到epoll");
+        }
+        if (active_config_.zerocopy_threshold > 0 && !enableZerocopy(fd_)) {
+            active_config_.zerocopy_threshold = 0;
+        }
+        if (!enableNoDelay(fd_)) {
+            LOG_WARN("设置TCP_NODELAY失败: {}", strerror(errno));
+        }
+        output_ = std::make_unique<OutputQueue>(active_config_);
+        // 解析缓冲区只存放跨越recv边界的不完整帧，首次需要时才申请内存
+        decoder_ = std::make_unique<FrameDecoder>(0);
+        appended_ = flushed_ = 0;
+        failures_ = 0;
+        clientMetrics().connects.inc();
+        clientMetrics().connect_time.record(monotonicMicroseconds() - connect_started_us_);
+        setState(State::Connected);
+        finishAttempt();
+
+        LOG_INFO("成功连接到服务器{}", remoteAddress());
+    }
+
+    // 连接未建立：按退避时间稍后重试
+    void connectFailed() {
+        clientMetrics().connect_failures.inc();
+        closeSocket();
+        uint64_t delay = scheduleReconnect(++failures_);
+        finishAttempt();
+        LOG_WARN("连接失败，{}毫秒后重试", delay);
+    }
+
+    // 进入等待重连状态并启动定时器，返回等待的毫秒数
+    uint64_t scheduleReconnect(uint32_t failures) {
+        ReconnectConfig config;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            config = reconnect_config_;
+        }
+        uint64_t delay = reconnectBackoffMs(config, failures);
+        setState(State::Backoff);
+        loop_.timers().schedule(timer_, delay);
+        return delay;
+    }
+
+    // 唤醒等待首次连接结果的start()
+    void finishAttempt() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++attempts_;
+        }
+        cv_.notify_all();
+    }
+
+    // 已建立的连接断开：未写出的请求失败，在退避基数内随机等待后重连
+    void disconnect(const char* reason) {
+        LOG_WARN("连接断开: {}", reason);
+        clientMetrics().disconnects.inc();
+        TRACE_INSTANT("disconnect", trace_id_);
+        setState(State::Draining);
+        closeSocket();
+        // 失败请求的完成回调中可能已停止客户端
+        if (state_ == State::Draining) {
+            scheduleReconnect(0);
+        }
+    }
+
+    // 注销并关闭socket，已追加但未写出的请求失败
+    void closeSocket() {
+        closeAttempts();
+        coalesce_timer_.cancel();
+        if (fd_ != -1) {
+            loop_.remove(fd_);
+            if (uring_send_.inflight) {
+                // 在途的发送持有socket的引用，关闭fd不会让它结束：先确保请求已交给内核，
+                // 再关闭读写让它以错误完成；完成之前发送队列中的数据须保持有效
+                uring_->submit();
+                shutdown(fd_, SHUT_RDWR);
+                uring_send_.retired = std::move(output_);
+            }
+            if (output_) {
+                // 零拷贝数据未完成时由发送队列延后关闭
+                output_->closeSocket(fd_);
             } else {
-                std::cout << "重连失败，3秒后重试" << std::endl;
-                std::this_thread::sleep_for(std::chrono::seconds(3));
+                close(fd_);
+            }
+            fd_ = -1;
+            std::lock_guard<std::mutex> lock(mutex_);
+            remote_address_.clear();
+        }
+        // 回调中可能再次停止客户端，每次先把请求摘下再完成
+        while (SendRequest* request = popInflight()) {
+            completeRequest(request, false);
+        }
+        inflight_calls_.drain([this](SendRequest* call) {
+            call->in_table = false;
+            finishCall(call, CallStatus::Disconnected, std::string_view());
+        });
+        output_.reset();
+    }
+
+    SendRequest* popInflight() {
+        SendRequest* request = inflight_head_;
+        if (request != nullptr) {
+            inflight_head_ = request->next;
+            if (inflight_head_ == nullptr) inflight_tail_ = nullptr;
+        }
+        return request;
+    }
+
+    // 读取服务器的消息：完整的帧直接在栈上的接收块中解析并以视图回调，
+    // 只有跨越recv边界的不完整帧拷贝进连接的解析缓冲区。
+    // 对端关闭、出错或回调中停止了客户端时返回false
+    bool readAll() {
+        TRACE_SCOPE("read", trace_id_);
+        char buffer[kReadChunkSize];
+        auto on_frame = [this](const FrameHeader& header, std::string_view payload) {
+            if (state_ != State::Connected) return;
+            clientMetrics().frames_received.inc();
+            if (header.type == static_cast<uint16_t>(FrameType::Response)) {
+                if (SendRequest* call = inflight_calls_.take(header.sequence)) {
+                    call->in_table = false;
+                    finishCall(call, CallStatus::Ok, payload);
+                    return;
+                }
             }
+            if (!message_callback_) return;
+            try {
+                message_callback_(header, payload);
+            } catch (const std::exception& e) {
+                LOG_ERROR("消息回调异常: {}", e.what());
+            }
+        };
+        while (true) {
+            ssize_t n = recv(fd_, buffer, sizeof(buffer), 0);
+            if (n > 0) {
+                clientMetrics().bytes_received.inc(n);
+                if (!decoder_->feed(buffer, n, on_frame)) {
+                    LOG_WARN("收到非法帧");
+                    return false;
+                }
+                if (state_ != State::Connected) return false;
+                continue;
+            }
+            if (n == 0) {
+                LOG_INFO("服务器关闭了连接");
+                return false;
+            }
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+            LOG_ERROR("接收数据失败: {}", strerror(errno));
+            return false;
+        }
+    }
+
+    void appendRequest(SendRequest* request) {
+        // 文件区间和共享缓冲区不拷贝；小负载拷贝合并到尾部缓冲区，大负载按所有权接管
+        if (request->file_fd >= 0) {
+            output_->appendFrameFile(FrameType::Message, next_sequence_++, request->file_fd,
+                                     request->file_offset, request->file_len);
+            request->file_fd = -1;
+        } else if (!request->shared.empty()) {
+            output_->appendFrame(FrameType::Message, next_sequence_++, request->shared);
+            request->shared.reset();
+        } else if (request->payload.readableBytes() < kCopyPayloadSize) {
+            output_->appendFrame(FrameType::Message, next_sequence_++,
+                                 std::string_view(request->payload.readPtr(),
+                                                  request->payload.readableBytes()));
+            request->payload.release();
         } else {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            output_->appendFrame(FrameType::Message, next_sequence_++, std::move(request->payload));
+        }
+        if (request->call) {
+            request->sequence = next_sequence_ - 1;
+            request->owner = this;
+            request->in_output = true;
+            request->in_table = inflight_calls_.insert(request->sequence, request);
+            if (request->deadline_ms != 0) {
+                uint64_t now = loop_.timers().now();
+                loop_.timers().schedule(request->timer,
+                                        request->deadline_ms > now ? request->deadline_ms - now : 0);
+            }
         }
+        appended_ += request->bytes;
+        request->end_offset = appended_;
+        request->next = nullptr;
+        if (inflight_tail_ != nullptr) {
+            inflight_tail_->next = request;
+        } else {
+            inflight_head_ = request;
+        }
+        inflight_tail_ = request;
+    }
+
+    // 有新数据排入：写出策略要求立即写出时写出，否则启动合并定时器等待更多数据
+    void scheduleFlush() {
+        if (output_->writeDue()) {
+            flushOutput();
+        } else if (!output_->empty() && !coalesce_timer_.armed()) {
+            loop_.timers().schedule(coalesce_timer_, output_->coalesceDelayMs());
+        }
+    }
+
+    // 非阻塞地写出发送队列，socket缓冲区满时等待下一次EPOLLOUT。使用io_uring时只提交
+    // 发送请求，由循环处理完成事件时确认写出的字节
+    void flushOutput() {
+        coalesce_timer_.cancel();
+        if (output_->empty()) return;
+        TRACE_SCOPE("flush", trace_id_);
+        // 同一时刻只有一个发送在途，新数据在它完成后一并提交
+        if (uring_send_.inflight) return;
+        if (uring_ != nullptr && submitUringSend()) return;
+        size_t before = output_->pendingBytes();
+        OutputQueue::FlushResult result = output_->flush(fd_);
+        afterWrite(before - output_->pendingBytes(), result);
+    }
+
+    // 写出written字节之后：完成已整体写入的请求，出错时断开连接
+    void afterWrite(size_t written, OutputQueue::FlushResult result) {
+        flushed_ += written;
+        clientMetrics().bytes_sent.inc(written);
+        if (result == OutputQueue::FlushResult::WouldBlock) {
+            clientMetrics().send_stalls.inc();
+            TRACE_INSTANT("send_stall", trace_id_);
+        }
+        while (inflight_head_ != nullptr && inflight_head_->end_offset <= flushed_) {
+            completeRequest(popInflight(), true);
+        }
+        // 完成回调中可能停止了客户端
+        if (state_ != State::Connected) return;
+
+        if (result == OutputQueue::FlushResult::Error) {
+            LOG_ERROR("发送数据失败: {}", strerror(errno));
+            disconnect("发送失败");
+        }
+    }
+
+    // 把队首数据作为一个SENDMSG提交到循环共用的io_uring，不等待完成。
+    // 队首是文件区间或提交队列已满时返回false，由调用方同步写出
+    bool submitUringSend() {
+        UringSend& send = uring_send_;
+        output_->beginWrite(fd_);
+        int count = output_->gather(send.iov, std::min(kMaxSendIovecs, active_config_.max_batch_iovecs),
+                                    active_config_.max_batch_bytes);
+        if (count == 0) return false;
+        struct io_uring_sqe* sqe = uring_->prepare(&send);
+        if (sqe == nullptr) return false;
+
+        memset(&send.msg, 0, sizeof(send.msg));
+        send.msg.msg_iov = send.iov;
+        send.msg.msg_iovlen = count;
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = fd_;
+        sqe->addr = reinterpret_cast<uint64_t>(&send.msg);
+        sqe->len = 1;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        send.inflight = true;
+        send.writable = false;
+        // 完成事件到达之前连接不能回收
+        retain();
+        return true;
+    }
+
+    // io_uring发送完成，在循环线程上回调
+    void onSendComplete(int result) {
+        UringSend& send = uring_send_;
+        send.inflight = false;
+        if (send.retired) {
+            // 连接已在发送途中关闭，数据不再被内核引用
+            send.retired.reset();
+        } else if (state_ == State::Connected) {
+            size_t before = output_->pendingBytes();
+            OutputQueue::FlushResult flush_result = OutputQueue::FlushResult::Done;
+            // socket是非阻塞的，缓冲区满时io_uring同样返回EAGAIN
+            if (result == -EAGAIN) {
+                flush_result = OutputQueue::FlushResult::WouldBlock;
+            } else if (result < 0 && result != -EINTR) {
+                errno = -result;
+                flush_result = OutputQueue::FlushResult::Error;
+            } else if (result > 0) {
+                output_->advance(result);
+            }
+            output_->endWrite(fd_);
+            afterWrite(before - output_->pendingBytes(), flush_result);
+            // 在途期间已收到可写通知时EPOLLOUT不会再来，直接重试
+            if (flush_result == OutputQueue::FlushResult::WouldBlock && !send.writable) {
+                release();
+                return;
+            }
+        }
+        // 继续发送剩余数据和在途期间新排入的数据；重连后的新连接也可能在等待
+        if (state_ == State::Connected && !output_->empty()) {
+            flushOutput();
+        }
+        release();
+    }
+
+    // 请求写出或失败：通知调用方并释放请求。调用写出后继续等待响应
+    void completeRequest(SendRequest* request, bool ok) {
+        queued_bytes_.fetch_sub(request->bytes, std::memory_order_relaxed);
+        const ClientMetrics& metrics = clientMetrics();
+        metrics.queued_bytes.sub(static_cast<int64_t>(request->bytes));
+        if (ok) {
+            metrics.messages_sent.inc();
+            metrics.send_latency.record(monotonicMicroseconds() - request->enqueued_us);
+        } else {
+            metrics.send_failures.inc();
+        }
+        if (request->call) {
+            request->in_output = false;
+            if (request->finished) {
+                delete request;
+            } else if (!ok) {
+                finishCall(request, CallStatus::Disconnected, std::string_view());
+            }
+            return;
+        }
+        if (request->sync) {
+            {
+                std::lock_guard<std::mutex> lock(request->mutex);
+                request->done = true;
+                request->ok = ok;
+            }
+            request->cv.notify_one();
+            request->release();
+            return;
+        }
+        if (request->promise) {
+            request->promise->set_value(ok);
+        } else if (request->callback) {
+            try {
+                request->callback(ok);
+            } catch (const std::exception& e) {
+                LOG_ERROR("发送回调异常: {}", e.what());
+            }
+        }
+        delete request;
+    }
+
+public:
+    // 调用完成：从在途表中移除并通知调用方；请求仍在发送队列中时等写出或失败后再释放
+    void finishCall(SendRequest* call, CallStatus status, std::string_view payload) {
+        call->finished = true;
+        if (status == CallStatus::Ok) {
+            clientMetrics().call_latency.record(monotonicMicroseconds() - call->enqueued_us);
+        }
+        if (call->in_table) {
+            inflight_calls_.take(call->sequence);
+            call->in_table = false;
+        }
+        call->timer.cancel();
+        if (call->call_promise) {
+            call->call_promise->set_value(CallResult{status, std::string(payload)});
+        } else if (call->call_callback) {
+            try {
+                call->call_callback(status, payload);
+            } catch (const std::exception& e) {
+                LOG_ERROR("调用回调异常: {}", e.what());
+            }
+        }
+        if (!call->in_output) delete call;
+    }
+
+private:
+    // 一次状态变化，由循环线程产生，回调线程消费
+    struct StateEvent : public PoolAllocated {
+        StateEvent* next = nullptr;
+        State previous;
+        State state;
+    };
+
+    // 投递到回调线程的通知，与投递到所属循环的发送通知分开
+    struct StateNotifier : public LoopNotification {
+        Connection* owner = nullptr;
+        void onNotify() override { owner->deliverStates(); }
+    };
+
+    // 在途的io_uring发送：msghdr和iovec在完成之前须保持有效
+    struct UringSend : public UringCompletion {
+        Connection* owner = nullptr;
+        struct msghdr msg;
+        struct iovec iov[kMaxSendIovecs];
+        bool inflight = false;
+        bool writable = false;                 // 在途期间收到过EPOLLOUT
+        std::unique_ptr<OutputQueue> retired;  // 发送途中关闭的连接的发送队列
+        void onUringComplete(int result) override { owner->onSendComplete(result); }
+    };
+
+    // 切换状态并把变化投递到回调线程，只在循环线程上调用。读取方无锁地看到新状态，
+    // 回调按变化顺序在回调线程上执行
+    void setState(State next) {
+        State previous = state_.load(std::memory_order_relaxed);
+        if (previous == next) return;
+        state_.store(next, std::memory_order_release);
+        // 每个状态是一段按连接关联的区间，查看器中每条连接一行
+        if (previous != State::Stopped) TRACE_ASYNC_END(connectionStateName(previous), trace_id_);
+        if (next != State::Stopped) TRACE_ASYNC_BEGIN(connectionStateName(next), trace_id_);
+
+        auto* event = new StateEvent();
+        event->previous = previous;
+        event->state = next;
+        published_.fetch_add(1, std::memory_order_release);
+        // 队列由空变为非空时才通知，deliverStates()每次取走全部变化
+        if (state_events_.push(event)) {
+            retain();
+            callbacks_.notify(&state_notifier_);
+        }
+    }
+
+    // 回调线程：按顺序回调取出的所有状态变化，回调时不持有任何锁，可以调用句柄的任何方法
+    void deliverStates() {
+        StateEvent* event = state_events_.popAll();
+        std::function<void(bool)> connection_callback;
+        StateCallback state_callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            connection_callback = connection_callback_;
+            state_callback = state_callback_;
+        }
+        while (event != nullptr) {
+            StateEvent* next = event->next;
+            try {
+                if (state_callback) state_callback(event->previous, event->state);
+                // 布尔回调只关心可用性：连上为true，每次进入断开或停止流程为false
+                if (connection_callback && event->state == State::Connected) {
+                    connection_callback(true);
+                } else if (connection_callback && event->state == State::Draining) {
+                    connection_callback(false);
+                }
+            } catch (const std::exception& e) {
+                LOG_ERROR("连接回调异常: {}", e.what());
+            }
+            delete event;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++delivered_;
+            }
+            cv_.notify_all();
+            event = next;
+        }
+        release();
+    }
+
+public:
+    // 由句柄设置的配置，mutex_保护，连接建立时读取
+    bool use_uring_ = false;
+    OutputConfig output_config_;
+    ReconnectConfig reconnect_config_;
+    std::function<void(bool)> connection_callback_;
+    StateCallback state_callback_;
+    std::atomic<size_t> queued_bytes_{0};
+    std::atomic<size_t> send_high_watermark_{kDefaultSendHighWatermark};
+    mutable std::mutex mutex_;
+
+private:
+    ClientPool& pool_;
+    EventLoop& loop_;
+    EventLoop& callbacks_;  // 执行状态回调的循环
+    std::atomic<int> refs_{1};
+    const std::string server_host_;
+    const int server_port_;
+    const std::vector<SocketAddress> addresses_;
+
+    // 在start()/stop()中持mutex_修改，读取不加锁
+    std::atomic<bool> running_{false};
+
+    // 以下由mutex_保护
+    std::string remote_address_;  // 已连接的服务器地址
+    uint64_t attempts_ = 0;  // 完成的连接尝试次数，start()据此等待首次结果
+    uint64_t stops_ = 0;     // 完成的停止次数，stop()据此等待清理结束
+    uint64_t delivered_ = 0; // 已回调的状态变化数，stop()据此等待回调送达
+    std::condition_variable cv_;
+
+    std::atomic<State> state_{State::Stopped};  // 只在循环线程上修改
+    std::atomic<uint64_t> published_{0};        // 已投递的状态变化数
+    MpscQueue<StateEvent> state_events_;
+    StateNotifier state_notifier_;
+    MpscQueue<SendRequest> send_queue_;
+
+    // 以下只在循环线程上访问
+    int fd_ = -1;
+    Timer timer_;                          // 连接超时或等待重连
+    Timer attempt_timer_;                  // 错开发起下一个连接尝试
+    Timer coalesce_timer_;                 // 合并写出时首条数据的最长等待
+    ReconnectConfig connect_config_;       // 本轮连接使用的配置
+    uint64_t connect_round_ = 0;           // 连接轮次，丢弃过期的解析结果
+    uint64_t connect_started_us_ = 0;      // 本轮连接开始的时间
+    uint64_t trace_id_ = 0;                // 跟踪记录中的连接编号
+    std::vector<SocketAddress> candidates_;
+    size_t next_candidate_ = 0;
+    std::vector<std::unique_ptr<ConnectAttempt>> connect_attempts_;
+    std::unique_ptr<OutputQueue> output_;
+    std::unique_ptr<FrameDecoder> decoder_;
+    LoopUring* uring_ = nullptr;           // 所属循环共用的io_uring，未启用时为空
+    UringSend uring_send_;
+    MessageCallback message_callback_;
+    OutputConfig active_config_;           // 当前连接使用的发送配置
+    SendRequest* inflight_head_ = nullptr; // 已追加到output_、等待写入socket的请求，按发送顺序排列
+    SendRequest* inflight_tail_ = nullptr;
+    uint64_t appended_ = 0;                // 当前连接累计追加的字节数
+    uint64_t flushed_ = 0;                 // 当前连接累计写入socket的字节数
+    uint32_t next_sequence_ = 0;           // 下一个发送帧的序号
+    uint32_t failures_ = 0;                // 连续失败的连接次数，决定退避上限
+    InflightTable<SendRequest> inflight_calls_;  // 已写出、等待响应的调用，以序号为键
+};
+
+void TcpClient::SendRequest::onTimer(Timer&) {
+    owner->finishCall(this, CallStatus::Timeout, std::string_view());
+}
+
+TcpClient::TcpClient(const std::string& host, int port)
+    : TcpClient(ClientPool::defaultPool(), host, port) {
+}
+
+TcpClient::TcpClient(ClientPool& pool, const std::string& host, int port)
+    : conn_(new Connection(pool, host, port, std::vector<SocketAddress>())) {
+}
+
+TcpClient::TcpClient(ClientPool& pool, const std::vector<SocketAddress>& addresses)
+    : conn_(new Connection(pool, addresses.empty() ? std::string() : addresses.front().toString(),
+                           addresses.empty() ? 0 : addresses.front().port(), addresses)) {
+}
+
+TcpClient::~TcpClient() {
+    stop();
+    conn_->release();
+}
+
+void TcpClient::start() {
+    conn_->start(true);
+}
+
+void TcpClient::startAsync() {
+    conn_->start(false);
+}
+
+void TcpClient::stop() {
+    conn_->stop();
+}
+
+std::future<bool> TcpClient::sendAsync(std::string_view data) {
+    auto* request = new SendRequest();
+    request->payload.append(data);
+    request->promise.emplace();
+    std::future<bool> future = request->promise->get_future();
+    if (!conn_->enqueue(request, true)) {
+        request->promise->set_value(false);
+        delete request;
+    }
+    return future;
+}
+
+bool TcpClient::sendAsync(std::string_view data, SendCallback callback) {
+    auto* request = new SendRequest();
+    request->payload.append(data);
+    request->callback = std::move(callback);
+    if (!conn_->enqueue(request, true)) {
+        delete request;
+        return false;
+    }
+    return true;
+}
+
+std::future<CallResult> TcpClient::call(std::string_view request, uint64_t timeout_ms) {
+    auto* call = new SendRequest();
+    call->payload.append(request);
+    call->call = true;
+    call->call_promise.emplace();
+    if (timeout_ms > 0) call->deadline_ms = TimingWheel::monotonicMilliseconds() + timeout_ms;
+    std::future<CallResult> future = call->call_promise->get_future();
+    if (!conn_->enqueue(call, true)) {
+        call->call_promise->set_value(CallResult{CallStatus::Rejected, std::string()});
+        delete call;
+    }
+    return future;
+}
+
+bool TcpClient::call(std::string_view request, CallCallback callback, uint64_t timeout_ms) {
+    auto* call = new SendRequest();
+    call->payload.append(request);
+    call->call = true;
+    call->call_callback = std::move(callback);
+    if (timeout_ms > 0) call->deadline_ms = TimingWheel::monotonicMilliseconds() + timeout_ms;
+    if (!conn_->enqueue(call, true)) {
+        delete call;
+        return false;
+    }
+    return true;
+}
+
+bool TcpClient::send(std::string_view data) {
+    auto* request = new SendRequest();
+    request->payload.append(data);
+    request->sync = true;
+    request->refs.store(2, std::memory_order_relaxed);
+    if (!conn_->enqueue(request, false)) {
+        delete request;
+        return false;
     }
+    return waitRequest(request);
 }
 
-bool TcpClient::send(const std::string& data) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (!connected_ || sock_fd_ == -1) {
-        std::cerr << "未连接到服务器，无法发送数据" << std::endl;
+bool TcpClient::sendAsync(const struct iovec* iov, int iovcnt, SendCallback callback) {
+    auto* request = new SendRequest();
+    appendIovecs(request->payload, iov, iovcnt);
+    request->callback = std::move(callback);
+    if (!conn_->enqueue(request, true)) {
+        delete request;
         return false;
     }
+    return true;
+}
+
+bool TcpClient::send(const struct iovec* iov, int iovcnt) {
+    auto* request = new SendRequest();
+    appendIovecs(request->payload, iov, iovcnt);
+    request->sync = true;
+    request->refs.store(2, std::memory_order_relaxed);
+    if (!conn_->enqueue(request, false)) {
+        delete request;
+        return false;
+    }
+    return waitRequest(request);
+}
+
+bool TcpClient::sendAsync(const SharedBuffer& data, SendCallback callback) {
+    auto* request = new SendRequest();
+    request->shared = data;
+    request->callback = std::move(callback);
+    if (!conn_->enqueue(request, true)) {
+        delete request;
+        return false;
+    }
+    return true;
+}
+
+bool TcpClient::send(const SharedBuffer& data) {
+    auto* request = new SendRequest();
+    request->shared = data;
+    request->sync = true;
+    request->refs.store(2, std::memory_order_relaxed);
+    if (!conn_->enqueue(request, false)) {
+        delete request;
+        return false;
+    }
+    return waitRequest(request);
+}
+
+bool TcpClient::sendFile(int fd, uint64_t offset, size_t len, SendCallback callback) {
+    auto* request = newFileRequest(fd, offset, len);
+    if (request == nullptr) return false;
+    request->callback = std::move(callback);
+    if (!conn_->enqueue(request, true)) {
+        delete request;
+        return false;
+    }
+    return true;
+}
 
-    std::cout << "正在发送数据: " << data << std::endl;
-    
-    size_t total_sent = 0;
-    while (total_sent < data.length()) {
-        ssize_t sent = ::send(sock_fd_, data.c_str() + total_sent, 
-                            data.length() - total_sent, MSG_NOSIGNAL);
-        if (sent == -1) {
-            if (errno == EINTR) continue;  // 重试被中断的系统调用
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // 等待socket可写
-                struct pollfd pfd;
-                pfd.fd = sock_fd_;
-                pfd.events = POLLOUT;
-                if (poll(&pfd, 1, 1000) > 0) continue;  // 1秒超时
-            }
-            std::cerr << "发送数据失败: " << strerror(errno) << std::endl;
-            connected_ = false;
-            notifyConnectionChange(false);
+bool TcpClient::sendFile(int fd, uint64_t offset, size_t len) {
+    auto* request = newFileRequest(fd, offset, len);
+    if (request == nullptr) return false;
+    request->sync = true;
+    request->refs.store(2, std::memory_order_relaxed);
+    if (!conn_->enqueue(request, false)) {
+        delete request;
+        return false;
+    }
+    return waitRequest(request);
+}
+
+TcpClient::SendRequest* TcpClient::newFileRequest(int fd, uint64_t offset, size_t len) {
+    if (len > kMaxFrameLength) {
+        LOG_WARN("文件区间{}字节超过单帧上限", len);
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        LOG_ERROR("获取文件信息失败: {}", strerror(errno));
+        return nullptr;
+    }
+    if (!S_ISREG(st.st_mode) || offset + len > static_cast<uint64_t>(st.st_size)) {
+        LOG_WARN("文件区间超出文件范围");
+        return nullptr;
+    }
+    // 复制描述符，调用方返回后即可关闭自己的fd
+    int dup_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dup_fd < 0) {
+        LOG_ERROR("复制文件描述符失败: {}", strerror(errno));
+        return nullptr;
+    }
+    auto* request = new SendRequest();
+    request->file_fd = dup_fd;
+    request->file_offset = offset;
+    request->file_len = len;
+    return request;
+}
+
+bool TcpClient::sendBatch(const std::vector<std::string>& messages) {
+    if (messages.empty()) return isConnected();
+
+    // 全部入队后只等待最后一条：事件循环按顺序发送，前面的失败会使后面的同样失败
+    SendRequest* last = nullptr;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        auto* request = new SendRequest();
+        request->payload.append(messages[i]);
+        if (i + 1 == messages.size()) {
+            request->sync = true;
+            request->refs.store(2, std::memory_order_relaxed);
+            last = request;
+        }
+        if (!conn_->enqueue(request, false)) {
+            delete request;
             return false;
         }
-        total_sent += sent;
     }
+    return waitRequest(last);
+}
 
-    std::cout << "数据发送成功" << std::endl;
-    return true;
+bool TcpClient::waitRequest(SendRequest* request) {
+    bool ok = false;
+    {
+        std::unique_lock<std::mutex> lock(request->mutex);
+        auto deadline = std::chrono::steady_clock::now() + kSyncSendTimeout;
+        while (!request->done && std::chrono::steady_clock::now() < deadline) {
+            request->cv.wait_for(lock, deadline - std::chrono::steady_clock::now());
+        }
+        if (request->done) {
+            ok = request->ok;
+        } else {
+            LOG_ERROR("发送数据超时");
+        }
+    }
+    request->release();
+    return ok;
+}
+
+IoBackend TcpClient::setIoBackend(IoBackend backend) {
+    std::lock_guard<std::mutex> lock(conn_->mutex_);
+    conn_->use_uring_ = false;
+    if (backend == IoBackend::IoUring) {
+        if (!IoUring::supported()) {
+            LOG_WARN("io_uring不可用，回退到epoll");
+            return IoBackend::Epoll;
+        }
+        conn_->use_uring_ = true;
+    }
+    return backend;
+}
+
+void TcpClient::setSendHighWatermark(size_t bytes) {
+    conn_->send_high_watermark_.store(bytes, std::memory_order_relaxed);
+}
+
+size_t TcpClient::queuedBytes() const {
+    return conn_->queued_bytes_.load(std::memory_order_relaxed);
+}
+
+void TcpClient::setOutputConfig(const OutputConfig& config) {
+    std::lock_guard<std::mutex> lock(conn_->mutex_);
+    conn_->output_config_ = config;
+}
+
+void TcpClient::setReconnectConfig(const ReconnectConfig& config) {
+    std::lock_guard<std::mutex> lock(conn_->mutex_);
+    conn_->reconnect_config_ = config;
 }
 
 void TcpClient::setConnectionCallback(std::function<void(bool)> callback) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    connection_callback_ = std::move(callback);
+    std::lock_guard<std::mutex> lock(conn_->mutex_);
+    conn_->connection_callback_ = std::move(callback);
+}
+
+void TcpClient::setMessageCallback(MessageCallback callback) {
+    conn_->setMessageCallback(std::move(callback));
+}
+
+void TcpClient::setStateCallback(StateCallback callback) {
+    std::lock_guard<std::mutex> lock(conn_->mutex_);
+    conn_->state_callback_ = std::move(callback);
 }
 
 bool TcpClient::isRunning() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return running_;
+    return conn_->running();
 }
 
 bool TcpClient::isConnected() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return connected_;
+    return conn_->connected();
 }
 
-void TcpClient::notifyConnectionChange(bool connected) {
-    if (connection_callback_) {
-        try {
-            connection_callback_(connected);
-        } catch (const std::exception& e) {
-            std::cerr << "连接回调异常: " << e.what() << std::endl;
-        }
-    }
-} 
\ No newline at end of file
+ConnectionState TcpClient::state() const {
+    return conn_->state();
+}
+
+std::string TcpClient::remoteAddress() const {
+    return conn_->remoteAddress();
+}
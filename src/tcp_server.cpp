@@ -0,0 +1,482 @@
+#include "tcp_server.h"
+#include "server_reactor.h"
+#include "uring.h"
+#include <sys/socket.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "logger.h"
+#include "trace.h"
+#include <cstring>
+#include <errno.h>
+#include <algorithm>
+#include <chrono>
+#include <system_error>
+
+namespace {
+// 每次recv至少预留的缓冲区空间
+constexpr size_t kRecvBufferSize = 1024;
+
+constexpr std::string_view kResponse = "服务器已收到消息";
+
+// 默认配置只改监听端口：其余字段保留各自的默认值，之后新增的字段也不受影响
+ServerConfig configWithPort(int port) {
+    ServerConfig config;
+    config.port = port;
+    return config;
+}
+}
+
+const ServerMetrics& serverMetrics() {
+    static const ServerMetrics metrics = [] {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        ServerMetrics m;
+        m.bytes_received = registry.counter("tcp_server_bytes_received_total", "从客户端读取的字节数");
+        m.bytes_sent = registry.counter("tcp_server_bytes_sent_total", "写入socket的字节数（含帧头）");
+        m.frames_received = registry.counter("tcp_server_frames_received_total", "收到的完整帧数");
+        m.send_stalls = registry.counter("tcp_server_send_stalls_total",
+                                         "socket发送缓冲区满（EAGAIN）而暂停写出的次数");
+        return m;
+    }();
+    return metrics;
+}
+
+void processMessage(const FrameHeader& header, std::string_view payload, OutputQueue& output) {
+    LOG_DEBUG("收到消息: {}", payload);
+    output.appendFrame(FrameType::Response, header.sequence, kResponse);
+}
+
+TcpServer::TcpServer(int port)
+    : TcpServer(configWithPort(port)) {
+}
+
+TcpServer::TcpServer(const ServerConfig& config)
+    : config_(config)
+    , server_fd_(-1)
+    , bound_port_(config.port)
+    , engine_(config.engine)
+    , running_(false) {
+    // 提前注册指标，采集端在第一个连接之前就能看到它们
+    serverMetrics();
+}
+
+TcpServer::~TcpServer() {
+    stop();
+}
+
+void TcpServer::setMessageHandler(MessageHandler handler) {
+    handler_ = std::move(handler);
+}
+
+int TcpServer::createListenSocket(int port, bool reuse_port) {
+    int flags = SOCK_STREAM | SOCK_CLOEXEC;
+    if (engine_ != ServerEngine::ThreadPerConnection) {
+        flags |= SOCK_NONBLOCK;
+    }
+    int fd = socket(AF_INET, flags, 0);
+    if (fd == -1) {
+        LOG_ERROR("创建socket失败: {}", strerror(errno));
+        return -1;
+    }
+
+    // 设置socket选项，允许地址重用
+    int opt = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        LOG_ERROR("设置socket选项失败: {}", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    // 多个反应器绑定同一端口，由内核在监听socket之间均衡分配新连接
+    if (reuse_port && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        LOG_ERROR("设置SO_REUSEPORT失败: {}", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        LOG_ERROR("绑定端口失败: {}", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    if (listen(fd, config_.admission.backlog) < 0) {
+        LOG_ERROR("监听失败: {}", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    // 端口为0时获取系统分配的端口
+    socklen_t len = sizeof(address);
+    if (getsockname(fd, (struct sockaddr*)&address, &len) == 0) {
+        bound_port_ = ntohs(address.sin_port);
+    }
+    return fd;
+}
+
+bool TcpServer::startReactors() {
+    int count = reactorCount();
+    for (int i = 0; i < count; ++i) {
+        // 第一个socket确定端口（可能由系统分配），其余绑定同一端口
+        int fd = createListenSocket(i == 0 ? config_.port : bound_port_, true);
+        if (fd == -1) {
+            reactors_.clear();
+            return false;
+        }
+        ReactorContext context;
+        context.output = config_.output;
+        context.dispatcher = dispatcher_.get();
+        context.admission = admission_.get();
+        context.timeouts = config_.timeouts;
+        auto reactor = engine_ == ServerEngine::IoUring ? createUringReactor(fd, context)
+                                                        : createEpollReactor(fd, context);
+        if (!reactor->init()) {
+            reactors_.clear();
+            return false;
+        }
+        reactors_.push_back(std::move(reactor));
+    }
+
+    for (auto& reactor : reactors_) {
+        ServerReactor* raw = reactor.get();
+        reactor_threads_.emplace_back([raw] { raw->run(); });
+    }
+    return true;
+}
+
+bool TcpServer::start() {
+    if (running_) return true;
+
+    engine_ = config_.engine;
+    admission_ = std::make_unique<AdmissionController>(config_.admission);
+    if (engine_ == ServerEngine::IoUring && !IoUring::supported()) {
+        LOG_WARN("当前内核不支持io_uring所需特性，回退到epoll");
+        engine_ = ServerEngine::Epoll;
+    }
+
+    if (engine_ != ServerEngine::ThreadPerConnection) {
+        if (handler_) {
+            dispatcher_ = std::make_unique<MessageDispatcher>(
+                handler_, static_cast<size_t>(std::max(config_.handler_threads, 0)));
+        }
+        bool started = startReactors();
+        if (!started && engine_ == ServerEngine::IoUring) {
+            LOG_WARN("io_uring反应器初始化失败，回退到epoll");
+            engine_ = ServerEngine::Epoll;
+            started = startReactors();
+        }
+        if (!started) {
+            dispatcher_.reset();
+            return false;
+        }
+        running_ = true;
+    } else {
+        server_fd_ = createListenSocket(config_.port, false);
+        if (server_fd_ == -1) {
+            return false;
+        }
+        running_ = true;
+        accept_thread_ = std::thread(&TcpServer::acceptLoop, this);
+    }
+
+    if (engine_ == ServerEngine::ThreadPerConnection) {
+        LOG_INFO("服务器启动成功，监听端口: {}", bound_port_);
+    } else {
+        LOG_INFO("服务器启动成功，监听端口: {}，I/O引擎: {}，反应器线程数: {}", bound_port_,
+                 engine_ == ServerEngine::IoUring ? "io_uring" : "epoll", reactorCount());
+    }
+    return true;
+}
+
+void TcpServer::stop() {
+    if (!running_.exchange(false)) return;
+
+    if (!reactors_.empty()) {
+        for (auto& reactor : reactors_) {
+            reactor->stop();
+        }
+        for (auto& thread : reactor_threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        reactor_threads_.clear();
+        // 处理线程会向反应器的完成队列投递结果，先停止线程池再释放反应器
+        if (dispatcher_) {
+            dispatcher_->stop();
+        }
+        reactors_.clear();
+        dispatcher_.reset();
+    } else {
+        // shutdown可以唤醒阻塞在accept中的线程
+        shutdown(server_fd_, SHUT_RDWR);
+        if (accept_thread_.joinable()) {
+            accept_thread_.join();
+        }
+
+        // 唤醒阻塞在recv中的客户端线程
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            for (int fd : client_sockets_) {
+                shutdown(fd, SHUT_RDWR);
+            }
+        }
+
+        // 等待所有客户端线程结束
+        for (auto& client : client_threads_) {
+            if (client->thread.joinable()) {
+                client->thread.join();
+            }
+        }
+        client_threads_.clear();
+    }
+
+    // 关闭服务器socket
+    if (server_fd_ != -1) {
+        close(server_fd_);
+        server_fd_ = -1;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+    }
+    state_cv_.notify_all();
+
+    LOG_INFO("服务器已停止");
+}
+
+void TcpServer::wait() {
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    while (!state_cv_.wait_for(lock, std::chrono::seconds(1), [this] { return !running_; })) {}
+}
+
+bool TcpServer::isRunning() const {
+    return running_;
+}
+
+int TcpServer::port() const {
+    return bound_port_;
+}
+
+ServerEngine TcpServer::engine() const {
+    return engine_;
+}
+
+AdmissionStats TcpServer::admissionStats() const {
+    return admission_ ? admission_->stats() : AdmissionStats();
+}
+
+int TcpServer::reactorCount() const {
+    if (config_.reactor_count > 0) return config_.reactor_count;
+    unsigned int cores = std::thread::hardware_concurrency();
+    return cores > 0 ? static_cast<int>(cores) : 1;
+}
+
+void TcpServer::acceptLoop() {
+    ReserveFd reserve_fd;
+    while (running_) {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+        LOG_INFO("等待客户端连接...");
+        int client_socket = accept(server_fd_, (struct sockaddr*)&client_addr, &client_len);
+
+        if (client_socket < 0) {
+            if (!running_) break;
+            if (errno == EINTR) {  // 被信号中断
+                continue;
+            }
+            if (errno == EMFILE || errno == ENFILE) {
+                admission_->recordFdExhausted();
+                LOG_WARN("文件描述符耗尽，拒绝新连接");
+                reserve_fd.shedOne(server_fd_);
+                continue;
+            }
+            LOG_ERROR("接受连接失败: {}", strerror(errno));
+            continue;
+        }
+
+        // 先回收已结束的线程，连接数上限同时限制了客户端线程数
+        cleanupFinishedThreads();
+        AdmissionResult result = admission_->admit(client_addr.sin_addr.s_addr);
+        if (result != AdmissionResult::Accepted) {
+            LOG_DEBUG("拒绝新连接: {}", admissionResultName(result));
+            rejectConnection(client_socket);
+            continue;
+        }
+
+        char client_ip[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &(client_addr.sin_addr), client_ip, INET_ADDRSTRLEN);
+        LOG_INFO("新客户端连接，IP: {}, 端口: {}", client_ip, ntohs(client_addr.sin_port));
+        TRACE_INSTANT("accepted", 0);
+
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            client_sockets_.insert(client_socket);
+        }
+
+        auto client = std::make_unique<ClientThread>();
+        ClientThread* raw = client.get();
+        try {
+            client->thread = std::thread([this, raw, client_socket] {
+                handleClient(client_socket);
+                raw->finished = true;
+            });
+        } catch (const std::system_error& e) {
+            // 线程资源耗尽时拒绝连接，而不是让accept线程退出
+            LOG_ERROR("创建客户端线程失败: {}", e.what());
+            {
+                std::lock_guard<std::mutex> lock(clients_mutex_);
+                client_sockets_.erase(client_socket);
+            }
+            rejectConnection(client_socket);
+            admission_->release();
+            continue;
+        }
+        client_threads_.push_back(std::move(client));
+    }
+}
+
+void TcpServer::handleClient(int client_socket) {
+    [[maybe_unused]] uint64_t trace_id = traceNextId();
+    TRACE_SCOPE("handle_client", trace_id);
+    // 零拷贝需要先在socket上开启SO_ZEROCOPY
+    OutputConfig output_config = config_.output;
+    if (output_config.zerocopy_threshold > 0 && !enableZerocopy(client_socket)) {
+        output_config.zerocopy_threshold = 0;
+    }
+    OutputQueue response(output_config);
+
+    // 使用RAII方式管理客户端socket，在发送队列之前析构：零拷贝数据未完成时由发送队列延后关闭
+    struct SocketGuard {
+        TcpServer* server;
+        OutputQueue& output;
+        int fd;
+        ~SocketGuard() {
+            {
+                std::lock_guard<std::mutex> lock(server->clients_mutex_);
+                server->client_sockets_.erase(fd);
+            }
+            output.closeSocket(fd);
+            server->admission_->release();
+        }
+    } guard{this, response, client_socket};
+
+    // 阻塞线程没有定时器，写出策略只体现在写出期间的TCP_CORK上，每次读取后总是立即写出
+    if (!enableNoDelay(client_socket)) {
+        LOG_WARN("设置TCP_NODELAY失败: {}", strerror(errno));
+    }
+
+    // 写超时：阻塞发送在该时间内没有进展时返回EAGAIN，flush随之失败
+    const TimeoutConfig& timeouts = config_.timeouts;
+    if (timeouts.write_timeout_ms > 0) {
+        struct timeval tv;
+        tv.tv_sec = timeouts.write_timeout_ms / 1000;
+        tv.tv_usec = (timeouts.write_timeout_ms % 1000) * 1000;
+        setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    }
+
+    FrameDecoder decoder;
+    uint64_t last_activity = TimingWheel::monotonicMilliseconds();
+    uint64_t frame_started = 0;  // 未收齐的帧开始接收的时间
+    while (running_) {
+        // 空闲与读超时：阻塞线程没有事件循环，用poll的超时代替时间轮
+        bool read_deadline = timeouts.read_timeout_ms > 0 && decoder.buffered() > 0;
+        if (timeouts.idle_timeout_ms > 0 || read_deadline) {
+            uint64_t deadline = UINT64_MAX;
+            if (timeouts.idle_timeout_ms > 0) {
+                deadline = last_activity + timeouts.idle_timeout_ms;
+            }
+            if (read_deadline) {
+                deadline = std::min(deadline, frame_started + timeouts.read_timeout_ms);
+            }
+            uint64_t now = TimingWheel::monotonicMilliseconds();
+            struct pollfd pfd {client_socket, POLLIN, 0};
+            int ready = poll(&pfd, 1, deadline > now ? static_cast<int>(deadline - now) : 0);
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready == 0) {
+                LOG_INFO("连接超时，关闭连接");
+                break;
+            }
+        }
+
+        char* buffer = decoder.prepare(kRecvBufferSize);
+        ssize_t bytes_read = recv(client_socket, buffer, decoder.writableBytes(), 0);
+        if (bytes_read <= 0) {
+            if (bytes_read == 0) {
+                LOG_INFO("客户端主动断开连接");
+            } else if (errno == EINTR) {  // 忽略被信号中断的情况
+                continue;
+            } else {
+                LOG_ERROR("接收数据失败: {}", strerror(errno));
+            }
+            break;
+        }
+        TRACE_SCOPE("process", trace_id);
+        decoder.commit(bytes_read);
+        serverMetrics().bytes_received.inc(bytes_read);
+        last_activity = TimingWheel::monotonicMilliseconds();
+        bool frame_completed = false;
+
+        // 一次recv可能包含多个帧，也可能只有半个帧
+        if (!decoder.drain([this, &response, &frame_completed](const FrameHeader& header,
+                                                               std::string_view payload) {
+                frame_completed = true;
+                serverMetrics().frames_received.inc();
+                if (!handler_) {
+                    processMessage(header, payload, response);
+                    return;
+                }
+                LOG_DEBUG("收到消息: {}", payload);
+                ByteBuffer reply;
+                if (invokeHandler(handler_, header, payload, reply)) {
+                    response.appendFrame(FrameType::Response, header.sequence,
+                                         std::string_view(reply.readPtr(), reply.readableBytes()));
+                }
+            })) {
+            LOG_WARN("收到非法帧，关闭连接");
+            break;
+        }
+        // 与反应器相同：每收齐一帧重新计算未完成帧的截止时间
+        if (decoder.buffered() > 0 && (frame_completed || frame_started == 0)) {
+            frame_started = last_activity;
+        } else if (decoder.buffered() == 0) {
+            frame_started = 0;
+        }
+
+        // 本次读取产生的所有响应合并发送；阻塞socket上flush返回即全部发完
+        size_t pending = response.pendingBytes();
+        OutputQueue::FlushResult flushed = response.flush(client_socket);
+        serverMetrics().bytes_sent.inc(pending - response.pendingBytes());
+        if (flushed != OutputQueue::FlushResult::Done) {
+            LOG_ERROR("发送响应失败: {}", strerror(errno));
+            break;
+        }
+        if (response.zerocopyPending() && !response.reapZerocopy(client_socket)) {
+            LOG_ERROR("读取零拷贝完成通知失败: {}", strerror(errno));
+            break;
+        }
+    }
+    LOG_INFO("客户端连接已关闭");
+}
+
+void TcpServer::cleanupFinishedThreads() {
+    client_threads_.erase(
+        std::remove_if(
+            client_threads_.begin(),
+            client_threads_.end(),
+            [](auto& client) {
+                if (!client->finished) return false;
+                client->thread.join();
+                return true;
+            }
+        ),
+        client_threads_.end()
+    );
+}
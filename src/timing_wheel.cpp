@@ -0,0 +1,209 @@
+#include "timing_wheel.h"
+#include <algorithm>
+#include <climits>
+#include <ctime>
+
+namespace {
+
+constexpr uint64_t kSlotMask = TimingWheel::kSlots - 1;
+
+// 最高层能表示的最大tick差，超出的定时器先放在最高层，迁移时重新计算
+constexpr uint64_t kMaxDelta =
+    (uint64_t(1) << (TimingWheel::kSlotBits * TimingWheel::kLevels)) - 1;
+
+void listInit(TimerNode& head) {
+    head.prev = &head;
+    head.next = &head;
+}
+
+bool listEmpty(const TimerNode& head) {
+    return head.next == &head;
+}
+
+void listPushBack(TimerNode& head, TimerNode* node) {
+    node->prev = head.prev;
+    node->next = &head;
+    head.prev->next = node;
+    head.prev = node;
+}
+
+void listUnlink(TimerNode* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = nullptr;
+    node->next = nullptr;
+}
+
+// 把src整个链表移到空链表dst，src变为空
+void listSplice(TimerNode& src, TimerNode& dst) {
+    if (listEmpty(src)) return;
+    dst.next = src.next;
+    dst.prev = src.prev;
+    dst.next->prev = &dst;
+    dst.prev->next = &dst;
+    listInit(src);
+}
+
+}  // namespace
+
+void Timer::cancel() {
+    if (wheel_ != nullptr && armed()) {
+        wheel_->remove(*this);
+    }
+}
+
+TimingWheel::TimingWheel(uint64_t tick_ms, uint64_t now_ms)
+    : tick_ms_(std::max<uint64_t>(tick_ms, 1))
+    , now_ms_(now_ms)
+    , current_(now_ms / tick_ms_ + 1)
+    , size_(0)
+    , occupied_{} {
+    for (auto& head : slots_) {
+        listInit(head);
+    }
+}
+
+TimingWheel::~TimingWheel() {
+    // 剩余定时器解除关联，之后它们析构或取消时不再访问时间轮
+    for (auto& head : slots_) {
+        while (!listEmpty(head)) {
+            auto* timer = static_cast<Timer*>(head.next);
+            listUnlink(timer);
+            timer->wheel_ = nullptr;
+        }
+    }
+}
+
+uint64_t TimingWheel::monotonicMilliseconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+void TimingWheel::schedule(Timer& timer, uint64_t delay_ms) {
+    if (timer.armed()) {
+        timer.wheel_->remove(timer);
+    }
+    // 向上取整保证不提前到期；已处理过的tick不能再放入，至少是下一个tick
+    timer.deadline_ms_ = now_ms_ + delay_ms;
+    timer.expires_ = std::max(current_, (timer.deadline_ms_ + tick_ms_ - 1) / tick_ms_);
+    timer.wheel_ = this;
+    insert(timer);
+    ++size_;
+}
+
+void TimingWheel::insert(Timer& timer) {
+    uint64_t expires = timer.expires_;
+    uint64_t delta = expires - current_;
+    if (delta > kMaxDelta) {
+        expires = current_ + kMaxDelta;
+        delta = kMaxDelta;
+    }
+    int level = 0;
+    while (delta >= (uint64_t(1) << (kSlotBits * (level + 1)))) {
+        ++level;
+    }
+    size_t index = (expires >> (kSlotBits * level)) & kSlotMask;
+    timer.level_ = static_cast<int16_t>(level);
+    timer.slot_ = static_cast<uint16_t>(index);
+    listPushBack(slot(level, index), &timer);
+    occupied_[level] |= uint64_t(1) << index;
+}
+
+void TimingWheel::remove(Timer& timer) {
+    listUnlink(&timer);
+    if (timer.level_ >= 0 && listEmpty(slot(timer.level_, timer.slot_))) {
+        occupied_[timer.level_] &= ~(uint64_t(1) << timer.slot_);
+    }
+    --size_;
+}
+
+void TimingWheel::cascade(int level, size_t index) {
+    if (!(occupied_[level] & (uint64_t(1) << index))) return;
+    TimerNode pending;
+    listInit(pending);
+    listSplice(slot(level, index), pending);
+    occupied_[level] &= ~(uint64_t(1) << index);
+    while (!listEmpty(pending)) {
+        auto* timer = static_cast<Timer*>(pending.next);
+        listUnlink(timer);
+        insert(*timer);
+    }
+}
+
+size_t TimingWheel::expireSlot(size_t index) {
+    if (!(occupied_[0] & (uint64_t(1) << index))) return 0;
+    // 先摘到临时链表再回调：回调中取消同一批的其他定时器也是安全的
+    TimerNode expired;
+    listInit(expired);
+    listSplice(slot(0, index), expired);
+    occupied_[0] &= ~(uint64_t(1) << index);
+    for (TimerNode* node = expired.next; node != &expired; node = node->next) {
+        static_cast<Timer*>(node)->level_ = -1;
+    }
+
+    size_t fired = 0;
+    while (!listEmpty(expired)) {
+        auto* timer = static_cast<Timer*>(expired.next);
+        listUnlink(timer);
+        --size_;
+        ++fired;
+        if (timer->handler_ != nullptr) {
+            timer->handler_->onTimer(*timer);
+        }
+    }
+    return fired;
+}
+
+size_t TimingWheel::advance(uint64_t now_ms) {
+    setNow(now_ms);
+    uint64_t target = now_ms_ / tick_ms_;
+    if (size_ == 0) {
+        current_ = std::max(current_, target + 1);
+        return 0;
+    }
+
+    size_t fired = 0;
+    while (current_ <= target) {
+        uint64_t tick = current_;
+        size_t index = tick & kSlotMask;
+        if (index == 0) {
+            // 低层转完一圈，把上一层对应槽中的定时器迁移下来
+            for (int level = 1; level < kLevels; ++level) {
+                size_t upper = (tick >> (kSlotBits * level)) & kSlotMask;
+                cascade(level, upper);
+                if (upper != 0) break;
+            }
+        }
+        // 回调前先前移，回调中新启动的定时器不会落入正在处理的槽
+        current_ = tick + 1;
+        fired += expireSlot(index);
+
+        if (size_ == 0) {
+            current_ = std::max(current_, target + 1);
+            break;
+        }
+        // 跳过本圈剩余的空槽，直接到下一个非空槽或下一圈开始
+        index = current_ & kSlotMask;
+        if (index == 0) continue;
+        uint64_t rest = occupied_[0] & (~uint64_t(0) << index);
+        uint64_t next = rest != 0 ? (current_ & ~kSlotMask) + __builtin_ctzll(rest)
+                                  : (current_ | kSlotMask) + 1;
+        current_ = std::min(next, target + 1);
+    }
+    return fired;
+}
+
+int TimingWheel::nextTimeoutMs(uint64_t now_ms) const {
+    if (size_ == 0) return -1;
+    size_t index = current_ & kSlotMask;
+    // 下一圈开始时需要迁移高层定时器或处理本层回绕的槽
+    uint64_t next = index == 0 ? current_ : (current_ | kSlotMask) + 1;
+    uint64_t rest = occupied_[0] & (~uint64_t(0) << index);
+    if (rest != 0) {
+        next = (current_ & ~kSlotMask) + __builtin_ctzll(rest);
+    }
+    uint64_t due_ms = next * tick_ms_;
+    if (due_ms <= now_ms) return 0;
+    return static_cast<int>(std::min<uint64_t>(due_ms - now_ms, INT_MAX));
+}
@@ -0,0 +1,194 @@
+#include "trace.h"
+#include "logger.h"
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// 把计数换算为时间的基准点：进程启动时记录一次，导出时再取一次，按两点间的比例换算
+struct Clock {
+    uint64_t ticks;
+    std::chrono::steady_clock::time_point time;
+};
+
+Clock now() {
+    return Clock{tracedetail::readTicks(), std::chrono::steady_clock::now()};
+}
+
+const Clock kStart = now();
+
+// 所有线程的缓冲区。不析构：线程退出时仍可能访问
+struct RingRegistry {
+    std::mutex mutex;
+    std::vector<tracedetail::TraceRing*> active;
+    std::deque<tracedetail::TraceRing*> retired;  // 已退出线程的缓冲区，按退出顺序
+};
+
+RingRegistry& registry() {
+    static RingRegistry* instance = new RingRegistry();
+    return *instance;
+}
+
+std::atomic<uint64_t> next_id(1);
+
+// 线程退出时把缓冲区移到保留列表，导出时仍可看到这个线程的记录
+struct RingOwner {
+    tracedetail::TraceRing* ring = nullptr;
+    ~RingOwner() {
+        if (ring == nullptr) return;
+        tracedetail::tls_ring = nullptr;
+        RingRegistry& rings = registry();
+        std::lock_guard<std::mutex> lock(rings.mutex);
+        rings.active.erase(std::remove(rings.active.begin(), rings.active.end(), ring), rings.active.end());
+        rings.retired.push_back(ring);
+        if (rings.retired.size() > kTraceRetainedRings) {
+            delete rings.retired.front();
+            rings.retired.pop_front();
+        }
+    }
+};
+
+thread_local RingOwner tls_owner;
+
+const char* phaseName(TracePhase phase) {
+    switch (phase) {
+    case TracePhase::Begin: return "B";
+    case TracePhase::End: return "E";
+    case TracePhase::Instant: return "i";
+    case TracePhase::AsyncBegin: return "b";
+    case TracePhase::AsyncEnd: return "e";
+    }
+    return "i";
+}
+
+// 跟踪点名称是代码中的字面量，仍按JSON规则转义以防万一
+void appendEscaped(std::string& out, const char* text) {
+    for (const char* p = text; *p != '\0'; ++p) {
+        char c = *p;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+}
+
+// 一个缓冲区中仍有效的记录：写满后只有最近kTraceRingSize条
+void appendRing(std::string& out, const tracedetail::TraceRing& ring, double ticks_per_us, bool& first) {
+    uint64_t end = ring.next.load(std::memory_order_acquire);
+    uint64_t begin = std::max(end > kTraceRingSize ? end - kTraceRingSize : 0,
+                              ring.start.load(std::memory_order_relaxed));
+    char number[96];
+    for (uint64_t i = begin; i < end; ++i) {
+        const TraceRecord& record = ring.records[i & (kTraceRingSize - 1)];
+        double ts = record.ticks >= kStart.ticks ? (record.ticks - kStart.ticks) / ticks_per_us : 0;
+        out += first ? "\n" : ",\n";
+        first = false;
+        out += "{\"name\":\"";
+        appendEscaped(out, record.name);
+        out += "\",\"cat\":\"tcp\",\"ph\":\"";
+        out += phaseName(record.phase);
+        snprintf(number, sizeof(number), "\",\"ts\":%.3f,\"pid\":%d,\"tid\":%u", ts,
+                 static_cast<int>(getpid()), ring.tid);
+        out += number;
+        if (record.phase == TracePhase::AsyncBegin || record.phase == TracePhase::AsyncEnd) {
+            snprintf(number, sizeof(number), ",\"id\":\"0x%llx\"", static_cast<unsigned long long>(record.id));
+            out += number;
+        } else if (record.phase == TracePhase::Instant) {
+            out += ",\"s\":\"t\"";
+        }
+        if (record.id != 0) {
+            snprintf(number, sizeof(number), ",\"args\":{\"id\":%llu}", static_cast<unsigned long long>(record.id));
+            out += number;
+        }
+        out += '}';
+    }
+}
+
+}  // namespace
+
+namespace tracedetail {
+
+thread_local TraceRing* tls_ring = nullptr;
+
+TraceRing* registerThread() {
+    TraceRing* ring = new TraceRing();
+    ring->tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    RingRegistry& rings = registry();
+    {
+        std::lock_guard<std::mutex> lock(rings.mutex);
+        rings.active.push_back(ring);
+    }
+    tls_owner.ring = ring;
+    tls_ring = ring;
+    return ring;
+}
+
+}  // namespace tracedetail
+
+uint64_t traceNextId() {
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::string traceEventsJson() {
+    Clock end = now();
+    double elapsed_us = std::chrono::duration<double, std::micro>(end.time - kStart.time).count();
+    // 运行时间太短时比例不准，按1GHz估计
+    double ticks_per_us = elapsed_us > 1000 && end.ticks > kStart.ticks
+        ? (end.ticks - kStart.ticks) / elapsed_us : 1000.0;
+#if !defined(__x86_64__) && !defined(__i386__)
+    ticks_per_us = 1000.0;  // 计数本身就是纳秒
+#endif
+
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    RingRegistry& rings = registry();
+    std::lock_guard<std::mutex> lock(rings.mutex);
+    for (const tracedetail::TraceRing* ring : rings.retired) {
+        appendRing(out, *ring, ticks_per_us, first);
+    }
+    for (const tracedetail::TraceRing* ring : rings.active) {
+        appendRing(out, *ring, ticks_per_us, first);
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+bool dumpTrace(const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        LOG_ERROR("打开跟踪文件{}失败: {}", path, strerror(errno));
+        return false;
+    }
+    out << traceEventsJson();
+    if (!out.flush()) {
+        LOG_ERROR("写入跟踪文件{}失败: {}", path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void clearTrace() {
+    RingRegistry& rings = registry();
+    std::lock_guard<std::mutex> lock(rings.mutex);
+    for (tracedetail::TraceRing* ring : rings.retired) delete ring;
+    rings.retired.clear();
+    // 活跃线程的缓冲区只由所属线程写，这里只移动导出的起点
+    for (tracedetail::TraceRing* ring : rings.active) {
+        ring->start.store(ring->next.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
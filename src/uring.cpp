@@ -0,0 +1,340 @@
+#include "uring.h"
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <errno.h>
+
+namespace {
+
+int uringSetup(unsigned entries, struct io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int uringRegister(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+// 多重recv需要6.0及以上内核，无法通过probe检测，只能比较版本号
+bool kernelAtLeast(int major, int minor) {
+    struct utsname name;
+    if (uname(&name) != 0) return false;
+    int kernel_major = 0;
+    int kernel_minor = 0;
+    if (sscanf(name.release, "%d.%d", &kernel_major, &kernel_minor) != 2) return false;
+    return kernel_major > major || (kernel_major == major && kernel_minor >= minor);
+}
+
+bool probeSupported() {
+    if (!kernelAtLeast(6, 0)) return false;
+
+    IoUring ring(4);
+    if (!ring.valid()) return false;
+
+    // 确认服务器反应器和客户端发送提交的操作码均可用，并验证提供缓冲区上的多重recv
+    for (int op : {IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_READ, IORING_OP_POLL_ADD,
+                   IORING_OP_TIMEOUT, IORING_OP_SENDMSG, IORING_OP_PROVIDE_BUFFERS}) {
+        if (!ring.supportsOp(op)) return false;
+    }
+    return ring.setupBufferRing(0, 2, 64) && ring.recvSelfTest();
+}
+
+}  // namespace
+
+IoUring::IoUring(unsigned entries)
+    : ring_fd_(-1)
+    , sq_ptr_(MAP_FAILED)
+    , sq_ring_size_(0)
+    , sq_head_(nullptr)
+    , sq_tail_(nullptr)
+    , sq_mask_(0)
+    , sq_entries_(0)
+    , sqes_(nullptr)
+    , sqes_size_(0)
+    , sqe_tail_(0)
+    , sqe_flushed_(0)
+    , cq_ptr_(MAP_FAILED)
+    , cq_ring_size_(0)
+    , cq_head_(nullptr)
+    , cq_tail_(nullptr)
+    , cq_mask_(0)
+    , cqes_(nullptr)
+    , buf_ring_(nullptr)
+    , buf_ring_size_(0)
+    , buf_base_(nullptr)
+    , buf_group_(0)
+    , buf_entries_(0)
+    , buf_size_(0) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = uringSetup(entries, &params);
+    if (ring_fd_ < 0) {
+        ring_fd_ = -1;
+        return;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ptr_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+        close(ring_fd_);
+        ring_fd_ = -1;
+        return;
+    }
+
+    cq_ptr_ = single_mmap ? sq_ptr_
+                          : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd_, IORING_OFF_SQES);
+    if (cq_ptr_ == MAP_FAILED || sqes == MAP_FAILED) {
+        if (sqes != MAP_FAILED) munmap(sqes, sqes_size_);
+        if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_ring_size_);
+        munmap(sq_ptr_, sq_ring_size_);
+        sq_ptr_ = cq_ptr_ = MAP_FAILED;
+        close(ring_fd_);
+        ring_fd_ = -1;
+        return;
+    }
+    sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sq_ptr_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_entries_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+
+    // SQ索引数组固定为恒等映射，之后只需推进尾指针
+    unsigned* sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    for (unsigned i = 0; i < sq_entries_; ++i) {
+        sq_array[i] = i;
+    }
+    sqe_tail_ = sqe_flushed_ = *sq_tail_;
+
+    char* cq = static_cast<char*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+}
+
+IoUring::~IoUring() {
+    // 先关闭ring，内核取消所有未完成请求后才释放缓冲区
+    if (ring_fd_ != -1) close(ring_fd_);
+    if (buf_ring_ != nullptr) munmap(buf_ring_, buf_ring_size_);
+    delete[] buf_base_;
+    if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+    if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_ring_size_);
+    if (sq_ptr_ != MAP_FAILED) munmap(sq_ptr_, sq_ring_size_);
+}
+
+bool IoUring::supported() {
+    static const bool result = probeSupported();
+    return result;
+}
+
+bool IoUring::valid() const {
+    return ring_fd_ != -1;
+}
+
+bool IoUring::supportsOp(int opcode) const {
+    if (!valid()) return false;
+
+    const unsigned op_count = 256;
+    size_t size = sizeof(struct io_uring_probe) + op_count * sizeof(struct io_uring_probe_op);
+    auto* probe = static_cast<struct io_uring_probe*>(calloc(1, size));
+    if (probe == nullptr) return false;
+
+    bool result = false;
+    if (uringRegister(ring_fd_, IORING_REGISTER_PROBE, probe, op_count) == 0 &&
+        opcode <= probe->last_op) {
+        result = probe->ops[opcode].flags & IO_URING_OP_SUPPORTED;
+    }
+    free(probe);
+    return result;
+}
+
+struct io_uring_sqe* IoUring::getSqe() {
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (sqe_tail_ - head >= sq_entries_) {
+        return nullptr;
+    }
+    struct io_uring_sqe* sqe = &sqes_[sqe_tail_ & sq_mask_];
+    ++sqe_tail_;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+unsigned IoUring::flushSq() {
+    unsigned pending = sqe_tail_ - sqe_flushed_;
+    if (pending > 0) {
+        __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+        sqe_flushed_ = sqe_tail_;
+    }
+    return pending;
+}
+
+int IoUring::enter(unsigned to_submit, unsigned wait_nr, unsigned flags) {
+    while (true) {
+        int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit, wait_nr,
+                                           flags, nullptr, 0));
+        if (ret < 0 && errno == EINTR) {
+            // 已提交的部分不会重复提交，只需继续等待
+            to_submit = 0;
+            continue;
+        }
+        return ret;
+    }
+}
+
+int IoUring::submit() {
+    unsigned pending = flushSq();
+    if (pending == 0) return 0;
+    return enter(pending, 0, 0);
+}
+
+int IoUring::submitAndWait(unsigned wait_nr) {
+    unsigned pending = flushSq();
+    return enter(pending, wait_nr, wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0);
+}
+
+bool IoUring::setupBufferRing(uint16_t group_id, unsigned entries, unsigned buffer_size) {
+    if (!valid() || buf_base_ != nullptr || entries == 0 || (entries & (entries - 1)) != 0) {
+        return false;
+    }
+
+    buf_group_ = group_id;
+    buf_entries_ = entries;
+    buf_size_ = buffer_size;
+    buf_base_ = new char[static_cast<size_t>(entries) * buffer_size];
+
+    if (bufferRingUsable() && registerBufferRing()) {
+        return true;
+    }
+
+    // 缓冲区环不可用时回退到IORING_OP_PROVIDE_BUFFERS，一次性提供全部缓冲区
+    struct io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr) return false;
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = static_cast<int>(entries);
+    sqe->addr = reinterpret_cast<uint64_t>(buf_base_);
+    sqe->len = buffer_size;
+    sqe->off = 0;
+    sqe->buf_group = group_id;
+    if (submitAndWait(1) < 0) return false;
+
+    int result = -EIO;
+    forEachCqe([&result](struct io_uring_cqe* cqe) { result = cqe->res; });
+    return result >= 0;
+}
+
+bool IoUring::registerBufferRing() {
+    buf_ring_size_ = buf_entries_ * sizeof(struct io_uring_buf);
+    void* ring = mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+        return false;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+    reg.ring_entries = buf_entries_;
+    reg.bgid = buf_group_;
+    if (uringRegister(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        munmap(ring, buf_ring_size_);
+        return false;
+    }
+    buf_ring_ = static_cast<struct io_uring_buf_ring*>(ring);
+
+    // 将全部缓冲区交给内核
+    for (unsigned i = 0; i < buf_entries_; ++i) {
+        struct io_uring_buf* buf = &buf_ring_->bufs[i];
+        buf->addr = reinterpret_cast<uint64_t>(buffer(static_cast<uint16_t>(i)));
+        buf->len = buf_size_;
+        buf->bid = static_cast<uint16_t>(i);
+    }
+    __atomic_store_n(&buf_ring_->tail, static_cast<uint16_t>(buf_entries_), __ATOMIC_RELEASE);
+    return true;
+}
+
+bool IoUring::bufferRingUsable() {
+    // 部分内核可以注册缓冲区环但选择缓冲区时始终返回ENOBUFS，需要实际收发一次验证
+    static const bool result = [] {
+        IoUring ring(4);
+        if (!ring.valid()) return false;
+        ring.buf_group_ = 0;
+        ring.buf_entries_ = 1;
+        ring.buf_size_ = 64;
+        ring.buf_base_ = new char[64];
+        return ring.registerBufferRing() && ring.recvSelfTest();
+    }();
+    return result;
+}
+
+bool IoUring::recvSelfTest() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) return false;
+
+    bool ok = false;
+    struct io_uring_sqe* sqe = getSqe();
+    if (sqe != nullptr && write(fds[1], "x", 1) == 1) {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = fds[0];
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = buf_group_;
+        if (submitAndWait(1) >= 0) {
+            forEachCqe([&ok](struct io_uring_cqe* cqe) {
+                ok = ok || (cqe->res == 1 && (cqe->flags & IORING_CQE_F_BUFFER));
+            });
+        }
+    }
+    // 关闭socket使多重recv结束
+    close(fds[0]);
+    close(fds[1]);
+    return ok;
+}
+
+char* IoUring::buffer(uint16_t buffer_id) const {
+    return buf_base_ + static_cast<size_t>(buffer_id) * buf_size_;
+}
+
+void IoUring::recycleBuffer(uint16_t buffer_id) {
+    if (buf_ring_ != nullptr) {
+        uint16_t tail = buf_ring_->tail;
+        struct io_uring_buf* buf = &buf_ring_->bufs[tail & (buf_entries_ - 1)];
+        buf->addr = reinterpret_cast<uint64_t>(buffer(buffer_id));
+        buf->len = buf_size_;
+        buf->bid = buffer_id;
+        __atomic_store_n(&buf_ring_->tail, static_cast<uint16_t>(tail + 1), __ATOMIC_RELEASE);
+        return;
+    }
+
+    // 回退模式：随下一次提交归还缓冲区，成功时不产生完成事件
+    struct io_uring_sqe* sqe = getSqe();
+    while (sqe == nullptr) {
+        submit();
+        sqe = getSqe();
+    }
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = 1;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer(buffer_id));
+    sqe->len = buf_size_;
+    sqe->off = buffer_id;
+    sqe->buf_group = buf_group_;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    sqe->user_data = 0;
+}
@@ -0,0 +1,513 @@
+#include "server_reactor.h"
+#include "uring.h"
+#include "message_dispatcher.h"
+#include "admission_control.h"
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <unistd.h>
+#include "logger.h"
+#include "trace.h"
+#include <cstring>
+#include <errno.h>
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+
+namespace {
+
+// 提供缓冲区的大小与数量
+constexpr unsigned kRecvBufferSize = 4096;
+constexpr unsigned kBufferCount = 512;
+constexpr uint16_t kBufferGroup = 0;
+constexpr unsigned kRingEntries = 1024;
+// 单次SENDMSG携带的iovec数上限
+constexpr int kMaxSendIovecs = 64;
+
+// user_data低3位存放操作类型，高位存放连接指针
+enum CompletionTag : uint64_t {
+    kTagAccept = 1,
+    kTagWakeup = 2,
+    kTagRecv = 3,
+    kTagSend = 4,
+    kTagCompletion = 5,
+    kTagTimeout = 6
+};
+constexpr uint64_t kTagMask = 7;
+
+// io_uring反应器：多重accept、基于提供缓冲区环的多重recv，
+// 一轮完成事件产生的所有发送在下一次io_uring_enter中批量提交。
+// 发送使用SENDMSG聚合发送队列中的多个数据块，不使用MSG_ZEROCOPY。
+// 连接超时由反应器自己的时间轮驱动，有定时器时用IORING_OP_TIMEOUT限定等待时间
+class UringReactor : public ServerReactor {
+public:
+    UringReactor(int listen_fd, const ReactorContext& context)
+        : listen_fd_(listen_fd)
+        , output_config_(context.output)
+        , dispatcher_(context.dispatcher)
+        , admission_(*context.admission)
+        , timeouts_(context.timeouts)
+        , timers_(context.timeouts.tick_ms)
+        , timeout_deadline_ms_(0)
+        , next_connection_id_(0)
+        , wakeup_fd_(eventfd(0, EFD_CLOEXEC))
+        , wakeup_value_(0)
+        , quit_(false)
+        , ring_(kRingEntries) {
+    }
+
+    ~UringReactor() override {
+        // 先shutdown让对端立即收到FIN，ring关闭后内核才会释放socket
+        for (auto& item : connections_) {
+            shutdown(item.first, SHUT_RDWR);
+            close(item.first);
+            admission_.release();
+        }
+        close(listen_fd_);
+        if (wakeup_fd_ != -1) close(wakeup_fd_);
+    }
+
+    bool init() override {
+        if (!ring_.valid() || wakeup_fd_ == -1) return false;
+        if (!ring_.setupBufferRing(kBufferGroup, kBufferCount, kRecvBufferSize)) return false;
+        if (dispatcher_ != nullptr) {
+            if (!completions_.valid()) return false;
+            armCompletion();
+        }
+        armAccept();
+        armWakeup();
+        return true;
+    }
+
+    void run() override {
+        while (!quit_) {
+            armTimeout();
+            if (ring_.submitAndWait(1) < 0 && errno != EAGAIN && errno != EBUSY) {
+                LOG_ERROR("io_uring_enter失败: {}", strerror(errno));
+                break;
+            }
+            // 与epoll反应器相同：先更新时间基准，处理完所有完成事件后再执行到期回调
+            uint64_t now = TimingWheel::monotonicMilliseconds();
+            timers_.setNow(now);
+            ring_.forEachCqe([this](struct io_uring_cqe* cqe) { onCompletion(cqe); });
+            timers_.advance(now);
+        }
+    }
+
+    void stop() override {
+        quit_ = true;
+        uint64_t one = 1;
+        ssize_t ret = write(wakeup_fd_, &one, sizeof(one));
+        (void)ret;
+    }
+
+private:
+    // 每个连接的状态
+    // 连接对象和它的缓冲区都来自缓冲区池，关闭后回到池中供新连接复用
+    struct Connection : public TimerHandler, public PoolAllocated {
+        Connection(UringReactor& reactor, int fd, const OutputConfig& output_config)
+            : reactor(reactor), fd(fd), output(output_config)
+            , idle_timer(this), read_timer(this), write_timer(this), coalesce_timer(this) {}
+
+        void onTimer(Timer& timer) override {
+            reactor.onConnectionTimer(this, timer);
+        }
+
+        UringReactor& reactor;
+        int fd;
+        uint64_t id = 0;
+        uint64_t trace_id = 0;      // 跟踪记录中的连接编号，所有反应器间唯一
+        FrameDecoder decoder;       // 跨完成事件的不完整帧
+        OutputQueue output;         // 等待发送的数据，在途部分在完成前不会被修改
+        ResponseSequencer sequencer;  // 处理线程池返回结果的排序
+        struct msghdr msg;          // 在途SENDMSG引用的消息头
+        struct iovec iov[kMaxSendIovecs];
+        bool recv_armed = false;
+        bool send_inflight = false;
+        bool closing = false;
+        uint64_t last_activity_ms = 0;  // 最近一次收到数据或发送有进展的时间
+        Timer idle_timer;           // 空闲超时，到期时按last_activity_ms惰性续期
+        Timer read_timer;           // 未收齐的帧的截止时间
+        Timer write_timer;          // 积压数据的发送进展截止时间
+        Timer coalesce_timer;       // 合并写出时首条数据的最长等待
+    };
+
+    // 获取SQE，队列已满时先提交已有请求
+    struct io_uring_sqe* nextSqe() {
+        struct io_uring_sqe* sqe = ring_.getSqe();
+        while (sqe == nullptr) {
+            ring_.submit();
+            sqe = ring_.getSqe();
+        }
+        return sqe;
+    }
+
+    static uint64_t encode(void* ptr, CompletionTag tag) {
+        return reinterpret_cast<uint64_t>(ptr) | tag;
+    }
+
+    void armAccept() {
+        struct io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = listen_fd_;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        sqe->user_data = encode(nullptr, kTagAccept);
+    }
+
+    void armWakeup() {
+        struct io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = wakeup_fd_;
+        sqe->addr = reinterpret_cast<uint64_t>(&wakeup_value_);
+        sqe->len = sizeof(wakeup_value_);
+        sqe->user_data = encode(nullptr, kTagWakeup);
+    }
+
+    // 处理线程池的完成队列：eventfd是非阻塞的，用POLL_ADD等待可读后再取出结果
+    void armCompletion() {
+        struct io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = completions_.fd();
+        sqe->poll32_events = POLLIN;
+        sqe->user_data = encode(nullptr, kTagCompletion);
+    }
+
+    // 最近的定时器早于已提交的超时请求时提交新的超时请求，使io_uring_enter按时返回。
+    // 被取代的超时请求仍会完成，只多一次无害的唤醒
+    void armTimeout() {
+        if (timers_.empty()) return;
+        uint64_t now = TimingWheel::monotonicMilliseconds();
+        uint64_t deadline = now + timers_.nextTimeoutMs(now);
+        if (timeout_deadline_ms_ != 0 && timeout_deadline_ms_ <= deadline) return;
+
+        uint64_t delay = deadline - now;
+        timeout_spec_.tv_sec = delay / 1000;
+        timeout_spec_.tv_nsec = (delay % 1000) * 1000000;
+        struct io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_TIMEOUT;
+        sqe->fd = -1;
+        sqe->addr = reinterpret_cast<uint64_t>(&timeout_spec_);
+        sqe->len = 1;
+        sqe->user_data = encode(nullptr, kTagTimeout);
+        timeout_deadline_ms_ = deadline;
+    }
+
+    // 多重accept不返回对端地址，通过getpeername取得源IP做准入检查
+    bool admit(int client_socket) {
+        struct sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        uint32_t source_ip = 0;
+        if (getpeername(client_socket, (struct sockaddr*)&addr, &len) == 0) {
+            source_ip = addr.sin_addr.s_addr;
+        }
+        AdmissionResult result = admission_.admit(source_ip);
+        if (result != AdmissionResult::Accepted) {
+            LOG_DEBUG("拒绝新连接: {}", admissionResultName(result));
+            rejectConnection(client_socket);
+            return false;
+        }
+        return true;
+    }
+
+    void armRecv(Connection* conn) {
+        struct io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = conn->fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = kBufferGroup;
+        sqe->user_data = encode(conn, kTagRecv);
+        conn->recv_armed = true;
+    }
+
+    void submitSend(Connection* conn) {
+        conn->coalesce_timer.cancel();
+        conn->output.beginWrite(conn->fd);
+        memset(&conn->msg, 0, sizeof(conn->msg));
+        conn->msg.msg_iov = conn->iov;
+        conn->msg.msg_iovlen = conn->output.gather(
+            conn->iov, std::min(kMaxSendIovecs, output_config_.max_batch_iovecs),
+            output_config_.max_batch_bytes);
+
+        struct io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = conn->fd;
+        sqe->addr = reinterpret_cast<uint64_t>(&conn->msg);
+        sqe->len = 1;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = encode(conn, kTagSend);
+        conn->send_inflight = true;
+    }
+
+    void onCompletion(struct io_uring_cqe* cqe) {
+        auto tag = static_cast<CompletionTag>(cqe->user_data & kTagMask);
+        void* ptr = reinterpret_cast<void*>(cqe->user_data & ~kTagMask);
+        switch (tag) {
+        case kTagAccept:
+            onAccept(cqe);
+            break;
+        case kTagWakeup:
+            if (!quit_) armWakeup();
+            break;
+        case kTagRecv:
+            onRecv(static_cast<Connection*>(ptr), cqe);
+            break;
+        case kTagSend:
+            onSend(static_cast<Connection*>(ptr), cqe->res);
+            break;
+        case kTagCompletion:
+            onHandlerCompletions();
+            if (!quit_) armCompletion();
+            break;
+        case kTagTimeout:
+            // 到期定时器在本轮完成事件处理后统一执行
+            timeout_deadline_ms_ = 0;
+            break;
+        default:
+            // 归还缓冲区失败等内部请求，不关联连接
+            break;
+        }
+    }
+
+    // 多重accept由内核逐个投递连接，accept_batch不适用；准入检查与epoll相同
+    void onAccept(struct io_uring_cqe* cqe) {
+        if (cqe->res >= 0) {
+            int client_socket = cqe->res;
+            if (admit(client_socket)) {
+                LOG_INFO("新客户端连接，fd: {}", client_socket);
+                if (!enableNoDelay(client_socket)) {
+                    LOG_WARN("设置TCP_NODELAY失败: {}", strerror(errno));
+                }
+                auto conn = std::make_unique<Connection>(*this, client_socket, output_config_);
+                conn->id = next_connection_id_++;
+                conn->trace_id = traceNextId();
+                TRACE_INSTANT("accepted", conn->trace_id);
+                conn->last_activity_ms = timers_.now();
+                if (timeouts_.idle_timeout_ms > 0) {
+                    timers_.schedule(conn->idle_timer, timeouts_.idle_timeout_ms);
+                }
+                armRecv(conn.get());
+                connections_.emplace(client_socket, std::move(conn));
+            }
+        } else if (cqe->res == -EMFILE || cqe->res == -ENFILE) {
+            // 取走队首连接，否则重新提交的accept会立即再次失败
+            admission_.recordFdExhausted();
+            LOG_WARN("文件描述符耗尽，拒绝新连接");
+            reserve_fd_.shedOne(listen_fd_);
+        } else if (cqe->res != -ECANCELED) {
+            LOG_ERROR("接受连接失败: {}", strerror(-cqe->res));
+        }
+
+        // 多重accept被内核终止时重新提交
+        if (!(cqe->flags & IORING_CQE_F_MORE) && !quit_) {
+            armAccept();
+        }
+    }
+
+    void onRecv(Connection* conn, struct io_uring_cqe* cqe) {
+        TRACE_SCOPE("read", conn->trace_id);
+        int res = cqe->res;
+        bool frame_error = false;
+        if (cqe->flags & IORING_CQE_F_BUFFER) {
+            uint16_t buffer_id = static_cast<uint16_t>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+            if (res > 0) {
+                conn->last_activity_ms = timers_.now();
+                serverMetrics().bytes_received.inc(res);
+                bool frame_completed = false;
+                // 完整帧直接在内核填充的缓冲区上解析，只有不完整的尾部会被拷贝
+                frame_error = !conn->decoder.feed(
+                    ring_.buffer(buffer_id), res,
+                    [this, conn, &frame_completed](const FrameHeader& header,
+                                                   std::string_view payload) {
+                        frame_completed = true;
+                        serverMetrics().frames_received.inc();
+                        if (dispatcher_ != nullptr) {
+                            dispatcher_->dispatch(completions_, conn->fd, conn->id,
+                                                  conn->sequencer.nextIndex(), header, payload);
+                        } else {
+                            processMessage(header, payload, conn->output);
+                        }
+                    });
+                updateReadDeadline(conn, frame_completed);
+            }
+            ring_.recycleBuffer(buffer_id);
+        }
+
+        if (!(cqe->flags & IORING_CQE_F_MORE)) {
+            conn->recv_armed = false;
+        }
+
+        if (frame_error) {
+            LOG_WARN("收到非法帧，关闭连接");
+            beginClose(conn);
+            return;
+        }
+        if (res == 0) {
+            if (!conn->closing) LOG_INFO("客户端主动断开连接");
+            beginClose(conn);
+            return;
+        }
+        if (res < 0 && res != -ENOBUFS) {
+            if (!conn->closing && res != -ECANCELED) {
+                LOG_ERROR("接收数据失败: {}", strerror(-res));
+            }
+            beginClose(conn);
+            return;
+        }
+
+        // 缓冲区耗尽（ENOBUFS）或内核结束多重recv时重新提交
+        if (!conn->recv_armed && !conn->closing) {
+            armRecv(conn);
+        }
+        flushOutput(conn);
+    }
+
+    void onSend(Connection* conn, int res) {
+        TRACE_SCOPE("send_complete", conn->trace_id);
+        conn->send_inflight = false;
+        if (res < 0) {
+            if (!conn->closing) {
+                LOG_ERROR("发送响应失败: {}", strerror(-res));
+            }
+            beginClose(conn);
+            return;
+        }
+
+        conn->output.advance(res);
+        serverMetrics().bytes_sent.inc(res);
+        if (conn->closing) {
+            releaseIfIdle(conn);
+            return;
+        }
+        conn->output.endWrite(conn->fd);
+        if (res > 0) {
+            conn->last_activity_ms = timers_.now();
+        }
+        updateWriteDeadline(conn, res > 0);
+        // 部分发送或在途期间追加了新数据，继续发送
+        flushOutput(conn);
+    }
+
+    // 按请求顺序把处理结果追加到各连接的发送队列，发送在本轮完成事件之后批量提交
+    void onHandlerCompletions() {
+        HandlerCall* call = completions_.popAll();
+        while (call != nullptr) {
+            HandlerCall* next = call->next;
+            auto it = connections_.find(call->fd);
+            if (it == connections_.end() || it->second->id != call->connection_id ||
+                it->second->closing) {
+                // 连接在处理期间已关闭
+                delete call;
+            } else {
+                Connection* conn = it->second.get();
+                conn->sequencer.complete(call, conn->output);
+                flushOutput(conn);
+            }
+            call = next;
+        }
+    }
+
+    // 没有发送在途时，将积压数据聚合提交；写出策略要求继续合并时启动合并定时器
+    void flushOutput(Connection* conn, bool force = false) {
+        if (conn->send_inflight || conn->closing || conn->output.empty()) return;
+        if (!force && !conn->output.writeDue()) {
+            if (!conn->coalesce_timer.armed()) {
+                timers_.schedule(conn->coalesce_timer, conn->output.coalesceDelayMs());
+            }
+            return;
+        }
+        submitSend(conn);
+        updateWriteDeadline(conn, false);
+    }
+
+    void onConnectionTimer(Connection* conn, Timer& timer) {
+        if (conn->closing) return;
+        if (&timer == &conn->coalesce_timer) {
+            flushOutput(conn, true);
+            return;
+        }
+        if (&timer == &conn->idle_timer) {
+            // 与epoll反应器相同：惰性续期，还有请求在处理线程池中时不算空闲
+            uint64_t idle_ms = timers_.now() - conn->last_activity_ms;
+            if (idle_ms < static_cast<uint64_t>(timeouts_.idle_timeout_ms) ||
+                conn->sequencer.outstanding() > 0) {
+                uint64_t remaining = conn->sequencer.outstanding() > 0
+                    ? timeouts_.idle_timeout_ms : timeouts_.idle_timeout_ms - idle_ms;
+                timers_.schedule(conn->idle_timer, remaining);
+                return;
+            }
+            LOG_INFO("连接空闲超时，关闭连接");
+        } else if (&timer == &conn->read_timer) {
+            LOG_WARN("未在{}ms内收齐完整帧，关闭连接", timeouts_.read_timeout_ms);
+        } else {
+            LOG_WARN("发送积压数据超时，关闭连接");
+        }
+        beginClose(conn);
+    }
+
+    // 缓冲区中有未收齐的帧时启动读超时，每收齐一帧重新计时
+    void updateReadDeadline(Connection* conn, bool frame_completed) {
+        if (timeouts_.read_timeout_ms <= 0) return;
+        if (conn->decoder.buffered() == 0) {
+            conn->read_timer.cancel();
+        } else if (frame_completed || !conn->read_timer.armed()) {
+            timers_.schedule(conn->read_timer, timeouts_.read_timeout_ms);
+        }
+    }
+
+    // 有积压数据时启动写超时，每次发送有进展重新计时
+    void updateWriteDeadline(Connection* conn, bool progressed) {
+        if (timeouts_.write_timeout_ms <= 0) return;
+        if (conn->output.empty()) {
+            conn->write_timer.cancel();
+        } else if (progressed || !conn->write_timer.armed()) {
+            timers_.schedule(conn->write_timer, timeouts_.write_timeout_ms);
+        }
+    }
+
+    // shutdown会使在途的多重recv以0结束，所有请求完成后再释放连接
+    void beginClose(Connection* conn) {
+        if (!conn->closing) {
+            TRACE_INSTANT("close", conn->trace_id);
+            conn->closing = true;
+            shutdown(conn->fd, SHUT_RDWR);
+        }
+        releaseIfIdle(conn);
+    }
+
+    void releaseIfIdle(Connection* conn) {
+        if (conn->recv_armed || conn->send_inflight) return;
+        int fd = conn->fd;
+        close(fd);
+        connections_.erase(fd);
+        admission_.release();
+        LOG_INFO("客户端连接已关闭");
+    }
+
+    int listen_fd_;
+    OutputConfig output_config_;
+    MessageDispatcher* dispatcher_;
+    AdmissionController& admission_;
+    TimeoutConfig timeouts_;
+    TimingWheel timers_;
+    struct __kernel_timespec timeout_spec_;
+    uint64_t timeout_deadline_ms_;  // 已提交的超时请求中最早的到期时间，0表示没有
+    ReserveFd reserve_fd_;
+    CompletionQueue completions_;
+    uint64_t next_connection_id_;
+    int wakeup_fd_;
+    uint64_t wakeup_value_;
+    std::atomic<bool> quit_;
+    // 连接在ring之前声明：析构时先关闭ring，再释放在途请求引用的发送缓冲区
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+    IoUring ring_;
+};
+
+}  // namespace
+
+std::unique_ptr<ServerReactor> createUringReactor(int listen_fd, const ReactorContext& context) {
+    return std::make_unique<UringReactor>(listen_fd, context);
+}
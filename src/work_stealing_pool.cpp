@@ -0,0 +1,114 @@
+#include "work_stealing_pool.h"
+#include <chrono>
+
+namespace {
+
+// 当前线程所属的线程池及其工作线程编号，非工作线程为空
+thread_local const WorkStealingPool* tCurrentPool = nullptr;
+thread_local size_t tWorkerIndex = 0;
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(size_t thread_count)
+    : next_worker_(0)
+    , pending_(0)
+    , idle_(0)
+    , stolen_(0)
+    , quit_(false) {
+    if (thread_count == 0) {
+        unsigned int cores = std::thread::hardware_concurrency();
+        thread_count = cores > 0 ? cores : 1;
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_[i]->thread = std::thread(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    stop();
+}
+
+void WorkStealingPool::submit(Task task) {
+    size_t index = tCurrentPool == this
+        ? tWorkerIndex
+        : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+    pending_.fetch_add(1);
+
+    // 先增加pending_再检查idle_，与工作线程的顺序相反，保证不会错过唤醒
+    if (idle_.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.notify_one();
+    }
+}
+
+void WorkStealingPool::stop() {
+    if (quit_.exchange(true)) return;
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    sleep_cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    for (auto& worker : workers_) {
+        worker->tasks.clear();
+    }
+}
+
+bool WorkStealingPool::popLocal(size_t index, Task& task) {
+    Worker& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) return false;
+    task = std::move(worker.tasks.front());
+    worker.tasks.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t thief, Task& task) {
+    // 从下一个线程开始依次尝试，避免所有空闲线程争抢同一个队列
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        Worker& victim = *workers_[(thief + i) % workers_.size()];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) continue;
+        // 从队尾窃取，队首留给队列所有者，减少双方的冲突
+        task = std::move(victim.tasks.back());
+        victim.tasks.pop_back();
+        stolen_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(size_t index) {
+    tCurrentPool = this;
+    tWorkerIndex = index;
+
+    Task task;
+    while (!quit_.load(std::memory_order_relaxed)) {
+        if (popLocal(index, task) || steal(index, task)) {
+            pending_.fetch_sub(1);
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        // 没有可执行的任务：休眠直到有新任务提交。try_lock窃取失败时pending_可能
+        // 仍大于0，超时后重新扫描
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        idle_.fetch_add(1);
+        sleep_cv_.wait_for(lock, std::chrono::milliseconds(10), [this] {
+            return pending_.load() > 0 || quit_.load();
+        });
+        idle_.fetch_sub(1);
+    }
+    tCurrentPool = nullptr;
+}
@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+#include "admission_control.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kSecond = 1000000000ull;
+
+uint32_t ip(const char* text) {
+    uint32_t addr = 0;
+    inet_pton(AF_INET, text, &addr);
+    return addr;
+}
+
+}  // namespace
+
+// 测试令牌桶的突发容量与按速率补充
+TEST(TokenBucketTest, BurstThenRefill) {
+    TokenBucket bucket(10, 5, 0);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(bucket.tryTake(0));
+    }
+    EXPECT_FALSE(bucket.tryTake(0));
+    EXPECT_FALSE(bucket.full(0));
+
+    // 100ms补充1个令牌
+    EXPECT_TRUE(bucket.tryTake(kSecond / 10));
+    EXPECT_FALSE(bucket.tryTake(kSecond / 10));
+
+    // 补充不超过容量
+    EXPECT_TRUE(bucket.full(10 * kSecond));
+    int taken = 0;
+    while (bucket.tryTake(10 * kSecond)) ++taken;
+    EXPECT_EQ(taken, 5);
+}
+
+// 测试不限制时全部接受，并统计当前连接数
+TEST(AdmissionControllerTest, UnlimitedAcceptsAll) {
+    AdmissionController admission{AdmissionConfig()};
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(admission.admit(ip("10.0.0.1"), 0), AdmissionResult::Accepted);
+    }
+    EXPECT_EQ(admission.stats().accepted, 1000u);
+    EXPECT_EQ(admission.stats().active_connections, 1000u);
+    admission.release();
+    EXPECT_EQ(admission.stats().active_connections, 999u);
+}
+
+// 测试最大连接数：达到上限后拒绝，释放后恢复接受
+TEST(AdmissionControllerTest, MaxConnections) {
+    AdmissionConfig config;
+    config.max_connections = 3;
+    AdmissionController admission(config);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(admission.admit(ip("10.0.0.1"), 0), AdmissionResult::Accepted);
+    }
+    EXPECT_EQ(admission.admit(ip("10.0.0.2"), 0), AdmissionResult::TooManyConnections);
+    admission.release();
+    EXPECT_EQ(admission.admit(ip("10.0.0.2"), 0), AdmissionResult::Accepted);
+
+    AdmissionStats stats = admission.stats();
+    EXPECT_EQ(stats.accepted, 4u);
+    EXPECT_EQ(stats.rejected_max_connections, 1u);
+    EXPECT_EQ(stats.active_connections, 3u);
+}
+
+// 测试多线程并发准入时不超过最大连接数
+TEST(AdmissionControllerTest, MaxConnectionsUnderContention) {
+    AdmissionConfig config;
+    config.max_connections = 100;
+    AdmissionController admission(config);
+    std::atomic<int> accepted(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) {
+                if (admission.admit(ip("10.0.0.1"), 0) == AdmissionResult::Accepted) {
+                    accepted.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(accepted.load(), 100);
+    EXPECT_EQ(admission.stats().rejected_max_connections, 7900u);
+}
+
+// 测试全局速率限制，被拒绝的连接不占用连接名额
+TEST(AdmissionControllerTest, GlobalRateLimit) {
+    AdmissionConfig config;
+    config.max_connections = 100;
+    config.accept_rate = 10;
+    config.accept_burst = 2;
+    AdmissionController admission(config);
+    uint64_t now = 5 * kSecond;
+    EXPECT_EQ(admission.admit(ip("10.0.0.1"), now), AdmissionResult::Accepted);
+    EXPECT_EQ(admission.admit(ip("10.0.0.2"), now), AdmissionResult::Accepted);
+    EXPECT_EQ(admission.admit(ip("10.0.0.3"), now), AdmissionResult::GlobalRateLimited);
+    EXPECT_EQ(admission.admit(ip("10.0.0.3"), now + kSecond / 10), AdmissionResult::Accepted);
+
+    AdmissionStats stats = admission.stats();
+    EXPECT_EQ(stats.rejected_global_rate, 1u);
+    EXPECT_EQ(stats.active_connections, 3u);
+}
+
+// 测试单个源IP的速率限制不影响其他源IP
+TEST(AdmissionControllerTest, SourceRateLimit) {
+    AdmissionConfig config;
+    config.source_accept_rate = 1;
+    config.source_accept_burst = 3;
+    AdmissionController admission(config);
+    uint64_t now = 5 * kSecond;
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(admission.admit(ip("192.168.1.1"), now), AdmissionResult::Accepted);
+    }
+    EXPECT_EQ(admission.admit(ip("192.168.1.1"), now), AdmissionResult::SourceRateLimited);
+    EXPECT_EQ(admission.admit(ip("192.168.1.2"), now), AdmissionResult::Accepted);
+    EXPECT_EQ(admission.admit(ip("192.168.1.1"), now + kSecond), AdmissionResult::Accepted);
+
+    AdmissionStats stats = admission.stats();
+    EXPECT_EQ(stats.rejected_source_rate, 1u);
+    EXPECT_EQ(stats.accepted, 5u);
+}
+
+// 测试被源IP拒绝的连接归还全局令牌，不挤占其他源的全局配额
+TEST(AdmissionControllerTest, SourceRejectRefundsGlobalToken) {
+    AdmissionConfig config;
+    config.accept_rate = 10;
+    config.accept_burst = 2;
+    config.source_accept_rate = 1;
+    config.source_accept_burst = 1;
+    AdmissionController admission(config);
+    uint64_t now = 5 * kSecond;
+    EXPECT_EQ(admission.admit(ip("10.0.0.1"), now), AdmissionResult::Accepted);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(admission.admit(ip("10.0.0.1"), now), AdmissionResult::SourceRateLimited);
+    }
+    EXPECT_EQ(admission.admit(ip("10.0.0.2"), now), AdmissionResult::Accepted);
+    EXPECT_EQ(admission.admit(ip("10.0.0.3"), now), AdmissionResult::GlobalRateLimited);
+
+    AdmissionStats stats = admission.stats();
+    EXPECT_EQ(stats.rejected_source_rate, 5u);
+    EXPECT_EQ(stats.rejected_global_rate, 1u);
+}
+
+// 测试跟踪表满时只淘汰最久未使用的源：持续活跃、正在被限速的源在大量新源涌入时仍受限，
+// 长时间未出现的源被淘汰后按新源对待
+TEST(AdmissionControllerTest, SourceTableEvictsLeastRecentlyUsed) {
+    AdmissionConfig config;
+    config.source_accept_rate = 0.001;
+    config.source_accept_burst = 1;
+    AdmissionController admission(config);
+    uint64_t now = kSecond;
+    const uint32_t idle = ip("172.16.0.1");
+    const uint32_t throttled = ip("172.16.0.2");
+    EXPECT_EQ(admission.admit(idle, now), AdmissionResult::Accepted);
+    EXPECT_EQ(admission.admit(throttled, now), AdmissionResult::Accepted);
+    // 同一网段的大量源地址，总数远超跟踪表容量
+    for (uint32_t i = 0; i < 200000; ++i) {
+        now += kSecond / 100000;
+        EXPECT_EQ(admission.admit(htonl(0x0a000000 + i), now), AdmissionResult::Accepted);
+        if (i % 1000 == 0) {
+            EXPECT_EQ(admission.admit(throttled, now), AdmissionResult::SourceRateLimited);
+        }
+    }
+    EXPECT_EQ(admission.admit(throttled, now), AdmissionResult::SourceRateLimited);
+    EXPECT_EQ(admission.admit(idle, now), AdmissionResult::Accepted);
+}
+
+// 测试大量不同源IP时跟踪表有界，已补满的令牌桶被回收后限速仍然有效
+TEST(AdmissionControllerTest, SourceTableIsBounded) {
+    AdmissionConfig config;
+    config.source_accept_rate = 1;
+    config.source_accept_burst = 1;
+    AdmissionController admission(config);
+    uint64_t now = 0;
+    for (uint32_t i = 0; i < 200000; ++i) {
+        EXPECT_EQ(admission.admit(htonl(0x0a000000 + i), now), AdmissionResult::Accepted);
+        now += kSecond / 1000;
+    }
+    EXPECT_EQ(admission.admit(htonl(0x0b000001), now), AdmissionResult::Accepted);
+    EXPECT_EQ(admission.admit(htonl(0x0b000001), now), AdmissionResult::SourceRateLimited);
+}
+
+// 测试预留fd：接受并立即以RST拒绝队首连接
+TEST(ReserveFdTest, ShedsQueuedConnection) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(listen_fd, 4), 0);
+    ASSERT_EQ(getsockname(listen_fd, (struct sockaddr*)&addr, &len), 0);
+
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(client, (struct sockaddr*)&addr, sizeof(addr)), 0);
+
+    ReserveFd reserve;
+    EXPECT_TRUE(reserve.shedOne(listen_fd));
+    EXPECT_FALSE(reserve.shedOne(listen_fd));
+
+    char buffer[16];
+    ssize_t n;
+    do {
+        n = recv(client, buffer, sizeof(buffer), 0);
+    } while (n < 0 && errno == EINTR);
+    EXPECT_EQ(n, -1);
+    EXPECT_EQ(errno, ECONNRESET);
+    close(client);
+    close(listen_fd);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
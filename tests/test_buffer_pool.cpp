@@ -0,0 +1,309 @@
+#include <gtest/gtest.h>
+#include "buffer_pool.h"
+#include "frame.h"
+#include "tcp_client.h"
+#include "tcp_server.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 堆分配计数钩子：统计计数窗口内operator new的调用次数
+std::atomic<bool> gCountAllThreads(false);
+thread_local bool tCountThisThread = false;
+std::atomic<size_t> gAllocationCount(0);
+
+// 在计数窗口内执行f，返回期间所有线程发生的堆分配次数
+template <typename F>
+size_t countAllocations(F&& f) {
+    gAllocationCount = 0;
+    gCountAllThreads = true;
+    f();
+    gCountAllThreads = false;
+    return gAllocationCount;
+}
+
+// 同上，但只统计调用线程
+template <typename F>
+size_t countThreadAllocations(F&& f) {
+    gAllocationCount = 0;
+    tCountThisThread = true;
+    f();
+    tCountThisThread = false;
+    return gAllocationCount;
+}
+
+const std::string kResponse = "服务器已收到消息";
+
+int connectTo(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    struct timeval tv{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 接收len字节到调用方提供的缓冲区，不做任何堆分配
+bool recvInto(int fd, char* buffer, size_t len) {
+    size_t received = 0;
+    while (received < len) {
+        ssize_t n = recv(fd, buffer + received, len - received, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        received += n;
+    }
+    return true;
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+    if (tCountThisThread || gCountAllThreads.load(std::memory_order_relaxed)) {
+        gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+// 测试大小级别的划分
+TEST(BufferPoolTest, SizeClasses) {
+    EXPECT_EQ(BufferPool::sizeClass(0), 0u);
+    EXPECT_EQ(BufferPool::sizeClass(1), 0u);
+    EXPECT_EQ(BufferPool::sizeClass(256), 0u);
+    EXPECT_EQ(BufferPool::sizeClass(257), 1u);
+    EXPECT_EQ(BufferPool::sizeClass(4096), 4u);
+    EXPECT_EQ(BufferPool::sizeClass(BufferPool::kMaxBlockSize), BufferPool::kClassCount - 1);
+    EXPECT_EQ(BufferPool::sizeClass(BufferPool::kMaxBlockSize + 1), BufferPool::kClassCount);
+
+    PooledBuffer buffer(1000);
+    EXPECT_EQ(buffer.capacity(), 1024u);
+
+    // 超出最大级别直接走堆
+    size_t large_before = BufferPool::instance().stats().large_allocations;
+    PooledBuffer large(BufferPool::kMaxBlockSize + 1);
+    EXPECT_EQ(large.capacity(), BufferPool::kMaxBlockSize + 1);
+    EXPECT_EQ(BufferPool::instance().stats().large_allocations, large_before + 1);
+}
+
+// 测试释放的块被同一线程立即复用
+TEST(BufferPoolTest, ReusesReleasedBlocks) {
+    void* first;
+    {
+        PooledBuffer buffer(4096);
+        first = buffer.data();
+    }
+    PooledBuffer buffer(3000);
+    EXPECT_EQ(buffer.data(), first);
+}
+
+// 测试线程退出时本地缓存归还到全局链表，供其他线程复用
+TEST(BufferPoolTest, ThreadCacheRecycledOnExit) {
+    const size_t BLOCK_COUNT = 512;
+    std::thread worker([&] {
+        std::vector<PooledBuffer> buffers;
+        buffers.reserve(BLOCK_COUNT);
+        for (size_t i = 0; i < BLOCK_COUNT; ++i) {
+            buffers.emplace_back(16 * 1024);
+        }
+    });
+    worker.join();
+
+    size_t slab_bytes = BufferPool::instance().stats().slab_bytes;
+    std::thread reader([&] {
+        std::vector<PooledBuffer> buffers;
+        buffers.reserve(BLOCK_COUNT);
+        for (size_t i = 0; i < BLOCK_COUNT; ++i) {
+            buffers.emplace_back(16 * 1024);
+        }
+    });
+    reader.join();
+    EXPECT_EQ(BufferPool::instance().stats().slab_bytes, slab_bytes);
+}
+
+// 测试字节缓冲区在读完后复用空间，在数据未读完时扩容
+TEST(BufferPoolTest, ByteBufferCompactsAndGrows) {
+    ByteBuffer buffer;
+    EXPECT_EQ(buffer.capacity(), 0u);
+
+    std::string first(200, 'a');
+    buffer.append(first);
+    EXPECT_EQ(buffer.capacity(), BufferPool::kMinBlockSize);
+    buffer.consume(150);
+
+    // 挪动未读数据即可容纳，不换块
+    buffer.append(std::string(100, 'b'));
+    EXPECT_EQ(buffer.capacity(), BufferPool::kMinBlockSize);
+    EXPECT_EQ(std::string(buffer.readPtr(), buffer.readableBytes()),
+              std::string(50, 'a') + std::string(100, 'b'));
+
+    // 空间不足时换更大的块，数据保持连续
+    buffer.append(std::string(1000, 'c'));
+    EXPECT_GE(buffer.capacity(), 1150u);
+    EXPECT_EQ(buffer.readableBytes(), 1150u);
+
+    ByteBuffer other(std::move(buffer));
+    EXPECT_EQ(buffer.capacity(), 0u);
+    EXPECT_EQ(other.readableBytes(), 1150u);
+}
+
+// 测试共享缓冲区拷贝只增加引用计数，最后一个引用释放时归还内存
+TEST(BufferPoolTest, SharedBufferRefcount) {
+    ByteBuffer owned;
+    owned.append(std::string(3000, 's'));
+    const char* data = owned.readPtr();
+
+    SharedBuffer shared(std::move(owned));
+    EXPECT_EQ(shared.data(), data);
+    EXPECT_EQ(shared.size(), 3000u);
+    EXPECT_EQ(shared.useCount(), 1);
+    {
+        SharedBuffer copy = shared;
+        EXPECT_EQ(copy.data(), data);
+        EXPECT_EQ(shared.useCount(), 2);
+        SharedBuffer moved(std::move(copy));
+        EXPECT_EQ(copy.useCount(), 0);
+        EXPECT_EQ(shared.useCount(), 2);
+    }
+    EXPECT_EQ(shared.useCount(), 1);
+
+    SharedBuffer copied(std::string_view("拷贝"));
+    EXPECT_EQ(copied.view(), "拷贝");
+    copied = shared;
+    EXPECT_EQ(shared.useCount(), 2);
+    copied.reset();
+    EXPECT_TRUE(copied.empty());
+    EXPECT_EQ(shared.useCount(), 1);
+}
+
+// 测试服务器稳态下的收发不做任何堆分配，参数为I/O引擎
+class SteadyStateAllocationTest : public ::testing::TestWithParam<ServerEngine> {};
+
+TEST_P(SteadyStateAllocationTest, ServerHotPathDoesNotAllocate) {
+    ServerConfig config;
+    config.port = 0;
+    config.engine = GetParam();
+    config.reactor_count = 1;
+    TcpServer server(config);
+    ASSERT_TRUE(server.start());
+
+    int fd = connectTo(server.port());
+    ASSERT_GE(fd, 0);
+
+    // 每次写入一批帧，覆盖单次读取多帧的情况
+    const int BATCH = 16;
+    std::string batch;
+    for (int i = 0; i < BATCH; ++i) {
+        appendFrame(batch, FrameType::Message, i, "消息 " + std::to_string(i));
+    }
+    const size_t response_size = BATCH * (kFrameHeaderSize + kResponse.size());
+    std::vector<char> responses(response_size);
+
+    auto roundTrip = [&] {
+        if (send(fd, batch.data(), batch.size(), 0) != (ssize_t)batch.size()) return false;
+        return recvInto(fd, responses.data(), response_size);
+    };
+
+    // 预热：连接的缓冲区和各线程的本地缓存达到稳态
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(roundTrip());
+    }
+
+    bool ok = true;
+    size_t allocations = countAllocations([&] {
+        for (int i = 0; i < 1000 && ok; ++i) {
+            ok = roundTrip();
+        }
+    });
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(allocations, 0u);
+
+    FrameHeader header = decodeFrameHeader(responses.data());
+    EXPECT_EQ(header.type, static_cast<uint16_t>(FrameType::Response));
+    EXPECT_EQ(std::string(responses.data() + kFrameHeaderSize, header.length), kResponse);
+
+    close(fd);
+    server.stop();
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, SteadyStateAllocationTest,
+                         ::testing::Values(ServerEngine::Epoll,
+                                           ServerEngine::IoUring,
+                                           ServerEngine::ThreadPerConnection));
+
+// 测试客户端稳态下发送消息不做任何堆分配。只统计调用send的线程，
+// 事件循环线程与服务器线程不在统计范围内
+TEST(ClientAllocationTest, SendDoesNotAllocate) {
+    ServerConfig config;
+    config.port = 0;
+    config.reactor_count = 1;
+    TcpServer server(config);
+    ASSERT_TRUE(server.start());
+
+    TcpClient client("127.0.0.1", server.port());
+    client.start();
+    for (int i = 0; i < 100 && !client.isConnected(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(client.isConnected());
+
+    // 发送请求在事件循环线程上释放，先让该线程的本地缓存达到上限、开始向全局链表归还
+    const std::string message = "客户端稳态消息";
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT_TRUE(client.send(message));
+    }
+
+    // 请求大多由事件循环线程释放、分批归还，预热结束时全局链表的余量取决于最后一个slab
+    // 切出后用掉了多少，余量不足一个批次时发送线程还会再切一个slab。因此允许测量窗口内
+    // 最多补充一次slab，之后的窗口必须完全没有分配
+    bool ok = true;
+    size_t allocations = 0;
+    for (int window = 0; window < 3; ++window) {
+        allocations = countThreadAllocations([&] {
+            for (int i = 0; i < 1000 && ok; ++i) {
+                ok = client.send(message);
+            }
+        });
+        if (allocations == 0) break;
+        EXPECT_LE(allocations, 1u);
+    }
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(allocations, 0u);
+
+    client.stop();
+    server.stop();
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+#include "client_pool.h"
+#include "tcp_client.h"
+#include "tcp_server.h"
+#include <dirent.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 当前进程的线程数
+size_t threadCount() {
+    size_t count = 0;
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr) return 0;
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') ++count;
+    }
+    closedir(dir);
+    return count;
+}
+
+// 轮询等待条件成立，超时返回false
+template <typename F>
+bool waitUntil(F&& condition, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+// 返回一个当前没有监听的本地端口
+int unusedPort() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    getsockname(fd, (struct sockaddr*)&addr, &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+}  // namespace
+
+// 测试大量客户端共享池中的少量线程：创建和连接客户端不增加线程
+TEST(ClientPoolTest, ManyClientsShareLoopThreads) {
+    constexpr int kClients = 1000;
+    ServerConfig config;
+    config.port = 0;
+    config.reactor_count = 1;
+    config.admission.backlog = kClients;
+    TcpServer server(config);
+    ASSERT_TRUE(server.start());
+
+    ClientPool pool(2);
+    EXPECT_EQ(pool.loopCount(), 2u);
+    size_t threads_before = threadCount();
+
+    std::atomic<int> connected(0);
+    std::vector<std::unique_ptr<TcpClient>> clients;
+    for (int i = 0; i < kClients; ++i) {
+        clients.push_back(std::make_unique<TcpClient>(pool, "127.0.0.1", server.port()));
+        clients.back()->setConnectionCallback([&connected](bool up) {
+            connected.fetch_add(up ? 1 : -1);
+        });
+        clients.back()->startAsync();
+    }
+    ASSERT_TRUE(waitUntil([&] { return connected.load() == kClients; }, std::chrono::seconds(10)));
+    EXPECT_EQ(threadCount(), threads_before);
+
+    std::atomic<int> completed(0);
+    for (int i = 0; i < kClients; ++i) {
+        EXPECT_TRUE(clients[i]->sendAsync("池化客户端 " + std::to_string(i), [&completed](bool ok) {
+            if (ok) completed.fetch_add(1);
+        }));
+    }
+    EXPECT_TRUE(waitUntil([&] { return completed.load() == kClients; }, std::chrono::seconds(5)));
+    EXPECT_TRUE(clients.front()->send("同步发送"));
+
+    // stop()返回时断开回调已经执行完毕
+    for (auto& client : clients) {
+        client->stop();
+    }
+    EXPECT_EQ(connected.load(), 0);
+    clients.clear();
+    server.stop();
+}
+
+// 测试服务器不可用时start()如实返回，服务器启动后由定时器自动重连
+TEST(ClientPoolTest, ReconnectsWhenServerComesUp) {
+    int port = unusedPort();
+    ClientPool pool(1);
+    TcpClient client(pool, "127.0.0.1", port);
+    client.start();
+    EXPECT_TRUE(client.isRunning());
+    EXPECT_FALSE(client.isConnected());
+    EXPECT_FALSE(client.send("连接前"));
+
+    ServerConfig config;
+    config.port = port;
+    TcpServer server(config);
+    ASSERT_TRUE(server.start());
+    ASSERT_TRUE(waitUntil([&] { return client.isConnected(); }, std::chrono::seconds(5)));
+    EXPECT_TRUE(client.send("重连后"));
+
+    // 服务器关闭连接后客户端检测到断开并再次重连
+    server.stop();
+    EXPECT_TRUE(waitUntil([&] { return !client.isConnected(); }, std::chrono::seconds(5)));
+    client.stop();
+    EXPECT_FALSE(client.isRunning());
+}
+
+// 测试在连接回调中停止客户端
+TEST(ClientPoolTest, StopFromCallback) {
+    ServerConfig config;
+    config.port = 0;
+    TcpServer server(config);
+    ASSERT_TRUE(server.start());
+
+    ClientPool pool(1);
+    TcpClient client(pool, "127.0.0.1", server.port());
+    std::atomic<int> calls(0);
+    client.setConnectionCallback([&](bool up) {
+        ++calls;
+        if (up) client.stop();
+    });
+    client.start();
+    ASSERT_TRUE(waitUntil([&] { return calls.load() == 2; }, std::chrono::seconds(5)));
+    EXPECT_FALSE(client.isRunning());
+    EXPECT_FALSE(client.isConnected());
+    server.stop();
+}
+
+// 测试状态回调按顺序在回调线程上执行，回调阻塞时事件循环照常运转
+TEST(ClientPoolTest, StateCallbacksRunOffLoop) {
+    ServerConfig config;
+    config.port = 0;
+    auto server = std::make_unique<TcpServer>(config);
+    ASSERT_TRUE(server->start());
+
+    ClientPool pool(1);
+    TcpClient client(pool, "127.0.0.1", server->port());
+    ReconnectConfig reconnect;
+    reconnect.initial_backoff_ms = 20;
+    reconnect.max_backoff_ms = 50;
+    client.setReconnectConfig(reconnect);
+    EXPECT_EQ(client.state(), ConnectionState::Stopped);
+
+    std::mutex mutex;
+    std::vector<std::pair<ConnectionState, ConnectionState>> changes;
+    std::atomic<bool> on_caller(false);
+    std::atomic<bool> send_completed(false);
+    std::thread::id caller = std::this_thread::get_id();
+    client.setStateCallback([&](ConnectionState previous, ConnectionState state) {
+        if (std::this_thread::get_id() == caller) on_caller = true;
+        if (state == ConnectionState::Connected) {
+            // 发送完成回调在事件循环上执行，回调线程阻塞等待它不会死锁
+            auto done = std::make_shared<std::promise<void>>();
+            client.sendAsync("回调中", [done](bool) { done->set_value(); });
+            if (done->get_future().wait_for(std::chrono::seconds(5)) == std::future_status::ready) {
+                send_completed = true;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        changes.emplace_back(previous, state);
+    });
+    client.start();
+    EXPECT_EQ(client.state(), ConnectionState::Connected);
+    ASSERT_TRUE(waitUntil([&] { return send_completed.load(); }, std::chrono::seconds(5)));
+
+    // 服务器关闭后依次进入断开和退避
+    server.reset();
+    ASSERT_TRUE(waitUntil([&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return changes.size() >= 4;
+    }, std::chrono::seconds(5)));
+    client.stop();
+    EXPECT_EQ(client.state(), ConnectionState::Stopped);
+    EXPECT_FALSE(on_caller.load());
+
+    // stop()返回时所有状态变化都已回调
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_GE(changes.size(), 5u);
+    EXPECT_EQ(changes[0], std::make_pair(ConnectionState::Stopped, ConnectionState::Connecting));
+    EXPECT_EQ(changes[1], std::make_pair(ConnectionState::Connecting, ConnectionState::Connected));
+    EXPECT_EQ(changes[2], std::make_pair(ConnectionState::Connected, ConnectionState::Draining));
+    EXPECT_EQ(changes[3], std::make_pair(ConnectionState::Draining, ConnectionState::Backoff));
+    EXPECT_EQ(changes.back().second, ConnectionState::Stopped);
+    for (size_t i = 1; i < changes.size(); ++i) {
+        EXPECT_EQ(changes[i].first, changes[i - 1].second) << i;
+    }
+    EXPECT_STREQ(connectionStateName(ConnectionState::Backoff), "backoff");
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
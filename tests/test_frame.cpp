@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include "frame.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct DecodedFrame {
+    FrameHeader header;
+    std::string payload;
+};
+
+// 收集解析出的帧，同时记录payload视图的地址
+struct FrameCollector {
+    std::vector<DecodedFrame> frames;
+    std::vector<const char*> views;
+
+    void operator()(const FrameHeader& header, std::string_view payload) {
+        frames.push_back({header, std::string(payload)});
+        views.push_back(payload.data());
+    }
+};
+
+std::string makeFrame(uint32_t sequence, const std::string& payload) {
+    std::string out;
+    appendFrame(out, FrameType::Message, sequence, payload);
+    return out;
+}
+
+}  // namespace
+
+// 测试帧头编解码
+TEST(FrameTest, HeaderRoundTrip) {
+    FrameHeader header;
+    header.length = 123456;
+    header.type = static_cast<uint16_t>(FrameType::Response);
+    header.sequence = 0xdeadbeef;
+
+    char bytes[kFrameHeaderSize];
+    encodeFrameHeader(bytes, header);
+    FrameHeader decoded = decodeFrameHeader(bytes);
+    EXPECT_EQ(decoded.length, header.length);
+    EXPECT_EQ(decoded.type, header.type);
+    EXPECT_EQ(decoded.sequence, header.sequence);
+}
+
+// 测试一次读取中包含多个帧
+TEST(FrameTest, ManyFramesPerRead) {
+    std::string data;
+    for (uint32_t i = 0; i < 100; ++i) {
+        appendFrame(data, FrameType::Message, i, "消息" + std::to_string(i));
+    }
+
+    FrameDecoder decoder;
+    char* buffer = decoder.prepare(data.size());
+    memcpy(buffer, data.data(), data.size());
+    decoder.commit(data.size());
+
+    FrameCollector collector;
+    ASSERT_TRUE(decoder.drain(collector));
+    ASSERT_EQ(collector.frames.size(), 100u);
+    for (uint32_t i = 0; i < 100; ++i) {
+        EXPECT_EQ(collector.frames[i].header.sequence, i);
+        EXPECT_EQ(collector.frames[i].payload, "消息" + std::to_string(i));
+    }
+    EXPECT_EQ(decoder.buffered(), 0u);
+}
+
+// 测试帧被拆分到多次读取（逐字节喂入）
+TEST(FrameTest, PartialFrames) {
+    std::string data = makeFrame(1, "hello") + makeFrame(2, std::string(5000, 'x'));
+
+    FrameDecoder decoder(16);
+    FrameCollector collector;
+    for (char c : data) {
+        *decoder.prepare(1) = c;
+        decoder.commit(1);
+        ASSERT_TRUE(decoder.drain(collector));
+    }
+    ASSERT_EQ(collector.frames.size(), 2u);
+    EXPECT_EQ(collector.frames[0].payload, "hello");
+    EXPECT_EQ(collector.frames[1].payload, std::string(5000, 'x'));
+    EXPECT_EQ(decoder.buffered(), 0u);
+}
+
+// 测试外部缓冲区中的完整帧不经拷贝直接解析
+TEST(FrameTest, FeedParsesInPlace) {
+    std::string data = makeFrame(1, "first") + makeFrame(2, "second");
+    std::string tail = makeFrame(3, "third");
+    data += tail.substr(0, 7);
+
+    FrameDecoder decoder;
+    FrameCollector collector;
+    ASSERT_TRUE(decoder.feed(data.data(), data.size(), collector));
+    ASSERT_EQ(collector.frames.size(), 2u);
+    EXPECT_EQ(collector.views[0], data.data() + kFrameHeaderSize);
+    EXPECT_EQ(decoder.buffered(), 7u);
+
+    // 剩余部分到达后拼出第三个帧
+    ASSERT_TRUE(decoder.feed(tail.data() + 7, tail.size() - 7, collector));
+    ASSERT_EQ(collector.frames.size(), 3u);
+    EXPECT_EQ(collector.frames[2].header.sequence, 3u);
+    EXPECT_EQ(collector.frames[2].payload, "third");
+    EXPECT_EQ(decoder.buffered(), 0u);
+}
+
+// 测试超长帧被视为协议错误
+TEST(FrameTest, OversizedFrameRejected) {
+    FrameDecoder decoder(4096, 1024);
+    std::string data = makeFrame(1, std::string(2048, 'x'));
+
+    FrameCollector collector;
+    EXPECT_FALSE(decoder.feed(data.data(), data.size(), collector));
+    EXPECT_TRUE(collector.frames.empty());
+}
+
+// 测试只收到声明了超大负载的帧头时不按声明长度预留内存，随数据到达逐步扩大，
+// 大帧处理完后接收缓冲区缩回
+TEST(FrameTest, PartialReserveFollowsReceivedBytes) {
+    const uint32_t length = 4 * 1024 * 1024;
+    FrameHeader header;
+    header.length = length;
+    header.type = static_cast<uint16_t>(FrameType::Message);
+    header.sequence = 9;
+    char bytes[kFrameHeaderSize];
+    encodeFrameHeader(bytes, header);
+
+    FrameDecoder decoder;
+    FrameCollector collector;
+    ASSERT_TRUE(decoder.feed(bytes, sizeof(bytes), collector));
+    EXPECT_LE(decoder.capacity(), 2 * kPartialReserveMin);
+
+    // 分块送入负载，预留量不超过已收到数据量的若干倍
+    std::string payload(length, 'b');
+    const size_t chunk = 32 * 1024;
+    for (size_t offset = 0; offset < payload.size(); offset += chunk) {
+        size_t n = std::min(chunk, payload.size() - offset);
+        char* buffer = decoder.prepare(n);
+        memcpy(buffer, payload.data() + offset, n);
+        decoder.commit(n);
+        ASSERT_TRUE(decoder.drain(collector));
+        EXPECT_LE(decoder.capacity(), 4 * (kFrameHeaderSize + offset + n) + 2 * kPartialReserveMin);
+    }
+    ASSERT_EQ(collector.frames.size(), 1u);
+    EXPECT_EQ(collector.frames[0].payload, payload);
+    EXPECT_LE(decoder.capacity(), kDecoderShrinkCapacity);
+
+    // 大帧之后紧跟一个小帧的前半部分：缩回到小缓冲区，剩余数据保留
+    std::string data = makeFrame(1, std::string(length, 'c'));
+    std::string tail = makeFrame(2, "small");
+    data += tail.substr(0, 10);
+    ASSERT_TRUE(decoder.feed(data.data(), data.size() / 2, collector));
+    ASSERT_TRUE(decoder.feed(data.data() + data.size() / 2, data.size() - data.size() / 2, collector));
+    ASSERT_EQ(collector.frames.size(), 2u);
+    EXPECT_EQ(decoder.buffered(), 10u);
+    EXPECT_LE(decoder.capacity(), kDecoderShrinkCapacity);
+    ASSERT_TRUE(decoder.feed(tail.data() + 10, tail.size() - 10, collector));
+    ASSERT_EQ(collector.frames.size(), 3u);
+    EXPECT_EQ(collector.frames[2].payload, "small");
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
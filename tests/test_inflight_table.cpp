@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "inflight_table.h"
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// 测试插入、查找和删除
+TEST(InflightTableTest, InsertFindTake) {
+    InflightTable<int> table;
+    int a = 1, b = 2;
+    EXPECT_TRUE(table.empty());
+    EXPECT_TRUE(table.insert(7, &a));
+    EXPECT_FALSE(table.insert(7, &b));
+    EXPECT_TRUE(table.insert(8, &b));
+    EXPECT_EQ(table.size(), 2u);
+    EXPECT_EQ(table.find(7), &a);
+    EXPECT_EQ(table.find(9), nullptr);
+    EXPECT_EQ(table.take(7), &a);
+    EXPECT_EQ(table.take(7), nullptr);
+    EXPECT_EQ(table.find(8), &b);
+    EXPECT_EQ(table.size(), 1u);
+}
+
+// 测试落在同一槽位的键：删除探测链中间的元素后其余元素仍可找到
+TEST(InflightTableTest, CollidingKeysSurviveRemoval) {
+    InflightTable<int> table(16);
+    std::vector<int> values(4);
+    uint32_t capacity = static_cast<uint32_t>(table.capacity());
+    for (uint32_t i = 0; i < 4; ++i) {
+        ASSERT_TRUE(table.insert(3 + i * capacity, &values[i]));
+    }
+    // 占据探测链之后的槽，验证前移不会越过起始槽在链外的元素
+    int other = 0;
+    ASSERT_TRUE(table.insert(5, &other));
+
+    EXPECT_EQ(table.take(3 + capacity), &values[1]);
+    for (uint32_t i : {0u, 2u, 3u}) {
+        EXPECT_EQ(table.find(3 + i * capacity), &values[i]);
+    }
+    EXPECT_EQ(table.find(5), &other);
+    EXPECT_EQ(table.take(3), &values[0]);
+    EXPECT_EQ(table.take(3 + 3 * capacity), &values[3]);
+    EXPECT_EQ(table.find(3 + 2 * capacity), &values[2]);
+    EXPECT_EQ(table.find(5), &other);
+}
+
+// 测试负载超过一半时扩容，已有元素不丢失
+TEST(InflightTableTest, GrowsAndKeepsEntries) {
+    InflightTable<int> table(8);
+    std::vector<int> values(1000);
+    for (uint32_t i = 0; i < values.size(); ++i) {
+        ASSERT_TRUE(table.insert(i, &values[i]));
+    }
+    EXPECT_GE(table.capacity(), 2 * values.size());
+    for (uint32_t i = 0; i < values.size(); ++i) {
+        EXPECT_EQ(table.find(i), &values[i]);
+    }
+}
+
+// 测试序号回绕与随机操作，结果与std::unordered_map一致
+TEST(InflightTableTest, MatchesReferenceUnderRandomOperations) {
+    InflightTable<int> table(8);
+    std::unordered_map<uint32_t, int*> reference;
+    std::vector<int> values(512);
+    std::mt19937 rng(7);
+    // 模拟流水线：序号连续递增并跨越uint32上限，完成顺序随机
+    uint32_t next = UINT32_MAX - 20000;
+    for (int step = 0; step < 100000; ++step) {
+        if (reference.size() < values.size() && (reference.empty() || rng() % 3 != 0)) {
+            int* value = &values[next % values.size()];
+            ASSERT_TRUE(table.insert(next, value));
+            reference[next] = value;
+            ++next;
+        } else {
+            uint32_t id = next - 1 - rng() % (values.size() * 2);
+            auto it = reference.find(id);
+            int* expected = it == reference.end() ? nullptr : it->second;
+            ASSERT_EQ(table.take(id), expected);
+            if (it != reference.end()) reference.erase(it);
+        }
+        ASSERT_EQ(table.size(), reference.size());
+    }
+    for (const auto& entry : reference) {
+        EXPECT_EQ(table.find(entry.first), entry.second);
+    }
+
+    size_t drained = 0;
+    table.drain([&drained](int*) { ++drained; });
+    EXPECT_EQ(drained, reference.size());
+    EXPECT_TRUE(table.empty());
+    EXPECT_EQ(table.find(next - 1), nullptr);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "latency_histogram.h"
+#include <thread>
+#include <vector>
+
+// 测试均匀分布的分位数在精度范围内
+TEST(LatencyHistogramTest, Percentiles) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.valueAtPercentile(50), 0u);
+    for (uint64_t i = 1; i <= 10000; ++i) {
+        histogram.record(i);
+    }
+    EXPECT_EQ(histogram.count(), 10000u);
+    EXPECT_EQ(histogram.min(), 1u);
+    EXPECT_EQ(histogram.max(), 10000u);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 5000.5);
+    EXPECT_NEAR(static_cast<double>(histogram.valueAtPercentile(50)), 5000, 5);
+    EXPECT_NEAR(static_cast<double>(histogram.valueAtPercentile(99)), 9900, 10);
+    EXPECT_NEAR(static_cast<double>(histogram.valueAtPercentile(99.9)), 9990, 10);
+    EXPECT_EQ(histogram.valueAtPercentile(100), 10000u);
+    EXPECT_EQ(histogram.valueAtPercentile(0), 1u);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_EQ(histogram.max(), 0u);
+}
+
+// 测试大数值的相对误差不超过千分之一，超出上限的值按上限计数
+TEST(LatencyHistogramTest, PrecisionAndRange) {
+    LatencyHistogram histogram(1000000, 3);
+    histogram.record(123456);
+    uint64_t value = histogram.valueAtPercentile(50);
+    EXPECT_LE(value, 123456u);
+    EXPECT_GE(static_cast<double>(value), 123456 * 0.999);
+
+    histogram.record(5000000);
+    EXPECT_EQ(histogram.max(), 5000000u);
+    EXPECT_EQ(histogram.count(), 2u);
+    EXPECT_GE(static_cast<double>(histogram.valueAtPercentile(100)), 1000000 * 0.999);
+}
+
+// 测试按期望间隔补记被挡住的样本
+TEST(LatencyHistogramTest, CoordinatedOmissionCorrection) {
+    LatencyHistogram histogram;
+    // 每10微秒发一个请求，其中一个卡了1000微秒：期间本应发出的99个请求也被补记
+    for (int i = 0; i < 100; ++i) {
+        histogram.recordCorrected(10, 10);
+    }
+    histogram.recordCorrected(1000, 10);
+    EXPECT_EQ(histogram.count(), 200u);
+    EXPECT_EQ(histogram.valueAtPercentile(50), 10u);
+    EXPECT_GT(histogram.valueAtPercentile(75), 400u);
+
+    LatencyHistogram uncorrected;
+    for (int i = 0; i < 100; ++i) {
+        uncorrected.record(10);
+    }
+    uncorrected.record(1000);
+    EXPECT_EQ(uncorrected.valueAtPercentile(99), 10u);
+}
+
+// 测试多线程并发记录与合并
+TEST(LatencyHistogramTest, ConcurrentRecordAndMerge) {
+    LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&histogram, t] {
+            for (int i = 0; i < 10000; ++i) {
+                histogram.record(static_cast<uint64_t>(t * 10000 + i + 1));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(histogram.count(), 40000u);
+    EXPECT_EQ(histogram.min(), 1u);
+    EXPECT_EQ(histogram.max(), 40000u);
+
+    LatencyHistogram total;
+    total.record(1000000);
+    total.merge(histogram);
+    EXPECT_EQ(total.count(), 40001u);
+    EXPECT_EQ(total.max(), 1000000u);
+    EXPECT_NEAR(static_cast<double>(total.valueAtPercentile(50)), 20000, 20);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include "load_generator.h"
+#include "client_pool.h"
+#include "tcp_server.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <map>
+#include <random>
+#include <string>
+
+// 测试负载大小分布的解析与取值
+TEST(LoadGeneratorTest, PayloadSizes) {
+    PayloadSizes sizes;
+    ASSERT_TRUE(parsePayloadSizes("256", sizes));
+    std::mt19937_64 rng(1);
+    EXPECT_EQ(sizes.next(rng), 256u);
+    EXPECT_EQ(sizes.maxSize(), 256u);
+
+    ASSERT_TRUE(parsePayloadSizes("64-1024", sizes));
+    for (int i = 0; i < 1000; ++i) {
+        size_t size = sizes.next(rng);
+        EXPECT_GE(size, 64u);
+        EXPECT_LE(size, 1024u);
+    }
+
+    ASSERT_TRUE(parsePayloadSizes("64:90,4096:10", sizes));
+    EXPECT_EQ(sizes.maxSize(), 4096u);
+    std::map<size_t, int> counts;
+    for (int i = 0; i < 10000; ++i) {
+        counts[sizes.next(rng)]++;
+    }
+    ASSERT_EQ(counts.size(), 2u);
+    EXPECT_NEAR(counts[64], 9000, 300);
+
+    EXPECT_FALSE(parsePayloadSizes("", sizes));
+    EXPECT_FALSE(parsePayloadSizes("abc", sizes));
+    EXPECT_FALSE(parsePayloadSizes("100-10", sizes));
+    EXPECT_FALSE(parsePayloadSizes("64:0", sizes));
+    EXPECT_FALSE(parsePayloadSizes("64,,128", sizes));
+    // 失败时不修改原有分布
+    EXPECT_EQ(sizes.maxSize(), 4096u);
+}
+
+// 测试开环压测按目标速率发送，所有请求收到响应，延迟从计划时间算起不小于服务时间
+TEST(LoadGeneratorTest, OpenLoopRun) {
+    ServerConfig server_config;
+    server_config.port = 0;
+    TcpServer server(server_config);
+    ASSERT_TRUE(server.start());
+
+    ClientPool pool(2);
+    LoadConfig config;
+    config.port = server.port();
+    config.connections = 4;
+    config.rate = 2000;
+    config.duration_ms = 500;
+    config.ramp_up_ms = 40;
+    config.sender_threads = 2;
+    ASSERT_TRUE(parsePayloadSizes("16-256", config.payload));
+
+    LoadReport report;
+    ASSERT_TRUE(runLoad(pool, config, report));
+    EXPECT_EQ(report.connected, 4u);
+    EXPECT_NEAR(static_cast<double>(report.sent), 1000, 100);
+    EXPECT_EQ(report.rejected, 0u);
+    EXPECT_EQ(report.failed, 0u);
+    EXPECT_EQ(report.completed, report.sent);
+    EXPECT_GT(report.throughput, 1500);
+    EXPECT_EQ(report.latency.count, report.completed);
+    EXPECT_EQ(report.latency.failed, 0u);
+    EXPECT_EQ(report.latency.rejected, 0u);
+    EXPECT_GT(report.latency.p50, 0u);
+    EXPECT_GE(report.latency.p50, report.service.p50);
+    EXPECT_GE(report.latency.p99, report.service.p99);
+    EXPECT_LE(report.latency.p99, report.latency.max);
+
+    std::string json = loadReportJson(config, report);
+    EXPECT_NE(json.find("\"rate\": 2000.000"), std::string::npos);
+    EXPECT_NE(json.find("\"completed\": " + std::to_string(report.completed)), std::string::npos);
+    EXPECT_NE(json.find("\"p99_9\""), std::string::npos);
+    EXPECT_NE(json.find("{\"min\": 16, \"max\": 256, \"weight\": 1}"), std::string::npos);
+}
+
+// 测试服务器不响应时超时的请求按超时时的耗时计入延迟分位数，而不是从结果中消失
+TEST(LoadGeneratorTest, TimeoutsCountInLatency) {
+    // 只监听不accept：连接在内核队列中建立，请求写出后永远等不到响应
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listen_fd, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    ASSERT_EQ(listen(listen_fd, 16), 0);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+
+    ClientPool pool(1);
+    LoadConfig config;
+    config.port = ntohs(addr.sin_port);
+    config.connections = 2;
+    config.rate = 200;
+    config.duration_ms = 200;
+    config.timeout_ms = 100;
+
+    LoadReport report;
+    ASSERT_TRUE(runLoad(pool, config, report));
+    EXPECT_GT(report.sent, 0u);
+    EXPECT_EQ(report.completed, 0u);
+    EXPECT_EQ(report.failed, report.sent);
+    EXPECT_EQ(report.timed_out, report.sent);
+    EXPECT_EQ(report.latency.count, report.sent);
+    EXPECT_EQ(report.latency.failed, report.sent);
+    // 超时请求的延迟不小于超时时间
+    EXPECT_GE(report.latency.p50, 100000u);
+
+    std::string json = loadReportJson(config, report);
+    EXPECT_NE(json.find("\"timed_out\": " + std::to_string(report.sent)), std::string::npos);
+    EXPECT_NE(json.find("\"failed\": " + std::to_string(report.sent) + ", \"rejected\": 0"), std::string::npos);
+    close(listen_fd);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
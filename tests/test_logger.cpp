@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include "logger.h"
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 收集日志行的输出目标，只保留格式化后的消息部分
+class CapturingSink {
+public:
+    CapturingSink() {
+        Logger::instance().setSink([this](LogLevel level, std::string_view line) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            levels_.push_back(level);
+            lines_.emplace_back(line);
+        });
+    }
+
+    ~CapturingSink() {
+        Logger::instance().setSink(nullptr);
+    }
+
+    std::vector<std::string> messages() {
+        Logger::instance().flush();
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::string> result;
+        for (const auto& line : lines_) {
+            // 去掉"时间 [级别] [T线程] "前缀和换行符
+            size_t pos = line.find("] [T");
+            pos = line.find("] ", pos + 1);
+            result.push_back(line.substr(pos + 2, line.size() - pos - 3));
+        }
+        return result;
+    }
+
+    std::vector<std::string> lines() {
+        Logger::instance().flush();
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lines_;
+    }
+
+    std::vector<LogLevel> levels() {
+        Logger::instance().flush();
+        std::lock_guard<std::mutex> lock(mutex_);
+        return levels_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::string> lines_;
+    std::vector<LogLevel> levels_;
+};
+
+}  // namespace
+
+// 测试各类参数的编码与格式化
+TEST(LoggerTest, FormatsArguments) {
+    CapturingSink sink;
+    std::string str = "字符串";
+    std::string_view view = "视图";
+    const char* null_str = nullptr;
+    LOG_INFO("整数 {} {} {}", -42, 7u, uint64_t(1) << 40);
+    LOG_INFO("浮点 {} 布尔 {} 字符 {}", 1.5, true, 'x');
+    LOG_INFO("字符串 {} {} {} {}", str, view, "字面量", null_str);
+    LOG_INFO("占位符多于参数 {} {}", 1);
+    LOG_INFO("参数多于占位符", 1, "two");
+
+    std::vector<std::string> messages = sink.messages();
+    ASSERT_EQ(messages.size(), 5u);
+    EXPECT_EQ(messages[0], "整数 -42 7 1099511627776");
+    EXPECT_EQ(messages[1], "浮点 1.5 布尔 true 字符 x");
+    EXPECT_EQ(messages[2], "字符串 字符串 视图 字面量 (null)");
+    EXPECT_EQ(messages[3], "占位符多于参数 1 {}");
+    EXPECT_EQ(messages[4], "参数多于占位符 1 two");
+}
+
+// 测试参数在写日志时被拷贝，之后修改原值不影响输出
+TEST(LoggerTest, ArgumentsCapturedAtCallSite) {
+    CapturingSink sink;
+    std::string value = "原始值";
+    LOG_INFO("值: {}", value);
+    value = "修改后";
+
+    std::vector<std::string> messages = sink.messages();
+    ASSERT_EQ(messages.size(), 1u);
+    EXPECT_EQ(messages[0], "值: 原始值");
+}
+
+// 测试输出行包含级别，WARN和ERROR按级别区分
+TEST(LoggerTest, LevelsInOutput) {
+    CapturingSink sink;
+    LOG_INFO("信息");
+    LOG_WARN("警告");
+    LOG_ERROR("错误");
+
+    std::vector<std::string> lines = sink.lines();
+    std::vector<LogLevel> levels = sink.levels();
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_NE(lines[0].find("[INFO]"), std::string::npos);
+    EXPECT_NE(lines[1].find("[WARN]"), std::string::npos);
+    EXPECT_NE(lines[2].find("[ERROR]"), std::string::npos);
+    EXPECT_EQ(levels[2], LogLevel::Error);
+}
+
+// 测试低于编译期级别的日志不输出，参数也不求值
+TEST(LoggerTest, CompileTimeFiltering) {
+    if (kCompiledLogLevel == LogLevel::Debug) {
+        GTEST_SKIP() << "以DEBUG级别编译";
+    }
+    CapturingSink sink;
+    int evaluated = 0;
+    LOG_DEBUG("调试 {}", ++evaluated);
+    EXPECT_EQ(evaluated, 0);
+    EXPECT_TRUE(sink.messages().empty());
+}
+
+// 测试多线程并发写日志：不丢失、同一线程内保持顺序，已退出线程的日志仍会输出
+TEST(LoggerTest, ConcurrentThreadsKeepPerThreadOrder) {
+    CapturingSink sink;
+    const int THREAD_COUNT = 8;
+    const int MESSAGE_COUNT = 2000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREAD_COUNT; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < MESSAGE_COUNT; ++i) {
+                LOG_INFO("{} {}", t, i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<std::string> messages = sink.messages();
+    ASSERT_EQ(messages.size() + Logger::instance().droppedCount(),
+              size_t(THREAD_COUNT * MESSAGE_COUNT));
+    std::vector<int> next(THREAD_COUNT, 0);
+    for (const auto& message : messages) {
+        int t = std::stoi(message.substr(0, message.find(' ')));
+        int i = std::stoi(message.substr(message.find(' ') + 1));
+        EXPECT_GT(i + 1, next[t]);
+        next[t] = i + 1;
+    }
+}
+
+// 测试环满时丢弃日志并计数，而不是阻塞写日志的线程
+TEST(LoggerTest, DropsWhenRingFull) {
+    CapturingSink sink;
+    Logger::instance().setRingCapacity(1024);
+    uint64_t dropped_before = Logger::instance().droppedCount();
+    std::thread writer([] {
+        std::string payload(100, 'x');
+        for (int i = 0; i < 1000; ++i) {
+            LOG_INFO("{}", payload);
+        }
+    });
+    writer.join();
+    Logger::instance().setRingCapacity(256 * 1024);
+
+    std::vector<std::string> messages = sink.messages();
+    uint64_t dropped = Logger::instance().droppedCount() - dropped_before;
+    EXPECT_GT(dropped, 0u);
+    size_t written = 0;
+    for (const auto& message : messages) {
+        if (message == std::string(100, 'x')) ++written;
+    }
+    EXPECT_EQ(written + dropped, 1000u);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,236 @@
+#include <gtest/gtest.h>
+#include "metrics.h"
+#include "metrics_server.h"
+#include "client_pool.h"
+#include "tcp_client.h"
+#include "tcp_server.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 轮询等待条件成立，超时返回false
+template <typename F>
+bool waitUntil(F&& condition, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// 在已连接的socket上发送请求并读到对端关闭
+std::string httpGet(int fd, const std::string& path) {
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) < 0) return std::string();
+    std::string response;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, n);
+    }
+    close(fd);
+    return response;
+}
+
+std::string httpGetTcp(int port, const std::string& path) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return std::string();
+    }
+    return httpGet(fd, path);
+}
+
+std::string httpGetUnix(const std::string& socket_path, const std::string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socket_path.c_str());
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return std::string();
+    }
+    return httpGet(fd, path);
+}
+
+}  // namespace
+
+// 测试多个线程并发累加计数器，线程退出后其计数仍保留
+TEST(MetricsTest, CounterAcrossThreads) {
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    Counter counter = registry.counter("test_counter_threads_total", "测试计数器");
+    ASSERT_TRUE(counter.valid());
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([counter] {
+            for (int i = 0; i < 10000; ++i) counter.inc();
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(registry.value(counter), 80000u);
+
+    counter.inc(5);
+    EXPECT_EQ(registry.value(counter), 80005u);
+
+    // 重复注册返回同一个指标
+    Counter again = registry.counter("test_counter_threads_total", "测试计数器");
+    again.inc();
+    EXPECT_EQ(registry.value(counter), 80006u);
+
+    // 类型冲突时返回未注册的句柄，操作没有效果
+    Gauge conflict = registry.gauge("test_counter_threads_total", "类型冲突");
+    EXPECT_FALSE(conflict.valid());
+    conflict.inc();
+    EXPECT_EQ(registry.value(counter), 80006u);
+}
+
+// 测试仪表在一个线程上增加、在另一个线程上减少
+TEST(MetricsTest, GaugeAcrossThreads) {
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    Gauge gauge = registry.gauge("test_gauge_depth", "测试仪表");
+
+    std::thread producer([gauge] { gauge.add(100); });
+    producer.join();
+    std::thread consumer([gauge] { gauge.sub(30); });
+    consumer.join();
+    EXPECT_EQ(registry.value(gauge), 70);
+
+    gauge.sub(100);
+    EXPECT_EQ(registry.value(gauge), -30);
+    gauge.add(30);
+    EXPECT_EQ(registry.value(gauge), 0);
+}
+
+// 测试直方图按2的幂分桶并累计总和
+TEST(MetricsTest, HistogramBuckets) {
+    EXPECT_EQ(metricsdetail::histogramBucket(0), 0u);
+    EXPECT_EQ(metricsdetail::histogramBucket(1), 0u);
+    EXPECT_EQ(metricsdetail::histogramBucket(2), 1u);
+    EXPECT_EQ(metricsdetail::histogramBucket(3), 2u);
+    EXPECT_EQ(metricsdetail::histogramBucket(4), 2u);
+    EXPECT_EQ(metricsdetail::histogramBucket(1000), 10u);
+    EXPECT_EQ(metricsdetail::histogramBucket(UINT64_MAX), kHistogramBuckets - 1);
+
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    Histogram histogram = registry.histogram("test_histogram_us", "测试直方图");
+    histogram.record(1);
+    histogram.record(3);
+    histogram.record(1000);
+    std::thread other([histogram] { histogram.record(1000); });
+    other.join();
+
+    HistogramSnapshot snapshot = registry.snapshot(histogram);
+    EXPECT_EQ(snapshot.count, 4u);
+    EXPECT_EQ(snapshot.sum, 2004u);
+    EXPECT_EQ(snapshot.buckets[0], 1u);
+    EXPECT_EQ(snapshot.buckets[2], 1u);
+    EXPECT_EQ(snapshot.buckets[10], 2u);
+}
+
+// 测试Prometheus文本格式：同名指标只输出一次HELP和TYPE，直方图的桶是累计的
+TEST(MetricsTest, PrometheusText) {
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    registry.counter("test_format_total", "按结果计数", "result=\"ok\"").inc(3);
+    registry.counter("test_format_total", "按结果计数", "result=\"error\"").inc();
+    Histogram histogram = registry.histogram("test_format_us", "格式测试");
+    histogram.record(2);
+    histogram.record(2);
+    histogram.record(5);
+
+    std::string text = registry.prometheusText();
+    EXPECT_NE(text.find("# HELP test_format_total 按结果计数\n# TYPE test_format_total counter\n"
+                        "test_format_total{result=\"ok\"} 3\ntest_format_total{result=\"error\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_format_us histogram\n"), std::string::npos);
+    EXPECT_NE(text.find("test_format_us_bucket{le=\"1\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("test_format_us_bucket{le=\"2\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("test_format_us_bucket{le=\"8\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("test_format_us_bucket{le=\"+Inf\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("test_format_us_sum 9\n"), std::string::npos);
+    EXPECT_NE(text.find("test_format_us_count 3\n"), std::string::npos);
+}
+
+// 测试指标端点在TCP端口和Unix域socket上返回Prometheus文本，其他路径返回404
+TEST(MetricsTest, MetricsServer) {
+    MetricsRegistry::instance().counter("test_endpoint_total", "端点测试").inc(7);
+
+    MetricsServer tcp_server;
+    ASSERT_TRUE(tcp_server.listenTcp(0));
+    ASSERT_GT(tcp_server.port(), 0);
+    std::string response = httpGetTcp(tcp_server.port(), "/metrics");
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(response.find("test_endpoint_total 7\n"), std::string::npos);
+    EXPECT_EQ(httpGetTcp(tcp_server.port(), "/other").rfind("HTTP/1.1 404", 0), 0u);
+    tcp_server.stop();
+
+    std::string path = "/tmp/tcp_metrics_test_" + std::to_string(getpid()) + ".sock";
+    MetricsServer unix_server;
+    ASSERT_TRUE(unix_server.listenUnix(path));
+    response = httpGetUnix(path, "/metrics");
+    EXPECT_NE(response.find("test_endpoint_total 7\n"), std::string::npos);
+    unix_server.stop();
+    EXPECT_NE(access(path.c_str(), F_OK), 0);
+}
+
+// 测试客户端和服务器的数据路径指标随收发增长
+TEST(MetricsTest, ClientServerCounters) {
+    ServerConfig config;
+    config.port = 0;
+    TcpServer server(config);
+    ASSERT_TRUE(server.start());
+    ClientPool pool(1);
+    TcpClient client(pool, "127.0.0.1", server.port());
+    client.start();
+    ASSERT_TRUE(client.isConnected());
+
+    // 客户端和服务器已注册各自的指标，这里取得同一批句柄
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    Counter client_sent = registry.counter("tcp_client_messages_sent_total", "");
+    Counter client_frames = registry.counter("tcp_client_frames_received_total", "");
+    Counter server_frames = registry.counter("tcp_server_frames_received_total", "");
+    Gauge server_active = registry.gauge("tcp_server_active_connections", "");
+    Histogram call_latency = registry.histogram("tcp_client_call_latency_us", "");
+    EXPECT_GE(registry.value(registry.counter("tcp_client_connects_total", "")), 1u);
+    ASSERT_TRUE(waitUntil([&] { return registry.value(server_active) == 1; }, std::chrono::seconds(5)));
+    EXPECT_GE(registry.value(registry.counter("tcp_server_connections_accepted_total", "")), 1u);
+
+    uint64_t sent_before = registry.value(client_sent);
+    uint64_t frames_before = registry.value(client_frames);
+    uint64_t server_frames_before = registry.value(server_frames);
+    uint64_t calls_before = registry.snapshot(call_latency).count;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(client.call("ping").get().ok());
+    }
+    EXPECT_EQ(registry.value(client_sent) - sent_before, 10u);
+    EXPECT_EQ(registry.value(client_frames) - frames_before, 10u);
+    EXPECT_EQ(registry.value(server_frames) - server_frames_before, 10u);
+    EXPECT_EQ(registry.snapshot(call_latency).count - calls_before, 10u);
+
+    client.stop();
+    EXPECT_TRUE(waitUntil([&] { return registry.value(server_active) == 0; }, std::chrono::seconds(5)));
+    server.stop();
+
+    std::string text = registry.prometheusText();
+    EXPECT_NE(text.find("# HELP tcp_client_send_latency_us "), std::string::npos);
+    EXPECT_NE(text.find("tcp_server_connections_rejected_total{reason=\"max_connections\"} 0\n"),
+              std::string::npos);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,274 @@
+#include <gtest/gtest.h>
+#include "multi_server_client.h"
+#include "client_pool.h"
+#include "tcp_server.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 回显负载的服务器，每个请求先等待delay再回复
+std::unique_ptr<TcpServer> startEchoServer(std::chrono::milliseconds delay, std::atomic<int>& handled) {
+    ServerConfig config;
+    config.port = 0;
+    auto server = std::make_unique<TcpServer>(config);
+    server->setMessageHandler([delay, &handled](const FrameHeader&, std::string_view payload, ByteBuffer& response) {
+        handled++;
+        if (delay.count() > 0) std::this_thread::sleep_for(delay);
+        response.append(payload);
+        return true;
+    });
+    return server->start() ? std::move(server) : nullptr;
+}
+
+// 返回一个当前没有监听的本地端口
+int unusedPort() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    getsockname(fd, (struct sockaddr*)&addr, &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+// 轮询等待条件成立，超时返回false
+template <typename F>
+bool waitUntil(F&& condition, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+}  // namespace
+
+// 测试延迟均值：变慢立即反映，变快按时间平滑，空闲时逐渐衰减
+TEST(MultiServerClientTest, PeakEwma) {
+    LatencyEwma ewma(1000);
+    EXPECT_EQ(ewma.valueUs(0), 0u);
+    ewma.record(1000, 0);
+    EXPECT_EQ(ewma.valueUs(0), 1000u);
+
+    // 紧接着的快样本几乎不改变均值
+    ewma.record(100, 0);
+    EXPECT_EQ(ewma.valueUs(0), 1000u);
+
+    // 间隔一个时间常数后权重为e^-1
+    ewma.record(100, 1000);
+    EXPECT_NEAR(static_cast<double>(ewma.valueUs(1000)), 100 + 900 * std::exp(-1.0), 2);
+
+    // 慢样本直接取为当前值
+    ewma.record(5000, 1100);
+    EXPECT_EQ(ewma.valueUs(1100), 5000u);
+    EXPECT_LT(ewma.valueUs(3100), 1000u);
+}
+
+// 测试请求主要流向快的服务器，慢服务器只分到少量请求
+TEST(MultiServerClientTest, PrefersFastServers) {
+    std::atomic<int> handled[3] = {{0}, {0}, {0}};
+    auto fast1 = startEchoServer(std::chrono::milliseconds(0), handled[0]);
+    auto fast2 = startEchoServer(std::chrono::milliseconds(0), handled[1]);
+    auto slow = startEchoServer(std::chrono::milliseconds(20), handled[2]);
+    ASSERT_TRUE(fast1 && fast2 && slow);
+
+    ClientPool pool(2);
+    MultiServerClient client(pool, {"127.0.0.1", "127.0.0.1", "localhost"},
+                             {fast1->port(), fast2->port(), slow->port()});
+    client.start();
+    ASSERT_TRUE(waitUntil([&] { return client.connectedCount() == 3; }, std::chrono::seconds(5)));
+
+    constexpr int kCalls = 300;
+    for (int i = 0; i < kCalls; ++i) {
+        CallResult result = client.call("请求" + std::to_string(i)).get();
+        ASSERT_TRUE(result.ok());
+        EXPECT_EQ(result.payload, "请求" + std::to_string(i));
+    }
+
+    int total = handled[0] + handled[1] + handled[2];
+    EXPECT_EQ(total, kCalls);
+    EXPECT_GT(handled[0].load(), 0);
+    EXPECT_GT(handled[1].load(), 0);
+    EXPECT_LT(handled[2].load(), total / 10);
+
+    std::vector<ServerStats> stats = client.stats();
+    ASSERT_EQ(stats.size(), 3u);
+    EXPECT_EQ(stats[2].server, "localhost:" + std::to_string(slow->port()));
+    EXPECT_GT(stats[2].latency_us, stats[0].latency_us);
+    EXPECT_EQ(stats[0].requests + stats[1].requests + stats[2].requests, static_cast<uint64_t>(total));
+    client.stop();
+}
+
+// 测试不可用的服务器不参与选择，恢复后重新加入
+TEST(MultiServerClientTest, SkipsUnavailableServers) {
+    std::atomic<int> handled(0);
+    auto server = startEchoServer(std::chrono::milliseconds(0), handled);
+    ASSERT_NE(server, nullptr);
+    int down_port = unusedPort();
+
+    ClientPool pool(1);
+    MultiServerClient client(pool, {"127.0.0.1", "127.0.0.1", "127.0.0.1"}, {down_port, server->port()});
+    EXPECT_EQ(client.serverCount(), 2u);
+    ReconnectConfig reconnect;
+    reconnect.initial_backoff_ms = 20;
+    reconnect.max_backoff_ms = 50;
+    client.setReconnectConfig(reconnect);
+
+    std::atomic<int> up(0);
+    client.setConnectionCallback([&up](const std::string&, bool connected) {
+        up.fetch_add(connected ? 1 : -1);
+    });
+    EXPECT_FALSE(client.sendAsync("未启动", SendCallback()));
+    client.start();
+    EXPECT_EQ(client.connectedCount(), 1u);
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_TRUE(client.call("调用").get().ok());
+    }
+    EXPECT_TRUE(client.send("单向"));
+    // 连接回调在回调线程上异步执行
+    EXPECT_TRUE(waitUntil([&] { return up.load() == 1; }, std::chrono::seconds(5)));
+
+    // 原先不可用的服务器启动后自动连上
+    ServerConfig config;
+    config.port = down_port;
+    TcpServer recovered(config);
+    ASSERT_TRUE(recovered.start());
+    EXPECT_TRUE(waitUntil([&] { return client.connectedCount() == 2; }, std::chrono::seconds(5)));
+    EXPECT_TRUE(waitUntil([&] { return up.load() == 2; }, std::chrono::seconds(5)));
+    client.stop();
+    EXPECT_EQ(up.load(), 0);
+    EXPECT_EQ(client.call("停止后").get().status, CallStatus::Rejected);
+}
+
+// 测试每个服务器保持多条连接，不指定键的调用分散到各条连接，断开后在后台补齐
+TEST(MultiServerClientTest, PoolsConnectionsPerServer) {
+    std::atomic<int> handled(0);
+    auto server = startEchoServer(std::chrono::milliseconds(0), handled);
+    ASSERT_NE(server, nullptr);
+    int port = server->port();
+
+    ClientPool pool(2);
+    BalancerConfig balancer;
+    balancer.connections_per_server = 4;
+    MultiServerClient client(pool, {"127.0.0.1"}, {port}, balancer);
+    ReconnectConfig reconnect;
+    reconnect.initial_backoff_ms = 20;
+    reconnect.max_backoff_ms = 50;
+    client.setReconnectConfig(reconnect);
+
+    std::atomic<int> up(0);
+    client.setConnectionCallback([&up](const std::string&, bool connected) {
+        up.fetch_add(connected ? 1 : -1);
+    });
+    client.start();
+    ASSERT_TRUE(waitUntil([&] { return client.connectionCount() == 4; }, std::chrono::seconds(5)));
+    EXPECT_TRUE(waitUntil([&] { return server->admissionStats().active_connections == 4; },
+                          std::chrono::seconds(5)));
+    // 服务器级别的回调只在第一条连接建立时触发一次
+    EXPECT_TRUE(waitUntil([&] { return up.load() == 1; }, std::chrono::seconds(5)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(up.load(), 1);
+    EXPECT_EQ(client.connectedCount(), 1u);
+
+    std::vector<std::future<CallResult>> futures;
+    for (int i = 0; i < 200; ++i) {
+        futures.push_back(client.call("并发" + std::to_string(i)));
+    }
+    for (int i = 0; i < 200; ++i) {
+        CallResult result = futures[i].get();
+        ASSERT_TRUE(result.ok());
+        EXPECT_EQ(result.payload, "并发" + std::to_string(i));
+    }
+    std::vector<ServerStats> stats = client.stats();
+    ASSERT_EQ(stats.size(), 1u);
+    EXPECT_EQ(stats[0].connections, 4u);
+    EXPECT_EQ(stats[0].requests, 200u);
+    EXPECT_EQ(stats[0].outstanding, 0u);
+
+    // 服务器重启后，断开的连接全部在后台重新建立
+    server->stop();
+    EXPECT_TRUE(waitUntil([&] { return client.connectionCount() == 0; }, std::chrono::seconds(5)));
+    EXPECT_TRUE(waitUntil([&] { return up.load() == 0; }, std::chrono::seconds(5)));
+    ServerConfig config;
+    config.port = port;
+    TcpServer restarted(config);
+    ASSERT_TRUE(restarted.start());
+    EXPECT_TRUE(waitUntil([&] { return client.connectionCount() == 4; }, std::chrono::seconds(5)));
+    EXPECT_TRUE(waitUntil([&] { return up.load() == 1; }, std::chrono::seconds(5)));
+    EXPECT_TRUE(client.call("重连后").get().ok());
+    client.stop();
+}
+
+// 测试按键发送时同一个键的消息按发送顺序到达
+TEST(MultiServerClientTest, KeyedSendsPreserveOrder) {
+    // 单个处理线程按提交顺序执行，服务器看到的顺序即各连接上的到达顺序
+    ServerConfig config;
+    config.port = 0;
+    config.handler_threads = 1;
+    TcpServer server(config);
+    std::mutex mutex;
+    std::map<std::string, std::vector<int>> received;
+    std::atomic<int> count(0);
+    server.setMessageHandler([&](const FrameHeader&, std::string_view payload, ByteBuffer& response) {
+        size_t colon = payload.find(':');
+        if (colon == std::string_view::npos) {
+            response.append(payload);
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        received[std::string(payload.substr(0, colon))].push_back(std::stoi(std::string(payload.substr(colon + 1))));
+        count++;
+        return false;
+    });
+    ASSERT_TRUE(server.start());
+
+    ClientPool pool(2);
+    BalancerConfig balancer;
+    balancer.connections_per_server = 4;
+    MultiServerClient client(pool, {"127.0.0.1"}, {server.port()}, balancer);
+    client.start();
+    ASSERT_TRUE(waitUntil([&] { return client.connectionCount() == 4; }, std::chrono::seconds(5)));
+
+    constexpr int kKeys = 8;
+    constexpr int kPerKey = 200;
+    for (int i = 0; i < kPerKey; ++i) {
+        for (int k = 0; k < kKeys; ++k) {
+            std::string key = "键" + std::to_string(k);
+            ASSERT_TRUE(client.sendByKey(key, key + ":" + std::to_string(i), SendCallback()));
+        }
+    }
+    ASSERT_TRUE(waitUntil([&] { return count.load() == kKeys * kPerKey; }, std::chrono::seconds(5)));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(received.size(), static_cast<size_t>(kKeys));
+    for (const auto& entry : received) {
+        ASSERT_EQ(entry.second.size(), static_cast<size_t>(kPerKey)) << entry.first;
+        for (int i = 0; i < kPerKey; ++i) {
+            EXPECT_EQ(entry.second[i], i) << entry.first;
+        }
+    }
+    EXPECT_EQ(client.callByKey("键0", "调用").get().status, CallStatus::Ok);
+    client.stop();
+    EXPECT_FALSE(client.sendByKey("键0", "停止后", SendCallback()));
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,533 @@
+#include <gtest/gtest.h>
+#include "output_queue.h"
+#include "frame.h"
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 建立一对回环TCP连接，返回发送端和接收端
+bool makeTcpPair(int& sender, int& receiver) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(listen_fd, 1) < 0 ||
+        getsockname(listen_fd, (struct sockaddr*)&addr, &len) < 0) {
+        close(listen_fd);
+        return false;
+    }
+
+    sender = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(sender, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(sender);
+        close(listen_fd);
+        return false;
+    }
+    receiver = accept(listen_fd, nullptr, nullptr);
+    close(listen_fd);
+
+    struct timeval tv{1, 0};
+    setsockopt(receiver, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return receiver >= 0;
+}
+
+// 接收指定长度的数据，超时或断开时返回已收到的部分
+std::string recvExactly(int fd, size_t len) {
+    std::string result;
+    char buffer[16 * 1024];
+    while (result.size() < len) {
+        ssize_t n = recv(fd, buffer, std::min(sizeof(buffer), len - result.size()), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        result.append(buffer, n);
+    }
+    return result;
+}
+
+ByteBuffer makeBuffer(const std::string& data) {
+    ByteBuffer buffer;
+    buffer.append(data);
+    return buffer;
+}
+
+// 读取socket当前的TCP_CORK设置
+int corkValue(int fd) {
+    int value = -1;
+    socklen_t len = sizeof(value);
+    getsockopt(fd, IPPROTO_TCP, TCP_CORK, &value, &len);
+    return value;
+}
+
+}  // namespace
+
+// 测试拷贝追加的小块数据合并到同一个iovec
+TEST(OutputQueueTest, CoalescesSmallAppends) {
+    OutputQueue queue;
+    for (uint32_t i = 0; i < 10; ++i) {
+        queue.appendFrame(FrameType::Response, i, "响应");
+    }
+    EXPECT_EQ(queue.pendingBytes(), 10 * (kFrameHeaderSize + strlen("响应")));
+
+    struct iovec iov[8];
+    ASSERT_EQ(queue.gather(iov, 8, SIZE_MAX), 1);
+    EXPECT_EQ(iov[0].iov_len, queue.pendingBytes());
+}
+
+// 测试接管所有权的数据块不拷贝，作为独立的iovec
+TEST(OutputQueueTest, OwnedPayloadsStaySeparate) {
+    OutputQueue queue;
+    ByteBuffer payload = makeBuffer(std::string(1000, 'p'));
+    const char* payload_data = payload.readPtr();
+    queue.appendFrame(FrameType::Message, 1, std::move(payload));
+    queue.append("尾部");
+
+    struct iovec iov[8];
+    ASSERT_EQ(queue.gather(iov, 8, SIZE_MAX), 3);
+    EXPECT_EQ(iov[0].iov_len, kFrameHeaderSize);
+    EXPECT_EQ(iov[1].iov_base, payload_data);
+    EXPECT_EQ(iov[1].iov_len, 1000u);
+    EXPECT_EQ(iov[2].iov_len, strlen("尾部"));
+}
+
+// 测试gather遵守iovec数和字节数上限，advance按顺序确认部分发送
+TEST(OutputQueueTest, GatherRespectsLimitsAndAdvanceKeepsOrder) {
+    OutputQueue queue;
+    std::string expected;
+    for (int i = 0; i < 4; ++i) {
+        std::string chunk(100, static_cast<char>('a' + i));
+        queue.append(makeBuffer(chunk));
+        expected += chunk;
+    }
+
+    struct iovec iov[8];
+    EXPECT_EQ(queue.gather(iov, 2, SIZE_MAX), 2);
+    ASSERT_EQ(queue.gather(iov, 8, 250), 3);
+    EXPECT_EQ(iov[2].iov_len, 50u);
+
+    std::string sent;
+    while (!queue.empty()) {
+        int count = queue.gather(iov, 8, 70);
+        ASSERT_GT(count, 0);
+        // 每次只确认一部分，模拟短写
+        size_t n = std::min<size_t>(iov[0].iov_len, 30);
+        sent.append(static_cast<const char*>(iov[0].iov_base), n);
+        queue.advance(n);
+    }
+    EXPECT_EQ(sent, expected);
+}
+
+// 测试队列始终有积压时：已发送的队首条目被回收，回收前交出的数据块指针仍然有效且顺序不变
+TEST(OutputQueueTest, StandingBacklogKeepsOrder) {
+    OutputQueue queue;
+    std::string expected;
+    std::string sent;
+    struct iovec iov[4];
+    for (int i = 0; i < 1000; ++i) {
+        std::string chunk(10 + i % 7, static_cast<char>('a' + i % 26));
+        queue.append(makeBuffer(chunk));
+        expected += chunk;
+        if (i < 3) continue;
+        ASSERT_EQ(queue.gather(iov, 4, SIZE_MAX), 4);
+        sent.append(static_cast<const char*>(iov[0].iov_base), iov[0].iov_len);
+        queue.advance(iov[0].iov_len);
+        // 出队可能触发回收，之前gather交出的其余数据块不受影响
+        ASSERT_EQ(std::string(static_cast<const char*>(iov[1].iov_base), iov[1].iov_len),
+                  expected.substr(sent.size(), iov[1].iov_len));
+    }
+    while (!queue.empty()) {
+        ASSERT_GT(queue.gather(iov, 4, SIZE_MAX), 0);
+        sent.append(static_cast<const char*>(iov[0].iov_base), iov[0].iov_len);
+        queue.advance(iov[0].iov_len);
+    }
+    EXPECT_EQ(sent, expected);
+}
+
+// 测试flush通过TCP连接发送后帧完整且有序
+TEST(OutputQueueTest, FlushRoundTripsFrames) {
+    int sender, receiver;
+    ASSERT_TRUE(makeTcpPair(sender, receiver));
+
+    OutputConfig config;
+    config.max_batch_iovecs = 4;
+    config.max_batch_bytes = 8 * 1024;
+    OutputQueue queue(config);
+
+    std::vector<std::string> payloads;
+    size_t total = 0;
+    for (uint32_t i = 0; i < 50; ++i) {
+        std::string payload(i * 100, static_cast<char>('a' + i % 26));
+        if (i % 3 == 0) {
+            queue.appendFrame(FrameType::Message, i, makeBuffer(payload));
+        } else {
+            queue.appendFrame(FrameType::Message, i, payload);
+        }
+        total += kFrameHeaderSize + payload.size();
+        payloads.push_back(payload);
+    }
+    EXPECT_EQ(queue.flush(sender), OutputQueue::FlushResult::Done);
+    EXPECT_TRUE(queue.empty());
+
+    std::string received = recvExactly(receiver, total);
+    ASSERT_EQ(received.size(), total);
+    FrameDecoder decoder;
+    uint32_t next = 0;
+    bool ok = decoder.feed(received.data(), received.size(),
+                           [&](const FrameHeader& header, std::string_view payload) {
+        EXPECT_EQ(header.sequence, next);
+        EXPECT_EQ(payload, payloads[next]);
+        ++next;
+    });
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(next, payloads.size());
+
+    close(sender);
+    close(receiver);
+}
+
+// 测试发送缓冲区满时返回WouldBlock，数据留在队列中稍后继续发送
+TEST(OutputQueueTest, FlushStopsWhenSocketFull) {
+    int sender, receiver;
+    ASSERT_TRUE(makeTcpPair(sender, receiver));
+    fcntl(sender, F_SETFL, fcntl(sender, F_GETFL, 0) | O_NONBLOCK);
+
+    OutputQueue queue;
+    const std::string chunk(64 * 1024, 'w');
+    size_t total = 0;
+    while (queue.flush(sender) == OutputQueue::FlushResult::Done) {
+        queue.append(chunk);
+        total += chunk.size();
+        ASSERT_LT(total, 256u * 1024 * 1024);
+    }
+    EXPECT_FALSE(queue.empty());
+
+    // 接收端读出所有数据后，队列中剩余部分可以发完
+    std::string received;
+    char buffer[64 * 1024];
+    while (received.size() < total) {
+        if (!queue.empty()) queue.flush(sender);
+        ssize_t n = recv(receiver, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        ASSERT_GT(n, 0);
+        received.append(buffer, n);
+    }
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(received, std::string(total, 'w'));
+
+    close(sender);
+    close(receiver);
+}
+
+// 测试大块数据以MSG_ZEROCOPY发送：数据完整，完成通知到达后释放内存
+TEST(OutputQueueTest, ZerocopyLargePayload) {
+    int sender, receiver;
+    ASSERT_TRUE(makeTcpPair(sender, receiver));
+    if (!enableZerocopy(sender)) {
+        close(sender);
+        close(receiver);
+        GTEST_SKIP() << "内核不支持SO_ZEROCOPY";
+    }
+
+    OutputConfig config;
+    config.zerocopy_threshold = 16 * 1024;
+    OutputQueue queue(config);
+
+    std::string large(256 * 1024, 'z');
+    queue.appendFrame(FrameType::Message, 1, makeBuffer(large));
+    queue.appendFrame(FrameType::Message, 2, "小帧");
+
+    std::string received;
+    size_t total = 2 * kFrameHeaderSize + large.size() + strlen("小帧");
+    while (received.size() < total) {
+        ASSERT_NE(queue.flush(sender), OutputQueue::FlushResult::Error);
+        received += recvExactly(receiver, std::min<size_t>(total - received.size(), 64 * 1024));
+    }
+    EXPECT_TRUE(queue.empty());
+    EXPECT_GE(queue.zerocopyTracker().sendCount(), 1u);
+
+    // 完成通知通过错误队列异步到达
+    for (int i = 0; i < 100 && queue.zerocopyPending(); ++i) {
+        struct pollfd pfd{sender, 0, 0};
+        poll(&pfd, 1, 10);
+        ASSERT_TRUE(queue.reapZerocopy(sender));
+    }
+    EXPECT_FALSE(queue.zerocopyPending());
+    EXPECT_TRUE(queue.zerocopyTracker().idle());
+
+    FrameDecoder decoder;
+    int frames = 0;
+    decoder.feed(received.data(), received.size(),
+                 [&](const FrameHeader& header, std::string_view payload) {
+        EXPECT_EQ(payload, header.sequence == 1 ? std::string_view(large) : std::string_view("小帧"));
+        ++frames;
+    });
+    EXPECT_EQ(frames, 2);
+
+    close(sender);
+    close(receiver);
+}
+
+// 测试零拷贝数据块只发出一部分、剩余部分低于阈值改为普通发送：整块出队后仍等待完成通知，
+// 关闭时未完成的数据块由后台保留到通知到达，对端收到完整数据后才看到连接关闭
+TEST(OutputQueueTest, PartialZerocopyWaitsForCompletion) {
+    int sender, receiver;
+    ASSERT_TRUE(makeTcpPair(sender, receiver));
+    if (!enableZerocopy(sender)) {
+        close(sender);
+        close(receiver);
+        GTEST_SKIP() << "内核不支持SO_ZEROCOPY";
+    }
+    int sndbuf = 64 * 1024;
+    setsockopt(sender, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    fcntl(sender, F_SETFL, fcntl(sender, F_GETFL, 0) | O_NONBLOCK);
+
+    OutputConfig config;
+    config.zerocopy_threshold = 600 * 1024;
+    OutputQueue queue(config);
+    std::string large(1024 * 1024, 'p');
+    queue.append(makeBuffer(large));
+
+    std::string received;
+    char buffer[64 * 1024];
+    while (!queue.empty()) {
+        ASSERT_NE(queue.flush(sender), OutputQueue::FlushResult::Error);
+        ssize_t n = recv(receiver, buffer, sizeof(buffer), 0);
+        ASSERT_GT(n, 0);
+        received.append(buffer, n);
+    }
+    EXPECT_GE(queue.zerocopyTracker().sendCount(), 1u);
+    // 没有读取过完成通知，整块数据仍被保留
+    EXPECT_TRUE(queue.zerocopyPending());
+
+    queue.closeSocket(sender);
+    EXPECT_FALSE(queue.zerocopyPending());
+    ssize_t n;
+    while ((n = recv(receiver, buffer, sizeof(buffer), 0)) > 0) {
+        received.append(buffer, n);
+    }
+    EXPECT_EQ(n, 0);
+    EXPECT_EQ(received, large);
+    close(receiver);
+}
+
+// 测试零拷贝数据块只发出一部分就因socket缓冲区满而停在队首时关闭连接：数据块同样交给后台
+// 保留到完成通知到达，队列销毁后缓冲区池不会把它交给别人改写，对端收到的数据不被破坏
+TEST(OutputQueueTest, CloseWithPartialZerocopyFront) {
+    int sender, receiver;
+    ASSERT_TRUE(makeTcpPair(sender, receiver));
+    if (!enableZerocopy(sender)) {
+        close(sender);
+        close(receiver);
+        GTEST_SKIP() << "内核不支持SO_ZEROCOPY";
+    }
+    int sndbuf = 32 * 1024;
+    setsockopt(sender, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    fcntl(sender, F_SETFL, fcntl(sender, F_GETFL, 0) | O_NONBLOCK);
+
+    const size_t size = 512 * 1024;
+    {
+        OutputConfig config;
+        config.zerocopy_threshold = 16 * 1024;
+        OutputQueue queue(config);
+        queue.append(makeBuffer(std::string(size, 'p')));
+        ASSERT_EQ(queue.flush(sender), OutputQueue::FlushResult::WouldBlock);
+        ASSERT_FALSE(queue.empty());
+        ASSERT_GE(queue.zerocopyTracker().sendCount(), 1u);
+        // 数据块仍在队首，但已有部分被内核引用
+        EXPECT_TRUE(queue.zerocopyPending());
+        queue.closeSocket(sender);
+    }
+    // 若数据块已回到缓冲区池，这些缓冲区会复用它并覆盖内核待发的数据。
+    // 回环设备在投递时就拷贝了零拷贝数据，这里只有经过真实网卡时才可能观察到破坏
+    std::vector<ByteBuffer> reused;
+    for (int i = 0; i < 8; ++i) {
+        reused.push_back(makeBuffer(std::string(size, 'X')));
+    }
+
+    std::string received;
+    char buffer[64 * 1024];
+    ssize_t n;
+    while ((n = recv(receiver, buffer, sizeof(buffer), 0)) > 0) {
+        received.append(buffer, n);
+    }
+    EXPECT_EQ(n, 0);
+    EXPECT_GT(received.size(), 0u);
+    EXPECT_LT(received.size(), size);
+    EXPECT_EQ(received.find_first_not_of('p'), std::string::npos);
+    close(receiver);
+}
+
+// 测试共享缓冲区、多段数据和文件区间混合排队：共享缓冲区不拷贝，文件区间以sendfile发送
+TEST(OutputQueueTest, SharedIovecAndFileSegments) {
+    int sender, receiver;
+    ASSERT_TRUE(makeTcpPair(sender, receiver));
+
+    char path[] = "/tmp/output_queue_testXXXXXX";
+    int file_fd = mkstemp(path);
+    ASSERT_GE(file_fd, 0);
+    unlink(path);
+    std::string content(100 * 1024, 'f');
+    for (size_t i = 0; i < content.size(); i += 997) content[i] = static_cast<char>('a' + i % 26);
+    ASSERT_EQ(write(file_fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+
+    OutputConfig config;
+    config.max_batch_bytes = 16 * 1024;
+    OutputQueue queue(config);
+    SharedBuffer shared(std::string_view("共享的负载"));
+    queue.appendFrame(FrameType::Message, 1, shared);
+    queue.appendFrame(FrameType::Message, 2, shared);
+    EXPECT_EQ(shared.useCount(), 3);
+
+    char head[] = "头部";
+    char body[] = "正文";
+    struct iovec parts[2] = {{head, strlen(head)}, {body, strlen(body)}};
+    queue.appendFrame(FrameType::Message, 3, parts, 2);
+    // 文件区间复制一个描述符交给队列
+    queue.appendFrameFile(FrameType::Message, 4, dup(file_fd), 1000, content.size() - 2000);
+    queue.appendFrame(FrameType::Message, 5, "尾部");
+
+    // gather在文件区间之前停下
+    struct iovec iov[16];
+    int count = queue.gather(iov, 16, SIZE_MAX);
+    size_t gathered = 0;
+    for (int i = 0; i < count; ++i) gathered += iov[i].iov_len;
+    EXPECT_EQ(gathered, 4 * kFrameHeaderSize + 2 * shared.size() + strlen("头部正文"));
+
+    size_t total = queue.pendingBytes();
+    std::string received;
+    while (received.size() < total) {
+        ASSERT_NE(queue.flush(sender), OutputQueue::FlushResult::Error);
+        received += recvExactly(receiver, std::min<size_t>(total - received.size(), 64 * 1024));
+    }
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(shared.useCount(), 1);
+
+    std::vector<std::string> payloads;
+    FrameDecoder decoder(4096, 1024 * 1024);
+    decoder.feed(received.data(), received.size(), [&](const FrameHeader& header, std::string_view payload) {
+        EXPECT_EQ(header.sequence, payloads.size() + 1);
+        payloads.emplace_back(payload);
+    });
+    ASSERT_EQ(payloads.size(), 5u);
+    EXPECT_EQ(payloads[0], "共享的负载");
+    EXPECT_EQ(payloads[1], "共享的负载");
+    EXPECT_EQ(payloads[2], "头部正文");
+    EXPECT_EQ(payloads[3], content.substr(1000, content.size() - 2000));
+    EXPECT_EQ(payloads[4], "尾部");
+
+    close(file_fd);
+    close(sender);
+    close(receiver);
+}
+
+// 测试三种写出策略的写出时机与TCP_CORK的开关
+TEST(OutputQueueTest, WritePolicies) {
+    int sender, receiver;
+    ASSERT_TRUE(makeTcpPair(sender, receiver));
+    ASSERT_TRUE(enableNoDelay(sender));
+
+    // 低延迟：有数据即写出，从不开启cork
+    OutputQueue latency;
+    EXPECT_FALSE(latency.writeDue());
+    latency.append("低延迟");
+    EXPECT_TRUE(latency.writeDue());
+    EXPECT_EQ(latency.flush(sender), OutputQueue::FlushResult::Done);
+    EXPECT_EQ(corkValue(sender), 0);
+    EXPECT_EQ(recvExactly(receiver, std::string("低延迟").size()), "低延迟");
+
+    // 吞吐：积累到coalesce_bytes才写出，排空后解除cork
+    OutputConfig config;
+    config.write_policy = WritePolicy::Throughput;
+    config.coalesce_bytes = 1024;
+    OutputQueue throughput(config);
+    EXPECT_TRUE(throughput.coalescing());
+    throughput.append(std::string(100, 't'));
+    EXPECT_FALSE(throughput.writeDue());
+    throughput.append(std::string(1000, 't'));
+    EXPECT_TRUE(throughput.writeDue());
+    EXPECT_EQ(throughput.flush(sender), OutputQueue::FlushResult::Done);
+    EXPECT_EQ(corkValue(sender), 0);
+    EXPECT_EQ(recvExactly(receiver, 1100), std::string(1100, 't'));
+
+    // 合并定时器到期时调用方直接flush，不足一个MSS的尾部也立即发出
+    throughput.append("尾部");
+    EXPECT_FALSE(throughput.writeDue());
+    EXPECT_EQ(throughput.flush(sender), OutputQueue::FlushResult::Done);
+    EXPECT_EQ(recvExactly(receiver, std::string("尾部").size()), "尾部");
+
+    // 自适应：积压达到阈值后转为合并，积压回落后回到低延迟
+    config.write_policy = WritePolicy::Adaptive;
+    config.adaptive_threshold_bytes = 4096;
+    OutputQueue adaptive(config);
+    adaptive.append(std::string(100, 'a'));
+    EXPECT_TRUE(adaptive.writeDue());
+    EXPECT_EQ(adaptive.flush(sender), OutputQueue::FlushResult::Done);
+    EXPECT_FALSE(adaptive.coalescing());
+    adaptive.append(std::string(8192, 'a'));
+    EXPECT_TRUE(adaptive.writeDue());
+    EXPECT_EQ(adaptive.flush(sender), OutputQueue::FlushResult::Done);
+    EXPECT_TRUE(adaptive.coalescing());
+    adaptive.append(std::string(100, 'a'));
+    EXPECT_FALSE(adaptive.writeDue());
+    EXPECT_EQ(adaptive.flush(sender), OutputQueue::FlushResult::Done);
+    EXPECT_FALSE(adaptive.coalescing());
+    EXPECT_EQ(recvExactly(receiver, 8392), std::string(8392, 'a'));
+
+    close(sender);
+    close(receiver);
+}
+
+// 测试合并写出时socket缓冲区满：保持cork，未写完的数据不再等待合并
+TEST(OutputQueueTest, CorkedWhileDraining) {
+    int sender, receiver;
+    ASSERT_TRUE(makeTcpPair(sender, receiver));
+    fcntl(sender, F_SETFL, fcntl(sender, F_GETFL, 0) | O_NONBLOCK);
+
+    OutputConfig config;
+    config.write_policy = WritePolicy::Throughput;
+    OutputQueue queue(config);
+    const std::string chunk(64 * 1024, 'c');
+    size_t total = 0;
+    while (queue.flush(sender) == OutputQueue::FlushResult::Done) {
+        queue.append(chunk);
+        total += chunk.size();
+        ASSERT_LT(total, 256u * 1024 * 1024);
+    }
+    EXPECT_EQ(corkValue(sender), 1);
+    EXPECT_TRUE(queue.writeDue());
+
+    std::string received;
+    char buffer[64 * 1024];
+    while (received.size() < total) {
+        if (!queue.empty()) queue.flush(sender);
+        ssize_t n = recv(receiver, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        ASSERT_GT(n, 0);
+        received.append(buffer, n);
+    }
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.writeDue());
+    EXPECT_EQ(corkValue(sender), 0);
+    EXPECT_EQ(received.size(), total);
+
+    close(sender);
+    close(receiver);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
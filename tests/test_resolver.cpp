@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include "resolver.h"
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 解析并等待结果
+std::vector<SocketAddress> resolveAndWait(Resolver& resolver, const std::string& host, int port) {
+    auto promise = std::make_shared<std::promise<std::vector<SocketAddress>>>();
+    std::future<std::vector<SocketAddress>> future = promise->get_future();
+    resolver.resolve(host, port, [promise](const std::vector<SocketAddress>& addresses) {
+        promise->set_value(addresses);
+    });
+    if (future.wait_for(std::chrono::seconds(5)) != std::future_status::ready) return {};
+    return future.get();
+}
+
+// 解析并返回回调是否在调用线程上同步执行
+bool resolvesInline(Resolver& resolver, const std::string& host, int port) {
+    bool called = false;
+    resolver.resolve(host, port, [&called](const std::vector<SocketAddress>&) { called = true; });
+    return called;
+}
+
+}  // namespace
+
+// 测试数字地址的解析与格式化
+TEST(ResolverTest, ParsesNumericAddresses) {
+    SocketAddress v4;
+    ASSERT_TRUE(SocketAddress::parse("127.0.0.1", 8080, v4));
+    EXPECT_EQ(v4.family(), AF_INET);
+    EXPECT_EQ(v4.port(), 8080);
+    EXPECT_EQ(v4.toString(), "127.0.0.1:8080");
+
+    SocketAddress v6;
+    ASSERT_TRUE(SocketAddress::parse("::1", 443, v6));
+    EXPECT_EQ(v6.family(), AF_INET6);
+    EXPECT_EQ(v6.toString(), "[::1]:443");
+    v6.setPort(80);
+    EXPECT_EQ(v6.port(), 80);
+
+    SocketAddress other;
+    EXPECT_FALSE(SocketAddress::parse("localhost", 80, other));
+    EXPECT_FALSE(SocketAddress::parse("1.2.3", 80, other));
+}
+
+// 测试数字地址不经过解析线程，直接同步回调
+TEST(ResolverTest, NumericAddressResolvesInline) {
+    Resolver resolver;
+    std::vector<SocketAddress> result;
+    resolver.resolve("10.0.0.1", 9000, [&result](const std::vector<SocketAddress>& addresses) {
+        result = addresses;
+    });
+    ASSERT_EQ(result.size(), 1u);
+    EXPECT_EQ(result[0].toString(), "10.0.0.1:9000");
+    EXPECT_EQ(resolver.lookupCount(), 0u);
+}
+
+// 测试域名解析结果在TTL内被缓存，过期后重新查询，并发查询合并
+TEST(ResolverTest, CachesUntilTtlExpires) {
+    ResolverConfig config;
+    config.ttl_ms = 300;
+    Resolver resolver(config);
+
+    std::vector<SocketAddress> addresses = resolveAndWait(resolver, "localhost", 1234);
+    ASSERT_FALSE(addresses.empty());
+    bool has_loopback = false;
+    for (const SocketAddress& address : addresses) {
+        EXPECT_EQ(address.port(), 1234);
+        if (address.toString() == "127.0.0.1:1234" || address.toString() == "[::1]:1234") has_loopback = true;
+    }
+    EXPECT_TRUE(has_loopback);
+    EXPECT_EQ(resolver.lookupCount(), 1u);
+
+    // 缓存命中时同步回调，端口按本次请求填写
+    EXPECT_TRUE(resolvesInline(resolver, "localhost", 80));
+    EXPECT_EQ(resolver.lookupCount(), 1u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    std::atomic<int> completed(0);
+    for (int i = 0; i < 10; ++i) {
+        resolver.resolve("localhost", 80, [&completed](const std::vector<SocketAddress>& result) {
+            if (!result.empty()) completed++;
+        });
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (completed.load() < 10 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(completed.load(), 10);
+    EXPECT_EQ(resolver.lookupCount(), 2u);
+
+    resolver.clear();
+    EXPECT_FALSE(resolveAndWait(resolver, "localhost", 80).empty());
+    EXPECT_EQ(resolver.lookupCount(), 3u);
+}
+
+// 测试解析失败的结果也被短暂缓存
+TEST(ResolverTest, FailuresAreNegativelyCached) {
+    Resolver resolver;
+    EXPECT_TRUE(resolveAndWait(resolver, "nonexistent.invalid", 80).empty());
+    EXPECT_EQ(resolver.lookupCount(), 1u);
+    EXPECT_TRUE(resolvesInline(resolver, "nonexistent.invalid", 80));
+    EXPECT_EQ(resolver.lookupCount(), 1u);
+}
+
+// 测试不同主机名由多个解析线程并发解析，每个查询都得到回调
+TEST(ResolverTest, DistinctHostsResolveOnWorkerPool) {
+    ResolverConfig config;
+    config.max_threads = 3;
+    Resolver resolver(config);
+
+    constexpr int kHosts = 20;
+    std::atomic<int> failed(0);
+    std::atomic<int> resolved(0);
+    for (int i = 0; i < kHosts; ++i) {
+        resolver.resolve("host" + std::to_string(i) + ".invalid", 80,
+                         [&failed](const std::vector<SocketAddress>& result) {
+                             if (result.empty()) failed++;
+                         });
+    }
+    resolver.resolve("localhost", 80, [&resolved](const std::vector<SocketAddress>& result) {
+        if (!result.empty()) resolved++;
+    });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((failed.load() < kHosts || resolved.load() < 1) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(failed.load(), kHosts);
+    EXPECT_EQ(resolved.load(), 1);
+    EXPECT_EQ(resolver.lookupCount(), static_cast<uint64_t>(kHosts + 1));
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
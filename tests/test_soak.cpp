@@ -0,0 +1,336 @@
+#include <gtest/gtest.h>
+#include "logger.h"
+#include "metrics.h"
+#include "client_pool.h"
+#include "tcp_client.h"
+#include "tcp_server.h"
+#include <sys/resource.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 规模与长时间运行测试：进程内启动服务器，在回环网络上建立上万条连接，
+// 测量每连接内存、线程数、fd泄漏和消息丢失，并在连接反复断开重连的同时持续收发。
+// 所有等待都由回调计数唤醒，不依赖固定的睡眠时间。
+// 连接数、运行时间和各项阈值可用环境变量调整：
+//   SOAK_CONNECTIONS             规模测试的连接数，默认10000
+//   SOAK_CHURN_CONNECTIONS       反复重连测试的连接数，默认1000
+// 同一进程中每条连接占两个fd，fd上限不足以建立默认连接数时跳过该测试，
+// 显式指定的连接数不足时测试失败
+//   SOAK_SECONDS                 反复重连测试的运行秒数，默认5
+//   SOAK_MAX_RSS_PER_CONN_KB     每条连接（客户端和服务器两端合计）的内存上限，默认64
+//   SOAK_MAX_RSS_GROWTH_KB       反复重连期间的内存增长上限，默认8192
+//   SOAK_MIN_CALLS_PER_SEC       请求/响应速率下限，默认10000
+
+namespace {
+
+int envInt(const char* name, int fallback) {
+    const char* value = std::getenv(name);
+    if (value == nullptr || *value == '\0') return fallback;
+    int parsed = std::atoi(value);
+    return parsed > 0 ? parsed : fallback;
+}
+
+// 显式设置了该环境变量
+bool envSet(const char* name) {
+    const char* value = std::getenv(name);
+    return value != nullptr && *value != '\0';
+}
+
+// 把打开文件数的软限制提升到硬限制，返回提升后的软限制
+size_t raiseFileLimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) < 0) return 0;
+    if (limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+    }
+    return limit.rlim_cur;
+}
+
+// 常驻内存（字节）
+size_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t total = 0;
+    size_t resident = 0;
+    statm >> total >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+int threadCount() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("Threads:", 0) == 0) return std::atoi(line.c_str() + 8);
+    }
+    return -1;
+}
+
+// 当前打开的fd数，不含遍历目录本身占用的那个
+int openFdCount() {
+    DIR* dir = opendir("/proc/self/fd");
+    if (dir == nullptr) return -1;
+    int count = 0;
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') ++count;
+    }
+    closedir(dir);
+    return count - 1;
+}
+
+// 由回调线程累加、测试线程等待到达目标值的计数器
+class CountWaiter {
+public:
+    void add(int n = 1) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            count_ += n;
+        }
+        cv_.notify_all();
+    }
+
+    int count() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+    bool waitFor(int target, std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (count_ < target) {
+            if (cv_.wait_until(lock, deadline) == std::cv_status::timeout && count_ < target) return false;
+        }
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int count_ = 0;
+};
+
+// 一组连接到同一服务器的客户端，状态回调统计进入和离开已连接状态的次数
+struct ClientSet {
+    std::vector<std::unique_ptr<TcpClient>> clients;
+    CountWaiter connects;
+    CountWaiter disconnects;
+
+    void create(ClientPool& pool, int port, size_t count) {
+        clients.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            auto client = std::make_unique<TcpClient>(pool, "127.0.0.1", port);
+            client->setStateCallback([this](ConnectionState previous, ConnectionState state) {
+                if (state == ConnectionState::Connected) connects.add();
+                if (previous == ConnectionState::Connected) disconnects.add();
+            });
+            clients.push_back(std::move(client));
+        }
+    }
+
+    void stopAll() {
+        for (auto& client : clients) client->stop();
+    }
+};
+
+// 同一进程中每条连接占两个fd，另留出余量，返回fd上限允许的连接数
+size_t connectionCapacity(size_t fd_limit) {
+    return fd_limit > 256 ? (fd_limit - 256) / 2 : 0;
+}
+
+// 在[begin, end)的每个客户端上各发出rounds个调用，等待全部完成，返回成功数。
+// 等待超时返回后迟到的回调仍会更新计数，计数由回调共同持有
+int callAll(ClientSet& set, size_t begin, size_t end, int rounds, std::chrono::milliseconds timeout) {
+    struct CallState {
+        CountWaiter completed;
+        std::atomic<int> succeeded{0};
+    };
+    auto state = std::make_shared<CallState>();
+    int issued = 0;
+    for (int round = 0; round < rounds; ++round) {
+        for (size_t i = begin; i < end; ++i) {
+            bool queued = set.clients[i]->call("ping", [state](CallStatus status, std::string_view) {
+                if (status == CallStatus::Ok) state->succeeded.fetch_add(1, std::memory_order_relaxed);
+                state->completed.add();
+            });
+            if (queued) ++issued;
+        }
+    }
+    if (!state->completed.waitFor(issued, timeout)) return -1;
+    return state->succeeded.load();
+}
+
+std::unique_ptr<TcpServer> startServer() {
+    ServerConfig config;
+    config.port = 0;
+    config.admission.backlog = 4096;
+    auto server = std::make_unique<TcpServer>(config);
+    if (!server->start()) return nullptr;
+    return server;
+}
+
+}  // namespace
+
+// 上万条并发连接：连接全部建立后线程数不变，每连接内存低于阈值，每条连接上的调用都成功，
+// 服务器收到的帧数与发出的调用数一致，全部关闭后fd数回到初始值
+TEST(SoakTest, ScaleConnections) {
+    size_t fd_limit = raiseFileLimit();
+    size_t connections = static_cast<size_t>(envInt("SOAK_CONNECTIONS", 10000));
+    if (connections > connectionCapacity(fd_limit)) {
+        if (!envSet("SOAK_CONNECTIONS")) {
+            GTEST_SKIP() << "fd上限为" << fd_limit << "，不足以建立" << connections
+                         << "条连接；可提高硬限制或用SOAK_CONNECTIONS指定更少的连接数";
+        }
+        FAIL() << "fd上限为" << fd_limit << "，不足以建立" << connections << "条连接";
+    }
+
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    Counter server_frames = registry.counter("tcp_server_frames_received_total", "");
+    Gauge server_active = registry.gauge("tcp_server_active_connections", "");
+
+    int fds_initial = openFdCount();
+    {
+        auto server = startServer();
+        ASSERT_NE(server, nullptr);
+        ClientPool pool(2);
+        ClientSet set;
+
+        int threads_before = threadCount();
+        int fds_before = openFdCount();
+        size_t rss_before = residentBytes();
+
+        auto connect_started = std::chrono::steady_clock::now();
+        set.create(pool, server->port(), connections);
+        for (auto& client : set.clients) client->startAsync();
+        ASSERT_TRUE(set.connects.waitFor(static_cast<int>(connections), std::chrono::seconds(120)))
+            << "已连接" << set.connects.count() << "/" << connections;
+        double connect_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - connect_started).count();
+
+        // 每条连接上各一个调用：响应返回说明服务器已接受该连接
+        uint64_t frames_before = registry.value(server_frames);
+        auto calls_started = std::chrono::steady_clock::now();
+        constexpr int kRounds = 4;
+        int succeeded = callAll(set, 0, connections, kRounds, std::chrono::seconds(120));
+        double call_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - calls_started).count();
+        int expected = static_cast<int>(connections) * kRounds;
+        EXPECT_EQ(succeeded, expected);
+        EXPECT_EQ(registry.value(server_frames) - frames_before, static_cast<uint64_t>(expected));
+        EXPECT_EQ(registry.value(server_active), static_cast<int64_t>(connections));
+
+        int threads_after = threadCount();
+        int fds_after = openFdCount();
+        size_t rss_after = residentBytes();
+        double rss_per_connection_kb = rss_after > rss_before
+            ? (rss_after - rss_before) / 1024.0 / connections : 0;
+        double calls_per_second = expected / call_seconds;
+        std::cout << "连接数 " << connections << "，建立用时 " << connect_seconds << "s\n"
+                  << "每连接内存 " << rss_per_connection_kb << "KB（两端合计）\n"
+                  << "线程数 " << threads_before << " -> " << threads_after << "\n"
+                  << "fd数 " << fds_before << " -> " << fds_after << "\n"
+                  << "调用速率 " << calls_per_second << "/s" << std::endl;
+
+        // 连接不占用线程，每条连接两端各一个fd
+        EXPECT_EQ(threads_after, threads_before);
+        EXPECT_EQ(fds_after - fds_before, static_cast<int>(connections) * 2);
+        EXPECT_LE(rss_per_connection_kb, envInt("SOAK_MAX_RSS_PER_CONN_KB", 64));
+        EXPECT_GE(calls_per_second, envInt("SOAK_MIN_CALLS_PER_SEC", 10000));
+
+        set.stopAll();
+        EXPECT_EQ(set.disconnects.count(), static_cast<int>(connections));
+        server->stop();
+        EXPECT_EQ(registry.value(server_active), 0);
+    }
+    EXPECT_EQ(openFdCount(), fds_initial);
+}
+
+// 反复断开重连：每轮停止并重新启动一批客户端，再在所有连接上发出调用。
+// 调用全部成功，线程数不增长，预热后的内存增长低于阈值，结束后fd数回到初始值
+TEST(SoakTest, ConnectionChurn) {
+    size_t fd_limit = raiseFileLimit();
+    size_t connections = static_cast<size_t>(envInt("SOAK_CHURN_CONNECTIONS", 1000));
+    if (connections > connectionCapacity(fd_limit)) {
+        if (!envSet("SOAK_CHURN_CONNECTIONS")) {
+            GTEST_SKIP() << "fd上限为" << fd_limit << "，不足以建立" << connections << "条连接";
+        }
+        FAIL() << "fd上限为" << fd_limit << "，不足以建立" << connections << "条连接";
+    }
+    ASSERT_GE(connections, 10u);
+    size_t batch = connections / 10;
+    auto duration = std::chrono::seconds(envInt("SOAK_SECONDS", 5));
+
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    Counter server_frames = registry.counter("tcp_server_frames_received_total", "");
+
+    int fds_initial = openFdCount();
+    {
+        auto server = startServer();
+        ASSERT_NE(server, nullptr);
+        ClientPool pool(2);
+        ClientSet set;
+        set.create(pool, server->port(), connections);
+        for (auto& client : set.clients) client->startAsync();
+        ASSERT_TRUE(set.connects.waitFor(static_cast<int>(connections), std::chrono::seconds(60)));
+
+        int threads_before = threadCount();
+        uint64_t frames_before = registry.value(server_frames);
+        int expected_connects = static_cast<int>(connections);
+        int expected_calls = 0;
+        int succeeded_calls = 0;
+        size_t rss_warm = 0;
+        int rounds = 0;
+        size_t next = 0;
+        auto deadline = std::chrono::steady_clock::now() + duration;
+        while (rounds < 2 || std::chrono::steady_clock::now() < deadline) {
+            // 轮流选出一批客户端断开后立即重连，其余连接上的调用照常进行
+            for (size_t i = 0; i < batch; ++i) {
+                TcpClient& client = *set.clients[(next + i) % connections];
+                client.stop();
+                client.startAsync();
+            }
+            next = (next + batch) % connections;
+            expected_connects += static_cast<int>(batch);
+            ASSERT_TRUE(set.connects.waitFor(expected_connects, std::chrono::seconds(30)))
+                << "第" << rounds << "轮重连未完成";
+
+            int succeeded = callAll(set, 0, connections, 1, std::chrono::seconds(30));
+            ASSERT_GE(succeeded, 0) << "第" << rounds << "轮调用未完成";
+            expected_calls += static_cast<int>(connections);
+            succeeded_calls += succeeded;
+            ++rounds;
+            // 第一轮之后内存池和缓冲区已预热，以此为基线
+            if (rounds == 1) rss_warm = residentBytes();
+        }
+
+        size_t rss_end = residentBytes();
+        double growth_kb = rss_end > rss_warm ? (rss_end - rss_warm) / 1024.0 : 0;
+        std::cout << "重连轮数 " << rounds << "，每轮 " << batch << " 条，内存增长 " << growth_kb << "KB\n"
+                  << "线程数 " << threads_before << " -> " << threadCount() << std::endl;
+
+        EXPECT_EQ(succeeded_calls, expected_calls);
+        EXPECT_EQ(registry.value(server_frames) - frames_before, static_cast<uint64_t>(expected_calls));
+        EXPECT_EQ(threadCount(), threads_before);
+        EXPECT_LE(growth_kb, envInt("SOAK_MAX_RSS_GROWTH_KB", 8192));
+
+        set.stopAll();
+        server->stop();
+    }
+    EXPECT_EQ(openFdCount(), fds_initial);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    // 上万条连接的建立和断开日志会淹没测试结果，只输出警告及以上
+    Logger::instance().setSink([](LogLevel level, std::string_view line) {
+        if (level >= LogLevel::Warn) std::cerr << line;
+    });
+    return RUN_ALL_TESTS();
+}
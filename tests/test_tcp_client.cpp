@@ -1,116 +1,734 @@
 #include <gtest/gtest.h>
 #include "tcp_client.h"
+#include "tcp_server.h"
+#include "client_pool.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <poll.h>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <chrono>
+#include <condition_variable>
 #include <atomic>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
 
 // 测试TCP客户端的基本功能
 class TcpClientTest : public ::testing::Test {
 protected:
-    void SetUp() override {
-        // 测试前的设置
+    // 在进程内启动测试服务器，监听系统分配的端口，不与本机其他进程冲突
+    static void SetUpTestSuite() {
+        ServerConfig config;
+        config.port = 0;
+        server_ = new TcpServer(config);
+        ASSERT_TRUE(server_->start());
+        port_ = server_->port();
     }
 
-    void TearDown() override {
-        // 测试后的清理
+    static void TearDownTestSuite() {
+        delete server_;
+        server_ = nullptr;
     }
+
+    static TcpServer* server_;
+    static int port_;
+};
+
+TcpServer* TcpClientTest::server_ = nullptr;
+int TcpClientTest::port_ = 0;
+
+// 等待计数达到目标值：由回调中的notify唤醒，不按固定时间睡眠
+class CountWaiter {
+public:
+    void add() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++count_;
+        }
+        cv_.notify_all();
+    }
+
+    int count() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+    // 超时返回false
+    bool waitFor(int target, std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (count_ < target) {
+            if (cv_.wait_until(lock, deadline) == std::cv_status::timeout && count_ < target) return false;
+        }
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int count_ = 0;
 };
 
 // 测试客户端创建和销毁
 TEST_F(TcpClientTest, CreateAndDestroy) {
-    TcpClient client("127.0.0.1", 8888);
-    EXPECT_NO_THROW(client.start());
-    EXPECT_NO_THROW(client.stop());
+    TcpClient client("127.0.0.1", port_);
+    EXPECT_EQ(client.state(), ConnectionState::Stopped);
+    client.start();
+    EXPECT_TRUE(client.isConnected());
+    client.stop();
+    EXPECT_EQ(client.state(), ConnectionState::Stopped);
 }
 
 // 测试连接状态回调
 TEST_F(TcpClientTest, ConnectionCallback) {
-    TcpClient client("127.0.0.1", 8888);
-    std::atomic<bool> callback_called(false);
-    
-    client.setConnectionCallback([&callback_called](bool connected) {
-        callback_called = true;
+    TcpClient client("127.0.0.1", port_);
+    CountWaiter connected;
+    CountWaiter disconnected;
+    client.setConnectionCallback([&](bool up) {
+        (up ? connected : disconnected).add();
     });
-    
+
     client.start();
-    // 增加等待时间，确保回调有足够时间被调用
-    std::this_thread::sleep_for(std::chrono::seconds(5));
-    EXPECT_TRUE(callback_called);
+    EXPECT_TRUE(connected.waitFor(1, std::chrono::seconds(5)));
     client.stop();
+    // stop()返回前已送达断开回调
+    EXPECT_EQ(disconnected.count(), 1);
+    EXPECT_EQ(connected.count(), 1);
 }
 
 // 测试消息发送
 TEST_F(TcpClientTest, SendMessage) {
-    TcpClient client("127.0.0.1", 8888);
+    TcpClient client("127.0.0.1", port_);
+    CountWaiter responses;
+    client.setMessageCallback([&responses](const FrameHeader&, std::string_view) { responses.add(); });
     client.start();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    
+    ASSERT_TRUE(client.isConnected());
+
     std::string message = "测试消息";
-    bool send_result = client.send(message);
-    // 注意：由于没有实际的服务器，发送可能会失败
-    // 这里我们主要测试接口是否正常工作
-    EXPECT_NO_THROW(client.send(message));
-    
+    EXPECT_TRUE(client.send(message));
+    EXPECT_TRUE(client.send(message));
+    EXPECT_TRUE(responses.waitFor(2, std::chrono::seconds(5)));
+    client.stop();
+    EXPECT_FALSE(client.send(message));
+}
+
+// 测试使用io_uring后端发送
+TEST_F(TcpClientTest, SendWithIoUringBackend) {
+    TcpClient client("127.0.0.1", port_);
+    IoBackend backend = client.setIoBackend(IoBackend::IoUring);
+    EXPECT_EQ(backend, IoUring::supported() ? IoBackend::IoUring : IoBackend::Epoll);
+
+    client.start();
+    ASSERT_TRUE(client.isConnected());
+    EXPECT_TRUE(client.send("io_uring消息"));
+    EXPECT_TRUE(client.send(std::string(64 * 1024, 'x')));
+    client.stop();
+}
+
+// 测试批量发送与大块数据的零拷贝发送
+TEST_F(TcpClientTest, SendBatchAndZerocopy) {
+    TcpClient client("127.0.0.1", port_);
+    OutputConfig config;
+    config.max_batch_iovecs = 8;
+    config.zerocopy_threshold = 32 * 1024;
+    client.setOutputConfig(config);
+
+    client.start();
+    ASSERT_TRUE(client.isConnected());
+
+    std::vector<std::string> messages;
+    for (int i = 0; i < 100; ++i) {
+        messages.push_back("批量消息 " + std::to_string(i));
+    }
+    EXPECT_TRUE(client.sendBatch(messages));
+    EXPECT_TRUE(client.sendBatch({}));
+
+    // 返回时内核已不再引用数据，可以立即修改
+    std::string large(256 * 1024, 'z');
+    EXPECT_TRUE(client.send(large));
+    large.assign(large.size(), 'y');
+    EXPECT_TRUE(client.send(large));
+    EXPECT_TRUE(client.isConnected());
+    client.stop();
+}
+
+// 测试多个线程并发异步发送，所有请求都完成
+TEST_F(TcpClientTest, AsyncSendFromManyThreads) {
+    TcpClient client("127.0.0.1", port_);
+    client.start();
+    ASSERT_TRUE(client.isConnected());
+
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 500;
+    std::atomic<int> callbacks(0);
+    std::vector<std::thread> threads;
+    std::vector<std::vector<std::future<bool>>> futures(kThreads);
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                std::string message = "线程" + std::to_string(t) + "消息" + std::to_string(i);
+                if (i % 2 == 0) {
+                    futures[t].push_back(client.sendAsync(message));
+                } else {
+                    EXPECT_TRUE(client.sendAsync(message, [&callbacks](bool ok) {
+                        if (ok) callbacks.fetch_add(1);
+                    }));
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (auto& list : futures) {
+        for (auto& future : list) {
+            ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+            EXPECT_TRUE(future.get());
+        }
+    }
+    // 同步发送与异步发送走同一队列，返回时之前的请求都已写入socket
+    EXPECT_TRUE(client.send("最后一条"));
+    EXPECT_EQ(callbacks.load(), kThreads * kPerThread / 2);
+    EXPECT_EQ(client.queuedBytes(), 0u);
+    client.stop();
+}
+
+// 测试接收服务器的响应：每条消息对应一条响应，序号与发送顺序一致
+TEST_F(TcpClientTest, ReceivesResponses) {
+    TcpClient client("127.0.0.1", port_);
+    constexpr int kMessages = 20000;
+    std::atomic<int> received(0);
+    std::atomic<bool> in_order(true);
+    std::atomic<bool> payload_ok(true);
+    CountWaiter done;
+    client.setMessageCallback([&](const FrameHeader& header, std::string_view payload) {
+        int index = received.load();
+        if (header.sequence != static_cast<uint32_t>(index) ||
+            header.type != static_cast<uint16_t>(FrameType::Response)) {
+            in_order = false;
+        }
+        if (payload != "服务器已收到消息") payload_ok = false;
+        received.store(index + 1);
+        if (index + 1 == kMessages) done.add();
+    });
+    client.start();
+    ASSERT_TRUE(client.isConnected());
+
+    // 持续发送而不读取时服务器的发送会被客户端的接收缓冲区卡住，读取后双向都能跑满
+    const std::string message = "需要响应的消息";
+    for (int i = 0; i < kMessages; ++i) {
+        while (!client.sendAsync(message, SendCallback())) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    EXPECT_TRUE(done.waitFor(1, std::chrono::seconds(10)));
+    EXPECT_EQ(received.load(), kMessages);
+    EXPECT_TRUE(in_order);
+    EXPECT_TRUE(payload_ok);
+    EXPECT_TRUE(client.isConnected());
+    client.stop();
+}
+
+// 测试在消息回调中异步发送下一条，完成多轮往返
+TEST_F(TcpClientTest, PingPongFromMessageCallback) {
+    TcpClient client("127.0.0.1", port_);
+    constexpr int kRounds = 1000;
+    std::atomic<int> rounds(0);
+    std::promise<void> finished;
+    client.setMessageCallback([&](const FrameHeader&, std::string_view) {
+        if (rounds.fetch_add(1) + 1 == kRounds) {
+            finished.set_value();
+        } else {
+            client.sendAsync("ping", SendCallback());
+        }
+    });
+    client.start();
+    ASSERT_TRUE(client.isConnected());
+    ASSERT_TRUE(client.sendAsync("ping", SendCallback()));
+    EXPECT_EQ(finished.get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    EXPECT_EQ(rounds.load(), kRounds);
+    client.stop();
+}
+
+// 回显负载的服务器，负载为"drop"时不回复
+static std::unique_ptr<TcpServer> startEchoServer() {
+    ServerConfig config;
+    config.port = 0;
+    auto server = std::make_unique<TcpServer>(config);
+    server->setMessageHandler([](const FrameHeader&, std::string_view payload, ByteBuffer& response) {
+        if (payload == "drop") return false;
+        response.append(payload);
+        return true;
+    });
+    return server->start() ? std::move(server) : nullptr;
+}
+
+// 测试在一个连接上流水线地发出大量调用，每个调用拿到自己的响应
+TEST_F(TcpClientTest, CallPipelinesRequests) {
+    auto server = startEchoServer();
+    ASSERT_NE(server, nullptr);
+    TcpClient client("127.0.0.1", server->port());
+    CountWaiter unmatched;
+    client.setMessageCallback([&unmatched](const FrameHeader&, std::string_view) { unmatched.add(); });
+    client.start();
+    ASSERT_TRUE(client.isConnected());
+
+    constexpr int kCalls = 5000;
+    std::vector<std::future<CallResult>> futures;
+    CountWaiter callback_ok;
+    for (int i = 0; i < kCalls; ++i) {
+        std::string request = "请求" + std::to_string(i);
+        if (i % 2 == 0) {
+            futures.push_back(client.call(request));
+        } else {
+            ASSERT_TRUE(client.call(request, [&callback_ok, request](CallStatus status, std::string_view payload) {
+                if (status == CallStatus::Ok && payload == request) callback_ok.add();
+            }));
+        }
+    }
+    for (int i = 0; i < kCalls; i += 2) {
+        CallResult result = futures[i / 2].get();
+        ASSERT_TRUE(result.ok());
+        EXPECT_EQ(result.payload, "请求" + std::to_string(i));
+    }
+    EXPECT_TRUE(callback_ok.waitFor(kCalls / 2, std::chrono::seconds(5)));
+    EXPECT_EQ(callback_ok.count(), kCalls / 2);
+
+    // 普通发送的响应仍交给消息回调
+    EXPECT_TRUE(client.send("普通消息"));
+    EXPECT_TRUE(unmatched.waitFor(1, std::chrono::seconds(5)));
+    EXPECT_EQ(unmatched.count(), 1);
+    client.stop();
+}
+
+// 测试io_uring后端下同一循环上的多个连接共用一个ring，流水线调用和大块数据都按序完成
+TEST_F(TcpClientTest, IoUringSharedRingPipelinesCalls) {
+    if (!IoUring::supported()) GTEST_SKIP() << "io_uring不可用";
+    auto server = startEchoServer();
+    ASSERT_NE(server, nullptr);
+    ClientPool pool(1);
+    std::vector<std::unique_ptr<TcpClient>> clients;
+    for (int i = 0; i < 4; ++i) {
+        clients.push_back(std::make_unique<TcpClient>(pool, "127.0.0.1", server->port()));
+        ASSERT_EQ(clients.back()->setIoBackend(IoBackend::IoUring), IoBackend::IoUring);
+        clients.back()->start();
+        ASSERT_TRUE(clients.back()->isConnected());
+    }
+
+    constexpr int kCalls = 500;
+    std::vector<std::future<CallResult>> futures;
+    for (int i = 0; i < kCalls; ++i) {
+        // 夹杂大块数据，让发送在socket缓冲区满时等待可写后继续
+        std::string request = i % 50 == 0 ? std::string(512 * 1024, static_cast<char>('a' + i % 26))
+                                          : "请求" + std::to_string(i);
+        futures.push_back(clients[i % clients.size()]->call(request, 10000));
+    }
+    for (int i = 0; i < kCalls; ++i) {
+        CallResult result = futures[i].get();
+        ASSERT_TRUE(result.ok()) << i;
+        if (i % 50 == 0) {
+            EXPECT_EQ(result.payload, std::string(512 * 1024, static_cast<char>('a' + i % 26)));
+        } else {
+            EXPECT_EQ(result.payload, "请求" + std::to_string(i));
+        }
+    }
+    for (auto& client : clients) {
+        client->stop();
+    }
+}
+
+// 测试调用的截止时间、停止时的失败和未连接时的拒绝
+TEST_F(TcpClientTest, CallDeadlinesAndFailures) {
+    auto server = startEchoServer();
+    ASSERT_NE(server, nullptr);
+    TcpClient client("127.0.0.1", server->port());
+    EXPECT_EQ(client.call("未连接").get().status, CallStatus::Rejected);
+    client.start();
+    ASSERT_TRUE(client.isConnected());
+
+    auto start = std::chrono::steady_clock::now();
+    CallResult timed_out = client.call("drop", 100).get();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(timed_out.status, CallStatus::Timeout);
+    EXPECT_GE(elapsed, std::chrono::milliseconds(100));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(1000));
+
+    // 超时的调用不影响之后的调用
+    EXPECT_EQ(client.call("之后").get().payload, "之后");
+
+    // 没有截止时间的调用在停止时以断开完成
+    auto pending = client.call("drop", 0);
+    EXPECT_EQ(pending.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+    client.stop();
+    ASSERT_EQ(pending.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+    EXPECT_EQ(pending.get().status, CallStatus::Disconnected);
+}
+
+// 测试多段数据、共享缓冲区和文件区间的发送，回显的负载与原数据一致
+TEST_F(TcpClientTest, ZeroCopySendOverloads) {
+    auto server = startEchoServer();
+    ASSERT_NE(server, nullptr);
+    TcpClient client("127.0.0.1", server->port());
+    std::mutex mutex;
+    std::vector<std::string> echoed;
+    CountWaiter echoes;
+    client.setMessageCallback([&](const FrameHeader&, std::string_view payload) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            echoed.emplace_back(payload);
+        }
+        echoes.add();
+    });
+    client.start();
+    ASSERT_TRUE(client.isConnected());
+
+    char head[] = "头部|";
+    std::string body(5000, 'b');
+    struct iovec parts[2] = {{head, strlen(head)}, {&body[0], body.size()}};
+    EXPECT_TRUE(client.send(parts, 2));
+
+    SharedBuffer shared(std::string(20000, 's'));
+    std::promise<bool> shared_sent;
+    EXPECT_TRUE(client.sendAsync(shared, [&shared_sent](bool ok) { shared_sent.set_value(ok); }));
+    EXPECT_TRUE(client.send(shared));
+    EXPECT_TRUE(shared_sent.get_future().get());
+
+    char path[] = "/tmp/tcp_client_testXXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    unlink(path);
+    std::string content;
+    for (int i = 0; i < 10000; ++i) content += std::to_string(i) + ",";
+    ASSERT_EQ(write(fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+    EXPECT_TRUE(client.sendFile(fd, 10, content.size() - 20));
+    // 区间超出文件时被拒绝；调用方关闭fd不影响已入队的请求
+    EXPECT_FALSE(client.sendFile(fd, 10, content.size()));
+    std::promise<bool> file_sent;
+    EXPECT_TRUE(client.sendFile(fd, 0, 100, [&file_sent](bool ok) { file_sent.set_value(ok); }));
+    close(fd);
+    EXPECT_TRUE(file_sent.get_future().get());
+
+    EXPECT_TRUE(echoes.waitFor(5, std::chrono::seconds(5)));
     client.stop();
+    ASSERT_EQ(echoed.size(), 5u);
+    EXPECT_EQ(echoed[0], head + body);
+    EXPECT_EQ(echoed[1], shared.view());
+    EXPECT_EQ(echoed[2], shared.view());
+    EXPECT_EQ(echoed[3], content.substr(10, content.size() - 20));
+    EXPECT_EQ(echoed[4], content.substr(0, 100));
+    EXPECT_EQ(shared.useCount(), 1);
 }
 
-// 测试自动重连机制
+// 测试对端不读取时异步发送不阻塞调用方，积压超过高水位后被拒绝
+TEST_F(TcpClientTest, HighWatermarkRejectsWhenPeerStalls) {
+    // 只监听不accept也不读取的对端，连接在内核队列中完成
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(listen_fd, 4), 0);
+    ASSERT_EQ(getsockname(listen_fd, (struct sockaddr*)&addr, &len), 0);
+
+    constexpr size_t kWatermark = 256 * 1024;
+    TcpClient client("127.0.0.1", ntohs(addr.sin_port));
+    client.setSendHighWatermark(kWatermark);
+    client.start();
+    ASSERT_TRUE(client.isConnected());
+
+    const std::string chunk(16 * 1024, 'w');
+    std::vector<std::future<bool>> futures;
+    int rejected = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 1000; ++i) {
+        auto future = client.sendAsync(chunk);
+        if (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            futures.push_back(std::move(future));
+        } else if (!future.get()) {
+            ++rejected;
+        }
+        EXPECT_LE(client.queuedBytes(), kWatermark);
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    EXPECT_GT(rejected, 0);
+
+    // 停止时未发出的请求以失败完成，不会一直挂起
+    client.stop();
+    for (auto& future : futures) {
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+    }
+    EXPECT_EQ(client.queuedBytes(), 0u);
+    close(listen_fd);
+}
+
+// 测试自动重连机制：服务器尚未启动时首次连接失败，之后按退避重试直到服务器可用
 TEST_F(TcpClientTest, AutoReconnect) {
-    TcpClient client("127.0.0.1", 8888);
-    std::atomic<int> reconnect_count(0);
-    
-    client.setConnectionCallback([&reconnect_count](bool connected) {
-        if (!connected) {
-            reconnect_count++;
+    // 先占用一个端口再释放，得到当前没有监听者的端口
+    ServerConfig server_config;
+    server_config.port = 0;
+    auto probe = std::make_unique<TcpServer>(server_config);
+    ASSERT_TRUE(probe->start());
+    server_config.port = probe->port();
+    probe.reset();
+
+    TcpClient client("127.0.0.1", server_config.port);
+    ReconnectConfig config;
+    config.initial_backoff_ms = 20;
+    config.max_backoff_ms = 100;
+    client.setReconnectConfig(config);
+    CountWaiter connected;
+    CountWaiter backoffs;
+    client.setStateCallback([&](ConnectionState, ConnectionState state) {
+        if (state == ConnectionState::Connected) connected.add();
+        if (state == ConnectionState::Backoff) backoffs.add();
+    });
+
+    client.start();
+    EXPECT_FALSE(client.isConnected());
+    ASSERT_TRUE(backoffs.waitFor(1, std::chrono::seconds(5)));
+
+    TcpServer server(server_config);
+    ASSERT_TRUE(server.start());
+    ASSERT_TRUE(connected.waitFor(1, std::chrono::seconds(5)));
+    EXPECT_TRUE(client.isConnected());
+    EXPECT_TRUE(client.call("重连后").get().ok());
+    client.stop();
+    EXPECT_EQ(connected.count(), 1);
+}
+
+// 测试重连退避：等待时间不超过指数增长的上限，且在范围内随机分布
+TEST_F(TcpClientTest, ReconnectBackoffIsCappedAndJittered) {
+    ReconnectConfig config;
+    config.initial_backoff_ms = 100;
+    config.max_backoff_ms = 5000;
+    for (uint32_t failures = 0; failures < 40; ++failures) {
+        uint64_t ceiling = std::min<uint64_t>(config.max_backoff_ms,
+                                              failures < 10 ? 100u << failures : config.max_backoff_ms);
+        for (int i = 0; i < 50; ++i) {
+            EXPECT_LE(reconnectBackoffMs(config, failures), ceiling);
         }
+    }
+    std::set<uint64_t> samples;
+    for (int i = 0; i < 100; ++i) {
+        samples.insert(reconnectBackoffMs(config, 3));
+    }
+    EXPECT_GT(samples.size(), 10u);
+}
+
+// 测试服务器重启后客户端由断开事件驱动，在毫秒级内重连成功
+TEST_F(TcpClientTest, ReconnectsQuicklyAfterServerRestart) {
+    ServerConfig server_config;
+    server_config.port = 0;
+    auto server = std::make_unique<TcpServer>(server_config);
+    ASSERT_TRUE(server->start());
+    server_config.port = server->port();
+
+    TcpClient client("127.0.0.1", server_config.port);
+    ReconnectConfig config;
+    config.initial_backoff_ms = 20;
+    config.max_backoff_ms = 200;
+    client.setReconnectConfig(config);
+    CountWaiter connects;
+    CountWaiter disconnects;
+    client.setConnectionCallback([&](bool connected) {
+        (connected ? connects : disconnects).add();
     });
-    
     client.start();
-    std::this_thread::sleep_for(std::chrono::seconds(4)); // 等待可能的重连尝试
-    EXPECT_GE(reconnect_count, 0);
+    ASSERT_TRUE(client.isConnected());
+
+    // 不发送任何数据，只依靠对端关闭事件发现断开
+    server.reset();
+    ASSERT_TRUE(disconnects.waitFor(1, std::chrono::seconds(5)));
+    EXPECT_FALSE(client.isConnected());
+
+    server = std::make_unique<TcpServer>(server_config);
+    ASSERT_TRUE(server->start());
+    auto restarted = std::chrono::steady_clock::now();
+    ASSERT_TRUE(connects.waitFor(2, std::chrono::seconds(5)));
+    EXPECT_LT(std::chrono::steady_clock::now() - restarted, std::chrono::milliseconds(1000));
+    EXPECT_TRUE(client.isConnected());
+    EXPECT_TRUE(client.send("重连后的消息"));
+    client.stop();
+}
+
+// 测试以域名连接服务器
+TEST_F(TcpClientTest, ConnectsByHostName) {
+    TcpClient client("localhost", port_);
+    client.start();
+    ASSERT_TRUE(client.isConnected());
+    EXPECT_EQ(client.remoteAddress(), "127.0.0.1:" + std::to_string(port_));
+    EXPECT_TRUE(client.send("按域名连接"));
     client.stop();
+    EXPECT_TRUE(client.remoteAddress().empty());
+
+    TcpClient unknown("nonexistent.invalid", port_);
+    unknown.start();
+    EXPECT_FALSE(unknown.isConnected());
+    unknown.stop();
+}
+
+// 测试多个候选地址时错开并行连接：前面的地址没有响应或拒绝连接时，
+// 不必等到连接超时，后面的地址胜出
+TEST_F(TcpClientTest, HappyEyeballsSkipsUnresponsiveAddress) {
+    // 接受队列已满的监听socket：新的SYN被丢弃，连接一直停在进行中
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(listen_fd, 0), 0);
+    getsockname(listen_fd, (struct sockaddr*)&addr, &len);
+    std::vector<int> fillers;
+    while (fillers.size() < 16) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        connect(fd, (struct sockaddr*)&addr, sizeof(addr));
+        fillers.push_back(fd);
+        struct pollfd pfd{fd, POLLOUT, 0};
+        if (poll(&pfd, 1, 100) == 0) break;
+    }
+    ASSERT_LT(fillers.size(), 16u);
+
+    // 拒绝连接的地址：绑定后立即关闭的端口
+    int probe = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in free_addr = addr;
+    free_addr.sin_port = 0;
+    bind(probe, (struct sockaddr*)&free_addr, sizeof(free_addr));
+    getsockname(probe, (struct sockaddr*)&free_addr, &len);
+    close(probe);
+
+    SocketAddress unresponsive, refused, good;
+    ASSERT_TRUE(SocketAddress::parse("127.0.0.1", ntohs(addr.sin_port), unresponsive));
+    ASSERT_TRUE(SocketAddress::parse("127.0.0.1", ntohs(free_addr.sin_port), refused));
+    ASSERT_TRUE(SocketAddress::parse("127.0.0.1", port_, good));
+
+    ClientPool pool(1);
+    TcpClient client(pool, {unresponsive, refused, good});
+    ReconnectConfig config;
+    config.connect_timeout_ms = 3000;
+    config.attempt_delay_ms = 100;
+    client.setReconnectConfig(config);
+    auto start = std::chrono::steady_clock::now();
+    client.start();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_TRUE(client.isConnected());
+    EXPECT_EQ(client.remoteAddress(), good.toString());
+    // 第一个地址等待一个错开时间，被拒绝的地址立即让位给下一个
+    EXPECT_GE(elapsed, std::chrono::milliseconds(90));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(1000));
+    EXPECT_TRUE(client.send("胜出的连接"));
+    client.stop();
+
+    for (int fd : fillers) close(fd);
+    close(listen_fd);
+}
+
+// 测试低延迟策略下并发的小调用不被Nagle与延迟ACK拖慢，吞吐策略下合并定时器按时写出
+TEST_F(TcpClientTest, WritePolicies) {
+    auto server = startEchoServer();
+    ASSERT_NE(server, nullptr);
+
+    // 每轮并发两个调用，第二个请求不能等第一个的ACK（开启Nagle时每轮多等约10~40ms）
+    TcpClient latency("127.0.0.1", server->port());
+    latency.start();
+    ASSERT_TRUE(latency.isConnected());
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; ++i) {
+        auto first = latency.call("第一个");
+        auto second = latency.call("第二个");
+        ASSERT_TRUE(first.get().ok());
+        ASSERT_TRUE(second.get().ok());
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+    latency.stop();
+
+    // 吞吐策略：单个小请求等到合并定时器到期后写出
+    ServerConfig config;
+    config.port = 0;
+    config.output.write_policy = WritePolicy::Throughput;
+    TcpServer bulk_server(config);
+    bulk_server.setMessageHandler([](const FrameHeader&, std::string_view payload, ByteBuffer& response) {
+        response.append(payload);
+        return true;
+    });
+    ASSERT_TRUE(bulk_server.start());
+    OutputConfig output;
+    output.write_policy = WritePolicy::Throughput;
+    output.coalesce_delay_ms = 20;
+    TcpClient bulk("127.0.0.1", bulk_server.port());
+    bulk.setOutputConfig(output);
+    bulk.start();
+    ASSERT_TRUE(bulk.isConnected());
+    start = std::chrono::steady_clock::now();
+    CallResult result = bulk.call("合并").get();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_TRUE(result.ok());
+    EXPECT_EQ(result.payload, "合并");
+    EXPECT_GE(elapsed, std::chrono::milliseconds(20));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(1000));
+
+    // 大量流水线请求凑满coalesce_bytes时不等定时器
+    std::vector<std::future<CallResult>> futures;
+    for (int i = 0; i < 2000; ++i) {
+        futures.push_back(bulk.call(std::string(100, 'b')));
+    }
+    for (auto& future : futures) {
+        ASSERT_TRUE(future.get().ok());
+    }
+    bulk.stop();
 }
 
-// 测试多客户端并发
+// 测试多客户端并发：共用一个连接池异步连接，每个客户端都能完成调用
 TEST_F(TcpClientTest, MultipleClients) {
-    const int CLIENT_COUNT = 5;
+    constexpr int kClientCount = 50;
+    ClientPool pool(2);
+    CountWaiter connected;
     std::vector<std::unique_ptr<TcpClient>> clients;
-    
-    // 创建多个客户端
-    for (int i = 0; i < CLIENT_COUNT; ++i) {
-        clients.push_back(std::make_unique<TcpClient>("127.0.0.1", 8888));
-        clients.back()->start();
+    for (int i = 0; i < kClientCount; ++i) {
+        clients.push_back(std::make_unique<TcpClient>(pool, "127.0.0.1", port_));
+        clients.back()->setConnectionCallback([&connected](bool up) {
+            if (up) connected.add();
+        });
+        clients.back()->startAsync();
+    }
+    ASSERT_TRUE(connected.waitFor(kClientCount, std::chrono::seconds(10)));
+
+    std::vector<std::future<CallResult>> futures;
+    for (auto& client : clients) {
+        futures.push_back(client->call("多客户端"));
+    }
+    for (auto& future : futures) {
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_TRUE(future.get().ok());
     }
-    
-    // 等待一段时间
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    
-    // 清理
     for (auto& client : clients) {
         client->stop();
+        EXPECT_EQ(client->state(), ConnectionState::Stopped);
     }
-    
-    // 验证所有客户端都能正常停止
-    EXPECT_EQ(clients.size(), CLIENT_COUNT);
 }
 
-// 测试客户端状态管理
+// 测试客户端状态管理：停止后可以重新启动，重复停止没有影响
 TEST_F(TcpClientTest, ClientStateManagement) {
-    TcpClient client("127.0.0.1", 8888);
-    
-    // 测试启动
-    client.start();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    
-    // 测试停止
-    client.stop();
-    
-    // 测试重复启动
-    EXPECT_NO_THROW(client.start());
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    
-    // 测试重复停止
-    EXPECT_NO_THROW(client.stop());
+    TcpClient client("127.0.0.1", port_);
+
+    client.start();
+    EXPECT_EQ(client.state(), ConnectionState::Connected);
+    client.stop();
+    EXPECT_EQ(client.state(), ConnectionState::Stopped);
+
+    client.start();
+    EXPECT_EQ(client.state(), ConnectionState::Connected);
+    EXPECT_TRUE(client.call("重新启动后").get().ok());
+    client.stop();
+    client.stop();
+    EXPECT_EQ(client.state(), ConnectionState::Stopped);
 }
 
 int main(int argc, char **argv) {
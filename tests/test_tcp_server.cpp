@@ -0,0 +1,524 @@
+#include <gtest/gtest.h>
+#include "tcp_server.h"
+#include "uring.h"
+#include "frame.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+const std::string kResponse = "服务器已收到消息";
+
+// 阻塞方式连接到本地服务器，设置1秒接收超时
+int connectTo(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    struct timeval tv{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 接收指定长度的数据，超时或断开时返回已收到的部分
+std::string recvExactly(int fd, size_t len) {
+    std::string result;
+    char buffer[1024];
+    while (result.size() < len) {
+        ssize_t n = recv(fd, buffer, std::min(sizeof(buffer), len - result.size()), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        result.append(buffer, n);
+    }
+    return result;
+}
+
+// 发送一个消息帧
+bool sendFrame(int fd, uint32_t sequence, const std::string& payload) {
+    std::string frame;
+    appendFrame(frame, FrameType::Message, sequence, payload);
+    return send(fd, frame.data(), frame.size(), 0) == (ssize_t)frame.size();
+}
+
+// 接收一个响应帧，校验帧头后返回payload
+std::string recvResponse(int fd, uint32_t sequence) {
+    std::string header_bytes = recvExactly(fd, kFrameHeaderSize);
+    if (header_bytes.size() != kFrameHeaderSize) return std::string();
+    FrameHeader header = decodeFrameHeader(header_bytes.data());
+    EXPECT_EQ(header.type, static_cast<uint16_t>(FrameType::Response));
+    EXPECT_EQ(header.sequence, sequence);
+    return recvExactly(fd, header.length);
+}
+
+}  // namespace
+
+// 测试TCP服务器，参数为I/O引擎
+class TcpServerTest : public ::testing::TestWithParam<ServerEngine> {
+protected:
+    void SetUp() override {
+        ServerConfig config;
+        config.port = 0;
+        config.engine = GetParam();
+        server_ = std::make_unique<TcpServer>(config);
+        ASSERT_TRUE(server_->start());
+        ASSERT_GT(server_->port(), 0);
+    }
+
+    void TearDown() override {
+        server_->stop();
+    }
+
+    std::unique_ptr<TcpServer> server_;
+};
+
+// 测试每条消息都收到响应
+TEST_P(TcpServerTest, RespondsToEachMessage) {
+    int fd = connectTo(server_->port());
+    ASSERT_GE(fd, 0);
+
+    for (int i = 0; i < 5; ++i) {
+        std::string message = "消息 " + std::to_string(i);
+        ASSERT_TRUE(sendFrame(fd, i, message));
+        EXPECT_EQ(recvResponse(fd, i), kResponse);
+    }
+    close(fd);
+}
+
+// 测试多个并发连接
+TEST_P(TcpServerTest, MultipleConnections) {
+    const int CONNECTION_COUNT = 50;
+    std::vector<int> fds;
+    for (int i = 0; i < CONNECTION_COUNT; ++i) {
+        int fd = connectTo(server_->port());
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+    }
+
+    for (int fd : fds) {
+        ASSERT_TRUE(sendFrame(fd, 1, "ping"));
+    }
+    for (int fd : fds) {
+        EXPECT_EQ(recvResponse(fd, 1), kResponse);
+        close(fd);
+    }
+}
+
+// 测试停止服务器时关闭所有连接
+TEST_P(TcpServerTest, StopClosesConnections) {
+    int fd = connectTo(server_->port());
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(sendFrame(fd, 1, "ping"));
+    EXPECT_EQ(recvResponse(fd, 1), kResponse);
+
+    server_->stop();
+    EXPECT_FALSE(server_->isRunning());
+
+    char buffer[16];
+    EXPECT_EQ(recv(fd, buffer, sizeof(buffer), 0), 0);
+    close(fd);
+}
+
+// 测试多反应器模式下所有连接都能得到服务
+TEST(TcpServerReactorTest, ShardedReactorsServeAllConnections) {
+    ServerConfig config;
+    config.port = 0;
+    config.reactor_count = 4;
+    TcpServer server(config);
+    ASSERT_TRUE(server.start());
+    EXPECT_EQ(server.reactorCount(), 4);
+
+    const int CONNECTION_COUNT = 64;
+    std::vector<int> fds;
+    for (int i = 0; i < CONNECTION_COUNT; ++i) {
+        int fd = connectTo(server.port());
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+    }
+    for (int fd : fds) {
+        ASSERT_TRUE(sendFrame(fd, 1, "ping"));
+    }
+    for (int fd : fds) {
+        EXPECT_EQ(recvResponse(fd, 1), kResponse);
+        close(fd);
+    }
+    server.stop();
+}
+
+// 测试io_uring引擎的选择与回退
+TEST(TcpServerReactorTest, IoUringEngineSelection) {
+    ServerConfig config;
+    config.port = 0;
+    config.engine = ServerEngine::IoUring;
+    config.reactor_count = 2;
+    TcpServer server(config);
+    ASSERT_TRUE(server.start());
+    EXPECT_EQ(server.engine(),
+              IoUring::supported() ? ServerEngine::IoUring : ServerEngine::Epoll);
+
+    int fd = connectTo(server.port());
+    ASSERT_GE(fd, 0);
+    // 大于单个内核提供缓冲区的帧需要跨多个recv完成事件拼接
+    std::string large(64 * 1024, 'x');
+    ASSERT_TRUE(sendFrame(fd, 7, large));
+    EXPECT_EQ(recvResponse(fd, 7), kResponse);
+
+    // 一次写入多个帧，每个帧各得到一条响应
+    std::string batch;
+    for (uint32_t i = 0; i < 16; ++i) {
+        appendFrame(batch, FrameType::Message, 100 + i, "batch");
+    }
+    ASSERT_EQ(send(fd, batch.data(), batch.size(), 0), (ssize_t)batch.size());
+    for (uint32_t i = 0; i < 16; ++i) {
+        EXPECT_EQ(recvResponse(fd, 100 + i), kResponse);
+    }
+    close(fd);
+    server.stop();
+}
+
+// 测试开启零拷贝阈值后响应仍然正确（回环设备上内核会回退为拷贝）
+TEST(TcpServerReactorTest, ZerocopyResponses) {
+    for (ServerEngine engine : {ServerEngine::Epoll, ServerEngine::ThreadPerConnection}) {
+        ServerConfig config;
+        config.port = 0;
+        config.engine = engine;
+        config.reactor_count = 1;
+        config.output.zerocopy_threshold = 1;
+        TcpServer server(config);
+        ASSERT_TRUE(server.start());
+
+        int fd = connectTo(server.port());
+        ASSERT_GE(fd, 0);
+        for (uint32_t i = 0; i < 20; ++i) {
+            ASSERT_TRUE(sendFrame(fd, i, "zerocopy"));
+            EXPECT_EQ(recvResponse(fd, i), kResponse);
+        }
+        close(fd);
+        server.stop();
+    }
+}
+
+// 测试自定义消息处理函数，参数为I/O引擎
+class MessageHandlerTest : public ::testing::TestWithParam<ServerEngine> {
+protected:
+    void startServer(MessageHandler handler) {
+        ServerConfig config;
+        config.port = 0;
+        config.engine = GetParam();
+        config.reactor_count = 1;
+        config.handler_threads = 2;
+        server_ = std::make_unique<TcpServer>(config);
+        server_->setMessageHandler(std::move(handler));
+        ASSERT_TRUE(server_->start());
+    }
+
+    void TearDown() override {
+        if (server_) server_->stop();
+    }
+
+    std::unique_ptr<TcpServer> server_;
+};
+
+// 测试响应来自处理函数，流水线发送的请求按顺序回复，返回false的请求不回复
+TEST_P(MessageHandlerTest, RepliesInRequestOrder) {
+    startServer([](const FrameHeader& header, std::string_view payload, ByteBuffer& response) {
+        if (payload == "skip") return false;
+        // 越早的请求处理越慢，让结果乱序完成
+        std::this_thread::sleep_for(std::chrono::milliseconds((20 - header.sequence % 20) / 4));
+        response.append("echo:");
+        response.append(payload);
+        return true;
+    });
+
+    int fd = connectTo(server_->port());
+    ASSERT_GE(fd, 0);
+    std::string batch;
+    for (uint32_t i = 0; i < 40; ++i) {
+        appendFrame(batch, FrameType::Message, i, i % 10 == 5 ? "skip" : "m" + std::to_string(i));
+    }
+    ASSERT_EQ(send(fd, batch.data(), batch.size(), 0), (ssize_t)batch.size());
+    for (uint32_t i = 0; i < 40; ++i) {
+        if (i % 10 == 5) continue;
+        std::string header_bytes = recvExactly(fd, kFrameHeaderSize);
+        ASSERT_EQ(header_bytes.size(), kFrameHeaderSize);
+        FrameHeader header = decodeFrameHeader(header_bytes.data());
+        EXPECT_EQ(header.sequence, i);
+        EXPECT_EQ(recvExactly(fd, header.length), "echo:m" + std::to_string(i));
+    }
+    close(fd);
+}
+
+// 测试耗时的处理函数不增加同一反应器上其他连接的延迟
+TEST_P(MessageHandlerTest, SlowHandlerDoesNotBlockOtherConnections) {
+    if (GetParam() == ServerEngine::ThreadPerConnection) {
+        GTEST_SKIP() << "每连接线程模式下处理函数在连接线程上执行";
+    }
+    startServer([](const FrameHeader&, std::string_view payload, ByteBuffer& response) {
+        if (payload == "slow") {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        }
+        response.append(payload);
+        return true;
+    });
+
+    int slow_fd = connectTo(server_->port());
+    int fast_fd = connectTo(server_->port());
+    ASSERT_GE(slow_fd, 0);
+    ASSERT_GE(fast_fd, 0);
+
+    ASSERT_TRUE(sendFrame(slow_fd, 1, "slow"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(sendFrame(fast_fd, 1, "fast"));
+    std::string header_bytes = recvExactly(fast_fd, kFrameHeaderSize);
+    ASSERT_EQ(header_bytes.size(), kFrameHeaderSize);
+    EXPECT_EQ(recvExactly(fast_fd, decodeFrameHeader(header_bytes.data()).length), "fast");
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(300));
+
+    header_bytes = recvExactly(slow_fd, kFrameHeaderSize);
+    ASSERT_EQ(header_bytes.size(), kFrameHeaderSize);
+    EXPECT_EQ(recvExactly(slow_fd, decodeFrameHeader(header_bytes.data()).length), "slow");
+    close(slow_fd);
+    close(fast_fd);
+}
+
+// 测试处理期间连接关闭、服务器停止时不会访问已释放的连接
+TEST_P(MessageHandlerTest, ConnectionClosedDuringHandling) {
+    startServer([](const FrameHeader&, std::string_view payload, ByteBuffer& response) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        response.append(payload);
+        return true;
+    });
+
+    for (int i = 0; i < 10; ++i) {
+        int fd = connectTo(server_->port());
+        ASSERT_GE(fd, 0);
+        ASSERT_TRUE(sendFrame(fd, 1, "bye"));
+        close(fd);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    int fd = connectTo(server_->port());
+    ASSERT_GE(fd, 0);
+    for (uint32_t i = 0; i < 5; ++i) {
+        ASSERT_TRUE(sendFrame(fd, i, "busy"));
+    }
+    server_->stop();
+    close(fd);
+}
+
+// 测试处理函数抛出异常时该请求不回复，服务器和连接继续工作
+TEST_P(MessageHandlerTest, HandlerExceptionSkipsReply) {
+    startServer([](const FrameHeader&, std::string_view payload, ByteBuffer& response) -> bool {
+        if (payload == "throw") throw std::runtime_error("处理失败");
+        response.append(payload);
+        return true;
+    });
+
+    int fd = connectTo(server_->port());
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(sendFrame(fd, 1, "throw"));
+    ASSERT_TRUE(sendFrame(fd, 2, "after"));
+    std::string header_bytes = recvExactly(fd, kFrameHeaderSize);
+    ASSERT_EQ(header_bytes.size(), kFrameHeaderSize);
+    FrameHeader header = decodeFrameHeader(header_bytes.data());
+    EXPECT_EQ(header.sequence, 2u);
+    EXPECT_EQ(recvExactly(fd, header.length), "after");
+    close(fd);
+}
+
+// 测试连接准入控制，参数为I/O引擎
+class AdmissionTest : public ::testing::TestWithParam<ServerEngine> {};
+
+// 被拒绝的连接会立即收到RST或FIN
+bool isRejected(int fd) {
+    char buffer[16];
+    ssize_t n;
+    do {
+        n = recv(fd, buffer, sizeof(buffer), 0);
+    } while (n < 0 && errno == EINTR);
+    return n == 0 || (n < 0 && errno == ECONNRESET);
+}
+
+// 测试达到最大连接数后快速拒绝新连接，连接关闭后恢复接受
+TEST_P(AdmissionTest, MaxConnectionsShedsExcess) {
+    ServerConfig config;
+    config.port = 0;
+    config.engine = GetParam();
+    config.reactor_count = 1;
+    config.admission.max_connections = 2;
+    TcpServer server(config);
+    ASSERT_TRUE(server.start());
+
+    int first = connectTo(server.port());
+    int second = connectTo(server.port());
+    ASSERT_GE(first, 0);
+    ASSERT_GE(second, 0);
+    ASSERT_TRUE(sendFrame(first, 1, "ping"));
+    EXPECT_EQ(recvResponse(first, 1), kResponse);
+    ASSERT_TRUE(sendFrame(second, 1, "ping"));
+    EXPECT_EQ(recvResponse(second, 1), kResponse);
+
+    int third = connectTo(server.port());
+    ASSERT_GE(third, 0);
+    EXPECT_TRUE(isRejected(third));
+    close(third);
+
+    AdmissionStats stats = server.admissionStats();
+    EXPECT_EQ(stats.accepted, 2u);
+    EXPECT_EQ(stats.rejected_max_connections, 1u);
+    EXPECT_EQ(stats.active_connections, 2u);
+
+    // 关闭一个连接后名额归还
+    close(first);
+    for (int i = 0; i < 100 && server.admissionStats().active_connections > 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    int fourth = connectTo(server.port());
+    ASSERT_GE(fourth, 0);
+    ASSERT_TRUE(sendFrame(fourth, 2, "ping"));
+    EXPECT_EQ(recvResponse(fourth, 2), kResponse);
+
+    close(second);
+    close(fourth);
+    server.stop();
+}
+
+// 测试全局accept速率限制：超出令牌桶容量的连接被拒绝并计数
+TEST_P(AdmissionTest, AcceptRateLimit) {
+    ServerConfig config;
+    config.port = 0;
+    config.engine = GetParam();
+    config.reactor_count = 1;
+    config.admission.accept_rate = 1;
+    config.admission.accept_burst = 3;
+    TcpServer server(config);
+    ASSERT_TRUE(server.start());
+
+    std::vector<int> fds;
+    for (int i = 0; i < 6; ++i) {
+        int fd = connectTo(server.port());
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+    }
+    int served = 0;
+    for (size_t i = 0; i < fds.size(); ++i) {
+        if (sendFrame(fds[i], 1, "ping") && recvResponse(fds[i], 1) == kResponse) {
+            ++served;
+        }
+        close(fds[i]);
+    }
+    EXPECT_GE(served, 3);
+    EXPECT_LT(served, 6);
+
+    AdmissionStats stats = server.admissionStats();
+    EXPECT_EQ(stats.accepted + stats.rejected_global_rate, 6u);
+    EXPECT_GE(stats.rejected_global_rate, 1u);
+    server.stop();
+}
+
+// 测试连接超时，参数为I/O引擎
+class TimeoutTest : public ::testing::TestWithParam<ServerEngine> {};
+
+// 测试有收发的连接不会被关闭，空闲超过idle_timeout_ms后被服务器关闭
+TEST_P(TimeoutTest, IdleConnectionClosed) {
+    ServerConfig config;
+    config.port = 0;
+    config.engine = GetParam();
+    config.reactor_count = 1;
+    config.timeouts.idle_timeout_ms = 300;
+    TcpServer server(config);
+    ASSERT_TRUE(server.start());
+
+    int fd = connectTo(server.port());
+    ASSERT_GE(fd, 0);
+    for (uint32_t i = 0; i < 6; ++i) {
+        ASSERT_TRUE(sendFrame(fd, i, "ping"));
+        EXPECT_EQ(recvResponse(fd, i), kResponse);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(isRejected(fd));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(900));
+    close(fd);
+
+    for (int i = 0; i < 100 && server.admissionStats().active_connections > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(server.admissionStats().active_connections, 0u);
+    server.stop();
+}
+
+// 测试只发送半个帧的慢速客户端在读超时后被关闭，正常客户端不受影响
+TEST_P(TimeoutTest, PartialFrameClosedAfterReadTimeout) {
+    ServerConfig config;
+    config.port = 0;
+    config.engine = GetParam();
+    config.reactor_count = 1;
+    config.timeouts.read_timeout_ms = 200;
+    TcpServer server(config);
+    ASSERT_TRUE(server.start());
+
+    int slow = connectTo(server.port());
+    int normal = connectTo(server.port());
+    ASSERT_GE(slow, 0);
+    ASSERT_GE(normal, 0);
+
+    std::string frame;
+    appendFrame(frame, FrameType::Message, 1, "slow");
+    ASSERT_EQ(send(slow, frame.data(), 5, 0), 5);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(isRejected(slow));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(900));
+    close(slow);
+
+    // 没有未完成帧的连接不受读超时影响
+    ASSERT_TRUE(sendFrame(normal, 1, "ping"));
+    EXPECT_EQ(recvResponse(normal, 1), kResponse);
+    close(normal);
+    server.stop();
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, TimeoutTest,
+                         ::testing::Values(ServerEngine::Epoll,
+                                           ServerEngine::IoUring,
+                                           ServerEngine::ThreadPerConnection));
+
+INSTANTIATE_TEST_SUITE_P(Engines, AdmissionTest,
+                         ::testing::Values(ServerEngine::Epoll,
+                                           ServerEngine::IoUring,
+                                           ServerEngine::ThreadPerConnection));
+
+INSTANTIATE_TEST_SUITE_P(Engines, MessageHandlerTest,
+                         ::testing::Values(ServerEngine::Epoll,
+                                           ServerEngine::IoUring,
+                                           ServerEngine::ThreadPerConnection));
+
+INSTANTIATE_TEST_SUITE_P(Engines, TcpServerTest,
+                         ::testing::Values(ServerEngine::Epoll,
+                                           ServerEngine::IoUring,
+                                           ServerEngine::ThreadPerConnection));
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include "timing_wheel.h"
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 记录到期顺序与时间的测试定时器
+struct TestTimer : public TimerHandler {
+    explicit TestTimer(int id = 0) : id(id), timer(this) {}
+
+    void onTimer(Timer&) override {
+        ++fired;
+        if (on_fire) on_fire(*this);
+    }
+
+    int id;
+    int fired = 0;
+    std::function<void(TestTimer&)> on_fire;
+    Timer timer;
+};
+
+}  // namespace
+
+// 测试定时器在到期前不触发，到期后只触发一次
+TEST(TimingWheelTest, FiresOnceAfterDelay) {
+    TimingWheel wheel(10, 1000);
+    TestTimer t;
+    wheel.schedule(t.timer, 50);
+    EXPECT_TRUE(t.timer.armed());
+    EXPECT_EQ(t.timer.deadline(), 1050u);
+    EXPECT_EQ(wheel.size(), 1u);
+
+    EXPECT_EQ(wheel.advance(1049), 0u);
+    EXPECT_EQ(t.fired, 0);
+    EXPECT_EQ(wheel.advance(1050), 1u);
+    EXPECT_EQ(t.fired, 1);
+    EXPECT_FALSE(t.timer.armed());
+    EXPECT_TRUE(wheel.empty());
+    wheel.advance(5000);
+    EXPECT_EQ(t.fired, 1);
+}
+
+// 测试取消和重新启动
+TEST(TimingWheelTest, CancelAndReschedule) {
+    TimingWheel wheel(10, 0);
+    TestTimer a, b;
+    wheel.schedule(a.timer, 100);
+    wheel.schedule(b.timer, 100);
+    a.timer.cancel();
+    a.timer.cancel();
+    EXPECT_EQ(wheel.size(), 1u);
+
+    // 重新启动会替换原来的到期时间
+    wheel.schedule(b.timer, 300);
+    EXPECT_EQ(wheel.size(), 1u);
+    wheel.advance(200);
+    EXPECT_EQ(a.fired, 0);
+    EXPECT_EQ(b.fired, 0);
+    wheel.advance(300);
+    EXPECT_EQ(b.fired, 1);
+}
+
+// 测试定时器析构时自动取消
+TEST(TimingWheelTest, DestroyedTimerIsRemoved) {
+    TimingWheel wheel(10, 0);
+    {
+        TestTimer t;
+        wheel.schedule(t.timer, 100);
+        EXPECT_EQ(wheel.size(), 1u);
+    }
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_EQ(wheel.advance(1000), 0u);
+}
+
+// 测试跨越多层的定时器经迁移后按时到期，且不会提前
+TEST(TimingWheelTest, CascadesAcrossLevels) {
+    TimingWheel wheel(1, 0);
+    std::vector<uint64_t> delays = {1, 63, 64, 65, 4095, 4096, 4097, 262143, 262144, 300000,
+                                    16777215, 16777216, 20000000};
+    std::vector<std::unique_ptr<TestTimer>> timers;
+    std::vector<uint64_t> fired_at(delays.size(), 0);
+    uint64_t now = 0;
+    for (size_t i = 0; i < delays.size(); ++i) {
+        timers.push_back(std::make_unique<TestTimer>(static_cast<int>(i)));
+        timers.back()->on_fire = [&fired_at, &now](TestTimer& t) { fired_at[t.id] = now; };
+        wheel.schedule(timers.back()->timer, delays[i]);
+    }
+
+    // 按nextTimeoutMs推进，模拟事件循环
+    while (!wheel.empty()) {
+        int timeout = wheel.nextTimeoutMs(now);
+        ASSERT_GE(timeout, 0);
+        now += timeout;
+        wheel.advance(now);
+    }
+    for (size_t i = 0; i < delays.size(); ++i) {
+        EXPECT_EQ(fired_at[i], delays[i]) << "delay " << delays[i];
+    }
+}
+
+// 测试粗粒度tick下定时器最多晚一个tick到期
+TEST(TimingWheelTest, CoarseTickNeverFiresEarly) {
+    TimingWheel wheel(10, 3);
+    TestTimer t;
+    wheel.schedule(t.timer, 25);
+    wheel.advance(27);
+    EXPECT_EQ(t.fired, 0);
+    EXPECT_EQ(wheel.nextTimeoutMs(27), 3);
+    wheel.advance(30);
+    EXPECT_EQ(t.fired, 1);
+}
+
+// 测试大量随机定时器按到期时间顺序触发，长时间跳跃推进时也不遗漏
+TEST(TimingWheelTest, ManyTimersFireInOrder) {
+    constexpr int kCount = 200000;
+    TimingWheel wheel(1, 0);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint64_t> dist(1, 1000000);
+    std::vector<std::unique_ptr<TestTimer>> timers;
+    uint64_t now = 0;
+    uint64_t last_deadline = 0;
+    bool in_order = true;
+    for (int i = 0; i < kCount; ++i) {
+        timers.push_back(std::make_unique<TestTimer>(i));
+        timers.back()->on_fire = [&](TestTimer& t) {
+            if (t.timer.deadline() < last_deadline || t.timer.deadline() > now) in_order = false;
+            last_deadline = t.timer.deadline();
+        };
+        wheel.schedule(timers.back()->timer, dist(rng));
+    }
+    // 取消一半
+    for (int i = 0; i < kCount; i += 2) {
+        timers[i]->timer.cancel();
+    }
+    EXPECT_EQ(wheel.size(), static_cast<size_t>(kCount / 2));
+
+    size_t fired = 0;
+    while (now < 1000000) {
+        now += 997;
+        fired += wheel.advance(now);
+    }
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(fired, static_cast<size_t>(kCount / 2));
+    EXPECT_TRUE(wheel.empty());
+}
+
+// 测试回调中可以重新启动自己并取消同一批到期的其他定时器
+TEST(TimingWheelTest, CallbackMayRescheduleAndCancel) {
+    TimingWheel wheel(10, 0);
+    TestTimer periodic(1), victim(2);
+    periodic.on_fire = [&](TestTimer& t) {
+        victim.timer.cancel();
+        if (t.fired < 3) wheel.schedule(t.timer, 100);
+    };
+    wheel.schedule(periodic.timer, 100);
+    wheel.schedule(victim.timer, 100);
+
+    for (uint64_t now = 0; now <= 1000; now += 10) {
+        wheel.advance(now);
+    }
+    EXPECT_EQ(periodic.fired, 3);
+    EXPECT_EQ(victim.fired, 0);
+    EXPECT_TRUE(wheel.empty());
+}
+
+// 测试空时间轮的超时为-1，时间倒退时不处理
+TEST(TimingWheelTest, EmptyWheelAndClockGoingBack) {
+    TimingWheel wheel(10, 100);
+    EXPECT_EQ(wheel.nextTimeoutMs(100), -1);
+    TestTimer t;
+    wheel.schedule(t.timer, 50);
+    EXPECT_EQ(wheel.advance(50), 0u);
+    EXPECT_EQ(wheel.now(), 100u);
+    EXPECT_EQ(wheel.advance(150), 1u);
+}
+
+// 测试时间轮先于定时器析构时不会悬空
+TEST(TimingWheelTest, WheelDestroyedBeforeTimer) {
+    TestTimer t;
+    {
+        TimingWheel wheel(10, 0);
+        wheel.schedule(t.timer, 100);
+    }
+    EXPECT_FALSE(t.timer.armed());
+    t.timer.cancel();
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include "trace.h"
+#include "client_pool.h"
+#include "tcp_client.h"
+#include "tcp_server.h"
+#include <unistd.h>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+size_t countOf(const std::string& text, const std::string& pattern) {
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+// 取出名为name、阶段为phase的第一个事件所在的行
+std::string eventLine(const std::string& json, const std::string& name, const std::string& phase) {
+    std::istringstream lines(json);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.find("\"name\":\"" + name + "\"") != std::string::npos &&
+            line.find("\"ph\":\"" + phase + "\"") != std::string::npos) {
+            return line;
+        }
+    }
+    return std::string();
+}
+
+double timestampOf(const std::string& line) {
+    size_t pos = line.find("\"ts\":");
+    return pos == std::string::npos ? -1 : std::atof(line.c_str() + pos + 5);
+}
+
+}  // namespace
+
+// 测试多个线程的记录都能导出，已退出线程的记录仍保留，区间的结束不早于开始
+TEST(TraceTest, RecordsFromThreads) {
+    clearTrace();
+    {
+        TRACE_SCOPE("test_scope", 7);
+        TRACE_INSTANT("test_instant", 7);
+    }
+    std::thread worker([] {
+        TRACE_ASYNC_BEGIN("test_async", 42);
+        TRACE_ASYNC_END("test_async", 42);
+    });
+    worker.join();
+
+    std::string json = traceEventsJson();
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0u);
+    EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+
+    std::string begin = eventLine(json, "test_scope", "B");
+    std::string end = eventLine(json, "test_scope", "E");
+    ASSERT_FALSE(begin.empty());
+    ASSERT_FALSE(end.empty());
+    EXPECT_NE(begin.find("\"args\":{\"id\":7}"), std::string::npos);
+    EXPECT_GE(timestampOf(end), timestampOf(begin));
+    EXPECT_NE(eventLine(json, "test_instant", "i").find("\"s\":\"t\""), std::string::npos);
+
+    std::string async_begin = eventLine(json, "test_async", "b");
+    ASSERT_FALSE(async_begin.empty());
+    EXPECT_NE(async_begin.find("\"id\":\"0x2a\""), std::string::npos);
+    EXPECT_FALSE(eventLine(json, "test_async", "e").empty());
+    // 工作线程和主线程的tid不同
+    std::string tid_main = begin.substr(begin.find("\"tid\":"));
+    std::string tid_worker = async_begin.substr(async_begin.find("\"tid\":"));
+    EXPECT_NE(tid_main.substr(0, tid_main.find(',')), tid_worker.substr(0, tid_worker.find(',')));
+
+    clearTrace();
+    json = traceEventsJson();
+    EXPECT_EQ(countOf(json, "test_"), 0u);
+}
+
+// 测试缓冲区写满后只保留最近的记录
+TEST(TraceTest, RingOverwritesOldest) {
+    clearTrace();
+    std::thread worker([] {
+        for (size_t i = 0; i < kTraceRingSize; ++i) TRACE_INSTANT("old_event", i);
+        for (size_t i = 0; i < kTraceRingSize / 2; ++i) TRACE_INSTANT("new_event", i);
+    });
+    worker.join();
+
+    std::string json = traceEventsJson();
+    EXPECT_EQ(countOf(json, "\"name\":\"new_event\""), kTraceRingSize / 2);
+    EXPECT_EQ(countOf(json, "\"name\":\"old_event\""), kTraceRingSize / 2);
+    clearTrace();
+}
+
+// 测试客户端和服务器的跟踪点：连接状态按连接编号成对出现，服务器记录接受和读取
+TEST(TraceTest, ClientServerTimeline) {
+    clearTrace();
+    ServerConfig config;
+    config.port = 0;
+    TcpServer server(config);
+    ASSERT_TRUE(server.start());
+    {
+        ClientPool pool(1);
+        TcpClient client(pool, "127.0.0.1", server.port());
+        client.start();
+        ASSERT_TRUE(client.isConnected());
+        ASSERT_TRUE(client.call("ping").get().ok());
+        client.stop();
+    }
+    server.stop();
+
+    std::string json = traceEventsJson();
+    std::string connecting = eventLine(json, "connecting", "b");
+    ASSERT_FALSE(connecting.empty());
+    std::string id = connecting.substr(connecting.find("\"id\":\""), 12);
+    std::string connected = eventLine(json, "connecting", "e");
+    ASSERT_FALSE(connected.empty());
+    EXPECT_NE(connected.find(id), std::string::npos);
+    EXPECT_FALSE(eventLine(json, "connected", "b").empty());
+    EXPECT_FALSE(eventLine(json, "connected", "e").empty());
+    EXPECT_FALSE(eventLine(json, "enqueue", "i").empty());
+    EXPECT_FALSE(eventLine(json, "flush", "B").empty());
+    EXPECT_FALSE(eventLine(json, "accepted", "i").empty());
+    EXPECT_FALSE(eventLine(json, "read", "B").empty());
+
+    std::string path = "/tmp/tcp_trace_test_" + std::to_string(getpid()) + ".json";
+    ASSERT_TRUE(dumpTrace(path));
+    std::ifstream in(path);
+    std::stringstream content;
+    content << in.rdbuf();
+    EXPECT_NE(content.str().find("\"name\":\"connecting\""), std::string::npos);
+    unlink(path.c_str());
+    EXPECT_FALSE(dumpTrace("/nonexistent/dir/trace.json"));
+    clearTrace();
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include "work_stealing_pool.h"
+#include "mpsc_queue.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 轮询等待条件成立，最多等待timeout
+template <typename F>
+bool waitUntil(F&& condition, std::chrono::milliseconds timeout = std::chrono::seconds(5)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+struct Node {
+    Node* next = nullptr;
+    int producer = 0;
+    int value = 0;
+};
+
+}  // namespace
+
+// 测试外部提交的任务全部执行
+TEST(WorkStealingPoolTest, RunsAllSubmittedTasks) {
+    WorkStealingPool pool(4);
+    EXPECT_EQ(pool.threadCount(), 4u);
+
+    const int TASK_COUNT = 10000;
+    std::atomic<int> done(0);
+    for (int i = 0; i < TASK_COUNT; ++i) {
+        pool.submit([&done] { done.fetch_add(1); });
+    }
+    EXPECT_TRUE(waitUntil([&] { return done.load() == TASK_COUNT; }));
+}
+
+// 测试一个线程自己队列里积压的任务被其他空闲线程窃取执行，
+// 耗时任务不会阻塞同一队列里的其他任务
+TEST(WorkStealingPoolTest, IdleWorkersStealFromBusyWorker) {
+    WorkStealingPool pool(4);
+    std::atomic<bool> release(false);
+    std::atomic<int> done(0);
+
+    // 在工作线程内提交的任务都进入该线程自己的队列，随后该线程被阻塞
+    pool.submit([&] {
+        for (int i = 0; i < 100; ++i) {
+            pool.submit([&done] { done.fetch_add(1); });
+        }
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    EXPECT_TRUE(waitUntil([&] { return done.load() == 100; }));
+    EXPECT_GE(pool.stolenCount(), 100u);
+    release = true;
+}
+
+// 测试停止后未执行的任务被丢弃并释放其捕获的对象，停止可以重复调用
+TEST(WorkStealingPoolTest, StopDiscardsPendingTasks) {
+    std::atomic<int> done(0);
+    auto captured = std::make_shared<int>(0);
+    {
+        WorkStealingPool pool(1);
+        std::atomic<bool> started(false);
+        pool.submit([&] {
+            started = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        });
+        ASSERT_TRUE(waitUntil([&] { return started.load(); }));
+        for (int i = 0; i < 10; ++i) {
+            pool.submit([&done, captured] { done.fetch_add(1); });
+        }
+        pool.stop();
+        pool.stop();
+        EXPECT_EQ(captured.use_count(), 1);
+    }
+    EXPECT_EQ(done.load(), 0);
+}
+
+// 测试多生产者并发压入时不丢失节点，且每个生产者的节点保持压入顺序
+TEST(MpscQueueTest, PreservesPerProducerOrder) {
+    MpscQueue<Node> queue;
+    EXPECT_EQ(queue.popAll(), nullptr);
+
+    const int PRODUCER_COUNT = 4;
+    const int NODE_COUNT = 10000;
+    std::vector<std::vector<Node>> nodes(PRODUCER_COUNT, std::vector<Node>(NODE_COUNT));
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCER_COUNT; ++p) {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < NODE_COUNT; ++i) {
+                nodes[p][i].producer = p;
+                nodes[p][i].value = i;
+                queue.push(&nodes[p][i]);
+            }
+        });
+    }
+
+    std::vector<int> next(PRODUCER_COUNT, 0);
+    int received = 0;
+    auto consume = [&] {
+        for (Node* node = queue.popAll(); node != nullptr; node = node->next) {
+            EXPECT_EQ(node->value, next[node->producer]);
+            next[node->producer] = node->value + 1;
+            ++received;
+        }
+    };
+    while (received < PRODUCER_COUNT * NODE_COUNT) {
+        consume();
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    consume();
+    EXPECT_EQ(received, PRODUCER_COUNT * NODE_COUNT);
+    EXPECT_TRUE(queue.empty());
+
+    // 压入空队列时返回true，用于合并唤醒
+    Node a, b;
+    EXPECT_TRUE(queue.push(&a));
+    EXPECT_FALSE(queue.push(&b));
+    EXPECT_EQ(queue.popAll(), &a);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}